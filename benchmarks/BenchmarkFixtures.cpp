@@ -0,0 +1,85 @@
+/* benchmarks/BenchmarkFixtures.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "BenchmarkFixtures.h"
+
+#include "afv-native/afv/VoiceCompressionSink.h"
+#include "afv-native/audio/PinkNoiseGenerator.h"
+
+using namespace afv_native;
+
+namespace {
+    const size_t packetCount = 100;
+
+    class PacketCollector: public afv::ICompressedFrameSink {
+    public:
+        explicit PacketCollector(std::vector<std::vector<unsigned char>> &packets):
+                mPackets(packets)
+        {
+        }
+
+        void processCompressedFrame(const std::vector<unsigned char> &compressedData) override
+        {
+            mPackets.emplace_back(compressedData);
+        }
+
+    protected:
+        std::vector<std::vector<unsigned char>> &mPackets;
+    };
+}
+
+const std::vector<std::vector<unsigned char>> &bench::encodedVoicePackets()
+{
+    static const std::vector<std::vector<unsigned char>> packets = [] {
+        std::vector<std::vector<unsigned char>> encoded;
+        PacketCollector collector(encoded);
+        afv::VoiceCompressionSink encoder(collector);
+
+        const auto frames = pinkNoiseFrames(packetCount);
+        for (size_t i = 0; i < packetCount; i++) {
+            encoder.putAudioFrame(frames.data() + i * audio::frameSizeSamples);
+        }
+        return encoded;
+    }();
+    return packets;
+}
+
+std::vector<audio::SampleType> bench::pinkNoiseFrames(size_t count)
+{
+    std::vector<audio::SampleType> samples(count * audio::frameSizeSamples);
+    audio::PinkNoiseGenerator noise(0.5f);
+    for (size_t i = 0; i < count; i++) {
+        noise.getAudioFrame(samples.data() + i * audio::frameSizeSamples);
+    }
+    return samples;
+}
@@ -0,0 +1,98 @@
+/* benchmarks/afv/bench_Codec.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <benchmark/benchmark.h>
+
+#include "afv-native/afv/RemoteVoiceSource.h"
+#include "afv-native/afv/VoiceCompressionSink.h"
+#include "afv-native/afv/dto/voice_server/AudioRxOnTransceivers.h"
+
+#include "BenchmarkFixtures.h"
+
+using namespace afv_native;
+
+namespace {
+    const size_t inputFrames = 50;
+
+    class DiscardingFrameSink: public afv::ICompressedFrameSink {
+    public:
+        size_t BytesOut = 0;
+
+        void processCompressedFrame(const std::vector<unsigned char> &compressedData) override
+        {
+            BytesOut += compressedData.size();
+        }
+    };
+}
+
+/** Arg(0) is the encoder sample rate - wideband or narrowband. */
+static void BM_VoiceCompressionSink_encode(benchmark::State &state)
+{
+    const auto input = bench::pinkNoiseFrames(inputFrames);
+    DiscardingFrameSink frameSink;
+    afv::VoiceCompressionSink encoder(frameSink, static_cast<int>(state.range(0)));
+
+    size_t frame = 0;
+    for (auto _: state) {
+        encoder.putAudioFrame(input.data() + (frame % inputFrames) * audio::frameSizeSamples);
+        frame++;
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(frameSink.BytesOut);
+}
+BENCHMARK(BM_VoiceCompressionSink_encode)
+        ->Arg(audio::sampleRateHz)
+        ->Arg(audio::narrowbandSampleRateHz);
+
+/** one packet in, one frame out - the steady state for a single talker. */
+static void BM_RemoteVoiceSource_decode(benchmark::State &state)
+{
+    const auto &packets = bench::encodedVoicePackets();
+    std::vector<audio::SampleType> output(audio::frameSizeSamples);
+    afv::RemoteVoiceSource source;
+
+    afv::dto::AudioRxOnTransceivers pkt;
+    pkt.Callsign = "BENCH1";
+    pkt.SequenceCounter = 0;
+    pkt.LastPacket = false;
+
+    for (auto _: state) {
+        pkt.Audio = packets[pkt.SequenceCounter % packets.size()];
+        source.appendAudioDTO(pkt);
+        source.getAudioFrame(output.data());
+        benchmark::DoNotOptimize(output.data());
+        pkt.SequenceCounter++;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RemoteVoiceSource_decode);
@@ -0,0 +1,118 @@
+/* benchmarks/afv/bench_RadioSimulation.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <memory>
+#include <vector>
+#include <event2/event.h>
+
+#include "afv-native/afv/EffectResources.h"
+#include "afv-native/afv/RadioSimulation.h"
+#include "afv-native/afv/dto/voice_server/AudioRxOnTransceivers.h"
+
+#include "BenchmarkFixtures.h"
+
+#ifndef AFV_NATIVE_BENCH_RESOURCES
+#define AFV_NATIVE_BENCH_RESOURCES "."
+#endif
+
+using namespace afv_native;
+
+namespace {
+    const unsigned int baseFrequency = 118000000;
+    const unsigned int channelSpacing = 25000;
+}
+
+/** Arg(0) is the number of incoming voice streams, Arg(1) the number of radios.
+ *
+ * Streams are spread evenly across the radios, and each stream delivers one
+ * packet per frame.  Only the mix (getAudioFrame) is timed - the packet
+ * injection that would normally happen on the network thread is not.
+ */
+static void BM_RadioSimulation_getAudioFrame(benchmark::State &state)
+{
+    const auto streamCount = static_cast<unsigned int>(state.range(0));
+    const auto radioCount = static_cast<unsigned int>(state.range(1));
+    const auto &packets = bench::encodedVoicePackets();
+
+    // loaded once - every configuration shares the same effect samples.
+    static auto resources = std::make_shared<afv::EffectResources>(AFV_NATIVE_BENCH_RESOURCES);
+
+    struct event_base *evBase = event_base_new();
+    {
+        afv::RadioSimulation simulation(evBase, resources, nullptr, radioCount);
+        for (unsigned int radio = 0; radio < radioCount; radio++) {
+            simulation.setFrequency(radio, baseFrequency + radio * channelSpacing);
+        }
+
+        std::vector<afv::dto::AudioRxOnTransceivers> streams(streamCount);
+        for (unsigned int i = 0; i < streamCount; i++) {
+            char callsign[32];
+            snprintf(callsign, sizeof(callsign), "BENCH%u", i);
+            streams[i].Callsign = callsign;
+            streams[i].SequenceCounter = 0;
+            streams[i].LastPacket = false;
+            afv::dto::RxTransceiver trans;
+            trans.ID = 0;
+            trans.Frequency = baseFrequency + (i % radioCount) * channelSpacing;
+            trans.DistanceRatio = 1.0f;
+            streams[i].Transceivers.emplace_back(trans);
+        }
+
+        std::vector<audio::SampleType> output(audio::frameSizeSamples);
+        size_t frame = 0;
+        for (auto _: state) {
+            state.PauseTiming();
+            for (size_t i = 0; i < streams.size(); i++) {
+                auto &pkt = streams[i];
+                pkt.Audio = packets[(frame + i) % packets.size()];
+                simulation.rxVoicePacket(pkt);
+                pkt.SequenceCounter++;
+            }
+            state.ResumeTiming();
+
+            simulation.getAudioFrame(output.data());
+            benchmark::DoNotOptimize(output.data());
+            frame++;
+        }
+    }
+    event_base_free(evBase);
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RadioSimulation_getAudioFrame)
+        ->ArgNames({"streams", "radios"})
+        ->ArgsProduct({{0, 1, 4, 16, 64}, {1, 2, 4}})
+        ->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,168 @@
+/* benchmarks/audio/bench_Filters.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <benchmark/benchmark.h>
+
+#include "afv-native/audio/BiQuadFilter.h"
+#include "afv-native/audio/PinkNoiseGenerator.h"
+#include "afv-native/audio/SineToneSource.h"
+#include "afv-native/audio/VHFFilterSource.h"
+#include "afv-native/util/DenormalGuard.h"
+
+#include "BenchmarkFixtures.h"
+
+using namespace afv_native;
+using namespace afv_native::audio;
+
+namespace {
+    const size_t inputFrames = 50;
+
+    /** silenceTailFrames is what the filters see as a transmission fades out: noise that's decayed down into
+     * the subnormal range (around 1e-39, where floats bottom out at 1.2e-38).
+     */
+    std::vector<SampleType> silenceTailFrames()
+    {
+        auto frames = bench::pinkNoiseFrames(inputFrames);
+        for (auto &sample: frames) {
+            sample *= 1e-39f;
+        }
+        return frames;
+    }
+}
+
+static void BM_VHFFilterSource_transformFrame(benchmark::State &state)
+{
+    const auto input = bench::pinkNoiseFrames(inputFrames);
+    std::vector<SampleType> output(frameSizeSamples);
+    VHFFilterSource filter;
+
+    size_t frame = 0;
+    for (auto _: state) {
+        filter.transformFrame(output.data(), input.data() + (frame % inputFrames) * frameSizeSamples);
+        benchmark::DoNotOptimize(output.data());
+        benchmark::ClobberMemory();
+        frame++;
+    }
+    state.SetItemsProcessed(state.iterations() * frameSizeSamples);
+}
+BENCHMARK(BM_VHFFilterSource_transformFrame);
+
+static void BM_BiQuadFilter_TransformOne(benchmark::State &state)
+{
+    const auto input = bench::pinkNoiseFrames(inputFrames);
+    std::vector<SampleType> output(frameSizeSamples);
+    auto filter = BiQuadFilter::peakingEqFilter(2200.0f, 0.25f, 13.0f);
+
+    size_t frame = 0;
+    for (auto _: state) {
+        const SampleType *in = input.data() + (frame % inputFrames) * frameSizeSamples;
+        for (int i = 0; i < frameSizeSamples; i++) {
+            output[i] = filter.TransformOne(in[i]);
+        }
+        benchmark::DoNotOptimize(output.data());
+        benchmark::ClobberMemory();
+        frame++;
+    }
+    state.SetItemsProcessed(state.iterations() * frameSizeSamples);
+}
+BENCHMARK(BM_BiQuadFilter_TransformOne);
+
+/* the silence tail benchmarks take an argument: 0 runs them with the FPU as we found it, 1 inside a
+ * FlushDenormalsScope, as the audio callbacks do.
+ */
+static void BM_VHFFilterSource_silenceTail(benchmark::State &state)
+{
+    const auto input = silenceTailFrames();
+    std::vector<SampleType> output(frameSizeSamples);
+    VHFFilterSource filter;
+    util::FlushDenormalsScope denormals(state.range(0) != 0);
+
+    size_t frame = 0;
+    for (auto _: state) {
+        filter.transformFrame(output.data(), input.data() + (frame % inputFrames) * frameSizeSamples);
+        benchmark::DoNotOptimize(output.data());
+        benchmark::ClobberMemory();
+        frame++;
+    }
+    state.SetItemsProcessed(state.iterations() * frameSizeSamples);
+}
+BENCHMARK(BM_VHFFilterSource_silenceTail)->Arg(0)->Arg(1);
+
+static void BM_BiQuadFilter_silenceTail(benchmark::State &state)
+{
+    const auto input = silenceTailFrames();
+    std::vector<SampleType> output(frameSizeSamples);
+    auto filter = BiQuadFilter::peakingEqFilter(2200.0f, 0.25f, 13.0f);
+    util::FlushDenormalsScope denormals(state.range(0) != 0);
+
+    size_t frame = 0;
+    for (auto _: state) {
+        const SampleType *in = input.data() + (frame % inputFrames) * frameSizeSamples;
+        for (int i = 0; i < frameSizeSamples; i++) {
+            output[i] = filter.TransformOne(in[i]);
+        }
+        benchmark::DoNotOptimize(output.data());
+        benchmark::ClobberMemory();
+        frame++;
+    }
+    state.SetItemsProcessed(state.iterations() * frameSizeSamples);
+}
+BENCHMARK(BM_BiQuadFilter_silenceTail)->Arg(0)->Arg(1);
+
+static void BM_PinkNoiseGenerator_getAudioFrame(benchmark::State &state)
+{
+    std::vector<SampleType> output(frameSizeSamples);
+    PinkNoiseGenerator noise(0.5f);
+
+    for (auto _: state) {
+        noise.getAudioFrame(output.data());
+        benchmark::DoNotOptimize(output.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * frameSizeSamples);
+}
+BENCHMARK(BM_PinkNoiseGenerator_getAudioFrame);
+
+static void BM_SineToneSource_getAudioFrame(benchmark::State &state)
+{
+    std::vector<SampleType> output(frameSizeSamples);
+    SineToneSource tone(180.0, 0.5f);
+
+    for (auto _: state) {
+        tone.getAudioFrame(output.data());
+        benchmark::DoNotOptimize(output.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * frameSizeSamples);
+}
+BENCHMARK(BM_SineToneSource_getAudioFrame);
@@ -0,0 +1,129 @@
+/* benchmarks/cryptodto/bench_Channel.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+#include <vector>
+#include <openssl/rand.h>
+
+#include "afv-native/afv/dto/voice_server/AudioTxOnTransceivers.h"
+#include "afv-native/cryptodto/Channel.h"
+#include "afv-native/cryptodto/dto/ChannelConfig.h"
+
+#include "BenchmarkFixtures.h"
+
+using namespace afv_native;
+
+namespace {
+    /** makeLoopbackChannel sets up a channel that can decrypt its own output. */
+    void makeLoopbackChannel(cryptodto::Channel &channel)
+    {
+        cryptodto::dto::ChannelConfig config;
+        config.ChannelTag = "bench";
+        RAND_bytes(config.AeadTransmitKey, cryptodto::aeadModeKeySize);
+        ::memcpy(config.AeadReceiveKey, config.AeadTransmitKey, cryptodto::aeadModeKeySize);
+        channel.setChannelConfig(config);
+    }
+
+    afv::dto::AudioTxOnTransceivers makeVoicePacket()
+    {
+        afv::dto::AudioTxOnTransceivers pkt;
+        pkt.Callsign = "BENCH1";
+        pkt.SequenceCounter = 0;
+        pkt.Audio = bench::encodedVoicePackets()[0];
+        pkt.LastPacket = false;
+        pkt.Transceivers.emplace_back(0);
+        return pkt;
+    }
+}
+
+/** Arg(0) is the CryptoDtoMode. */
+static void BM_Channel_Encapsulate(benchmark::State &state)
+{
+    const auto mode = static_cast<cryptodto::CryptoDtoMode>(state.range(0));
+    cryptodto::Channel channel;
+    makeLoopbackChannel(channel);
+    auto pkt = makeVoicePacket();
+    std::vector<unsigned char> datagram(cryptodto::maxPermittedDatagramSize);
+
+    cryptodto::sequence_t sequence = 0;
+    size_t bytesOut = 0;
+    for (auto _: state) {
+        pkt.SequenceCounter = static_cast<uint32_t>(sequence);
+        auto len = channel.Encapsulate(datagram.data(), datagram.size(), sequence++, mode, pkt);
+        if (len == 0) {
+            state.SkipWithError("Encapsulate failed");
+            break;
+        }
+        bytesOut += len;
+        benchmark::DoNotOptimize(datagram.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(bytesOut);
+}
+BENCHMARK(BM_Channel_Encapsulate)
+        ->Arg(cryptodto::CryptoModeNone)
+        ->Arg(cryptodto::CryptoModeChaCha20Poly1305);
+
+/** Arg(0) is the CryptoDtoMode. */
+static void BM_Channel_Decapsulate(benchmark::State &state)
+{
+    const auto mode = static_cast<cryptodto::CryptoDtoMode>(state.range(0));
+    cryptodto::Channel channel;
+    makeLoopbackChannel(channel);
+    std::vector<unsigned char> datagram(cryptodto::maxPermittedDatagramSize);
+    auto len = channel.Encapsulate(datagram.data(), datagram.size(), 0, mode, makeVoicePacket());
+    if (len == 0) {
+        state.SkipWithError("Encapsulate failed");
+        return;
+    }
+
+    std::string channelTag;
+    cryptodto::sequence_t sequence;
+    cryptodto::CryptoDtoMode modeOut;
+    std::string dtoName;
+    for (auto _: state) {
+        msgpack::sbuffer dtoBuf;
+        if (!channel.Decapsulate(datagram.data(), len, channelTag, sequence, modeOut, dtoName, dtoBuf)) {
+            state.SkipWithError("Decapsulate failed");
+            break;
+        }
+        benchmark::DoNotOptimize(dtoBuf.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * len);
+}
+BENCHMARK(BM_Channel_Decapsulate)
+        ->Arg(cryptodto::CryptoModeNone)
+        ->Arg(cryptodto::CryptoModeChaCha20Poly1305);
@@ -0,0 +1,84 @@
+/* benchmarks/cryptodto/bench_SequenceTest.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "afv-native/cryptodto/SequenceTest.h"
+
+using namespace afv_native::cryptodto;
+
+namespace {
+    const unsigned sequenceWindow = 10;
+}
+
+static void BM_SequenceTest_Received_InOrder(benchmark::State &state)
+{
+    SequenceTest test(0, sequenceWindow);
+
+    sequence_t sequence = 0;
+    for (auto _: state) {
+        benchmark::DoNotOptimize(test.Received(sequence++));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SequenceTest_Received_InOrder);
+
+/** sequences arrive shuffled within a window-sized block, so most of them land
+ * in the bitfield rather than advancing the window directly.
+ */
+static void BM_SequenceTest_Received_Reordered(benchmark::State &state)
+{
+    std::vector<sequence_t> offsets(sequenceWindow);
+    for (unsigned i = 0; i < sequenceWindow; i++) {
+        offsets[i] = i;
+    }
+    std::mt19937 rng(1);
+    std::shuffle(offsets.begin(), offsets.end(), rng);
+
+    SequenceTest test(0, sequenceWindow);
+    sequence_t base = 0;
+    size_t i = 0;
+    for (auto _: state) {
+        benchmark::DoNotOptimize(test.Received(base + offsets[i]));
+        if (++i == offsets.size()) {
+            i = 0;
+            base += sequenceWindow;
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SequenceTest_Received_Reordered);
@@ -15,6 +15,10 @@ class AfvNativeConan(ConanFile):
         "audio_library": ["portaudio", "soundio"],
         "build_examples": [True, False],
         "build_tests": [True, False],
+        "build_benchmarks": [True, False],
+        "build_tools": [True, False],
+        "profile_locks": [True, False],
+        "rt_alloc_guard": [True, False],
     }
     default_options = {
         "shared": False,
@@ -22,6 +26,10 @@ class AfvNativeConan(ConanFile):
         "audio_library": "portaudio",
         "build_examples": False,
         "build_tests": False,
+        "build_benchmarks": False,
+        "build_tools": False,
+        "profile_locks": False,
+        "rt_alloc_guard": False,
         "*:shared": False,
         "*:fPIC": True,
         "libcurl:with_ssl": "openssl",
@@ -50,6 +58,8 @@ class AfvNativeConan(ConanFile):
         "include/*",
         "src/*",
         "test/*",
+        "benchmarks/*",
+        "tools/*",
         "CMakeLists.txt",
         "Doxyfile",
         "README.md",
@@ -80,6 +90,8 @@ class AfvNativeConan(ConanFile):
             self.build_requires("sdl2/[~2.0.9]@bincrafters/stable")
         if self.options.build_tests:
             self.build_requires("gtest/[~1.8.1]")
+        if self.options.build_benchmarks:
+            self.build_requires("benchmark/[~1.5.2]")
 
     def source(self):
         pass
@@ -89,6 +101,10 @@ class AfvNativeConan(ConanFile):
         cmake.configure(source_folder=".")
         cmake.definitions["AFV_NATIVE_AUDIO_LIBRARY"] = self.options.audio_library
         cmake.definitions["BUILD_EXAMPLES"] = self.options.build_examples
+        cmake.definitions["BUILD_BENCHMARKS"] = self.options.build_benchmarks
+        cmake.definitions["BUILD_TOOLS"] = self.options.build_tools
+        cmake.definitions["AFV_NATIVE_PROFILE_LOCKS"] = self.options.profile_locks
+        cmake.definitions["AFV_NATIVE_RT_ALLOC_GUARD"] = self.options.rt_alloc_guard
         return cmake
 
     def build(self):
@@ -103,3 +119,5 @@ class AfvNativeConan(ConanFile):
         self.cpp_info.libs = ["afv_native", "speexdsp"]
         if self.settings.compiler == 'Visual Studio':
             self.cpp_info.defines += ["_USE_MATH_DEFINES"]
+        if self.options.profile_locks:
+            self.cpp_info.defines += ["AFV_NATIVE_PROFILE_LOCKS"]
@@ -187,6 +187,11 @@ TestClient::drawFrame() {
                 mClient->setEnableOutputEffects(mOutputEffects);
             }
         }
+        if (ImGui::Checkbox("Narrowband Transmit", &mNarrowbandTx)) {
+            if (mClient) {
+                mClient->setEnableNarrowbandTx(mNarrowbandTx);
+            }
+        }
     }
     if (ImGui::CollapsingHeader("Client Position")) {
         ImGui::InputDouble("Latitude", &mClientLatitude);
@@ -264,6 +269,7 @@ TestClient::drawFrame() {
             mClient->setCallsign(mAFVCallsign);
             mClient->setEnableInputFilters(mInputFilter);
             mClient->setEnableOutputEffects(mOutputEffects);
+            mClient->setEnableNarrowbandTx(mNarrowbandTx);
             mClient->connect();
         }
     } else {
@@ -73,6 +73,7 @@ class TestClient
 
     bool mInputFilter = false;
     bool mOutputEffects = false;
+    bool mNarrowbandTx = false;
     float mPeak = 0.0f;
     float mVu = 0.0f;
 
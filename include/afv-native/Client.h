@@ -36,6 +36,7 @@
 
 #include "afv-native/afv/RadioSimulation.h"
 
+#include <atomic>
 #include <memory>
 #include <event2/event.h>
 
@@ -46,8 +47,12 @@
 #include "afv-native/afv/dto/Transceiver.h"
 #include "afv-native/audio/AudioDevice.h"
 #include "afv-native/event/EventCallbackTimer.h"
+#include "afv-native/event/EventLoopThread.h"
 #include "afv-native/http/EventTransferManager.h"
 #include "afv-native/http/RESTRequest.h"
+#include "afv-native/util/MpscQueue.h"
+#include "afv-native/util/ProfiledMutex.h"
+#include "afv-native/util/ThreadPolicy.h"
 
 namespace afv_native {
     /** Client provides a fully functional PilotClient that can be integrated into
@@ -67,8 +72,18 @@ namespace afv_native {
          * (It's used for some tear-down operations which must run to completion
          * after the client is shut-down if possible.)
          *
+         * Alternatively, pass nullptr for evBase, and the client runs its own
+         * event loop on a dedicated network thread.  Voice packets and timers
+         * are then serviced promptly no matter how often the host gets around
+         * to it, which suits hosts that only pump their event loop once a
+         * frame.  The public methods can still be called from the host's
+         * thread - the ones that touch the network state are queued to the
+         * network thread, and ClientEventCallback is only invoked from
+         * pollEvents().
+         *
          * @param evBase an initialised libevent event_base to register the client's
-         *      asynchronous IO and deferred operations against.
+         *      asynchronous IO and deferred operations against, or nullptr to
+         *      have the client run its own.
          * @param resourceBasePath A relative or absolute path to where the AFV-native
          *      resource files are located.
          * @param baseUrl The baseurl for the AFV API server to connect to.  The
@@ -157,6 +172,17 @@ namespace afv_native {
          */
         void setAudioApi(audio::AudioDevice::Api api);
 
+        /** set the length of the audio blocks exchanged with the audio device when next starting
+         * the audio system.
+         *
+         * Voice packets are always 20ms long, but the device can be run with shorter blocks
+         * (say, 10ms) to reduce the latency added by the device buffers on interfaces that can
+         * keep up.
+         *
+         * @param frameLengthMs the device block length in milliseconds.
+         */
+        void setAudioFrameLengthMs(unsigned int frameLengthMs);
+
         void setAudioInputDevice(std::string inputDevice);
         void setAudioOutputDevice(std::string outputDevice);
 
@@ -191,6 +217,15 @@ namespace afv_native {
         void setEnableInputFilters(bool enableInputFilters);
         void setEnableOutputEffects(bool enableEffects);
 
+        /** setEnableNarrowbandTx enables or disables the narrowband transmit path.
+         *
+         * When enabled, the microphone audio is downsampled to 16kHz before the input filters and voice codec
+         * are run, which substantially reduces the CPU used on the capture thread.  The voice packets sent are
+         * fully compatible with other clients either way.
+         */
+        void setEnableNarrowbandTx(bool enableNarrowband);
+        bool getEnableNarrowbandTx() const;
+
         /** ClientEventCallback provides notifications when certain client events occur.  These can be used to
          * provide feedback within the client itself without needing to poll Client's methods.
          *
@@ -202,6 +237,19 @@ namespace afv_native {
          */
         util::ChainedCallback<void(ClientEventType,void*)>  ClientEventCallback;
 
+        /** pollEvents invokes ClientEventCallback, on the calling thread, for every event queued by the network
+         * thread since the last call.
+         *
+         * This is only needed when the client runs its own network thread (see the constructor) - call it
+         * regularly, say once per frame.  Otherwise, events are delivered as they happen and this does nothing.
+         *
+         * @return the number of events delivered.
+         */
+        size_t pollEvents();
+
+        /** hasNetworkThread returns true if the client is running its own network thread. */
+        bool hasNetworkThread() const;
+
         /** getStationAliases returns a vector of all the known station aliases.
          *
          * @note this method uses a copy in place to prevent race inside the
@@ -219,6 +267,77 @@ namespace afv_native {
          */
         void logAudioStatistics();
 
+        /** setEnablePerformanceStats turns the per-stage audio latency histograms on or off.
+         *
+         * They're off by default.  Turning them off doesn't clear them.
+         */
+        void setEnablePerformanceStats(bool enable);
+
+        /** getPerformanceStats returns a snapshot of the per-stage audio latency histograms.
+         *
+         * This is safe to call from any thread, at any time.
+         */
+        afv::PerformanceStats getPerformanceStats() const;
+
+        void resetPerformanceStats();
+
+        /** setEnableAudioWatchdog turns the audio deadline watchdog on or off.
+         *
+         * While it's on, audio frames that take more than the threshold fraction (0.5 by default) of the frame
+         * period are recorded as incidents.  Each one is logged, and raised through ClientEventCallback as an
+         * AudioDeadline event from the event loop.
+         */
+        void setEnableAudioWatchdog(bool enable);
+        void setAudioWatchdogThreshold(float fraction);
+
+        /** getAudioIncidents returns the most recent audio deadline incidents, oldest first. */
+        std::vector<afv::AudioIncident> getAudioIncidents() const;
+
+        /** getChannelStatistics returns a snapshot of the voice channel's traffic and drop counters.
+         *
+         * The counters accumulate across reconnects until resetChannelStatistics() is called.
+         */
+        cryptodto::UDPChannelStats getChannelStatistics() const;
+        void resetChannelStatistics();
+
+        /** getStreamStatistics returns the counters for each incoming voice stream currently being tracked. */
+        std::vector<afv::VoiceStreamStats> getStreamStatistics() const;
+
+        /** enableRealtimeMemory moves the playback path's working memory (mixing buffers, decoders and
+         * incoming stream slots) into a block that's prefaulted and, where the OS allows, locked into memory,
+         * so that the audio thread doesn't take page faults - even after the client has been idle.
+         *
+         * Call it before the audio is started.  It can't be turned off again.  On Linux, locking is subject to
+         * RLIMIT_MEMLOCK - getRealtimeMemoryStats() reports whether it worked.
+         *
+         * @param streamSlots the number of simultaneous incoming voice streams to prepare for.
+         */
+        bool enableRealtimeMemory(unsigned int streamSlots = afv::defaultRealtimeStreamSlots);
+        afv::RealtimeMemoryStats getRealtimeMemoryStats() const;
+
+        /** setThreadPolicy sets the scheduling priority and CPU affinity for one class of the library's
+         * threads.
+         *
+         * The audio callbacks and the library's own threads apply it to themselves as they next run, so it can
+         * be changed whilst the audio is running.  Real-time scheduling usually needs privileges (on Linux,
+         * CAP_SYS_NICE or an RLIMIT_RTPRIO) - where it's refused, the thread falls back to elevated priority,
+         * then to leaving things alone.  getThreadPolicyStatus() reports what was actually achieved.
+         *
+         * The threads are also named ("afv-audio", "afv-log", ...) so they're easy to find in a debugger or
+         * profiler.
+         */
+        void setThreadPolicy(util::ThreadClass threadClass, const util::ThreadPolicy &policy);
+        util::ThreadPolicy getThreadPolicy(util::ThreadClass threadClass) const;
+        util::ThreadPolicyStatus getThreadPolicyStatus(util::ThreadClass threadClass) const;
+
+        /** getLockStatistics returns the contention counters for the library's audio-path locks.
+         *
+         * These are only collected when the library is built with AFV_NATIVE_PROFILE_LOCKS - otherwise this
+         * is always empty.
+         */
+        std::vector<util::LockStats> getLockStatistics() const;
+        void resetLockStatistics();
+
         std::shared_ptr<const afv::RadioSimulation> getRadioSimulation() const;
         std::shared_ptr<const audio::AudioDevice> getAudioDevice() const;
 
@@ -243,6 +362,30 @@ namespace afv_native {
             int mNextFreq;
         };
 
+        /** QueuedClientEvent is a ClientEventCallback notification on its way from the network thread to
+         * pollEvents(), with a copy of whatever its data pointed at.
+         */
+        struct QueuedClientEvent {
+            ClientEventType Type;
+            afv::APISessionError APIError;
+            afv::VoiceSessionError VoiceError;
+            int ChannelErrno;
+            afv::AudioIncident Incident;
+
+            explicit QueuedClientEvent(ClientEventType type = ClientEventType::APIServerConnected);
+
+            void *getData();
+        };
+
+        /** mNetworkThread is only set when the client runs its own event loop.  It has to be declared (and so
+         * constructed) before everything that attaches to mEvBase.
+         */
+        std::unique_ptr<event::EventLoopThread> mNetworkThread;
+        util::MpscQueue<QueuedClientEvent> mEventQueue;
+        /** mAPIConnected and mVoiceConnected mirror the session states for callers off the network thread. */
+        std::atomic<bool> mAPIConnected;
+        std::atomic<bool> mVoiceConnected;
+
         struct event_base *mEvBase;
         std::shared_ptr<afv::EffectResources> mFxRes;
 
@@ -279,13 +422,28 @@ namespace afv_native {
         void stopTransceiverUpdate();
 
         void aliasUpdateCallback();
+        void checkAudioIncidents();
+
+        /** deferToNetworkThread queues command to run on the network thread, if there is one and the caller
+         * isn't already on it.
+         *
+         * @return true if command was queued, in which case the caller should just return.
+         */
+        bool deferToNetworkThread(std::function<void()> command);
+        /** raiseEvent invokes ClientEventCallback immediately, or queues the event for pollEvents(). */
+        void raiseEvent(QueuedClientEvent event);
+        void publishConnectionState();
+        bool apiSessionUp() const;
     private:
         void unguardPtt();
     protected:
         event::EventCallbackTimer mTransceiverUpdateTimer;
+        event::EventCallbackTimer mAudioWatchdogTimer;
+        uint64_t mLastAudioIncident;
 
         std::string mClientName;
         audio::AudioDevice::Api mAudioApi;
+        unsigned int mAudioFrameLengthMs;
         std::string mAudioInputDeviceName;
         std::string mAudioOutputDeviceName;
     public:
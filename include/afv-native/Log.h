@@ -41,17 +41,140 @@
 #include <sstream>
 #include <ios>
 #include <iomanip>
+#include <atomic>
 #include "afv-native/Log.h"
 
-#define LOG(subsystem,...) ::afv_native::__Log(__FILE__, __LINE__, subsystem, __VA_ARGS__)
-#define LOGDUMPHEX(subsystem,buf,len) ::afv_native::__Dumphex(__FILE__,__LINE__, subsystem, buf, len)
+/* Log levels.  These must match the values of afv_native::LogLevel. */
+#define AFV_NATIVE_LOG_LEVEL_TRACE 0
+#define AFV_NATIVE_LOG_LEVEL_DEBUG 1
+#define AFV_NATIVE_LOG_LEVEL_INFO 2
+#define AFV_NATIVE_LOG_LEVEL_WARNING 3
+#define AFV_NATIVE_LOG_LEVEL_ERROR 4
+#define AFV_NATIVE_LOG_LEVEL_OFF 5
+
+/* AFV_NATIVE_LOG_MIN_LEVEL is the lowest level compiled in.  LOG calls below it expand to nothing, so their
+ * arguments aren't even evaluated.  Release builds drop trace and debug lines by default.
+ */
+#ifndef AFV_NATIVE_LOG_MIN_LEVEL
+# ifdef NDEBUG
+#  define AFV_NATIVE_LOG_MIN_LEVEL AFV_NATIVE_LOG_LEVEL_INFO
+# else
+#  define AFV_NATIVE_LOG_MIN_LEVEL AFV_NATIVE_LOG_LEVEL_TRACE
+# endif
+#endif
+
+#define AFV_NATIVE_LOG_AT(level,subsystem,...) \
+    do { \
+        if (::afv_native::isLogLevelEnabled(level)) { \
+            ::afv_native::__Log(__FILE__, __LINE__, subsystem, __VA_ARGS__); \
+        } \
+    } while (0)
+#define AFV_NATIVE_LOG_DISABLED() do {} while (0)
+
+#if AFV_NATIVE_LOG_MIN_LEVEL <= AFV_NATIVE_LOG_LEVEL_TRACE
+# define LOGTRACE(subsystem,...) AFV_NATIVE_LOG_AT(::afv_native::LogLevel::Trace, subsystem, __VA_ARGS__)
+#else
+# define LOGTRACE(subsystem,...) AFV_NATIVE_LOG_DISABLED()
+#endif
+#if AFV_NATIVE_LOG_MIN_LEVEL <= AFV_NATIVE_LOG_LEVEL_DEBUG
+# define LOGDEBUG(subsystem,...) AFV_NATIVE_LOG_AT(::afv_native::LogLevel::Debug, subsystem, __VA_ARGS__)
+# define LOGDUMPHEX(subsystem,buf,len) \
+    do { \
+        if (::afv_native::isLogLevelEnabled(::afv_native::LogLevel::Debug)) { \
+            ::afv_native::__Dumphex(__FILE__,__LINE__, subsystem, buf, len); \
+        } \
+    } while (0)
+#else
+# define LOGDEBUG(subsystem,...) AFV_NATIVE_LOG_DISABLED()
+# define LOGDUMPHEX(subsystem,buf,len) AFV_NATIVE_LOG_DISABLED()
+#endif
+#if AFV_NATIVE_LOG_MIN_LEVEL <= AFV_NATIVE_LOG_LEVEL_INFO
+# define LOGINFO(subsystem,...) AFV_NATIVE_LOG_AT(::afv_native::LogLevel::Info, subsystem, __VA_ARGS__)
+#else
+# define LOGINFO(subsystem,...) AFV_NATIVE_LOG_DISABLED()
+#endif
+#if AFV_NATIVE_LOG_MIN_LEVEL <= AFV_NATIVE_LOG_LEVEL_WARNING
+# define LOGWARN(subsystem,...) AFV_NATIVE_LOG_AT(::afv_native::LogLevel::Warning, subsystem, __VA_ARGS__)
+#else
+# define LOGWARN(subsystem,...) AFV_NATIVE_LOG_DISABLED()
+#endif
+#if AFV_NATIVE_LOG_MIN_LEVEL <= AFV_NATIVE_LOG_LEVEL_ERROR
+# define LOGERROR(subsystem,...) AFV_NATIVE_LOG_AT(::afv_native::LogLevel::Error, subsystem, __VA_ARGS__)
+#else
+# define LOGERROR(subsystem,...) AFV_NATIVE_LOG_DISABLED()
+#endif
+
+/* LOG logs at Info level. */
+#define LOG(subsystem,...) LOGINFO(subsystem, __VA_ARGS__)
 
 namespace afv_native {
+    enum class LogLevel: int {
+        Trace = AFV_NATIVE_LOG_LEVEL_TRACE,
+        Debug = AFV_NATIVE_LOG_LEVEL_DEBUG,
+        Info = AFV_NATIVE_LOG_LEVEL_INFO,
+        Warning = AFV_NATIVE_LOG_LEVEL_WARNING,
+        Error = AFV_NATIVE_LOG_LEVEL_ERROR,
+        Off = AFV_NATIVE_LOG_LEVEL_OFF,
+    };
+
+    extern std::atomic<LogLevel> __LogThreshold;
+
+    /** isLogLevelEnabled returns true if lines at level will be logged.  LOG calls check this before
+     * formatting anything.
+     */
+    inline bool isLogLevelEnabled(LogLevel level)
+    {
+        return level >= __LogThreshold.load(std::memory_order_relaxed);
+    }
+
+    /** setLogLevel sets the lowest level that will be logged at runtime.  The default is Info.
+     *
+     * This can't bring back lines removed at compile time by AFV_NATIVE_LOG_MIN_LEVEL.
+     */
+    void setLogLevel(LogLevel level);
+    LogLevel getLogLevel();
+
     typedef void (*log_fn)(const char *subsystem, const char *file, int line, const char *lineOut);
 
     void __Log(const char *file, int line, const char *subsystem, const char *format, ...);
+
+    /** setLogger replaces the function log lines are delivered to.  nullptr disables logging entirely.
+     *
+     * When asynchronous logging is enabled (the default), the logger is only ever called from the library's
+     * log writer thread, never from the thread that logged the line.
+     */
     void setLogger(afv_native::log_fn newLogger);
     void __Dumphex(const char *file, int line, const char *subsystem, const void *buf, size_t len);
+
+    /** setLogAsynchronous selects between the asynchronous and synchronous log paths.
+     *
+     * Asynchronous logging (the default) formats each line into a fixed-size record in a per-thread
+     * lock-free ring, which a background writer thread drains in batches.  Logging from an audio callback then
+     * costs one bounded, allocation-free format and copy.  Lines longer than logRecordTextSize are truncated,
+     * and if a thread's ring fills up, further lines are dropped (and the drop is reported) until the writer
+     * catches up.  Repeated lines from the same LOG() call are also rate limited.
+     *
+     * Synchronous logging calls the logger directly from the logging thread, with no truncation or rate
+     * limiting.
+     *
+     * Switching modes flushes any pending asynchronous output first.
+     */
+    void setLogAsynchronous(bool async);
+
+    /** prepareRealtimeLogging starts the asynchronous log backend if it isn't already running.
+     *
+     * Real-time threads (those inside a util::RealtimeScope) never allocate their own log ring.  The first time
+     * one logs, it adopts a spare that the backend keeps ready, and the writer thread replaces the spare.  Until
+     * the backend is started, or if it runs out of spares, lines from real-time threads are dropped and
+     * counted.  Audio devices call this from open(), before their callbacks start.
+     */
+    void prepareRealtimeLogging();
+
+    /** flushLog blocks until every line logged before the call has been delivered to the logger. */
+    void flushLog();
+
+    /** logRecordTextSize is the longest line (including the terminator) the asynchronous path will carry. */
+    const size_t logRecordTextSize = 256;
 }
 
 #endif //AFV_NATIVE_LOG_H
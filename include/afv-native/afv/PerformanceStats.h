@@ -0,0 +1,202 @@
+/* afv/PerformanceStats.h
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef AFV_NATIVE_PERFORMANCESTATS_H
+#define AFV_NATIVE_PERFORMANCESTATS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "afv-native/util/LatencyHistogram.h"
+
+namespace afv_native {
+    namespace afv {
+        /** PerformanceStage identifies one of the timed stages of the audio pipeline. */
+        enum class PerformanceStage {
+            /** waiting for the incoming stream map lock before rendering. */
+            RxLockWait = 0,
+            /** pulling decoded frames from every active incoming stream. */
+            RxDecode,
+            /** summing the streams audible on one radio (recorded per radio). */
+            RxMix,
+            /** the VHF bandwidth simulation on one radio (recorded per radio). */
+            RxVhfFilter,
+            /** crackle, noise, block tone and click on one radio (recorded per radio). */
+            RxEffects,
+            /** copying the finished mix out to the audio device. */
+            RxOutput,
+            /** the whole of one output frame, including all of the above except the lock wait. */
+            RxFrame,
+            /** the speex input preprocessor. */
+            TxPreprocess,
+            /** Opus encoding. */
+            TxEncode,
+            /** packing and encrypting the voice DTO. */
+            TxEncapsulate,
+            /** handing the datagram to the socket. */
+            TxSend,
+            /** the whole of one input frame, including all of the transmit stages. */
+            TxFrame,
+
+            Count
+        };
+
+        const size_t performanceStageCount = static_cast<size_t>(PerformanceStage::Count);
+
+        /** getPerformanceStageName returns a short, printable name for the stage. */
+        const char *getPerformanceStageName(PerformanceStage stage);
+
+        /** isTransmitStage returns true if the stage is part of the capture/transmit path. */
+        inline bool isTransmitStage(PerformanceStage stage)
+        {
+            return stage >= PerformanceStage::TxPreprocess;
+        }
+
+        /** AudioIncident describes one audio frame that came close to, or overran, its deadline. */
+        struct AudioIncident {
+            /** Sequence numbers incidents from 1, in the order they were recorded. */
+            uint64_t Sequence;
+            /** Transmit is true for a capture frame, false for a playback frame. */
+            bool Transmit;
+            /** Overrun is true if the frame took longer than its budget, not merely close to it. */
+            bool Overrun;
+            uint32_t FrameUs;
+            uint32_t BudgetUs;
+            /** SlowestStage is the stage (including lock waits) that took the most time in this frame. */
+            PerformanceStage SlowestStage;
+            /** StageUs holds the time spent in each stage during this frame. */
+            uint32_t StageUs[performanceStageCount];
+            /** ActiveStreams is the number of incoming streams being decoded at the time. */
+            uint32_t ActiveStreams;
+            /** ActiveRadios is the number of radios with audible streams at the time. */
+            uint32_t ActiveRadios;
+
+            AudioIncident();
+
+            uint32_t getStageUs(PerformanceStage stage) const
+            {
+                return StageUs[static_cast<size_t>(stage)];
+            }
+        };
+
+        /** PerformanceStats is a snapshot of the per-stage latency histograms. */
+        struct PerformanceStats {
+            bool Enabled;
+            util::LatencyHistogramSnapshot Stages[performanceStageCount];
+
+            PerformanceStats();
+
+            const util::LatencyHistogramSnapshot &getStage(PerformanceStage stage) const
+            {
+                return Stages[static_cast<size_t>(stage)];
+            }
+        };
+
+        /** PerformanceMonitor owns the latency histograms for each stage of the pipeline, and the audio deadline
+         * watchdog.
+         *
+         * Both are off by default.  When they're off, each instrumented stage costs one relaxed atomic load.
+         *
+         * The watchdog checks the time taken by each audio frame against the frame period.  Frames that take
+         * more than the threshold fraction of their budget are recorded as AudioIncidents, along with how long
+         * each stage took, in a small ring of recent incidents.  The watchdog needs the stages timed, so while
+         * it's on the histograms record too, even if stats are off.
+         */
+        class PerformanceMonitor {
+        public:
+            static const size_t incidentRingSize = 32;
+
+            PerformanceMonitor();
+
+            PerformanceMonitor(const PerformanceMonitor &copySrc) = delete;
+
+            void setEnabled(bool enabled);
+            bool isEnabled() const;
+
+            void setWatchdogEnabled(bool enabled);
+            bool isWatchdogEnabled() const
+            {
+                return mWatchdogEnabled.load(std::memory_order_relaxed);
+            }
+
+            /** setWatchdogThreshold sets the fraction of the frame budget above which a frame is reported.
+             * The default is 0.5.
+             */
+            void setWatchdogThreshold(float fraction);
+
+            /** checkFrame is called by the audio threads at the end of each frame.
+             *
+             * It collects the time each stage in that direction spent during the frame, and records an incident
+             * if the frame ran too long.  It never blocks - if the incident ring is busy, the incident is lost.
+             */
+            void checkFrame(
+                    bool transmit,
+                    uint32_t frameUs,
+                    uint32_t budgetUs,
+                    uint32_t activeStreams,
+                    uint32_t activeRadios);
+
+            /** getIncidents returns the incidents still in the ring with a Sequence greater than afterSequence,
+             * oldest first.
+             */
+            std::vector<AudioIncident> getIncidents(uint64_t afterSequence = 0) const;
+
+            util::LatencyHistogram *getHistogram(PerformanceStage stage)
+            {
+                return &mStages[static_cast<size_t>(stage)];
+            }
+
+            PerformanceStats snapshot() const;
+
+            void reset();
+
+        protected:
+            util::LatencyHistogram mStages[performanceStageCount];
+
+            std::atomic<bool> mStatsEnabled;
+            std::atomic<bool> mWatchdogEnabled;
+            std::atomic<float> mWatchdogThreshold;
+
+            mutable std::mutex mIncidentLock;
+            AudioIncident mIncidents[incidentRingSize];
+            uint64_t mIncidentCount;
+
+            void _update_histograms_enabled();
+        };
+    }
+}
+
+#endif //AFV_NATIVE_PERFORMANCESTATS_H
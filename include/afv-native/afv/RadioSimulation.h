@@ -39,10 +39,13 @@
 
 #include "afv-native/utility.h"
 #include "afv-native/afv/EffectResources.h"
+#include "afv-native/afv/PerformanceStats.h"
 #include "afv-native/afv/RemoteVoiceSource.h"
 #include "afv-native/afv/RollingAverage.h"
 #include "afv-native/afv/VoiceCompressionSink.h"
 #include "afv-native/afv/dto/voice_server/AudioRxOnTransceivers.h"
+#include "afv-native/afv/dto/voice_server/AudioTxOnTransceivers.h"
+#include "afv-native/audio/DecimatingSink.h"
 #include "afv-native/audio/ISampleSink.h"
 #include "afv-native/audio/ISampleSource.h"
 #include "afv-native/audio/OutputMixer.h"
@@ -52,13 +55,35 @@
 #include "afv-native/audio/VHFFilterSource.h"
 #include "afv-native/cryptodto/UDPChannel.h"
 #include "afv-native/event/EventCallbackTimer.h"
+#include "afv-native/util/ProfiledMutex.h"
+#include "afv-native/util/RcuPointer.h"
+#include "afv-native/util/RealtimeArena.h"
+#include "afv-native/util/SeqLock.h"
 
 namespace afv_native {
     namespace afv {
 
+        /** RadioConfig is the user-controlled configuration for each radio within a RadioSimulation.
+         *
+         * It's published to the audio threads via a SeqLock so that changing it never blocks them.
+         */
+        struct RadioConfig {
+            unsigned int Frequency;
+            float Gain;
+            bool BypassEffects;
+        };
+
+        /** TxConfig is the user-controlled transmit configuration, published in the same way as RadioConfig. */
+        struct TxConfig {
+            bool Ptt;
+            unsigned int TxRadio;
+        };
+
         /** RadioState is the internal state object for each radio within a RadioSimulation.
          *
-         * It tracks the current playback position of the mixing effects, the channel frequency and gain.
+         * It tracks the current playback position of the mixing effects, and the channel frequency and gain
+         * the playback thread is currently using.  Apart from mLastRxCount, it's only ever touched by the
+         * playback thread.
          */
         class RadioState {
         public:
@@ -68,8 +93,16 @@ namespace afv_native {
             std::shared_ptr<audio::PinkNoiseGenerator> WhiteNoise;
             std::shared_ptr<audio::RecordedSampleSource> Crackle;
             std::shared_ptr<audio::SineToneSource> BlockTone;
+            /** The effect sources are created once, up front, so that starting an effect doesn't allocate on
+             * the playback thread.  Click, WhiteNoise, Crackle and BlockTone point at these whilst the effect
+             * is playing, and are empty otherwise.
+             */
+            std::shared_ptr<audio::RecordedSampleSource> mClickSource;
+            std::shared_ptr<audio::PinkNoiseGenerator> mWhiteNoiseSource;
+            std::shared_ptr<audio::RecordedSampleSource> mCrackleSource;
+            std::shared_ptr<audio::SineToneSource> mBlockToneSource;
             audio::VHFFilterSource vhfFilter;
-            int mLastRxCount;
+            std::atomic<int> mLastRxCount;
             bool mBypassEffects;
         };
 
@@ -77,11 +110,40 @@ namespace afv_native {
          *
          * It's used to hold the RemoteVoiceSource object for that callsign+channel combination,
          * and the list of transceivers that this packet stream relates to.
+         *
+         * sampleCache holds the stream's decoded samples for the frame currently being mixed so
+         * that each radio can mix it in without decoding it again.  It points into sampleCacheStorage,
+         * or into the real-time arena for pooled slots.
+         *
+         * pooled is set on the stream slots created by RadioSimulation::enableRealtimeMemory, which are
+         * recycled rather than destroyed when their stream goes away.
          */
         struct CallsignMeta {
             std::shared_ptr<RemoteVoiceSource> source;
             std::vector<dto::RxTransceiver> transceivers;
+            std::unique_ptr<audio::SampleType[]> sampleCacheStorage;
+            audio::SampleType *sampleCache;
+            bool sampleCacheValid;
+            bool pooled;
             CallsignMeta();
+            CallsignMeta(std::shared_ptr<RemoteVoiceSource> pooledSource, audio::SampleType *pooledSampleCache);
+        };
+
+        /** defaultRealtimeStreamSlots is the number of incoming streams enableRealtimeMemory prepares for. */
+        const unsigned int defaultRealtimeStreamSlots = 16;
+
+        /** RealtimeMemoryStats reports on RadioSimulation's real-time memory mode. */
+        struct RealtimeMemoryStats {
+            bool Enabled;
+            util::RealtimeArenaStats Arena;
+            uint32_t StreamSlots;
+            uint32_t StreamSlotsFree;
+            /** StreamSlotMisses counts the streams that turned up when every slot was in use, and so were
+             * allocated from the heap as usual.
+             */
+            uint64_t StreamSlotMisses;
+
+            RealtimeMemoryStats();
         };
 
         /** RadioSimulation provides the foundation for handling radio channels and mixing them
@@ -131,8 +193,61 @@ namespace afv_native {
 
             void setEnableOutputEffects(bool enableEffects);
 
+            bool getEnableNarrowbandTx() const;
+            /** setEnableNarrowbandTx switches the transmit path between full-rate and narrowband operation.
+             *
+             * In narrowband mode the microphone input is decimated to narrowbandSampleRateHz before it's
+             * preprocessed and encoded.  The resulting voice packets are still valid for any opus decoder, so
+             * this is invisible to the other clients.
+             */
+            void setEnableNarrowbandTx(bool enableNarrowband);
+
+            /** getPerformanceStats returns a snapshot of the per-stage latency histograms. */
+            PerformanceStats getPerformanceStats() const;
+            /** setEnablePerformanceStats turns the per-stage latency histograms on or off.
+             *
+             * They're off by default - while off, the instrumentation costs next to nothing.
+             */
+            void setEnablePerformanceStats(bool enable);
+            void resetPerformanceStats();
+
+            /** setEnableAudioWatchdog turns the audio deadline watchdog on or off.
+             *
+             * While it's on, any playback or capture frame taking more than the threshold fraction of the frame
+             * period is recorded, with the time spent in each stage, as an AudioIncident.
+             */
+            void setEnableAudioWatchdog(bool enable);
+            void setAudioWatchdogThreshold(float fraction);
+
+            /** getAudioIncidents returns the recent incidents with a Sequence after afterSequence, oldest
+             * first.
+             */
+            std::vector<AudioIncident> getAudioIncidents(uint64_t afterSequence = 0) const;
+
+            /** getStreamStatistics returns the counters for each incoming voice stream we're currently tracking.
+             *
+             * Streams are forgotten (along with their counters) once they've been idle for
+             * compressedSourceCacheTimeoutMs.
+             */
+            std::vector<VoiceStreamStats> getStreamStatistics() const;
+
+            /** enableRealtimeMemory moves the playback path's working memory into a RealtimeArena, which is
+             * prefaulted and, where the OS allows it, locked into memory.
+             *
+             * The mixing buffers and streamSlots pooled incoming stream slots (each with its decoder state) are
+             * allocated from the arena, and the effect samples, per-radio state and the slots' sample caches are
+             * locked where they are.  Streams beyond streamSlots still work, but are allocated normally.
+             *
+             * This is meant to be done once, before the audio is started, and can't be undone.
+             *
+             * @return true if real-time memory is now enabled.
+             */
+            bool enableRealtimeMemory(unsigned int streamSlots = defaultRealtimeStreamSlots);
+            RealtimeMemoryStats getRealtimeMemoryStats() const;
+
             void putAudioFrame(const audio::SampleType *bufferIn) override;
             audio::SourceStatus getAudioFrame(audio::SampleType *bufferOut) override;
+            audio::SourceStatus getAudioFrames(audio::SampleType *bufferOut, size_t nFrames) override;
 
             /** Contains the number of IncomingAudioStreams known to the simulation stack */
             std::atomic<uint32_t> IncomingAudioStreams;
@@ -159,13 +274,29 @@ namespace afv_native {
             cryptodto::UDPChannel *mChannel;
             std::string mCallsign;
 
-            std::mutex mStreamMapLock;
+            mutable util::ProfiledMutex mStreamMapLock;
             std::unordered_map<std::string, struct CallsignMeta> mIncomingStreams;
 
-            std::mutex mRadioStateLock;
-            std::atomic<bool> mPtt;
-            bool mLastFramePtt;
-            unsigned int mTxRadio;
+            /** mArena is only set once enableRealtimeMemory has been called.  mSpareStreams holds the pooled
+             * stream slots that aren't in use.  It and mStreamSlotMisses are protected by mStreamMapLock.
+             *
+             * mArenaRegions are the blocks of our memory (rather than the arena's) that we locked with it, which
+             * we unlock again before they're freed.
+             */
+            std::shared_ptr<util::RealtimeArena> mArena;
+            std::vector<std::pair<const void *, size_t>> mArenaRegions;
+            std::vector<CallsignMeta> mSpareStreams;
+            unsigned int mStreamSlots;
+            uint64_t mStreamSlotMisses;
+
+            /** mTxConfig and mRadioConfig hold the configuration set via the public API.  The audio threads
+             * take a snapshot of these as they need them and never wait on the UI.
+             */
+            util::SeqLock<TxConfig> mTxConfig;
+            std::vector<util::SeqLock<RadioConfig>> mRadioConfig;
+
+            /** mLastFramePtt is only used by the capture thread. */
+            std::atomic<bool> mLastFramePtt;
             std::atomic<uint32_t> mTxSequence;
             std::vector<RadioState> mRadioState;
 
@@ -181,19 +312,41 @@ namespace afv_native {
 
             audio::SampleType *mFetchBuffer;
 
-            std::shared_ptr<VoiceCompressionSink> mVoiceSink;
-            std::shared_ptr<audio::SpeexPreprocessor> mVoiceFilter;
+            /** TxChain is one complete transmit chain.
+             *
+             * Changing the transmit options builds a whole new chain and publishes it through mTxChain, so the
+             * capture thread never waits for a chain to be rebuilt, nor frees the old one.
+             */
+            struct TxChain {
+                std::shared_ptr<VoiceCompressionSink> VoiceSink;
+                std::shared_ptr<audio::SpeexPreprocessor> VoiceFilter;
+                std::shared_ptr<audio::DecimatingSink> Decimator;
+                /** Head is the sink that receives the microphone audio. */
+                std::shared_ptr<audio::ISampleSink> Head;
+            };
+
+            /** mTxChainLock serialises rebuilding the transmit chain.  The capture thread never takes it. */
+            util::ProfiledMutex mTxChainLock;
+            util::RcuPointer<TxChain> mTxChain;
+            std::atomic<bool> mTxInputFilters;
+            std::atomic<bool> mTxNarrowband;
+            /** mTxDto is reused for every outgoing voice packet so that, once it's grown, sending doesn't need
+             * to allocate.  It's only touched by the transmit chain, on the capture thread.
+             */
+            dto::AudioTxOnTransceivers mTxDto;
 
             event::EventCallbackTimer mMaintenanceTimer;
             RollingAverage<double> mVuMeter;
 
+            PerformanceMonitor mPerformance;
+
             void resetRadioFx(unsigned int radio, bool except_click = false);
 
             void set_radio_effects(size_t rxIter, float crackleGain, float &whiteNoiseGain);
 
             bool mix_effect(std::shared_ptr<audio::ISampleSource> effect, float gain);
 
-            void processCompressedFrame(std::vector<unsigned char> compressedData) override;
+            void processCompressedFrame(const std::vector<unsigned char> &compressedData) override;
 
             static void dtoHandler(
                     const std::string &dtoName, const unsigned char *bufIn, size_t bufLen, void *user_data);
@@ -202,10 +355,21 @@ namespace afv_native {
 
             void maintainIncomingStreams();
         private:
-            bool _process_radio(
-                    const std::map<void *, audio::SampleType[audio::frameSizeSamples]> &sampleCache,
-                    std::map<void *, audio::SampleType[audio::frameSizeSamples]> &eqSampleCache,
-                    size_t rxIter);
+            /** _build_tx_chain builds a new transmit chain for the current options.  mTxChainLock must be held. */
+            std::shared_ptr<TxChain> _build_tx_chain();
+            uint32_t _count_active_radios() const;
+
+            /** _new_stream returns a spare pooled stream slot if there is one, or a fresh CallsignMeta if not.
+             * mStreamMapLock must be held.
+             */
+            CallsignMeta _new_stream();
+            /** _release_stream returns a pooled stream slot to the spares.  mStreamMapLock must be held. */
+            void _release_stream(CallsignMeta &stream);
+
+            /** _mix_frame renders a single output frame.  mStreamMapLock must be held. */
+            void _mix_frame(audio::SampleType *bufferOut);
+
+            bool _process_radio(size_t rxIter, const TxConfig &txConfig);
 
             /** mix_buffers is a utility function that mixes two buffers of audio together.  The src_dst
              * buffer is assumed to be the final output buffer and is modified by the mixing in place.
@@ -34,7 +34,10 @@
 #ifndef AFV_NATIVE_REMOTEVOICESOURCE_H
 #define AFV_NATIVE_REMOTEVOICESOURCE_H
 
+#include <atomic>
+#include <memory>
 #include <mutex>
+#include <string>
 #include <opus/opus.h>
 
 #include "afv-native/afv/dto/interfaces/IAudio.h"
@@ -42,6 +45,8 @@
 #include "afv-native/audio/ISampleSource.h"
 #include "afv-native/audio/SourceStatus.h"
 #include "afv-native/util/monotime.h"
+#include "afv-native/util/ProfiledMutex.h"
+#include "afv-native/util/RealtimeArena.h"
 
 /* From speexdsp - so we don't need the header.  (we handle the pointer opaquely here) */
 /* Generic adaptive jitter buffer state */
@@ -57,6 +62,24 @@ namespace afv_native {
          */
         const int frameTimeOut = 10;
 
+        /** VoiceStreamStats is a snapshot of the counters for a single incoming voice stream. */
+        struct VoiceStreamStats {
+            /** Callsign is the stream's callsign - it's only filled in by RadioSimulation. */
+            std::string Callsign;
+            uint64_t PacketsReceived;
+            uint64_t BytesReceived;
+            uint64_t FramesDecoded;
+            /** FramesConcealed counts frames where the packet hadn't arrived in time, so the codec's loss
+             * concealment filled in.
+             */
+            uint64_t FramesConcealed;
+            /** FramesSilenced counts frames the jitter buffer asked to be padded with silence. */
+            uint64_t FramesSilenced;
+            uint64_t DecodeErrors;
+
+            VoiceStreamStats();
+        };
+
         /** RemoveVoiceSource takes a stream of IAudio DTOs and stores them in an appropriately tuned jitterbuffer.
          *
          * These can then be demand polled by a consumer which will pull the packets from the jitterBuffer and run them
@@ -69,8 +92,11 @@ namespace afv_native {
         protected:
             JitterBuffer *mJitterBuffer;
             OpusDecoder *mDecoder;
+            /** mArena, if set, holds the decoder state (and is kept alive for it). */
+            std::shared_ptr<util::RealtimeArena> mArena;
+            bool mDecoderInArena;
 
-            std::mutex mJitterBufferMutex;
+            util::ProfiledMutex mJitterBufferMutex;
             bool mIsActive;
             util::monotime_t mLastActive;
         protected:
@@ -79,8 +105,16 @@ namespace afv_native {
             int mCurrentFrame;
             bool mEnding;
             int mEndingSequence;
+
+            std::atomic<uint64_t> mPacketsReceived;
+            std::atomic<uint64_t> mBytesReceived;
+            std::atomic<uint64_t> mFramesDecoded;
+            std::atomic<uint64_t> mFramesConcealed;
+            std::atomic<uint64_t> mFramesSilenced;
+            std::atomic<uint64_t> mDecodeErrors;
         public:
-            RemoteVoiceSource();
+            /** @param arena if not null, the decoder state is allocated from this arena rather than the heap. */
+            explicit RemoteVoiceSource(std::shared_ptr<util::RealtimeArena> arena = nullptr);
             virtual ~RemoteVoiceSource();
             RemoteVoiceSource(const RemoteVoiceSource &copySrc) = delete;
 
@@ -93,7 +127,15 @@ namespace afv_native {
              * jitter buffered packets.
              */
             void flush();
+
+            /** reset returns the source to the state it was created in, counters included, so that it can be
+             * reused for a new stream.
+             */
+            void reset();
             bool isActive() const;
+
+            /** getStatistics returns a snapshot of this stream's counters.  Safe to call from any thread. */
+            VoiceStreamStats getStatistics() const;
         };
     }
 }
@@ -38,28 +38,49 @@
 #include <vector>
 
 #include "afv-native/audio/ISampleSink.h"
+#include "afv-native/audio/audio_params.h"
+#include "afv-native/util/LatencyHistogram.h"
 
 namespace afv_native {
     namespace afv {
         class ICompressedFrameSink {
         public:
-            virtual void processCompressedFrame(std::vector<unsigned char> compressedData) = 0;
+            /** processCompressedFrame is called with each encoded frame.  compressedData belongs to the
+             * encoder and is reused for the next frame, so copy it if it needs to be kept.
+             */
+            virtual void processCompressedFrame(const std::vector<unsigned char> &compressedData) = 0;
         };
 
         /** VoiceCompressionSink is an SampleSink that accepts samples from an origin and
          * encodes them via opus, and hands them to the next layer in the mess.
+         *
+         * The encoder can be run at a reduced sample rate (see narrowbandSampleRateHz) - opus packets are
+         * decodable at any rate, so this doesn't change what goes over the wire.
          */
         class VoiceCompressionSink: public audio::ISampleSink {
         protected:
             OpusEncoder *mEncoder;
             ICompressedFrameSink &mCompressedFrameSink;
+            int mSampleRate;
+            int mFrameSizeSamples;
+            util::LatencyHistogram *mLatency;
+            /** mOutBuffer holds the frame being handed to mCompressedFrameSink.  It's kept between frames so
+             * that encoding doesn't allocate.
+             */
+            std::vector<unsigned char> mOutBuffer;
         public:
-            VoiceCompressionSink(ICompressedFrameSink &sink);
+            explicit VoiceCompressionSink(ICompressedFrameSink &sink, int sampleRate = audio::sampleRateHz);
             virtual ~VoiceCompressionSink();
             int open();
             void close();
             void reset();
+            int getSampleRate() const;
             void putAudioFrame(const audio::SampleType *bufferIn) override;
+
+            /** setLatencyHistogram sets the histogram the encoding time is recorded into (excluding the
+             * compressed frame sink), or nullptr to not record it.
+             */
+            void setLatencyHistogram(util::LatencyHistogram *histogram);
         };
     }
 }
@@ -82,6 +82,7 @@ namespace afv_native {
                     const std::vector<dto::Transceiver> &txDto,
                     std::function<void(http::Request *, bool)> callback);
             cryptodto::UDPChannel & getUDPChannel();
+            const cryptodto::UDPChannel & getUDPChannel() const;
 
             VoiceSessionError getLastError() const;
 
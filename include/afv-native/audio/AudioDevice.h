@@ -43,6 +43,8 @@
 
 #include "afv-native/audio/ISampleSink.h"
 #include "afv-native/audio/ISampleSource.h"
+#include "afv-native/audio/audio_params.h"
+#include "afv-native/util/RcuPointer.h"
 
 namespace afv_native {
     namespace audio {
@@ -52,19 +54,66 @@ namespace afv_native {
          *
          * The actual audio device drivers extend this abstract class and implement
          * the constructor and device probe functions as necessary.
+         *
+         * The device can run with a shorter (or longer) block length than the
+         * network frame length to reduce the amount of audio buffered by the
+         * hardware.  In that case, the source and sink are wrapped in the frame
+         * size adjusters when they're set so that the rest of the audio pipeline
+         * still only ever sees whole frames.
+         *
+         * Similarly, if the driver runs the hardware at a rate other than
+         * sampleRateHz, the source and sink are wrapped in resamplers.  As the
+         * driver may not know the rate until it opens the device, it reports it
+         * via setDeviceSampleRates(), which rebuilds the wrappers as required.
+         *
+         * The source and sink are handed to the audio callbacks through
+         * RcuPointers, so the callbacks never take a lock, and replaced sources
+         * and sinks are always released on the thread that replaced them rather
+         * than in the callback.  If a source fails, the callback only unpublishes
+         * it.
          */
         class AudioDevice {
         protected:
-            std::shared_ptr<ISampleSink> mSink;
-            std::mutex mSinkPtrLock;
-            std::shared_ptr<ISampleSource> mSource;
-            std::mutex mSourcePtrLock;
+            util::RcuPointer<ISampleSink> mSink;
+            util::RcuPointer<ISampleSource> mSource;
+
+            /** the length of each block we exchange with the hardware, in milliseconds. */
+            const unsigned int mDeviceFrameLengthMs;
+
+            /** the sample rates the hardware is running at.  These are sampleRateHz until the driver says
+             * otherwise.
+             */
+            unsigned int mInputSampleRate;
+            unsigned int mOutputSampleRate;
 
+            /** the number of samples in each block we exchange with the hardware, at the hardware's rates. */
+            unsigned int mInputFrameSizeSamples;
+            unsigned int mOutputFrameSizeSamples;
 
             /** Ensures data within the abstract is zeroed.   Should always be called via
              * the initialiser chain of any subclasses.
+             *
+             * @param deviceFrameLengthMs the length of the blocks to exchange with the
+             *      hardware in milliseconds.
+             */
+            explicit AudioDevice(unsigned int deviceFrameLengthMs = frameLengthMs);
+
+            /** setDeviceSampleRates is used by the driver to report the rates the hardware is actually
+             * running at.  It updates the device frame sizes and rebuilds the source and sink adapters.
+             *
+             * Must only be called while the streams are stopped.
              */
-            AudioDevice();
+            void setDeviceSampleRates(unsigned int inputSampleRate, unsigned int outputSampleRate);
+
+        private:
+            /** mClientLock protects the unadapted source and sink.  It's never taken by the audio callbacks. */
+            std::mutex mClientLock;
+            std::shared_ptr<ISampleSource> mClientSource;
+            std::shared_ptr<ISampleSink> mClientSink;
+
+            /** adaptSource/adaptSink wrap a source or sink as needed to match the hardware's rates and block sizes. */
+            std::shared_ptr<ISampleSource> adaptSource(std::shared_ptr<ISampleSource> src) const;
+            std::shared_ptr<ISampleSink> adaptSink(std::shared_ptr<ISampleSink> sink) const;
 
         public:
             /** Abstract API ID type - it is up to the implementing driver to ensure that
@@ -75,6 +124,15 @@ namespace afv_native {
              */
             typedef unsigned int Api;
 
+            /** NullApi and FileApi select the NullAudioDevice and FileAudioDevice, which have no hardware
+             * behind them.  They're available whichever audio library we're built with.
+             *
+             * With FileApi, the input and output device ids are the names of the WAVE files to read the input
+             * from and write the output to.
+             */
+            static const Api NullApi = 0x10000;
+            static const Api FileApi = 0x10001;
+
             /** DeviceInfo is a uniform structure by which API implementations can return
              * information about known devices.  The "id" value should be used as an
              * argument to the constructor of the driver instance to set the desired device.
@@ -102,7 +160,9 @@ namespace afv_native {
 
             /** setSource sets the ISampleSource for this AudioDevice.
              *
-             * Any existing source will have it's pointer released.
+             * Any existing source will have it's pointer released once the audio
+             * callback has stopped using it.  This may block for up to a callback's
+             * duration, so don't call it from the audio callback itself.
              *
              * This can be set to the invalid/empty pointer to disable the source, in which
              * case the device should output silence.
@@ -113,7 +173,8 @@ namespace afv_native {
 
             /** setSink sets the ISampleSink for this AudioDevice.
              *
-             * Any existing sink will have its pointer released.
+             * Any existing sink will have its pointer released once the audio
+             * callback has stopped using it, as per setSource.
              *
              * This can be set to the invalid/empty pointer to disable the sink, in which
              * case the device should simply discard any samples received from the hardware.
@@ -122,6 +183,18 @@ namespace afv_native {
              */
             virtual void setSink(std::shared_ptr<ISampleSink> newSink);
 
+            /** getInputSampleRate/getOutputSampleRate return the rates the hardware
+             * is running at.
+             */
+            unsigned int getInputSampleRate() const;
+            unsigned int getOutputSampleRate() const;
+
+            /** getInputFrameSizeSamples/getOutputFrameSizeSamples return the number
+             * of samples per block exchanged with the hardware.
+             */
+            unsigned int getInputFrameSizeSamples() const;
+            unsigned int getOutputFrameSizeSamples() const;
+
             /** OutputUnderflows is a monotonic counter of the number of playback buffer
              * underflows that have occurred since the AudioDevice was constructed.
              */
@@ -132,6 +205,17 @@ namespace afv_native {
              */
             std::atomic<uint32_t>   InputOverflows;
 
+        protected:
+            /** helpers for the driver factory hooks to handle NullApi and FileApi. */
+            static bool isVirtualApi(Api api);
+            static void addVirtualAPIs(std::map<Api,std::string> &apiList);
+            static std::shared_ptr<AudioDevice> makeVirtualDevice(
+                    const std::string &outputDeviceId,
+                    const std::string &inputDeviceId,
+                    Api audioApi,
+                    unsigned int deviceFrameLengthMs);
+
+        public:
             /* default implementation hooks... */
             static std::map<Api,std::string> getAPIs();
             static std::map<int,DeviceInfo> getCompatibleInputDevicesForApi(AudioDevice::Api api);
@@ -140,7 +224,8 @@ namespace afv_native {
                     const std::string &userStreamName,
                     const std::string &outputDeviceId,
                     const std::string &inputDeviceId,
-                    Api audioApi=-1);
+                    Api audioApi=-1,
+                    unsigned int deviceFrameLengthMs=frameLengthMs);
         };
     }
 }
@@ -38,6 +38,7 @@
 #include <memory>
 
 #include "afv-native/audio/IFilter.h"
+#include "afv-native/util/DenormalGuard.h"
 
 namespace afv_native {
     namespace audio {
@@ -60,7 +61,9 @@ namespace afv_native {
 
             SampleType TransformOne(SampleType sampleIn) override {
                 hpos %= 3;
-                mHistoryIn[hpos] = sampleIn;
+                // the history is flushed to zero as the signal fades out, so that it never goes subnormal.  The
+                // output only depends on the input history, so that's enough to keep it out of range as well.
+                mHistoryIn[hpos] = util::flushDenormal(sampleIn);
                 mHistoryOut[hpos] = (mB0 / mA0) * mHistoryIn[hpos]
                                     + (mB1 / mA0) * mHistoryIn[(hpos + 2) % 3]
                                     + (mB2 / mA0) * mHistoryIn[(hpos + 1) % 3]
@@ -0,0 +1,64 @@
+/* audio/ChannelCopy.h
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef AFV_NATIVE_CHANNELCOPY_H
+#define AFV_NATIVE_CHANNELCOPY_H
+
+#include <cstddef>
+
+#include "afv-native/audio/audio_params.h"
+
+namespace afv_native {
+    namespace audio {
+        /* These are the kernels used to move our mono sample blocks in and out of the channel areas the audio
+         * APIs hand us.  Device areas are described as a base pointer and a step in bytes between successive
+         * samples, as per libsoundio.
+         *
+         * They're written as plain loops over SampleType so the compiler can vectorise them for whatever target
+         * we're built for - contiguous areas are simply memcpy'd.
+         */
+
+        /** copyToStrided copies count samples from src into a device channel area. */
+        void copyToStrided(const SampleType *src, char *dst, size_t dstStep, size_t count);
+
+        /** copyFromStrided copies count samples from a device channel area into dst. */
+        void copyFromStrided(const char *src, size_t srcStep, SampleType *dst, size_t count);
+
+        /** duplicateToStereo writes count mono samples from src to both channels of the interleaved stereo
+         * buffer dst, which must have room for 2*count samples.
+         */
+        void duplicateToStereo(const SampleType *src, SampleType *dst, size_t count);
+    }
+}
+
+#endif //AFV_NATIVE_CHANNELCOPY_H
@@ -0,0 +1,82 @@
+/* audio/DecimatingSink.h
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef AFV_NATIVE_DECIMATINGSINK_H
+#define AFV_NATIVE_DECIMATINGSINK_H
+
+#include <memory>
+#include <vector>
+
+#include "afv-native/audio/ISampleSink.h"
+#include "afv-native/audio/audio_params.h"
+
+namespace afv_native {
+    namespace audio {
+        /** DecimatingSink low-pass filters full-rate frames and hands every Nth sample to the upstream sink.
+         *
+         * The upstream sink receives frames of frameSizeSamples / decimationFactor samples - the frame length in
+         * time doesn't change, only the sample rate does.  It's used by the narrowband transmit path so that the
+         * preprocessor and encoder only have to deal with the bandwidth we're actually going to send.
+         *
+         * The anti-aliasing filter is a windowed-sinc FIR and we only evaluate it for the samples we keep, so it's
+         * cheap enough to run on the capture thread.
+         */
+        class DecimatingSink: public ISampleSink {
+        public:
+            DecimatingSink(std::shared_ptr<ISampleSink> upstream, unsigned int decimationFactor);
+            virtual ~DecimatingSink();
+
+            void putAudioFrame(const SampleType *bufferIn) override;
+
+            /** reset clears the filter history. */
+            void reset();
+
+            size_t getOutputFrameSize() const;
+
+        protected:
+            /** number of taps in the anti-aliasing filter. */
+            static const size_t filterTaps = 95;
+
+            std::shared_ptr<ISampleSink> mUpstreamSink;
+            unsigned int mDecimationFactor;
+            size_t mOutputFrameSize;
+            std::vector<float> mCoefficients;
+
+            /** mWorkBuffer holds the last filterTaps-1 input samples, followed by the current input frame. */
+            SampleType *mWorkBuffer;
+            SampleType *mOutputBuffer;
+        };
+    }
+}
+
+#endif //AFV_NATIVE_DECIMATINGSINK_H
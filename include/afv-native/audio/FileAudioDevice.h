@@ -0,0 +1,85 @@
+/* audio/FileAudioDevice.h
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef AFV_NATIVE_FILEAUDIODEVICE_H
+#define AFV_NATIVE_FILEAUDIODEVICE_H
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include "afv-native/audio/NullAudioDevice.h"
+#include "afv-native/audio/WavSampleStorage.h"
+#include "afv-native/audio/WavWriter.h"
+
+namespace afv_native {
+    namespace audio {
+        /** FileAudioDevice is a NullAudioDevice that reads its input from, and writes its output to, WAVE files.
+         *
+         * Input files are mixed down to mono and resampled as necessary.  Once the input file is exhausted, the
+         * input is silence.  Output is written as 16 bit mono PCM at sampleRateHz.
+         *
+         * Either file name may be empty, in which case that side behaves as per NullAudioDevice.
+         */
+        class FileAudioDevice: public NullAudioDevice {
+        public:
+            FileAudioDevice(
+                    std::string inputFileName,
+                    std::string outputFileName,
+                    unsigned int deviceFrameLengthMs = frameLengthMs);
+            virtual ~FileAudioDevice();
+
+            bool open() override;
+            void close() override;
+
+            /** isInputFinished returns true once all of the input file has been consumed. */
+            bool isInputFinished() const;
+
+        protected:
+            void readInput(SampleType *bufferOut, size_t count) override;
+            void writeOutput(const SampleType *bufferIn, size_t count) override;
+
+        private:
+            const std::string mInputFileName;
+            const std::string mOutputFileName;
+
+            std::unique_ptr<WavSampleStorage> mInputSamples;
+            size_t mInputPosition;
+            std::atomic<bool> mInputFinished;
+
+            WavWriter mOutputWriter;
+        };
+    }
+}
+
+#endif //AFV_NATIVE_FILEAUDIODEVICE_H
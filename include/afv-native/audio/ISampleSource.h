@@ -34,6 +34,8 @@
 #ifndef AFV_NATIVE_ISAMPLESOURCE_H
 #define AFV_NATIVE_ISAMPLESOURCE_H
 
+#include <cstring>
+
 #include "afv-native/audio/audio_params.h"
 #include "afv-native/audio/SourceStatus.h"
 
@@ -48,6 +50,43 @@ namespace afv_native {
              *  the stream.
              */
             virtual SourceStatus getAudioFrame(SampleType *bufferOut) = 0;
+
+            /** getFrameSizeSamples returns the number of samples getAudioFrame() writes per call.
+             *
+             * This is frameSizeSamples for sources producing normal frames.  Sources producing some other frame
+             * size (such as those sitting at the device boundary) must override it.
+             */
+            virtual size_t getFrameSizeSamples() const
+            {
+                return frameSizeSamples;
+            }
+
+            /** fetch nFrames consecutive audioframes from the source in one go.
+             *
+             * Sources with significant per-call setup (locking, cache population, etc) should override this
+             * so that a device asking for several frames at once only pays for that setup once.  The default
+             * implementation simply calls getAudioFrame() repeatedly.
+             *
+             * If the source stops before all frames have been produced, the remainder of the buffer is
+             * silence-filled and the failing status returned.
+             *
+             * @param bufferOut The buffer to write nFrames * getFrameSizeSamples() samples into.
+             * @param nFrames The number of frames to fetch.
+             * @return The SourceStatus enum corresponding to the current state of
+             *  the stream.
+             */
+            virtual SourceStatus getAudioFrames(SampleType *bufferOut, size_t nFrames)
+            {
+                const size_t frameSize = getFrameSizeSamples();
+                for (size_t i = 0; i < nFrames; i++) {
+                    auto rv = getAudioFrame(bufferOut + (i * frameSize));
+                    if (rv != SourceStatus::OK) {
+                        ::memset(bufferOut + (i * frameSize), 0, (nFrames - i) * frameSize * sizeof(SampleType));
+                        return rv;
+                    }
+                }
+                return SourceStatus::OK;
+            }
         };
     }
 }
@@ -0,0 +1,94 @@
+/* audio/NullAudioDevice.h
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef AFV_NATIVE_NULLAUDIODEVICE_H
+#define AFV_NATIVE_NULLAUDIODEVICE_H
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#include "afv-native/audio/AudioDevice.h"
+
+namespace afv_native {
+    namespace audio {
+        /** NullAudioDevice is an AudioDevice with no hardware behind it.
+         *
+         * A thread exchanges frames with the source and sink, either paced to (a multiple of) real time, or as
+         * fast as the pipeline can go.  The input is silence and the output is discarded - subclasses can override
+         * readInput()/writeOutput() to do something more useful.
+         *
+         * This lets the whole pipeline run on machines without a sound card, for load tests, recording bots and
+         * benchmarks.
+         */
+        class NullAudioDevice: public AudioDevice {
+        public:
+            explicit NullAudioDevice(unsigned int deviceFrameLengthMs = frameLengthMs);
+            virtual ~NullAudioDevice();
+
+            bool open() override;
+            void close() override;
+
+            /** setSpeed sets how fast the device runs relative to real time.  0 runs as fast as possible.
+             *
+             * This can be changed while the device is running.
+             */
+            void setSpeed(double speed);
+            double getSpeed() const;
+
+            /** getFramesProcessed returns the number of device frames exchanged since the device was opened. */
+            uint64_t getFramesProcessed() const;
+
+        protected:
+            /** readInput provides count samples of input.  It's called on the device thread.  */
+            virtual void readInput(SampleType *bufferOut, size_t count);
+
+            /** writeOutput consumes count samples of output.  It's called on the device thread. */
+            virtual void writeOutput(const SampleType *bufferIn, size_t count);
+
+        private:
+            std::thread mThread;
+            std::atomic<bool> mRunning;
+            std::atomic<double> mSpeed;
+            std::atomic<uint64_t> mFramesProcessed;
+
+            SampleType *mInputFrame;
+            SampleType *mOutputFrame;
+
+            void run();
+            void processFrame();
+        };
+    }
+}
+
+#endif //AFV_NATIVE_NULLAUDIODEVICE_H
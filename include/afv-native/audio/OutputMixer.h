@@ -52,16 +52,25 @@ namespace afv_native {
         protected:
             std::forward_list<MixerSource> mSources;
             float mGain;
+
+            /** mIntermediateBuffer is where we fetch each source's frame before mixing it in. */
+            SampleType *mIntermediateBuffer;
+
+            bool mixFrame(SampleType * RESTRICT bufferOut);
         public:
             OutputMixer();
             virtual ~OutputMixer();
 
+            OutputMixer(const OutputMixer &copySrc) = delete;
+            OutputMixer &operator=(const OutputMixer &copySrc) = delete;
+
             void setSource(const std::shared_ptr<ISampleSource> &src, float gain);
             void removeSource(const std::shared_ptr<ISampleSource> &src);
 
             void setGain(float newGain);
 
             SourceStatus getAudioFrame(SampleType * RESTRICT bufferOut) override;
+            SourceStatus getAudioFrames(SampleType * RESTRICT bufferOut, size_t nFrames) override;
         };
     }
 }
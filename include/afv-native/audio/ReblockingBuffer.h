@@ -0,0 +1,147 @@
+/* audio/ReblockingBuffer.h
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef AFV_NATIVE_REBLOCKINGBUFFER_H
+#define AFV_NATIVE_REBLOCKINGBUFFER_H
+
+#include <cstddef>
+
+#include "afv-native/audio/audio_params.h"
+
+namespace afv_native {
+    namespace audio {
+        /** ReblockingBuffer is a single-threaded sample ring used to convert between streams with different
+         * block sizes.
+         *
+         * The ring size is always a power of two so the indices can run freely and be masked.  Blocks can be
+         * accessed in place via beginRead()/beginWrite() - if the requested block lies contiguously in the ring,
+         * you get a pointer straight into it, otherwise the block is staged in a scratch buffer and
+         * copied in or out when the operation ends.
+         *
+         * Only one read and one write may be outstanding at any time, and both ends must be driven from the same
+         * thread (or externally serialised).
+         */
+        class ReblockingBuffer {
+        public:
+            /** construct a new ReblockingBuffer
+             *
+             * @param minimumCapacity the minimum number of samples the ring must be able to hold.  This is rounded
+             *      up to the next power of two.
+             */
+            explicit ReblockingBuffer(size_t minimumCapacity);
+            virtual ~ReblockingBuffer();
+
+            ReblockingBuffer(const ReblockingBuffer &copySrc) = delete;
+            ReblockingBuffer &operator=(const ReblockingBuffer &copySrc) = delete;
+
+            size_t getCapacity() const
+            {
+                return mCapacity;
+            }
+
+            /** getAvailable returns the number of samples waiting to be read */
+            size_t getAvailable() const
+            {
+                return mWriteIndex - mReadIndex;
+            }
+
+            /** getSpace returns the number of samples that can be written before the ring is full */
+            size_t getSpace() const
+            {
+                return mCapacity - getAvailable();
+            }
+
+            /** getLatencySamples returns the delay this buffer is currently adding to the stream, in samples. */
+            size_t getLatencySamples() const
+            {
+                return getAvailable();
+            }
+
+            /** discards all buffered samples */
+            void reset();
+
+            /** resize reallocates the ring so it can hold at least minimumCapacity samples, discarding any
+             * buffered samples.
+             *
+             * This allocates, so don't use it from a realtime thread.
+             */
+            void resize(size_t minimumCapacity);
+
+            /** write copies up to count samples into the ring.
+             *
+             * @return the number of samples actually written.
+             */
+            size_t write(const SampleType *bufferIn, size_t count);
+
+            /** read copies up to count samples out of the ring.
+             *
+             * @return the number of samples actually read.
+             */
+            size_t read(SampleType *bufferOut, size_t count);
+
+            /** beginWrite returns a pointer that count samples can be written to.
+             *
+             * count must not exceed getSpace().  The samples don't become available for reading until endWrite()
+             * is called.
+             */
+            SampleType *beginWrite(size_t count);
+            void endWrite(size_t count);
+
+            /** beginRead returns a pointer to the next count samples in the ring.
+             *
+             * count must not exceed getAvailable().  The pointer remains valid until endRead() is called, which
+             * also releases the samples.
+             */
+            const SampleType *beginRead(size_t count);
+            void endRead(size_t count);
+
+        protected:
+            size_t mCapacity;
+            size_t mMask;
+            size_t mReadIndex;
+            size_t mWriteIndex;
+            bool mWriteStaged;
+
+            SampleType *mRing;
+            SampleType *mWriteScratch;
+            SampleType *mReadScratch;
+
+            /** copies count samples into the ring starting at the (unmasked) index, wrapping as required. */
+            void copyIn(size_t index, const SampleType *bufferIn, size_t count);
+            /** copies count samples out of the ring starting at the (unmasked) index, wrapping as required. */
+            void copyOut(size_t index, SampleType *bufferOut, size_t count) const;
+        };
+    }
+}
+
+#endif //AFV_NATIVE_REBLOCKINGBUFFER_H
@@ -54,6 +54,9 @@ namespace afv_native {
 
             bool isPlaying() const;
 
+            /** restart plays the sample again from the beginning. */
+            void restart();
+
         };
     }
 }
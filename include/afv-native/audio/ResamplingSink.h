@@ -0,0 +1,85 @@
+/* audio/ResamplingSink.h
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef AFV_NATIVE_RESAMPLINGSINK_H
+#define AFV_NATIVE_RESAMPLINGSINK_H
+
+#include <memory>
+
+#include "afv-native/audio/ISampleSink.h"
+#include "afv-native/audio/ReblockingBuffer.h"
+
+/* from speexdsp */
+struct SpeexResamplerState_;
+typedef struct SpeexResamplerState_ SpeexResamplerState;
+
+namespace afv_native {
+    namespace audio {
+        /** ResamplingSink accepts frames at some other sample rate and frame size, and passes them on to the
+         * destination sink as normal frames (frameSizeSamples at sampleRateHz).
+         *
+         * This is the input side counterpart of ResamplingSource.
+         */
+        class ResamplingSink: public ISampleSink {
+        protected:
+            std::shared_ptr<ISampleSink> mDestinationSink;
+            const unsigned int mInputSampleRate;
+            const unsigned int mInputFrameSize;
+
+            SpeexResamplerState *mResampler;
+            ReblockingBuffer mBuffer;
+        public:
+            /** construct a new ResamplingSink.
+             *
+             * @param destSink the sink to pass the resampled frames to.
+             * @param inputSampleRate the sample rate of the frames we'll be handed.
+             * @param inputFrameSize the number of samples in the frames we'll be handed.
+             */
+            ResamplingSink(
+                    std::shared_ptr<ISampleSink> destSink,
+                    unsigned int inputSampleRate,
+                    unsigned int inputFrameSize);
+            virtual ~ResamplingSink();
+
+            ResamplingSink(const ResamplingSink &copySrc) = delete;
+            ResamplingSink &operator=(const ResamplingSink &copySrc) = delete;
+
+            void putAudioFrame(const SampleType *bufferIn) override;
+
+            /** getLatencySamples returns the delay this stage is adding to the stream, in output samples. */
+            size_t getLatencySamples() const;
+        };
+    }
+}
+
+#endif //AFV_NATIVE_RESAMPLINGSINK_H
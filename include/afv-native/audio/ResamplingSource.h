@@ -0,0 +1,95 @@
+/* audio/ResamplingSource.h
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef AFV_NATIVE_RESAMPLINGSOURCE_H
+#define AFV_NATIVE_RESAMPLINGSOURCE_H
+
+#include <memory>
+
+#include "afv-native/audio/ISampleSource.h"
+#include "afv-native/audio/ReblockingBuffer.h"
+
+/* from speexdsp */
+struct SpeexResamplerState_;
+typedef struct SpeexResamplerState_ SpeexResamplerState;
+
+namespace afv_native {
+    namespace audio {
+        /** ResamplingSource converts a source of normal frames (frameSizeSamples at sampleRateHz) into a source of
+         * frames at some other sample rate and frame size.
+         *
+         * It's used at the device boundary so we can run hardware at its native rate rather than relying on the
+         * OS to convert for us.
+         */
+        class ResamplingSource: public ISampleSource {
+        protected:
+            std::shared_ptr<ISampleSource> mOriginSource;
+            const unsigned int mOutputSampleRate;
+            const unsigned int mOutputFrameSize;
+
+            SpeexResamplerState *mResampler;
+            SampleType *mInputFrame;
+            ReblockingBuffer mBuffer;
+
+            /** fill pulls and resamples frames from the origin until at least count samples are buffered.
+             *
+             * @return false if the origin failed, in which case it's released.
+             */
+            bool fill(size_t count);
+        public:
+            /** construct a new ResamplingSource.
+             *
+             * @param originSource the source to pull frames from.
+             * @param outputSampleRate the sample rate to produce.
+             * @param outputFrameSize the number of samples to produce per getAudioFrame call.
+             */
+            ResamplingSource(
+                    std::shared_ptr<ISampleSource> originSource,
+                    unsigned int outputSampleRate,
+                    unsigned int outputFrameSize);
+            virtual ~ResamplingSource();
+
+            ResamplingSource(const ResamplingSource &copySrc) = delete;
+            ResamplingSource &operator=(const ResamplingSource &copySrc) = delete;
+
+            SourceStatus getAudioFrame(SampleType *bufferOut) override;
+            SourceStatus getAudioFrames(SampleType *bufferOut, size_t nFrames) override;
+            size_t getFrameSizeSamples() const override;
+
+            /** getLatencySamples returns the delay this stage is adding to the stream, in output samples. */
+            size_t getLatencySamples() const;
+        };
+    }
+}
+
+#endif //AFV_NATIVE_RESAMPLINGSOURCE_H
@@ -0,0 +1,75 @@
+/* audio/SampleFormat.h
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef AFV_NATIVE_SAMPLEFORMAT_H
+#define AFV_NATIVE_SAMPLEFORMAT_H
+
+#include <cstddef>
+
+#include "afv-native/audio/audio_params.h"
+
+namespace afv_native {
+    namespace audio {
+        /** SampleFormat describes the (native endian) format of samples exchanged with something outside of the
+         * audio pipeline, such as a hardware device or a file.  Internally, we always use SampleType.
+         */
+        enum class SampleFormat {
+            Float32,
+            Int16,
+            /** signed 24 bit samples packed into 3 bytes each */
+            Int24,
+            Int32,
+        };
+
+        /** getSampleFormatBytes returns the size of one sample in the given format, in bytes. */
+        size_t getSampleFormatBytes(SampleFormat format);
+
+        /** convertToFormat converts count samples from src into the given format.
+         *
+         * Integer formats are clamped at full scale rather than wrapping.
+         *
+         * @param dst the first sample to write
+         * @param dstStep the number of bytes between successive samples in dst.  When this is the same as the
+         *      sample size, fast block conversions are used.
+         */
+        void convertToFormat(const SampleType *src, char *dst, size_t dstStep, SampleFormat format, size_t count);
+
+        /** convertFromFormat converts count samples in the given format from src into dst.
+         *
+         * @param srcStep the number of bytes between successive samples in src.
+         */
+        void convertFromFormat(const char *src, size_t srcStep, SampleFormat format, SampleType *dst, size_t count);
+    }
+}
+
+#endif //AFV_NATIVE_SAMPLEFORMAT_H
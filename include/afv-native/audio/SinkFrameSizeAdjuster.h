@@ -38,21 +38,32 @@
 #include <cstdint>
 
 #include "afv-native/audio/ISampleSink.h"
+#include "afv-native/audio/ReblockingBuffer.h"
 
 namespace afv_native {
     namespace audio {
+        /** SinkFrameSizeAdjuster accepts frames of an arbitrary size and passes them on to the destination sink as
+         * normal (frameSizeSamples) frames.
+         *
+         * putAudioSamples() accepts blocks of any size.  Whenever the input lines up with the destination's frames,
+         * they're passed on directly without being copied.
+         */
         class SinkFrameSizeAdjuster: public ISampleSink {
         protected:
             std::shared_ptr<ISampleSink> mDestinationSink;
             const unsigned int mSourceFrameSize;
 
-            size_t mSinkBufferOffset;
-            SampleType *mSinkBuffer;
+            ReblockingBuffer mBuffer;
         public:
             SinkFrameSizeAdjuster(std::shared_ptr<ISampleSink> destSink, unsigned int sinkFrameSize);
             virtual ~SinkFrameSizeAdjuster();
             void putAudioFrame(const SampleType *bufferIn) override;
 
+            /** putAudioSamples accepts count samples.  Any count is acceptable. */
+            void putAudioSamples(const SampleType *bufferIn, size_t count);
+
+            /** getLatencySamples returns the number of samples currently held waiting for a complete frame. */
+            size_t getLatencySamples() const;
         };
     }
 }
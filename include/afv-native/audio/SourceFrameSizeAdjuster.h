@@ -37,21 +37,63 @@
 #include <memory>
 
 #include "afv-native/audio/ISampleSource.h"
+#include "afv-native/audio/ReblockingBuffer.h"
 
 namespace afv_native {
     namespace audio {
+        /** SourceFrameSizeAdjuster converts a source of normal (frameSizeSamples) frames into a source of some other
+         * frame size.
+         *
+         * As well as the fixed size ISampleSource interface, it can hand out arbitrarily sized blocks via
+         * getAudioSamples() or peekSamples()/consumeSamples() for callers (such as audio devices) whose block size
+         * varies from call to call.
+         *
+         * Whenever the output lines up with the origin's frames, they're rendered straight into the caller's buffer
+         * without going via the internal ring.
+         */
         class SourceFrameSizeAdjuster: public ISampleSource {
         protected:
             std::shared_ptr<ISampleSource> mOriginSource;
             const unsigned int mDestinationFrameSize;
+            const size_t mMaxPeekSize;
 
-            size_t mSourceBufferOffset;
-            SampleType *mSourceBuffer;
+            ReblockingBuffer mBuffer;
+
+            /** fill pulls frames from the origin until at least count samples are buffered.
+             *
+             * @return false if the origin failed, in which case it's released.
+             */
+            bool fill(size_t count);
         public:
-            SourceFrameSizeAdjuster(std::shared_ptr<ISampleSource> originSource, unsigned int outputFrameSize);
+            /** construct a new SourceFrameSizeAdjuster.
+             *
+             * @param originSource the source to pull frames from.
+             * @param outputFrameSize the frame size to produce via getAudioFrame.
+             * @param maxPeekSize the largest block that will be requested via peekSamples().  If 0, this is the
+             *      same as outputFrameSize.
+             */
+            SourceFrameSizeAdjuster(
+                    std::shared_ptr<ISampleSource> originSource,
+                    unsigned int outputFrameSize,
+                    size_t maxPeekSize = 0);
             virtual ~SourceFrameSizeAdjuster();
             SourceStatus getAudioFrame(SampleType *bufferOut) override;
+            SourceStatus getAudioFrames(SampleType *bufferOut, size_t nFrames) override;
+            size_t getFrameSizeSamples() const override;
+
+            /** getAudioSamples fills bufferOut with count samples.  Any count is acceptable. */
+            SourceStatus getAudioSamples(SampleType *bufferOut, size_t count);
+
+            /** peekSamples returns a pointer to the next count samples without copying them out if possible.
+             *
+             * count must not exceed the maxPeekSize given at construction.  If the origin fails, the remainder is
+             * filled with silence.  The pointer is valid until consumeSamples() is called.
+             */
+            const SampleType *peekSamples(size_t count);
+            void consumeSamples(size_t count);
 
+            /** getLatencySamples returns the number of samples currently buffered ahead of the output. */
+            size_t getLatencySamples() const;
         };
     }
 }
@@ -37,6 +37,8 @@
 #include <memory>
 
 #include "afv-native/audio/ISampleSink.h"
+#include "afv-native/audio/audio_params.h"
+#include "afv-native/util/LatencyHistogram.h"
 
 /* from speexdsp */
 /* State of the preprocessor (one per channel). Should never be accessed directly. */
@@ -50,13 +52,26 @@ namespace afv_native {
         protected:
             std::shared_ptr<ISampleSink> mUpstreamSink;
             SpeexPreprocessState *mPreprocessorState;
+            size_t mFrameSizeSamples;
+            util::LatencyHistogram *mLatency;
 
             int16_t mSpeexFrame[frameSizeSamples];
             SampleType mOutputFrame[frameSizeSamples];
         public:
-            explicit SpeexPreprocessor(std::shared_ptr<ISampleSink> upstream);
+            /** construct a new SpeexPreprocessor.
+             *
+             * @param upstream the sink to pass the processed frames to.
+             * @param sampleRate the sample rate of the frames we'll be handed.  Frames are always frameLengthMs
+             *      long, so this also determines the number of samples per frame.  Must not exceed sampleRateHz.
+             */
+            explicit SpeexPreprocessor(std::shared_ptr<ISampleSink> upstream, int sampleRate = sampleRateHz);
             virtual ~SpeexPreprocessor();
             void putAudioFrame(const SampleType *bufferIn) override;
+
+            /** setLatencyHistogram sets the histogram the preprocessing time is recorded into (excluding the
+             * upstream sink), or nullptr to not record it.
+             */
+            void setLatencyHistogram(util::LatencyHistogram *histogram);
         };
     }
 }
@@ -0,0 +1,91 @@
+/* audio/WavWriter.h
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef AFV_NATIVE_WAVWRITER_H
+#define AFV_NATIVE_WAVWRITER_H
+
+#include <cstdio>
+#include <string>
+
+#include "afv-native/audio/SampleFormat.h"
+#include "afv-native/audio/audio_params.h"
+
+namespace afv_native {
+    namespace audio {
+        /** WavWriter streams mono samples out to a WAVE file.
+         *
+         * The header sizes are filled in when the file is closed, so a file that's never closed (say, because we
+         * crashed) will be missing its lengths - most tools will still read it.
+         *
+         * Like WavFile, this assumes we're running on a little endian machine.
+         */
+        class WavWriter {
+        public:
+            WavWriter();
+            virtual ~WavWriter();
+
+            WavWriter(const WavWriter &copySrc) = delete;
+            WavWriter &operator=(const WavWriter &copySrc) = delete;
+
+            /** open creates (or truncates) fileName and writes a WAVE header to it.
+             *
+             * @param format the format to store the samples in.
+             * @return true if the file was opened successfully.
+             */
+            bool open(const std::string &fileName, unsigned int sampleRate = sampleRateHz,
+                      SampleFormat format = SampleFormat::Int16);
+
+            /** writeSamples appends count samples to the file.
+             *
+             * @return false if the file isn't open or the write failed.
+             */
+            bool writeSamples(const SampleType *samples, size_t count);
+
+            /** close fills in the header sizes and closes the file. */
+            void close();
+
+            bool isOpen() const;
+            size_t getSamplesWritten() const;
+
+        protected:
+            FILE *mFile;
+            SampleFormat mFormat;
+            size_t mSamplesWritten;
+
+            static const size_t conversionBlockSize = 1024;
+            char *mConversionBuffer;
+        };
+    }
+}
+
+#endif //AFV_NATIVE_WAVWRITER_H
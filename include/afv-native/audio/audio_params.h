@@ -46,6 +46,17 @@ namespace afv_native {
 
         const int frameSizeSamples = (sampleRateHz * frameLengthMs / 1000);
 
+        /** sample rate used by the narrowband transmit path.
+         *
+         * At our encoder bitrate, opus only ever keeps wideband (8kHz) audio anyway, so there's little point
+         * preprocessing and analysing a full-rate signal.
+         */
+        const int narrowbandSampleRateHz = 16000;
+
+        const int narrowbandDecimationFactor = sampleRateHz / narrowbandSampleRateHz;
+
+        const int narrowbandFrameSizeSamples = (narrowbandSampleRateHz * frameLengthMs / 1000);
+
         const int32_t encoderBitrate = 16384;   /* 16Kibps */
 
         /** approximate target size of outputFrames in bytes */
@@ -42,6 +42,7 @@
 
 #include "afv-native/cryptodto/params.h"
 #include "afv-native/cryptodto/SequenceTest.h"
+#include "afv-native/cryptodto/dto/Header.h"
 #include "afv-native/cryptodto/dto/ICryptoDTO.h"
 #include "afv-native/Log.h"
 
@@ -49,10 +50,29 @@ namespace afv_native {
     namespace cryptodto {
         namespace dto {
             class ChannelConfig;
-
-            class Header;
         }
 
+        /** EncapsulateBuffers is the working storage Encapsulate() needs for each DTO.
+         *
+         * Senders that encapsulate often (such as the voice path) keep one of these so that, once its buffers have
+         * grown, encapsulating doesn't touch the heap.  An instance must only be used by one thread at a time.
+         */
+        class EncapsulateBuffers {
+        public:
+            msgpack::sbuffer DtoBuffer;
+            msgpack::sbuffer DtoTempBuffer;
+            msgpack::sbuffer HeaderBuffer;
+            dto::Header Header;
+            /** CipherContext is set up for ChaCha20-Poly1305 on first use, and only rekeyed after that. */
+            EVP_CIPHER_CTX *CipherContext;
+
+            EncapsulateBuffers();
+            ~EncapsulateBuffers();
+
+            EncapsulateBuffers(const EncapsulateBuffers &copySrc) = delete;
+            EncapsulateBuffers &operator=(const EncapsulateBuffers &copySrc) = delete;
+        };
+
         class Channel {
         protected:
             unsigned char aeadTransmitKey[aeadModeKeySize];
@@ -74,7 +94,8 @@ namespace afv_native {
                     size_t plainLen,
                     const dto::Header &header,
                     const unsigned char *aadIn,
-                    size_t aadLen);
+                    size_t aadLen,
+                    EncapsulateBuffers &buffers);
 
             static void makeChaCha20Poly1305Nonce(uint64_t sequence, unsigned char *nonceBuffer);
 
@@ -87,11 +108,12 @@ namespace afv_native {
              * @tparam T type of the DTO.  T must provide a getName() method that
              *          returns the DTO name, and be encodable by msgpack-c.
              * @param dtoBuf the sbuffer object to pass the encoded dto out in.
+             * @param dtoTempBuf an empty sbuffer to pack the dto body into before it's copied into dtoBuf.
              * @param dto the dto to encode
              * @return true if the message was successfully encoded, false otherwise.
              */
             template<class T>
-            static bool encodeDto(msgpack::sbuffer &dtoBuf, const T &dto)
+            static bool encodeDto(msgpack::sbuffer &dtoBuf, msgpack::sbuffer &dtoTempBuf, const T &dto)
             {
                 // assemble the body and pack it.
                 std::string dtoName = dto.getName();
@@ -101,7 +123,6 @@ namespace afv_native {
 
                 // because we don't know the dto size in advance, pack it into it's own
                 // temp buffer, then copy it into the actual payload buffer.
-                msgpack::sbuffer dtoTempBuf;
                 msgpack::pack(dtoTempBuf, dto);
                 nLen = static_cast<uint16_t>(dtoTempBuf.size());
                 if (dtoTempBuf.size() > UINT16_MAX) {
@@ -132,18 +153,34 @@ namespace afv_native {
                     cryptodto::CryptoDtoMode mode,
                     const T &dto)
             {
-                msgpack::sbuffer dtoBuf;
-                if (!encodeDto(dtoBuf, dto)) {
+                EncapsulateBuffers buffers;
+                return Encapsulate(bufOut, bufOutLen, sequence, mode, dto, buffers);
+            }
+
+            /** Encapsulate encodes and encrypts dto into bufOut, using buffers for all of its working storage. */
+            template<class T>
+            size_t Encapsulate(
+                    unsigned char *bufOut,
+                    size_t bufOutLen,
+                    sequence_t sequence,
+                    cryptodto::CryptoDtoMode mode,
+                    const T &dto,
+                    EncapsulateBuffers &buffers)
+            {
+                buffers.DtoBuffer.clear();
+                buffers.DtoTempBuffer.clear();
+                if (!encodeDto(buffers.DtoBuffer, buffers.DtoTempBuffer, dto)) {
                     return 0;
                 }
                 // use the generic encapsulate method.
                 return Encapsulate(
-                        reinterpret_cast<const unsigned char *>(dtoBuf.data()),
-                        dtoBuf.size(),
+                        reinterpret_cast<const unsigned char *>(buffers.DtoBuffer.data()),
+                        buffers.DtoBuffer.size(),
                         sequence,
                         mode,
                         bufOut,
-                        bufOutLen);
+                        bufOutLen,
+                        buffers);
             }
 
             size_t Encapsulate(
@@ -154,6 +191,15 @@ namespace afv_native {
                     unsigned char *cipherTextBufOut,
                     size_t cipherTextLen);
 
+            size_t Encapsulate(
+                    const unsigned char *plainTextBuf,
+                    size_t plainTextLen,
+                    sequence_t sequence,
+                    cryptodto::CryptoDtoMode mode,
+                    unsigned char *cipherTextBufOut,
+                    size_t cipherTextLen,
+                    EncapsulateBuffers &buffers);
+
             bool Decapsulate(
                     const unsigned char *cipherTextIn,
                     size_t cipherTextLen,
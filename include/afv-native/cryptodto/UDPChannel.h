@@ -36,18 +36,57 @@
 
 #include <atomic>
 #include <functional>
+#include <map>
+#include <mutex>
 #include <unordered_map>
 #include <event2/event.h>
 
 #include "afv-native/Log.h"
 #include "afv-native/cryptodto/Channel.h"
 #include "afv-native/cryptodto/dto/ICryptoDTO.h"
+#include "afv-native/util/LatencyHistogram.h"
+#include "afv-native/util/Trace.h"
 
 namespace afv_native {
     namespace cryptodto {
         typedef void (*DtoHandlerFunc)(
                 const std::string &dtoName, const unsigned char *bufIn, size_t bufLen, void *user_data);
 
+        /** UDPChannelStats is a snapshot of a UDPChannel's traffic counters.
+         *
+         * Every received datagram ends up in exactly one of DtosDispatched or one of the Dropped counters.
+         */
+        struct UDPChannelStats {
+            uint64_t PacketsReceived;
+            uint64_t BytesReceived;
+            uint64_t PacketsSent;
+            uint64_t BytesSent;
+
+            uint64_t ReceiveErrors;
+            uint64_t SendErrors;
+            /** SendWouldBlock counts datagrams dropped because the socket's transmit buffer was full. */
+            uint64_t SendWouldBlock;
+            uint64_t SendShortWrites;
+
+            uint64_t DroppedOversize;
+            uint64_t DroppedInvalidFrame;
+            uint64_t DroppedCipherMode;
+            uint64_t DroppedChannelTag;
+            uint64_t DroppedDuplicate;
+            uint64_t DroppedBadLength;
+            uint64_t DroppedUnknownDto;
+            /** SequenceOverflows counts datagrams that jumped past the receive window.  These are still
+             * accepted - the window is moved up to them - but usually indicate a burst of loss.
+             */
+            uint64_t SequenceOverflows;
+
+            uint64_t DtosDispatched;
+            /** DtosReceived counts the dispatched DTOs by name. */
+            std::map<std::string, uint64_t> DtosReceived;
+
+            UDPChannelStats();
+        };
+
         class UDPChannel: public Channel {
         private:
             std::string mAddress;
@@ -59,6 +98,14 @@ namespace afv_native {
              */
             unsigned char *mDatagramRxBuffer;
 
+            /** mDatagramTxBuffer and mTxBuffers are sendDto's working storage, so sending a voice frame doesn't
+             * allocate.  mTxBuffersBusy is set whilst they're in use - if another thread is sending at the same
+             * moment, the second sender uses temporary buffers rather than waiting.
+             */
+            unsigned char *mDatagramTxBuffer;
+            EncapsulateBuffers mTxBuffers;
+            std::atomic<bool> mTxBuffersBusy;
+
             evutil_socket_t mUDPSocket;
             struct event_base *mEvBase;
             struct event *mSocketEvent;
@@ -70,10 +117,86 @@ namespace afv_native {
             static void evReadCallback(evutil_socket_t fd, short events, void *arg);
             void readCallback();
 
+            struct Counters {
+                std::atomic<uint64_t> PacketsReceived;
+                std::atomic<uint64_t> BytesReceived;
+                std::atomic<uint64_t> PacketsSent;
+                std::atomic<uint64_t> BytesSent;
+                std::atomic<uint64_t> ReceiveErrors;
+                std::atomic<uint64_t> SendErrors;
+                std::atomic<uint64_t> SendWouldBlock;
+                std::atomic<uint64_t> SendShortWrites;
+                std::atomic<uint64_t> DroppedOversize;
+                std::atomic<uint64_t> DroppedInvalidFrame;
+                std::atomic<uint64_t> DroppedCipherMode;
+                std::atomic<uint64_t> DroppedChannelTag;
+                std::atomic<uint64_t> DroppedDuplicate;
+                std::atomic<uint64_t> DroppedBadLength;
+                std::atomic<uint64_t> DroppedUnknownDto;
+                std::atomic<uint64_t> SequenceOverflows;
+                std::atomic<uint64_t> DtosDispatched;
+            };
+            Counters mCounters;
+
+            static void bump(std::atomic<uint64_t> &counter, uint64_t value = 1)
+            {
+                counter.fetch_add(value, std::memory_order_relaxed);
+            }
+
+            static bool isWouldBlock(int socketError);
+
+            /** encapsulateAndSend encapsulates pkt into dgBuffer, which must be maxPermittedDatagramSize long, and
+             * sends it.
+             */
+            template<class T>
+            void encapsulateAndSend(const T &pkt, unsigned char *dgBuffer, EncapsulateBuffers &buffers)
+            {
+                sequence_t thisSeq = std::atomic_fetch_add(&mTxSequence, static_cast<sequence_t>(1));
+
+                size_t dgSize;
+                {
+                    util::ScopedLatency encapsulateTiming(mEncapsulateLatency);
+                    TRACE_SCOPE("network", "UDPChannel::encapsulate");
+                    dgSize = Encapsulate<T>(
+                            dgBuffer,
+                            maxPermittedDatagramSize,
+                            thisSeq,
+                            CryptoDtoMode::CryptoModeChaCha20Poly1305,
+                            pkt,
+                            buffers);
+                }
+                if (dgSize > 0) {
+                    sendDatagram(dgBuffer, dgSize);
+                } else {
+                    bump(mCounters.SendErrors);
+                }
+            }
+
+            void sendDatagram(const unsigned char *dgBuffer, size_t dgSize);
+
         protected:
-            std::unordered_map<std::string, std::function<void(const unsigned char *data, size_t len)> > mDtoHandlers;
+            /** DtoHandler is a registered DTO handler, along with the number of DTOs dispatched to it. */
+            struct DtoHandler {
+                std::function<void(const unsigned char *data, size_t len)> Callback;
+                std::atomic<uint64_t> Dispatched;
+
+                DtoHandler():
+                        Callback(),
+                        Dispatched(0)
+                {
+                }
+            };
+
+            /** mDtoHandlerLock guards changes to mDtoHandlers against getStatistics() walking it.  Handlers must
+             * be registered on the event thread, so dispatching, which happens there too, doesn't need to take it.
+             */
+            mutable std::mutex mDtoHandlerLock;
+            std::unordered_map<std::string, DtoHandler> mDtoHandlers;
             int mLastErrno;
 
+            util::LatencyHistogram *mEncapsulateLatency;
+            util::LatencyHistogram *mSendLatency;
+
             void enableRxMode(CryptoDtoMode mode);
 
             void disableRxMode(CryptoDtoMode mode);
@@ -92,30 +215,16 @@ namespace afv_native {
             void sendDto(const T &pkt)
             {
                 if (mUDPSocket < 0) {
-                    LOG("UDPChannel", "tried to send on closed socket");
+                    LOGWARN("UDPChannel", "tried to send on closed socket");
                     return;
                 }
-                std::vector<unsigned char> dgBuffer(maxPermittedDatagramSize);
-                sequence_t thisSeq = std::atomic_fetch_add(&mTxSequence, static_cast<sequence_t>(1));
-
-                size_t dgSize = Encapsulate<T>(
-                        dgBuffer.data(),
-                        maxPermittedDatagramSize,
-                        thisSeq,
-                        CryptoDtoMode::CryptoModeChaCha20Poly1305,
-                        pkt);
-                dgBuffer.resize(dgSize);
-                if (dgSize > 0) {
-                    auto sent = ::send(mUDPSocket, reinterpret_cast<char *>(dgBuffer.data()), dgBuffer.size(), 0);
-                    if (sent < 0) {
-                        if (errno == EWOULDBLOCK) {
-                            LOG("udpchannel", "UDP packet dropped on send due to TxBuffer being full");
-                        } else {
-                            LOG("udpchannel", "error sending datagram: %s", evutil_socket_error_to_string(evutil_socket_geterror(mUDPSocket)));
-                        }
-                    } else if (sent < dgBuffer.size()) {
-                        LOG("udpchannel", "short write sending datagram - sent %d of %d bytes", send, dgBuffer.size());
-                    }
+                if (!mTxBuffersBusy.exchange(true, std::memory_order_acquire)) {
+                    encapsulateAndSend(pkt, mDatagramTxBuffer, mTxBuffers);
+                    mTxBuffersBusy.store(false, std::memory_order_release);
+                } else {
+                    std::vector<unsigned char> dgBuffer(maxPermittedDatagramSize);
+                    EncapsulateBuffers buffers;
+                    encapsulateAndSend(pkt, dgBuffer.data(), buffers);
                 }
             }
 
@@ -129,6 +238,15 @@ namespace afv_native {
             int getLastErrno() const;
 
             void setChannelConfig(const dto::ChannelConfig &config) override;
+
+            /** setLatencyHistograms sets the histograms that sendDto records the time spent encapsulating and
+             * sending into.  Either may be nullptr to not record that stage.
+             */
+            void setLatencyHistograms(util::LatencyHistogram *encapsulate, util::LatencyHistogram *send);
+
+            /** getStatistics returns a snapshot of the channel's traffic counters.  Safe to call from any thread. */
+            UDPChannelStats getStatistics() const;
+            void resetStatistics();
         };
     }
 }
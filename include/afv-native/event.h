@@ -47,6 +47,7 @@ namespace afv_native {
         PttClosed,
         StationAliasesUpdated,
         AudioError,
+        AudioDeadline, // data is a pointer to the afv::AudioIncident
     };
 }
 
@@ -0,0 +1,120 @@
+/* event/EventLoopThread.h
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef AFV_NATIVE_EVENTLOOPTHREAD_H
+#define AFV_NATIVE_EVENTLOOPTHREAD_H
+
+#include <atomic>
+#include <functional>
+#include <thread>
+
+#include <event2/event.h>
+#include <event2/util.h>
+
+#include "afv-native/util/MpscQueue.h"
+
+namespace afv_native {
+    namespace event {
+        /** EventLoopThread owns an event_base and runs it on a thread of its own.
+         *
+         * Everything attached to the base must only be touched from that thread once it's started, as libevent
+         * isn't built thread-safe here.  Other threads get work onto it with post() and call(), which go through
+         * a lock-free queue and wake the loop up through a socket pair.
+         *
+         * Set up whatever needs to be on the base before start(), and tear it down after stop().
+         */
+        class EventLoopThread {
+        public:
+            /** @param threadName the name the thread is given for debuggers, profilers and traces.  It must
+             *      outlive the thread.
+             */
+            explicit EventLoopThread(const char *threadName = "afv-network");
+            virtual ~EventLoopThread();
+
+            EventLoopThread(const EventLoopThread &copySrc) = delete;
+            EventLoopThread &operator=(const EventLoopThread &copySrc) = delete;
+
+            struct event_base *getEventBase() const;
+
+            void start();
+
+            /** stop runs anything already posted, then stops the loop and waits for the thread to exit.
+             *
+             * It mustn't be called from the loop thread itself.
+             */
+            void stop();
+
+            bool isRunning() const;
+
+            /** isLoopThread returns true if the caller is running on this loop's thread. */
+            bool isLoopThread() const;
+
+            /** post queues command to run on the loop thread, in order with everything else posted.  It
+             * doesn't wait for it to run.  Safe to call from any thread.
+             *
+             * Commands posted before start() run once the loop starts.
+             */
+            void post(std::function<void()> command);
+
+            /** call runs command on the loop thread and waits for it to finish.
+             *
+             * If called from the loop thread, or whilst the loop isn't running, command is run immediately on
+             * the calling thread instead.
+             */
+            void call(const std::function<void()> &command);
+
+        protected:
+            /** housekeepingIntervalMs is how often the loop wakes up on its own to pick up thread policy changes. */
+            static const int housekeepingIntervalMs = 1000;
+
+            const char *mThreadName;
+            struct event_base *mEvBase;
+            evutil_socket_t mWakeSockets[2];
+            struct event *mWakeEvent;
+            struct event *mHousekeepingEvent;
+
+            util::MpscQueue<std::function<void()>> mCommands;
+            std::atomic<bool> mWakePending;
+            std::atomic<bool> mRunning;
+            std::thread mThread;
+
+            static void evWakeCallback(evutil_socket_t fd, short events, void *arg);
+            static void evHousekeepingCallback(evutil_socket_t fd, short events, void *arg);
+
+            void run();
+            void wake();
+            void runCommands();
+        };
+    }
+}
+
+#endif //AFV_NATIVE_EVENTLOOPTHREAD_H
@@ -39,14 +39,22 @@
 
 namespace afv_native {
     namespace event {
+        class SimulatedEventDriver;
+
         /** EventTimer is a one-shot periodic event to be fired by libevent.
              *
+             * If a SimulatedEventDriver is registered for the event base when
+             * the timer is created, the driver schedules it on virtual time
+             * instead.
              */
         class EventTimer {
         private:
+            friend class SimulatedEventDriver;
+
             static void evCallback(evutil_socket_t fd, short events, void *arg);
         protected:
             struct event *mEvent;
+            SimulatedEventDriver *mSimDriver;
 
             virtual void triggered() = 0;
         public:
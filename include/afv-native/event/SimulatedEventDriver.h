@@ -0,0 +1,143 @@
+/* event/SimulatedEventDriver.h
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef AFV_NATIVE_SIMULATEDEVENTDRIVER_H
+#define AFV_NATIVE_SIMULATEDEVENTDRIVER_H
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <set>
+#include <utility>
+
+#include <event2/event.h>
+
+#include "afv-native/util/monotime.h"
+
+namespace afv_native {
+    namespace event {
+        class EventTimer;
+
+        /** SimulatedEventDriver runs the EventTimers of an event_base on
+         * virtual time.
+         *
+         * Whilst a driver is registered for an event_base, any EventTimer
+         * created against that base is scheduled by the driver instead of
+         * libevent, and only fires when the driver is advanced.  Timers fire in
+         * deadline order, with ties broken by the order they were armed, so a
+         * run is reproducible regardless of host speed.
+         *
+         * If installed as the clock (installClock()), monotime_get() reports
+         * the driver's virtual time too, so heartbeat supervision, source
+         * expiry and the like follow the simulation.
+         *
+         * Only timers are simulated - socket I/O registered directly with
+         * libevent (UDPChannel, the HTTP transfer manager) is not.
+         *
+         * The driver must be created before, and destroyed after, the timers
+         * on its base; timers still alive when the driver goes become inert.
+         */
+        class SimulatedEventDriver: public util::MonotimeSource {
+        public:
+            /** Register a driver for evBase.  evBase may be nullptr for a
+             * harness that has no libevent base at all.
+             */
+            explicit SimulatedEventDriver(struct event_base *evBase, util::monotime_t startTime = 0);
+            ~SimulatedEventDriver() override;
+
+            SimulatedEventDriver(const SimulatedEventDriver &copySrc) = delete;
+            SimulatedEventDriver &operator=(const SimulatedEventDriver &copySrc) = delete;
+
+            util::monotime_t now() const override;
+
+            /** install this driver as the monotime_get() source.  It is removed
+             * again when the driver is destroyed.
+             */
+            void installClock();
+
+            /** advance virtual time by deltaMs, firing every timer that falls
+             * due on the way.
+             *
+             * @return the number of timers fired.
+             */
+            size_t advance(util::monotime_t deltaMs);
+
+            /** advanceTo behaves as advance, but to an absolute virtual time.
+             * Times in the past are ignored.
+             */
+            size_t advanceTo(util::monotime_t targetTime);
+
+            /** fire timers in order until none remain or limitMs of virtual
+             * time has passed.  Periodic timers never go idle, so the limit is
+             * always required.
+             */
+            size_t runUntilIdle(util::monotime_t limitMs);
+
+            /** @return the number of timers currently armed. */
+            size_t pendingTimers() const;
+
+            /** @return the deadline of the next timer, or -1 if none are armed. */
+            util::monotime_t nextDeadline() const;
+
+            /** @return the driver registered for evBase, or nullptr. */
+            static SimulatedEventDriver *forBase(struct event_base *evBase);
+
+        protected:
+            friend class EventTimer;
+
+            typedef std::pair<util::monotime_t, uint64_t> ScheduleKey;
+
+            struct event_base *mEvBase;
+            std::atomic<util::monotime_t> mNow;
+            bool mClockInstalled;
+
+            mutable std::mutex mScheduleLock;
+            uint64_t mNextSequence;
+            std::map<ScheduleKey, EventTimer *> mSchedule;
+            std::map<const EventTimer *, ScheduleKey> mScheduledTimers;
+            std::set<EventTimer *> mAttachedTimers;
+
+            void attach(EventTimer *timer);
+            void detach(EventTimer *timer);
+            void schedule(EventTimer *timer, unsigned int delayMs);
+            void cancel(EventTimer *timer);
+            bool isScheduled(const EventTimer *timer) const;
+
+            /** fire the earliest timer if it is due at or before limit. */
+            bool fireNext(util::monotime_t limit);
+        };
+    }
+}
+
+#endif //AFV_NATIVE_SIMULATEDEVENTDRIVER_H
@@ -0,0 +1,124 @@
+/* util/DenormalGuard.h
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef AFV_NATIVE_DENORMALGUARD_H
+#define AFV_NATIVE_DENORMALGUARD_H
+
+#include <cmath>
+#include <cstdint>
+
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define AFV_NATIVE_DENORMALS_SSE
+#elif defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))
+#define AFV_NATIVE_DENORMALS_AARCH64
+#endif
+
+namespace afv_native {
+    namespace util {
+        /** denormalThreshold is the magnitude below which filter state is treated as silence.
+         *
+         * It's about -300dBFS, so well below anything audible, and a long way above where floats go subnormal.
+         */
+        const float denormalThreshold = 1e-15f;
+
+        /** flushDenormal returns 0 for anything too small to matter, and value otherwise.
+         *
+         * This is for recursive filter state, which would otherwise decay into the subnormal range during
+         * silence - where, on x86, every operation on it takes a microcode assist.  It also covers platforms
+         * (and host threads) where FlushDenormalsScope can't help.
+         */
+        inline float flushDenormal(float value)
+        {
+            return (std::fabs(value) < denormalThreshold) ? 0.0f : value;
+        }
+
+        /** denormalFlushSupported is true if FlushDenormalsScope actually does anything on this platform. */
+#if defined(AFV_NATIVE_DENORMALS_SSE) || defined(AFV_NATIVE_DENORMALS_AARCH64)
+        const bool denormalFlushSupported = true;
+#else
+        const bool denormalFlushSupported = false;
+#endif
+
+        /** FlushDenormalsScope has the FPU flush subnormal results to zero (FTZ), and treat subnormal inputs
+         * as zero (DAZ, on x86), on the calling thread for as long as it exists.  The previous mode is restored
+         * when it's destroyed, so it's safe to use on a thread that isn't ours, like an audio API's callback.
+         */
+        class FlushDenormalsScope {
+        public:
+            explicit FlushDenormalsScope(bool enable = true):
+                    mEnabled(enable),
+                    mSavedMode(0)
+            {
+                if (!mEnabled) {
+                    return;
+                }
+#if defined(AFV_NATIVE_DENORMALS_SSE)
+                mSavedMode = _mm_getcsr();
+                _mm_setcsr(mSavedMode | sseFlushToZero | sseDenormalsAreZero);
+#elif defined(AFV_NATIVE_DENORMALS_AARCH64)
+                uint64_t fpcr;
+                __asm__ __volatile__("mrs %0, fpcr" : "=r"(fpcr));
+                mSavedMode = fpcr;
+                fpcr |= aarch64FlushToZero;
+                __asm__ __volatile__("msr fpcr, %0" : : "r"(fpcr));
+#endif
+            }
+
+            ~FlushDenormalsScope()
+            {
+                if (!mEnabled) {
+                    return;
+                }
+#if defined(AFV_NATIVE_DENORMALS_SSE)
+                _mm_setcsr(static_cast<unsigned int>(mSavedMode));
+#elif defined(AFV_NATIVE_DENORMALS_AARCH64)
+                uint64_t fpcr = mSavedMode;
+                __asm__ __volatile__("msr fpcr, %0" : : "r"(fpcr));
+#endif
+            }
+
+            FlushDenormalsScope(const FlushDenormalsScope &copySrc) = delete;
+            FlushDenormalsScope &operator=(const FlushDenormalsScope &copySrc) = delete;
+
+        private:
+            static const unsigned int sseFlushToZero = 0x8000;
+            static const unsigned int sseDenormalsAreZero = 0x0040;
+            static const uint64_t aarch64FlushToZero = uint64_t(1) << 24;
+
+            bool mEnabled;
+            uint64_t mSavedMode;
+        };
+    }
+}
+
+#endif //AFV_NATIVE_DENORMALGUARD_H
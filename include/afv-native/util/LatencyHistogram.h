@@ -0,0 +1,160 @@
+/* util/LatencyHistogram.h
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef AFV_NATIVE_LATENCYHISTOGRAM_H
+#define AFV_NATIVE_LATENCYHISTOGRAM_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace afv_native {
+    namespace util {
+        /** LatencyHistogramSnapshot is a point-in-time copy of a LatencyHistogram.
+         *
+         * Bucket 0 holds samples under 1us, and bucket n (n > 0) holds samples in [2^(n-1), 2^n) us.  The last
+         * bucket also collects everything larger.
+         */
+        struct LatencyHistogramSnapshot {
+            static const size_t bucketCount = 24;
+
+            uint64_t Buckets[bucketCount];
+            uint64_t Count;
+            uint64_t TotalUs;
+            uint32_t MaxUs;
+
+            LatencyHistogramSnapshot();
+
+            double getMeanUs() const;
+
+            /** getPercentileUs estimates the given percentile (0-100).
+             *
+             * @return the upper edge of the bucket the percentile falls into, clamped to MaxUs, or 0 if no samples
+             *      have been recorded.
+             */
+            uint32_t getPercentileUs(double percentile) const;
+
+            /** getBucketUpperBoundUs returns the (exclusive) upper edge of the given bucket. */
+            static uint32_t getBucketUpperBoundUs(size_t bucket);
+
+            /** getBucketForUs returns the bucket a sample of the given duration falls into. */
+            static size_t getBucketForUs(uint32_t us);
+        };
+
+        /** LatencyHistogram counts durations into fixed power-of-two buckets.
+         *
+         * Recording is wait-free (a handful of relaxed atomic adds) so it's safe to use from the audio callbacks,
+         * and snapshot() can be called from any thread.  A snapshot taken while samples are being recorded may be
+         * off by the samples in flight, but is never torn badly enough to matter for diagnostics.
+         *
+         * Histograms start disabled.  While disabled, ScopedLatency doesn't even read the clock.
+         */
+        class LatencyHistogram {
+        public:
+            LatencyHistogram();
+
+            LatencyHistogram(const LatencyHistogram &copySrc) = delete;
+            LatencyHistogram &operator=(const LatencyHistogram &copySrc) = delete;
+
+            void setEnabled(bool enabled)
+            {
+                mEnabled.store(enabled, std::memory_order_relaxed);
+            }
+
+            bool isEnabled() const
+            {
+                return mEnabled.load(std::memory_order_relaxed);
+            }
+
+            void record(uint32_t us);
+
+            /** takePendingUs returns the total time recorded since the last call, and starts a new total.
+             *
+             * This lets the audio deadline watchdog work out where the time went in a single frame.
+             */
+            uint32_t takePendingUs()
+            {
+                return mPendingUs.exchange(0, std::memory_order_relaxed);
+            }
+
+            LatencyHistogramSnapshot snapshot() const;
+
+            /** reset clears all of the recorded samples.  It doesn't change whether the histogram is enabled. */
+            void reset();
+
+        protected:
+            std::atomic<bool> mEnabled;
+            std::atomic<uint64_t> mBuckets[LatencyHistogramSnapshot::bucketCount];
+            std::atomic<uint64_t> mCount;
+            std::atomic<uint64_t> mTotalUs;
+            std::atomic<uint32_t> mMaxUs;
+            std::atomic<uint32_t> mPendingUs;
+        };
+
+        /** ScopedLatency records the time between its construction and destruction into a histogram.
+         *
+         * The histogram may be null, in which case (as when it's disabled) nothing is timed.
+         */
+        class ScopedLatency {
+        public:
+            typedef std::chrono::steady_clock clock;
+
+            explicit ScopedLatency(LatencyHistogram *histogram):
+                    mHistogram((histogram != nullptr && histogram->isEnabled()) ? histogram : nullptr),
+                    mStart()
+            {
+                if (mHistogram != nullptr) {
+                    mStart = clock::now();
+                }
+            }
+
+            ~ScopedLatency()
+            {
+                if (mHistogram != nullptr) {
+                    const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - mStart);
+                    mHistogram->record(static_cast<uint32_t>(elapsed.count()));
+                }
+            }
+
+            ScopedLatency(const ScopedLatency &copySrc) = delete;
+            ScopedLatency &operator=(const ScopedLatency &copySrc) = delete;
+
+        private:
+            LatencyHistogram *mHistogram;
+            clock::time_point mStart;
+        };
+    }
+}
+
+#endif //AFV_NATIVE_LATENCYHISTOGRAM_H
@@ -0,0 +1,121 @@
+/* util/MpscQueue.h
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef AFV_NATIVE_MPSCQUEUE_H
+#define AFV_NATIVE_MPSCQUEUE_H
+
+#include <atomic>
+#include <utility>
+
+namespace afv_native {
+    namespace util {
+        /** MpscQueue is an unbounded, lock-free, multiple-producer single-consumer FIFO.
+         *
+         * It's Dmitry Vyukov's non-intrusive MPSC queue:  producers swap their node into the head with a
+         * single exchange, and link it to its predecessor afterwards, so push() never waits on anybody.  The
+         * consumer walks the list from a stub node.  Between a producer's exchange and its link, pop() can't
+         * see that node (or anything pushed after it) yet, so an empty pop() only means "nothing ready", not
+         * "nothing coming" - whatever woke the consumer up has to be signalled after push() returns.
+         *
+         * push() allocates, so it's not for audio threads.  T must be default constructible.
+         */
+        template<typename T>
+        class MpscQueue {
+        public:
+            MpscQueue():
+                    mHead(new Node()),
+                    mTail(mHead.load())
+            {
+            }
+
+            ~MpscQueue()
+            {
+                T discard;
+                while (pop(discard)) {
+                }
+                delete mTail;
+            }
+
+            MpscQueue(const MpscQueue &copySrc) = delete;
+            MpscQueue &operator=(const MpscQueue &copySrc) = delete;
+
+            /** push adds value to the queue.  Safe to call from any thread. */
+            void push(T value)
+            {
+                Node *node = new Node(std::move(value));
+                Node *prev = mHead.exchange(node, std::memory_order_acq_rel);
+                prev->Next.store(node, std::memory_order_release);
+            }
+
+            /** pop takes the oldest value off the queue.  Must only be called by one thread at a time.
+             *
+             * @return true if valueOut was set, false if there was nothing ready.
+             */
+            bool pop(T &valueOut)
+            {
+                Node *tail = mTail;
+                Node *next = tail->Next.load(std::memory_order_acquire);
+                if (next == nullptr) {
+                    return false;
+                }
+                valueOut = std::move(next->Value);
+                // next becomes the new stub.
+                mTail = next;
+                delete tail;
+                return true;
+            }
+
+        protected:
+            struct Node {
+                std::atomic<Node *> Next;
+                T Value;
+
+                Node():
+                        Next(nullptr),
+                        Value()
+                {
+                }
+
+                explicit Node(T value):
+                        Next(nullptr),
+                        Value(std::move(value))
+                {
+                }
+            };
+
+            std::atomic<Node *> mHead;
+            Node *mTail;
+        };
+    }
+}
+
+#endif //AFV_NATIVE_MPSCQUEUE_H
@@ -0,0 +1,199 @@
+/* util/ProfiledMutex.h
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef AFV_NATIVE_PROFILEDMUTEX_H
+#define AFV_NATIVE_PROFILEDMUTEX_H
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifdef AFV_NATIVE_PROFILE_LOCKS
+#include <atomic>
+#include <chrono>
+#endif
+
+namespace afv_native {
+    namespace util {
+        /** LockStats is a snapshot of the contention counters for one named lock. */
+        struct LockStats {
+            std::string Name;
+            uint64_t Acquisitions;
+            /** ContendedAcquisitions counts the acquisitions that had to wait for another thread. */
+            uint64_t ContendedAcquisitions;
+            uint64_t TotalWaitUs;
+            uint32_t MaxWaitUs;
+            uint64_t TotalHoldUs;
+            uint32_t MaxHoldUs;
+
+            LockStats();
+        };
+
+        /** isLockProfilingEnabled returns true if the library was built with AFV_NATIVE_PROFILE_LOCKS. */
+        bool isLockProfilingEnabled();
+
+        /** getLockStatistics returns the counters for every named ProfiledMutex, sorted by name.
+         *
+         * Counters are kept per name, so every instance of (say) RemoteVoiceSource's jitter buffer lock adds to
+         * the same entry, and they survive the instances being destroyed.  Without AFV_NATIVE_PROFILE_LOCKS this
+         * is always empty.
+         */
+        std::vector<LockStats> getLockStatistics();
+        void resetLockStatistics();
+
+#ifdef AFV_NATIVE_PROFILE_LOCKS
+        struct LockCounters {
+            std::atomic<uint64_t> Acquisitions;
+            std::atomic<uint64_t> ContendedAcquisitions;
+            std::atomic<uint64_t> TotalWaitUs;
+            std::atomic<uint32_t> MaxWaitUs;
+            std::atomic<uint64_t> TotalHoldUs;
+            std::atomic<uint32_t> MaxHoldUs;
+        };
+
+        /** getLockCounters returns the (permanent) counters for the named lock, creating them if needed. */
+        LockCounters *getLockCounters(const char *name);
+#endif
+
+        /** ProfiledMutex is a std::mutex that, when the library is built with AFV_NATIVE_PROFILE_LOCKS, counts
+         * how often it's taken, how often and how long threads wait for it, and how long it's held.
+         *
+         * Without AFV_NATIVE_PROFILE_LOCKS it's just a std::mutex, and costs nothing extra.
+         *
+         * With it, an uncontended lock/unlock pair costs two clock reads and a few relaxed atomic adds on top of
+         * the mutex itself - fine for finding out which locks hurt, but not something to ship.
+         */
+        class ProfiledMutex {
+        public:
+#ifdef AFV_NATIVE_PROFILE_LOCKS
+            explicit ProfiledMutex(const char *name):
+                    mMutex(),
+                    mCounters(getLockCounters(name)),
+                    mAcquiredAt()
+            {
+            }
+#else
+            explicit ProfiledMutex(const char *):
+                    mMutex()
+            {
+            }
+#endif
+
+            ProfiledMutex(const ProfiledMutex &copySrc) = delete;
+            ProfiledMutex &operator=(const ProfiledMutex &copySrc) = delete;
+
+#ifdef AFV_NATIVE_PROFILE_LOCKS
+            void lock()
+            {
+                if (mMutex.try_lock()) {
+                    mAcquiredAt = clock::now();
+                    acquired(false, 0);
+                    return;
+                }
+                const auto waitStart = clock::now();
+                mMutex.lock();
+                mAcquiredAt = clock::now();
+                acquired(true, toUs(mAcquiredAt - waitStart));
+            }
+
+            bool try_lock()
+            {
+                if (!mMutex.try_lock()) {
+                    return false;
+                }
+                mAcquiredAt = clock::now();
+                acquired(false, 0);
+                return true;
+            }
+
+            void unlock()
+            {
+                const uint32_t heldUs = toUs(clock::now() - mAcquiredAt);
+                mMutex.unlock();
+                mCounters->TotalHoldUs.fetch_add(heldUs, std::memory_order_relaxed);
+                updateMax(mCounters->MaxHoldUs, heldUs);
+            }
+#else
+            void lock()
+            {
+                mMutex.lock();
+            }
+
+            bool try_lock()
+            {
+                return mMutex.try_lock();
+            }
+
+            void unlock()
+            {
+                mMutex.unlock();
+            }
+#endif
+
+        private:
+            std::mutex mMutex;
+#ifdef AFV_NATIVE_PROFILE_LOCKS
+            typedef std::chrono::steady_clock clock;
+
+            LockCounters *mCounters;
+            /** mAcquiredAt is only touched by the thread holding the lock. */
+            clock::time_point mAcquiredAt;
+
+            static uint32_t toUs(clock::duration d)
+            {
+                return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(d).count());
+            }
+
+            static void updateMax(std::atomic<uint32_t> &maxValue, uint32_t value)
+            {
+                uint32_t oldMax = maxValue.load(std::memory_order_relaxed);
+                while (value > oldMax && !maxValue.compare_exchange_weak(oldMax, value, std::memory_order_relaxed)) {
+                }
+            }
+
+            void acquired(bool contended, uint32_t waitUs)
+            {
+                mCounters->Acquisitions.fetch_add(1, std::memory_order_relaxed);
+                if (contended) {
+                    mCounters->ContendedAcquisitions.fetch_add(1, std::memory_order_relaxed);
+                    mCounters->TotalWaitUs.fetch_add(waitUs, std::memory_order_relaxed);
+                    updateMax(mCounters->MaxWaitUs, waitUs);
+                }
+            }
+#endif
+        };
+    }
+}
+
+#endif //AFV_NATIVE_PROFILEDMUTEX_H
@@ -0,0 +1,196 @@
+/* util/RcuPointer.h
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef AFV_NATIVE_RCUPOINTER_H
+#define AFV_NATIVE_RCUPOINTER_H
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace afv_native {
+    namespace util {
+        /** RcuPointer publishes a shared_ptr to readers that must never block or free memory.
+         *
+         * Readers take a ReadGuard with read(), which is wait-free and gives them a raw pointer that remains
+         * valid until the guard goes out of scope.  Writers publish() a new object and then wait for every
+         * reader that might still be using the old one to finish before releasing it, so the old object is
+         * always destroyed on the writer's thread and never on a reader's.
+         *
+         * The grace period tracking is the two-counter scheme from SRCU:  readers count themselves into
+         * the slot for the current epoch, and the writer flips the epoch and drains the old slot twice, which
+         * covers readers that sampled the epoch just before a flip.
+         *
+         * This is intended for handing sources and sinks to the audio callbacks.
+         */
+        template<typename T>
+        class RcuPointer {
+        public:
+            /** ReadGuard holds a read-side critical section open for as long as it exists. */
+            class ReadGuard {
+            public:
+                ReadGuard(ReadGuard &&moveSrc) noexcept:
+                        mReaderCount(moveSrc.mReaderCount),
+                        mPtr(moveSrc.mPtr)
+                {
+                    moveSrc.mReaderCount = nullptr;
+                    moveSrc.mPtr = nullptr;
+                }
+
+                ReadGuard(const ReadGuard &copySrc) = delete;
+                ReadGuard &operator=(const ReadGuard &copySrc) = delete;
+                ReadGuard &operator=(ReadGuard &&moveSrc) = delete;
+
+                ~ReadGuard()
+                {
+                    if (mReaderCount != nullptr) {
+                        mReaderCount->fetch_sub(1);
+                    }
+                }
+
+                T *get() const
+                {
+                    return mPtr;
+                }
+
+                T *operator->() const
+                {
+                    return mPtr;
+                }
+
+                explicit operator bool() const
+                {
+                    return mPtr != nullptr;
+                }
+
+            private:
+                friend class RcuPointer;
+
+                ReadGuard(std::atomic<int> *readerCount, T *ptr):
+                        mReaderCount(readerCount),
+                        mPtr(ptr)
+                {
+                }
+
+                std::atomic<int> *mReaderCount;
+                T *mPtr;
+            };
+
+            RcuPointer():
+                    mCurrent(nullptr),
+                    mEpoch(0),
+                    mReaders{{0}, {0}},
+                    mWriterLock(),
+                    mOwner()
+            {
+            }
+
+            RcuPointer(const RcuPointer &copySrc) = delete;
+            RcuPointer &operator=(const RcuPointer &copySrc) = delete;
+
+            /** read enters a read-side critical section and returns the currently published object.
+             *
+             * This is wait-free and safe to call from a realtime thread.
+             */
+            ReadGuard read()
+            {
+                auto *readerCount = &mReaders[mEpoch.load() & 1U];
+                readerCount->fetch_add(1);
+                return ReadGuard(readerCount, mCurrent.load());
+            }
+
+            /** unpublish withdraws the published object if it is still expected, so that subsequent readers
+             * see nullptr.
+             *
+             * It doesn't release the object - that happens on the next publish(), or when the RcuPointer is
+             * destroyed - so it's safe to call from a reader holding a ReadGuard for expected.
+             *
+             * @return true if expected was withdrawn, false if something else had already been published.
+             */
+            bool unpublish(T *expected)
+            {
+                return mCurrent.compare_exchange_strong(expected, nullptr);
+            }
+
+            /** publish replaces the published object.
+             *
+             * Blocks until no reader can still be using the previous object, then releases our reference to
+             * it.  Must not be called from a reader, or with a ReadGuard held.
+             */
+            void publish(std::shared_ptr<T> newPtr)
+            {
+                std::shared_ptr<T> oldPtr;
+                {
+                    std::lock_guard<std::mutex> writerGuard(mWriterLock);
+                    mCurrent.store(newPtr.get());
+                    oldPtr = std::move(mOwner);
+                    mOwner = std::move(newPtr);
+                    synchronize();
+                }
+                // oldPtr is released here, outside of the writer lock.
+            }
+
+            /** isPublished returns true if there is currently an object visible to readers. */
+            bool isPublished() const
+            {
+                return mCurrent.load() != nullptr;
+            }
+
+        private:
+            std::atomic<T *> mCurrent;
+            std::atomic<unsigned int> mEpoch;
+            std::atomic<int> mReaders[2];
+
+            std::mutex mWriterLock;
+            /** mOwner keeps the published (or unpublished but not yet released) object alive. */
+            std::shared_ptr<T> mOwner;
+
+            /** synchronize waits until every read-side critical section that started before it was called
+             * has finished.  mWriterLock must be held.
+             */
+            void synchronize()
+            {
+                for (int flip = 0; flip < 2; flip++) {
+                    const unsigned int oldEpoch = mEpoch.fetch_add(1);
+                    while (mReaders[oldEpoch & 1U].load() != 0) {
+                        std::this_thread::sleep_for(std::chrono::microseconds(100));
+                    }
+                }
+            }
+        };
+    }
+}
+
+#endif //AFV_NATIVE_RCUPOINTER_H
@@ -0,0 +1,126 @@
+/* util/RealtimeArena.h
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef AFV_NATIVE_REALTIMEARENA_H
+#define AFV_NATIVE_REALTIMEARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace afv_native {
+    namespace util {
+        /** RealtimeArenaStats is a snapshot of a RealtimeArena's usage. */
+        struct RealtimeArenaStats {
+            size_t CapacityBytes;
+            size_t UsedBytes;
+            /** Locked is true if the arena itself is locked into memory. */
+            bool Locked;
+            /** LockedRegionBytes is the total size of the other regions currently pinned with lockRegion(). */
+            size_t LockedRegionBytes;
+            /** LockFailures counts the lockRegion() calls the OS refused. */
+            uint32_t LockFailures;
+            /** FailedAllocations counts the allocations that didn't fit. */
+            uint32_t FailedAllocations;
+
+            RealtimeArenaStats();
+        };
+
+        /** RealtimeArena is a fixed block of memory for the audio threads' working data.
+         *
+         * The whole block is touched when the arena is created, so that it's resident before the audio
+         * threads get to it, and is locked into memory where the OS allows (mlock/VirtualLock) so that it
+         * can't be paged out again when the client sits idle.  If locking isn't permitted (RLIMIT_MEMLOCK,
+         * or the process working set limit on Windows), the arena still works - it's just not locked, which
+         * getStatistics() reports.
+         *
+         * Allocation is a simple bump of an offset, and nothing is ever freed until the arena is destroyed.
+         * Users are expected to allocate everything they need up front and pool it.  allocate() and
+         * lockRegion() take a lock, so neither belongs on an audio thread.
+         */
+        class RealtimeArena {
+        public:
+            explicit RealtimeArena(size_t capacityBytes);
+            virtual ~RealtimeArena();
+
+            RealtimeArena(const RealtimeArena &copySrc) = delete;
+            RealtimeArena &operator=(const RealtimeArena &copySrc) = delete;
+
+            /** allocate returns size bytes of zeroed memory from the arena, or nullptr if it doesn't fit.
+             *
+             * @param alignment must be a power of two, no larger than the page size.
+             */
+            void *allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+            template<class T>
+            T *allocateArray(size_t count)
+            {
+                return static_cast<T *>(allocate(sizeof(T) * count, alignof(T)));
+            }
+
+            /** lockRegion prefaults and locks memory that the arena doesn't own (such as the effect samples).
+             *
+             * The arena doesn't know when that memory goes away, so the caller must unlockRegion() it before
+             * it's freed.  Regions still locked when the arena is destroyed are left alone.
+             *
+             * @return true if the region was locked.  It's prefaulted either way.
+             */
+            bool lockRegion(const void *ptr, size_t len);
+
+            /** unlockRegion unlocks a region previously locked with lockRegion().
+             *
+             * @return true if the region was found (and unlocked).
+             */
+            bool unlockRegion(const void *ptr, size_t len);
+
+            RealtimeArenaStats getStatistics() const;
+
+            /** pageSize returns the OS's memory page size. */
+            static size_t pageSize();
+        protected:
+            mutable std::mutex mLock;
+            unsigned char *mBase;
+            size_t mCapacity;
+            size_t mUsed;
+            bool mLocked;
+            uint32_t mFailedAllocations;
+            uint32_t mLockFailures;
+            /** mLockedRegions are the (page aligned) regions locked by lockRegion. */
+            std::vector<std::pair<const void *, size_t>> mLockedRegions;
+            size_t mLockedRegionBytes;
+        };
+    }
+}
+
+#endif //AFV_NATIVE_REALTIMEARENA_H
@@ -0,0 +1,106 @@
+/* util/RealtimeGuard.h
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef AFV_NATIVE_REALTIMEGUARD_H
+#define AFV_NATIVE_REALTIMEGUARD_H
+
+#include <cstdint>
+
+namespace afv_native {
+    namespace util {
+        /** RealtimeScope marks the calling thread as running real-time code (an audio device callback) for as
+         * long as it exists.  Scopes nest.
+         *
+         * On its own this only sets a thread-local flag.  When the library is built with AFV_NATIVE_RT_ALLOC_GUARD
+         * (or linked into the test suite), the replacement operator new/delete count, or trap, every heap
+         * operation made whilst the flag is set.
+         */
+        class RealtimeScope {
+        public:
+            RealtimeScope();
+            ~RealtimeScope();
+
+            RealtimeScope(const RealtimeScope &copySrc) = delete;
+            RealtimeScope &operator=(const RealtimeScope &copySrc) = delete;
+        };
+
+        /** RealtimeAllocationPermit suspends the guard on the calling thread for as long as it exists.
+         *
+         * This is for the few places where an audio thread knowingly touches the heap outside of the steady
+         * state, so that they don't drown out the allocations we actually want to hear about.
+         */
+        class RealtimeAllocationPermit {
+        public:
+            RealtimeAllocationPermit();
+            ~RealtimeAllocationPermit();
+
+            RealtimeAllocationPermit(const RealtimeAllocationPermit &copySrc) = delete;
+            RealtimeAllocationPermit &operator=(const RealtimeAllocationPermit &copySrc) = delete;
+        };
+
+        /** RealtimeAllocationStats counts the heap operations made inside a RealtimeScope. */
+        struct RealtimeAllocationStats {
+            uint64_t Allocations;
+            uint64_t Deallocations;
+
+            RealtimeAllocationStats();
+        };
+
+        /** isRealtimeThread returns true if the calling thread is inside a RealtimeScope. */
+        bool isRealtimeThread();
+
+        /** isRealtimeAllocationGuardInstalled returns true if the replacement operator new/delete are linked
+         * in.  Without them the statistics below never move.
+         */
+        bool isRealtimeAllocationGuardInstalled();
+
+        RealtimeAllocationStats getRealtimeAllocationStats();
+        void resetRealtimeAllocationStats();
+
+        /** setRealtimeAllocationTrap makes a heap operation inside a RealtimeScope abort the process (after
+         * saying why on stderr) rather than just being counted.  Useful under a debugger.
+         */
+        void setRealtimeAllocationTrap(bool trap);
+
+        /** __RealtimeHeapOperation is called by the replacement operator new/delete for every heap operation.
+         * It must not allocate.
+         */
+        void __RealtimeHeapOperation(bool allocation);
+
+        /** __RealtimeAllocationGuardInstalled is called once by the replacement operator new/delete during
+         * static initialisation.
+         */
+        void __RealtimeAllocationGuardInstalled();
+    }
+}
+
+#endif //AFV_NATIVE_REALTIMEGUARD_H
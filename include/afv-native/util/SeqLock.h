@@ -0,0 +1,139 @@
+/* util/SeqLock.h
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef AFV_NATIVE_SEQLOCK_H
+#define AFV_NATIVE_SEQLOCK_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <type_traits>
+
+namespace afv_native {
+    namespace util {
+        /** SeqLock publishes a small, trivially copyable value to readers that must never block.
+         *
+         * Readers take a consistent snapshot with load(), retrying if they raced a writer - they never take a
+         * lock and never wait on a writer that isn't actively storing.  Writers are serialised against each
+         * other with an ordinary mutex, which readers never touch.
+         *
+         * This is intended for configuration that's changed from the UI and read from the audio threads.
+         */
+        template<typename T>
+        class SeqLock {
+            static_assert(std::is_trivially_copyable<T>::value, "SeqLock can only hold trivially copyable types");
+        public:
+            SeqLock():
+                    mSequence(0),
+                    mWriterLock(),
+                    mPayload()
+            {
+                _store(T());
+            }
+
+            explicit SeqLock(const T &initialValue):
+                    mSequence(0),
+                    mWriterLock(),
+                    mPayload()
+            {
+                _store(initialValue);
+            }
+
+            SeqLock(const SeqLock &copySrc) = delete;
+            SeqLock &operator=(const SeqLock &copySrc) = delete;
+
+            /** load returns a consistent copy of the current value. */
+            T load() const
+            {
+                uint32_t words[wordCount];
+                uint32_t seqBefore, seqAfter;
+                do {
+                    seqBefore = mSequence.load(std::memory_order_acquire);
+                    for (size_t i = 0; i < wordCount; i++) {
+                        words[i] = mPayload[i].load(std::memory_order_relaxed);
+                    }
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    seqAfter = mSequence.load(std::memory_order_relaxed);
+                } while ((seqBefore & 1U) != 0 || seqBefore != seqAfter);
+                T value;
+                ::memcpy(&value, words, sizeof(T));
+                return value;
+            }
+
+            /** store replaces the current value. */
+            void store(const T &newValue)
+            {
+                std::lock_guard<std::mutex> writerGuard(mWriterLock);
+                _store(newValue);
+            }
+
+            /** update atomically (with respect to other writers) modifies the current value.
+             *
+             * @param updateFn a callable taking a T&, which is called with a copy of the current value, and
+             *      should modify it as required.
+             */
+            template<typename Fn>
+            void update(Fn updateFn)
+            {
+                std::lock_guard<std::mutex> writerGuard(mWriterLock);
+                T value = load();
+                updateFn(value);
+                _store(value);
+            }
+
+        private:
+            static const size_t wordCount = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+            std::atomic<uint32_t> mSequence;
+            std::mutex mWriterLock;
+            std::atomic<uint32_t> mPayload[wordCount];
+
+            void _store(const T &newValue)
+            {
+                uint32_t words[wordCount] = {};
+                ::memcpy(words, &newValue, sizeof(T));
+
+                const uint32_t seq = mSequence.load(std::memory_order_relaxed);
+                mSequence.store(seq + 1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+                for (size_t i = 0; i < wordCount; i++) {
+                    mPayload[i].store(words[i], std::memory_order_relaxed);
+                }
+                mSequence.store(seq + 2, std::memory_order_release);
+            }
+        };
+    }
+}
+
+#endif //AFV_NATIVE_SEQLOCK_H
@@ -0,0 +1,119 @@
+/* util/ThreadPolicy.h
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef AFV_NATIVE_THREADPOLICY_H
+#define AFV_NATIVE_THREADPOLICY_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace afv_native {
+    namespace util {
+        /** ThreadClass identifies the kinds of thread the library runs code on. */
+        enum class ThreadClass {
+            /** Audio is the thread that plays back (and, for duplex devices, captures) audio - the audio device
+             * callback, or NullAudioDevice's thread.
+             */
+            Audio = 0,
+            /** AudioCapture is the capture callback, for audio APIs that use a separate thread for it. */
+            AudioCapture,
+            /** Logging is the asynchronous logger's writer. */
+            Logging,
+            /** Network is the Client's own event loop, when it's asked to run one. */
+            Network,
+        };
+        const size_t threadClassCount = 4;
+
+        const char *getThreadClassName(ThreadClass threadClass);
+
+        enum class ThreadPriority {
+            /** Default leaves the thread's scheduling as the OS or audio API set it up. */
+            Default = 0,
+            /** Elevated asks for better than normal priority, without real-time scheduling. */
+            Elevated,
+            /** Realtime asks for real-time scheduling (SCHED_FIFO, or THREAD_PRIORITY_TIME_CRITICAL on Windows). */
+            Realtime,
+        };
+
+        struct ThreadPolicy {
+            ThreadPriority Priority;
+            /** RealtimePriority is the SCHED_FIFO priority used for ThreadPriority::Realtime on POSIX systems.
+             * It's clamped to what the OS supports.
+             */
+            int RealtimePriority;
+            /** CpuMask is the set of CPUs the thread may run on, with bit 0 being the first CPU.  0 leaves the
+             * affinity as it was.
+             */
+            uint64_t CpuMask;
+
+            ThreadPolicy();
+        };
+
+        /** ThreadPolicyStatus records what was actually achieved the last time a thread of a class applied
+         * its policy.
+         */
+        struct ThreadPolicyStatus {
+            /** Applied is set once a thread of this class has applied the current policy. */
+            bool Applied;
+            /** Priority is the priority the thread ended up with.  Where the OS refuses real-time scheduling
+             * (say, no CAP_SYS_NICE or RLIMIT_RTPRIO on Linux), we fall back to Elevated, and then Default.
+             */
+            ThreadPriority Priority;
+            bool AffinityApplied;
+            /** LastError is the OS error from the last thing that failed, or 0. */
+            int LastError;
+
+            ThreadPolicyStatus();
+        };
+
+        /** setThreadPolicy sets the policy for a class of threads.  Safe to call from any thread.
+         *
+         * The threads pick it up the next time they call maintainThreadPolicy, which they do regularly (for the
+         * audio threads, every callback).
+         */
+        void setThreadPolicy(ThreadClass threadClass, const ThreadPolicy &policy);
+        ThreadPolicy getThreadPolicy(ThreadClass threadClass);
+        ThreadPolicyStatus getThreadPolicyStatus(ThreadClass threadClass);
+
+        /** maintainThreadPolicy names the calling thread (for debuggers, profilers and traces) and applies its
+         * class's policy, the first time it's called on a thread and again whenever the policy changes.
+         *
+         * Otherwise, it's just a couple of loads, so it's fine to call from an audio callback.  A thread should
+         * only ever belong to one class.
+         *
+         * @param name the thread's name.  Linux only keeps the first 15 characters.
+         */
+        void maintainThreadPolicy(ThreadClass threadClass, const char *name);
+    }
+}
+
+#endif //AFV_NATIVE_THREADPOLICY_H
@@ -0,0 +1,167 @@
+/* util/Trace.h
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef AFV_NATIVE_TRACE_H
+#define AFV_NATIVE_TRACE_H
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+
+/** TRACE_SCOPE records a span covering the rest of the enclosing scope.  category and name must be string
+ * literals (or otherwise outlive the trace).
+ */
+#define TRACE_SCOPE(category,name) \
+    ::afv_native::util::TraceScope AFV_NATIVE_TRACE_CONCAT(__traceScope, __LINE__)(category, name)
+#define AFV_NATIVE_TRACE_CONCAT(a,b) AFV_NATIVE_TRACE_CONCAT2(a,b)
+#define AFV_NATIVE_TRACE_CONCAT2(a,b) a##b
+
+namespace afv_native {
+    namespace util {
+        /** Tracing records begin/end spans and instant events into per-thread buffers, and exports them as
+         * Chrome trace-event JSON, which can be loaded into chrome://tracing or ui.perfetto.dev.
+         *
+         * Tracing is off by default, and costs one relaxed atomic load per trace point while it's off.  While
+         * it's on, recording an event is a clock read and a store into the calling thread's buffer - no locks
+         * and no allocation, except the first time each thread records an event in a given trace, when its
+         * buffer is allocated.  Real-time threads (those inside a RealtimeScope) instead adopt one of the
+         * realtimeTraceBuffers buffers that startTrace sets aside.  Once a thread's buffer is full, or if a
+         * real-time thread finds no spare, its further events are dropped and counted.
+         *
+         * All category and name strings are stored by pointer, so they must be string literals.
+         */
+        const size_t defaultTraceEventsPerThread = 65536;
+
+        /** realtimeTraceBuffers is the number of buffers startTrace sets aside for real-time threads - one each for
+         * the playback and capture threads.
+         */
+        const size_t realtimeTraceBuffers = 2;
+
+        extern std::atomic<bool> __TraceEnabled;
+
+        inline bool isTraceEnabled()
+        {
+            return __TraceEnabled.load(std::memory_order_relaxed);
+        }
+
+        /** startTrace discards any previous trace and starts recording a new one. */
+        void startTrace(size_t eventsPerThread = defaultTraceEventsPerThread);
+
+        /** stopTrace stops recording.  The recorded events are kept until the next startTrace. */
+        void stopTrace();
+
+        /** exportTrace stops recording and returns the trace as Chrome trace-event JSON. */
+        std::string exportTrace();
+
+        /** writeTrace stops recording and writes the trace to fileName.  Returns false if it couldn't. */
+        bool writeTrace(const std::string &fileName);
+
+        /** setTraceThreadName names the calling thread in exported traces. */
+        void setTraceThreadName(const char *name);
+
+        void __TraceRecord(char phase, const char *category, const char *name, const void *id);
+
+        inline void traceBegin(const char *category, const char *name)
+        {
+            if (isTraceEnabled()) {
+                __TraceRecord('B', category, name, nullptr);
+            }
+        }
+
+        inline void traceEnd(const char *category, const char *name)
+        {
+            if (isTraceEnabled()) {
+                __TraceRecord('E', category, name, nullptr);
+            }
+        }
+
+        inline void traceInstant(const char *category, const char *name)
+        {
+            if (isTraceEnabled()) {
+                __TraceRecord('i', category, name, nullptr);
+            }
+        }
+
+        /** traceAsyncBegin starts a span that may end on another thread, or interleave with other spans.
+         * id identifies the span, and must be passed to the matching traceAsyncEnd.
+         */
+        inline void traceAsyncBegin(const char *category, const char *name, const void *id)
+        {
+            if (isTraceEnabled()) {
+                __TraceRecord('b', category, name, id);
+            }
+        }
+
+        inline void traceAsyncEnd(const char *category, const char *name, const void *id)
+        {
+            if (isTraceEnabled()) {
+                __TraceRecord('e', category, name, id);
+            }
+        }
+
+        /** TraceScope records a span from its construction to its destruction.
+         *
+         * If tracing is started part way through the scope, nothing is recorded, so the begin and end always
+         * match up.
+         */
+        class TraceScope {
+        public:
+            TraceScope(const char *category, const char *name):
+                    mCategory(category),
+                    mName(name),
+                    mActive(isTraceEnabled())
+            {
+                if (mActive) {
+                    __TraceRecord('B', mCategory, mName, nullptr);
+                }
+            }
+
+            ~TraceScope()
+            {
+                if (mActive) {
+                    __TraceRecord('E', mCategory, mName, nullptr);
+                }
+            }
+
+            TraceScope(const TraceScope &copySrc) = delete;
+            TraceScope &operator=(const TraceScope &copySrc) = delete;
+
+        private:
+            const char *mCategory;
+            const char *mName;
+            bool mActive;
+        };
+    }
+}
+
+#endif //AFV_NATIVE_TRACE_H
@@ -50,6 +50,29 @@ namespace afv_native {
          * @return monotonic time in ms precision.
          */
         monotime_t monotime_get();
+
+        /** MonotimeSource is a replacement clock for monotime_get().
+         *
+         * Installing one redirects every monotime_get() caller (jitter buffers,
+         * heartbeat supervision, source expiry) to it, which is how the
+         * simulated event driver runs sessions on virtual time.
+         */
+        class MonotimeSource {
+        public:
+            virtual ~MonotimeSource() = default;
+
+            /** now() must be monotonic and in ms, like monotime_get(). */
+            virtual monotime_t now() const = 0;
+        };
+
+        /** monotime_set_source() installs a replacement clock.
+         *
+         * Passing nullptr restores the system steady clock.  The source must
+         * outlive its installation.
+         *
+         * @return the previously installed source (or nullptr).
+         */
+        MonotimeSource *monotime_set_source(MonotimeSource *source);
     }
 }
 
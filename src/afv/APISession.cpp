@@ -44,11 +44,31 @@
 #include "afv-native/http/RESTRequest.h"
 #include "afv-native/afv/dto/AuthRequest.h"
 #include "afv-native/afv/dto/PostCallsignResponse.h"
+#include "afv-native/util/Trace.h"
 
 using namespace ::afv_native::afv;
 using namespace ::afv_native;
 using json = nlohmann::json;
 
+namespace {
+    const char *stateTraceName(APISessionState state)
+    {
+        switch (state) {
+        case APISessionState::Disconnected:
+            return "APISession Disconnected";
+        case APISessionState::Connecting:
+            return "APISession Connecting";
+        case APISessionState::Running:
+            return "APISession Running";
+        case APISessionState::Reconnecting:
+            return "APISession Reconnecting";
+        case APISessionState::Error:
+            return "APISession Error";
+        }
+        return "APISession";
+    }
+}
+
 APISession::APISession(event_base *evBase, http::TransferManager &tm, std::string baseUrl, std::string clientName):
         StateCallback(),
         AliasUpdateCallback(),
@@ -131,7 +151,7 @@ APISession::_authenticationCallback(http::RESTRequest *req, bool success)
     if (success && req->getStatusCode() == 200) {
         mBearerToken = req->getResponseBody();
     	if (mBearerToken.empty()) {
-            LOG("APISession", "No Token Received");
+            LOGERROR("APISession", "No Token Received");
             mBearerToken = "";
             raiseError(APISessionError::InvalidAuthToken);
             return;
@@ -141,7 +161,7 @@ APISession::_authenticationCallback(http::RESTRequest *req, bool success)
             std::error_code ec;
             auto dec_token = jwt::decode(mBearerToken, algorithms({"none"}), ec, verify(false));
             if (ec) {
-                LOG("APISession", "couldn't parse bearer token: %s", ec.message().c_str());
+                LOGERROR("APISession", "couldn't parse bearer token: %s", ec.message().c_str());
 	            mBearerToken = "";
                 raiseError(APISessionError::InvalidAuthToken);
 	            return;
@@ -151,7 +171,7 @@ APISession::_authenticationCallback(http::RESTRequest *req, bool success)
                 	const int timeRemaining = expiry - ::time(nullptr);
                 	if (timeRemaining <= 60) {
                 		//FIXME: report error upstream.
-                		LOG("APISession", "token TTL (%d) is <= 60s.  Please check your system clock.", timeRemaining);
+                		LOGWARN("APISession", "token TTL (%d) is <= 60s.  Please check your system clock.", timeRemaining);
                 		mBearerToken = "";
                         raiseError(APISessionError::AuthTokenExpiryTimeInPast);
                 		return;
@@ -166,7 +186,7 @@ APISession::_authenticationCallback(http::RESTRequest *req, bool success)
             }
         } catch (const std::exception &e){
             // if we failed in here, carp about it, and use 6 hours.
-            LOG("APISession", "Couldn't parse Bearer Token to get expiry time: %s", e.what());
+            LOGERROR("APISession", "Couldn't parse Bearer Token to get expiry time: %s", e.what());
         	mBearerToken = "";
             raiseError(APISessionError::InvalidAuthToken);
             return;
@@ -177,10 +197,10 @@ APISession::_authenticationCallback(http::RESTRequest *req, bool success)
         // if it were an immediate disconnect.
         mBearerToken = "";
         if (!success) {
-            LOG("APISession", "curl internal error during login: %s", req->getCurlError().c_str());
+            LOGERROR("APISession", "curl internal error during login: %s", req->getCurlError().c_str());
             raiseError(APISessionError::ConnectionError);
         } else {
-            LOG("APISession", "got error from API server: Response Code %d", req->getStatusCode());
+            LOGERROR("APISession", "got error from API server: Response Code %d", req->getStatusCode());
             switch (req->getStatusCode()) {
             case 400:
                 raiseError(APISessionError::BadRequestOrClientIncompatible);
@@ -242,6 +262,7 @@ void APISession::setState(APISessionState newState)
 {
     if (newState != mState) {
         mState = newState;
+        util::traceInstant("session", stateTraceName(mState));
         StateCallback.invokeAll(mState);
     }
 }
@@ -250,6 +271,7 @@ void APISession::raiseError(APISessionError error)
 {
     mState = APISessionState::Disconnected;
     mLastError = error;
+    util::traceInstant("session", stateTraceName(APISessionState::Error));
     StateCallback.invokeAll(APISessionState::Error);
 }
 
@@ -280,7 +302,7 @@ void APISession::_stationsCallback(http::RESTRequest *req, bool success)
         auto jsReturn = req->getResponse();
 
         if (!jsReturn.is_array()) {
-            LOG("APISession", "station data returned wasn't an array.  Ignoring.");
+            LOGWARN("APISession", "station data returned wasn't an array.  Ignoring.");
         } else {
             mAliasedStations.clear();
             for (const auto &sJson: jsReturn) {
@@ -289,7 +311,7 @@ void APISession::_stationsCallback(http::RESTRequest *req, bool success)
                     sJson.get_to(s);
                     mAliasedStations.emplace_back(s);
                 } catch (nlohmann::json::exception &e) {
-                    LOG("APISession", "couldn't decode station alias: %s", e.what());
+                    LOGWARN("APISession", "couldn't decode station alias: %s", e.what());
                 }
             }
             LOG("APISession", "got %d station aliases.", mAliasedStations.size());
@@ -297,10 +319,10 @@ void APISession::_stationsCallback(http::RESTRequest *req, bool success)
         }
     } else {
         if (!success) {
-            LOG("APISession", "curl internal error during alias retrieval: %s", req->getCurlError().c_str());
+            LOGERROR("APISession", "curl internal error during alias retrieval: %s", req->getCurlError().c_str());
             // raiseError(APISessionError::ConnectionError);
         } else {
-            LOG("APISession", "got error from API server getting aliases: Response Code %d", req->getStatusCode());
+            LOGERROR("APISession", "got error from API server getting aliases: Response Code %d", req->getStatusCode());
         }
     }
     // cleanup and remove
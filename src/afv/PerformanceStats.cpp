@@ -0,0 +1,212 @@
+/* afv/PerformanceStats.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "afv-native/afv/PerformanceStats.h"
+
+#include <algorithm>
+
+using namespace afv_native;
+using namespace afv_native::afv;
+
+const char *afv::getPerformanceStageName(PerformanceStage stage)
+{
+    switch (stage) {
+    case PerformanceStage::RxLockWait:
+        return "RxLockWait";
+    case PerformanceStage::RxDecode:
+        return "RxDecode";
+    case PerformanceStage::RxMix:
+        return "RxMix";
+    case PerformanceStage::RxVhfFilter:
+        return "RxVhfFilter";
+    case PerformanceStage::RxEffects:
+        return "RxEffects";
+    case PerformanceStage::RxOutput:
+        return "RxOutput";
+    case PerformanceStage::RxFrame:
+        return "RxFrame";
+    case PerformanceStage::TxPreprocess:
+        return "TxPreprocess";
+    case PerformanceStage::TxEncode:
+        return "TxEncode";
+    case PerformanceStage::TxEncapsulate:
+        return "TxEncapsulate";
+    case PerformanceStage::TxSend:
+        return "TxSend";
+    case PerformanceStage::TxFrame:
+        return "TxFrame";
+    default:
+        return "Unknown";
+    }
+}
+
+PerformanceStats::PerformanceStats():
+        Enabled(false),
+        Stages()
+{
+}
+
+AudioIncident::AudioIncident():
+        Sequence(0),
+        Transmit(false),
+        Overrun(false),
+        FrameUs(0),
+        BudgetUs(0),
+        SlowestStage(PerformanceStage::RxFrame),
+        StageUs{},
+        ActiveStreams(0),
+        ActiveRadios(0)
+{
+}
+
+const size_t PerformanceMonitor::incidentRingSize;
+
+PerformanceMonitor::PerformanceMonitor():
+        mStages(),
+        mStatsEnabled(false),
+        mWatchdogEnabled(false),
+        mWatchdogThreshold(0.5f),
+        mIncidentLock(),
+        mIncidents(),
+        mIncidentCount(0)
+{
+}
+
+void PerformanceMonitor::_update_histograms_enabled()
+{
+    const bool enabled = mStatsEnabled.load() || mWatchdogEnabled.load();
+    for (auto &stage: mStages) {
+        stage.setEnabled(enabled);
+    }
+}
+
+void PerformanceMonitor::setEnabled(bool enabled)
+{
+    mStatsEnabled.store(enabled);
+    _update_histograms_enabled();
+}
+
+bool PerformanceMonitor::isEnabled() const
+{
+    return mStatsEnabled.load(std::memory_order_relaxed);
+}
+
+void PerformanceMonitor::setWatchdogEnabled(bool enabled)
+{
+    if (enabled && !mWatchdogEnabled.load()) {
+        // throw away whatever's accumulated since the last time anyone checked a frame.
+        for (auto &stage: mStages) {
+            stage.takePendingUs();
+        }
+    }
+    mWatchdogEnabled.store(enabled);
+    _update_histograms_enabled();
+}
+
+void PerformanceMonitor::setWatchdogThreshold(float fraction)
+{
+    mWatchdogThreshold.store(std::max(0.0f, fraction));
+}
+
+void PerformanceMonitor::checkFrame(
+        bool transmit,
+        uint32_t frameUs,
+        uint32_t budgetUs,
+        uint32_t activeStreams,
+        uint32_t activeRadios)
+{
+    AudioIncident incident;
+    incident.Transmit = transmit;
+    incident.Overrun = frameUs > budgetUs;
+    incident.FrameUs = frameUs;
+    incident.BudgetUs = budgetUs;
+    incident.SlowestStage = transmit ? PerformanceStage::TxFrame : PerformanceStage::RxFrame;
+    incident.ActiveStreams = activeStreams;
+    incident.ActiveRadios = activeRadios;
+
+    uint32_t slowestUs = 0;
+    for (size_t i = 0; i < performanceStageCount; i++) {
+        const auto stage = static_cast<PerformanceStage>(i);
+        if (isTransmitStage(stage) != transmit) {
+            continue;
+        }
+        incident.StageUs[i] = mStages[i].takePendingUs();
+        if (stage != PerformanceStage::RxFrame && stage != PerformanceStage::TxFrame &&
+            incident.StageUs[i] > slowestUs) {
+            slowestUs = incident.StageUs[i];
+            incident.SlowestStage = stage;
+        }
+    }
+
+    if (!isWatchdogEnabled() ||
+        static_cast<float>(frameUs) < static_cast<float>(budgetUs) * mWatchdogThreshold.load()) {
+        return;
+    }
+    std::unique_lock<std::mutex> incidentGuard(mIncidentLock, std::try_to_lock);
+    if (!incidentGuard.owns_lock()) {
+        return;
+    }
+    incident.Sequence = ++mIncidentCount;
+    mIncidents[(incident.Sequence - 1) % incidentRingSize] = incident;
+}
+
+std::vector<AudioIncident> PerformanceMonitor::getIncidents(uint64_t afterSequence) const
+{
+    std::lock_guard<std::mutex> incidentGuard(mIncidentLock);
+    uint64_t first = afterSequence + 1;
+    if (mIncidentCount > incidentRingSize) {
+        first = std::max<uint64_t>(first, mIncidentCount - incidentRingSize + 1);
+    }
+    std::vector<AudioIncident> incidents;
+    for (uint64_t seq = first; seq <= mIncidentCount; seq++) {
+        incidents.push_back(mIncidents[(seq - 1) % incidentRingSize]);
+    }
+    return incidents;
+}
+
+PerformanceStats PerformanceMonitor::snapshot() const
+{
+    PerformanceStats stats;
+    stats.Enabled = isEnabled();
+    for (size_t i = 0; i < performanceStageCount; i++) {
+        stats.Stages[i] = mStages[i].snapshot();
+    }
+    return stats;
+}
+
+void PerformanceMonitor::reset()
+{
+    for (auto &stage: mStages) {
+        stage.reset();
+    }
+}
@@ -34,12 +34,13 @@
 
 #include <cmath>
 #include <atomic>
+#include <chrono>
 
 #include "afv-native/Log.h"
 #include "afv-native/afv/RadioSimulation.h"
-#include "afv-native/afv/dto/voice_server/AudioTxOnTransceivers.h"
 #include "afv-native/audio/VHFFilterSource.h"
 #include "afv-native/audio/PinkNoiseGenerator.h"
+#include "afv-native/util/Trace.h"
 
 using namespace afv_native;
 using namespace afv_native::afv;
@@ -52,13 +53,41 @@ const float fxWhiteNoiseGain = 0.01f;
 
 const float fxBlockToneFreq = 180.0f;
 
+/** arenaAlignment is the alignment (and so the worst case padding) of each allocation we make from the
+ * real-time arena - a cache line, so the streams' decoders don't share them.
+ */
+const size_t arenaAlignment = 64;
+
 CallsignMeta::CallsignMeta():
         source(),
-        transceivers()
+        transceivers(),
+        sampleCacheStorage(new audio::SampleType[audio::frameSizeSamples]()),
+        sampleCache(sampleCacheStorage.get()),
+        sampleCacheValid(false),
+        pooled(false)
 {
     source = std::make_shared<RemoteVoiceSource>();
 }
 
+CallsignMeta::CallsignMeta(std::shared_ptr<RemoteVoiceSource> pooledSource, audio::SampleType *pooledSampleCache):
+        source(std::move(pooledSource)),
+        transceivers(),
+        sampleCacheStorage(),
+        sampleCache(pooledSampleCache),
+        sampleCacheValid(false),
+        pooled(true)
+{
+}
+
+RealtimeMemoryStats::RealtimeMemoryStats():
+        Enabled(false),
+        Arena(),
+        StreamSlots(0),
+        StreamSlotsFree(0),
+        StreamSlotMisses(0)
+{
+}
+
 RadioSimulation::RadioSimulation(
         struct event_base *evBase,
         std::shared_ptr<EffectResources> resources,
@@ -69,25 +98,50 @@ RadioSimulation::RadioSimulation(
         mEvBase(evBase),
         mResources(std::move(resources)),
         mChannel(),
-        mStreamMapLock(),
+        mStreamMapLock("RadioSimulation::mStreamMapLock"),
         mIncomingStreams(),
-        mRadioStateLock(),
-        mPtt(false),
+        mArena(),
+        mArenaRegions(),
+        mSpareStreams(),
+        mStreamSlots(0),
+        mStreamSlotMisses(0),
+        mTxConfig(TxConfig{false, 0}),
+        mRadioConfig(radioCount),
         mLastFramePtt(false),
-        mTxRadio(0),
         mTxSequence(0),
         mRadioState(radioCount),
         mChannelBuffer(nullptr),
         mMixingBuffer(nullptr),
         mFetchBuffer(nullptr),
-        mVoiceSink(std::make_shared<VoiceCompressionSink>(*this)),
-        mVoiceFilter(),
+        mTxChainLock("RadioSimulation::mTxChainLock"),
+        mTxChain(),
+        mTxInputFilters(false),
+        mTxNarrowband(false),
+        mTxDto(),
         mMaintenanceTimer(mEvBase, std::bind(&RadioSimulation::maintainIncomingStreams, this)),
-        mVuMeter(300 / audio::frameLengthMs) // VU is a 300ms zero to peak response...
+        mVuMeter(300 / audio::frameLengthMs), // VU is a 300ms zero to peak response...
+        mPerformance()
 {
     mChannelBuffer = new audio::SampleType[audio::frameSizeSamples];
     mMixingBuffer = new audio::SampleType[audio::frameSizeSamples];
     mFetchBuffer = new audio::SampleType[audio::frameSizeSamples];
+    for (auto &thisRadio: mRadioState) {
+        thisRadio.Frequency = 0;
+        thisRadio.Gain = 1.0f;
+        thisRadio.mLastRxCount.store(0);
+        thisRadio.mBypassEffects = false;
+        thisRadio.mClickSource = std::make_shared<audio::RecordedSampleSource>(mResources->mClick, false);
+        thisRadio.mWhiteNoiseSource = std::make_shared<audio::PinkNoiseGenerator>();
+        thisRadio.mCrackleSource = std::make_shared<audio::RecordedSampleSource>(mResources->mCrackle, true);
+        thisRadio.mBlockToneSource = std::make_shared<audio::SineToneSource>(fxBlockToneFreq);
+    }
+    for (auto &thisConfig: mRadioConfig) {
+        thisConfig.store(RadioConfig{0, 1.0f, false});
+    }
+    {
+        std::lock_guard<util::ProfiledMutex> txChainGuard(mTxChainLock);
+        mTxChain.publish(_build_tx_chain());
+    }
     setUDPChannel(channel);
     mMaintenanceTimer.enable(maintenanceTimerIntervalMs);
     AudiableAudioStreams = new std::atomic<uint32_t>[radioCount];
@@ -111,38 +165,79 @@ void RadioSimulation::putAudioFrame(const audio::SampleType *bufferIn)
         peakDb = std::min(0.0, peakDb);
         mVuMeter.addDatum(peakDb);
     }
-    if (!mPtt.load() && !mLastFramePtt) {
+    if (!mTxConfig.load().Ptt && !mLastFramePtt.load()) {
         // Tick the sequence over when we have no Ptt as the compressed endpoint wont' get called to do that.
         std::atomic_fetch_add<uint32_t>(&mTxSequence, 1);
         return;
     }
-    if (mVoiceFilter) {
-        mVoiceFilter->putAudioFrame(bufferIn);
-    } else {
-        mVoiceSink->putAudioFrame(bufferIn);
+    const bool watchdog = mPerformance.isWatchdogEnabled();
+    const auto frameStart = watchdog ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+    {
+        auto txChain = mTxChain.read();
+        util::ScopedLatency frameTiming(mPerformance.getHistogram(PerformanceStage::TxFrame));
+        if (txChain) {
+            txChain->Head->putAudioFrame(bufferIn);
+        }
+    }
+    if (watchdog) {
+        const auto frameTime = std::chrono::steady_clock::now() - frameStart;
+        mPerformance.checkFrame(
+                true,
+                static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(frameTime).count()),
+                audio::frameLengthMs * 1000,
+                IncomingAudioStreams.load(),
+                _count_active_radios());
     }
 }
 
-void RadioSimulation::processCompressedFrame(std::vector<unsigned char> compressedData)
+uint32_t RadioSimulation::_count_active_radios() const
 {
-    if (mChannel != nullptr && mChannel->isOpen()) {
-        dto::AudioTxOnTransceivers audioOutDto;
-        {
-            std::lock_guard<std::mutex> radioStateGuard(mRadioStateLock);
+    uint32_t activeRadios = 0;
+    for (size_t i = 0; i < mRadioConfig.size(); i++) {
+        if (AudiableAudioStreams[i].load() > 0) {
+            activeRadios++;
+        }
+    }
+    return activeRadios;
+}
 
-            if (!mPtt.load()) {
-                audioOutDto.LastPacket = true;
-                mLastFramePtt = false;
-            } else {
-                mLastFramePtt = true;
-            }
+std::shared_ptr<RadioSimulation::TxChain> RadioSimulation::_build_tx_chain()
+{
+    // the encoder and preprocessor are bound to their sample rate, so the entire chain is built to match.
+    const bool narrowband = mTxNarrowband.load();
+    const int txRate = narrowband ? audio::narrowbandSampleRateHz : audio::sampleRateHz;
+    auto chain = std::make_shared<TxChain>();
+    chain->VoiceSink = std::make_shared<VoiceCompressionSink>(*this, txRate);
+    chain->VoiceSink->setLatencyHistogram(mPerformance.getHistogram(PerformanceStage::TxEncode));
+    chain->Head = chain->VoiceSink;
+    if (mTxInputFilters.load()) {
+        chain->VoiceFilter = std::make_shared<audio::SpeexPreprocessor>(chain->VoiceSink, txRate);
+        chain->VoiceFilter->setLatencyHistogram(mPerformance.getHistogram(PerformanceStage::TxPreprocess));
+        chain->Head = chain->VoiceFilter;
+    }
+    if (narrowband) {
+        chain->Decimator = std::make_shared<audio::DecimatingSink>(chain->Head, audio::narrowbandDecimationFactor);
+        chain->Head = chain->Decimator;
+    }
+    return chain;
+}
 
-            audioOutDto.Transceivers.emplace_back(mTxRadio);
-        }
-        audioOutDto.SequenceCounter = std::atomic_fetch_add<uint32_t>(&mTxSequence, 1);
-        audioOutDto.Callsign = mCallsign;
-        audioOutDto.Audio = std::move(compressedData);
-        mChannel->sendDto(audioOutDto);
+void RadioSimulation::processCompressedFrame(const std::vector<unsigned char> &compressedData)
+{
+    TRACE_SCOPE("audio", "TxSendFrame");
+    if (mChannel != nullptr && mChannel->isOpen()) {
+        const auto txConfig = mTxConfig.load();
+
+        // we're only called by the transmit chain on the capture thread, which is what protects mTxDto.
+        mTxDto.LastPacket = !txConfig.Ptt;
+        mLastFramePtt.store(txConfig.Ptt);
+
+        mTxDto.Transceivers.clear();
+        mTxDto.Transceivers.emplace_back(txConfig.TxRadio);
+        mTxDto.SequenceCounter = std::atomic_fetch_add<uint32_t>(&mTxSequence, 1);
+        mTxDto.Callsign = mCallsign;
+        mTxDto.Audio = compressedData;
+        mChannel->sendDto(mTxDto);
     }
 }
 
@@ -155,18 +250,20 @@ RadioSimulation::mix_buffers(audio::SampleType * RESTRICT src_dst, const audio::
 }
 
 bool RadioSimulation::getTxActive(unsigned int radio) {
-    if (radio != mTxRadio) {
+    const auto txConfig = mTxConfig.load();
+    if (radio != txConfig.TxRadio) {
         return false;
     }
-    return mPtt.load();
+    return txConfig.Ptt;
 }
 
 bool
 RadioSimulation::getRxActive(unsigned int radio)
 {
-    std::lock_guard<std::mutex> radioStateGuard(mRadioStateLock);
-
-    return (mRadioState[radio].mLastRxCount > 0);
+    if (radio >= mRadioState.size()) {
+        return false;
+    }
+    return (mRadioState[radio].mLastRxCount.load() > 0);
 }
 
 inline bool
@@ -175,13 +272,20 @@ freqIsHF(unsigned int freq)
     return freq < 30000000;
 }
 
-bool RadioSimulation::_process_radio(
-        const std::map<void *, audio::SampleType[audio::frameSizeSamples]> &sampleCache,
-        std::map<void *, audio::SampleType[audio::frameSizeSamples]> &eqSampleCache,
-                                     size_t rxIter)
+bool RadioSimulation::_process_radio(size_t rxIter, const TxConfig &txConfig)
 {
+    // pick up any configuration changes.
+    const auto radioConfig = mRadioConfig[rxIter].load();
+    if (radioConfig.Frequency != mRadioState[rxIter].Frequency) {
+        mRadioState[rxIter].Frequency = radioConfig.Frequency;
+        // reset all of the effects, except the click which should be audiable due to the Squelch-gate kicking in on the new frequency
+        resetRadioFx(rxIter, true);
+    }
+    mRadioState[rxIter].Gain = radioConfig.Gain;
+    mRadioState[rxIter].mBypassEffects = radioConfig.BypassEffects;
+
     ::memset(mChannelBuffer, 0, audio::frameSizeBytes);
-    if (mPtt.load() && mTxRadio == rxIter) {
+    if (txConfig.Ptt && txConfig.TxRadio == rxIter) {
         // don't analyze and mix-in the radios transmitting, but suppress the
         // effects.
         resetRadioFx(rxIter);
@@ -191,81 +295,89 @@ bool RadioSimulation::_process_radio(
     // now, find all streams that this applies to.
     float crackleGain = 0.0f;
     uint32_t concurrentStreams = 0;
-    for (auto &srcPair: mIncomingStreams) {
-        if (!srcPair.second.source || !srcPair.second.source->isActive() ||
-            (sampleCache.find(srcPair.second.source.get()) == sampleCache.end())) {
-            continue;
-        }
-        bool mUseStream = false;
-        float voiceGain = 1.0f;
-        for (const afv::dto::RxTransceiver &tx: srcPair.second.transceivers) {
-            if (tx.Frequency == mRadioState[rxIter].Frequency) {
-                mUseStream = true;
-
-                float crackleFactor = 0.0f;
-                if (!mRadioState[rxIter].mBypassEffects) {
-                    crackleFactor = static_cast<float>(
-                            (exp(tx.DistanceRatio) * pow(tx.DistanceRatio, -2.5) / 350.0) - 0.00776652);
-                    crackleFactor = fmax(0.0f, crackleFactor);
-                    crackleFactor = fmin(0.15f, crackleFactor);
-
-                    crackleGain += crackleFactor;
+    {
+        util::ScopedLatency mixTiming(mPerformance.getHistogram(PerformanceStage::RxMix));
+        TRACE_SCOPE("audio", "RxMix");
+        for (auto &srcPair: mIncomingStreams) {
+            if (!srcPair.second.sampleCacheValid) {
+                continue;
+            }
+            bool mUseStream = false;
+            float voiceGain = 1.0f;
+            for (const afv::dto::RxTransceiver &tx: srcPair.second.transceivers) {
+                if (tx.Frequency == mRadioState[rxIter].Frequency) {
+                    mUseStream = true;
+
+                    float crackleFactor = 0.0f;
+                    if (!mRadioState[rxIter].mBypassEffects) {
+                        crackleFactor = static_cast<float>(
+                                (exp(tx.DistanceRatio) * pow(tx.DistanceRatio, -2.5) / 350.0) - 0.00776652);
+                        crackleFactor = fmax(0.0f, crackleFactor);
+                        crackleFactor = fmin(0.15f, crackleFactor);
+
+                        crackleGain += crackleFactor;
+                    }
+                    break; // matched once.  dont' bother anymore.
                 }
-                break; // matched once.  dont' bother anymore.
             }
-        }
-        if (mUseStream) {
-            // then include this stream.
-            try {
+            if (mUseStream) {
+                // then include this stream.
                 mix_buffers(
                         mChannelBuffer,
-                        sampleCache.at(srcPair.second.source.get()),
+                        srcPair.second.sampleCache,
                         voiceGain * mRadioState[rxIter].Gain);
                 concurrentStreams++;
-            } catch (const std::out_of_range &) {
-                LOG("RadioSimulation", "internal error:  Tried to mix uncached stream");
             }
         }
     }
     AudiableAudioStreams[rxIter].store(concurrentStreams);
-    if (concurrentStreams > 0) {
-        if (!mRadioState[rxIter].mBypassEffects) {
-            // if FX are enabled, and we muxed any streams, eq the buffer now to apply the bandwidth simulation,
-            // but don't interfere with the effects.
-            mRadioState[rxIter].vhfFilter.transformFrame(mChannelBuffer, mChannelBuffer);
-
-            float whiteNoiseGain = 0.0f;
-            set_radio_effects(rxIter, crackleGain, whiteNoiseGain);
-            if (!mix_effect(mRadioState[rxIter].Crackle, crackleGain * mRadioState[rxIter].Gain)) {
-                mRadioState[rxIter].Crackle.reset();
-            }
-            if (!mix_effect(mRadioState[rxIter].WhiteNoise, whiteNoiseGain * mRadioState[rxIter].Gain)) {
-                mRadioState[rxIter].WhiteNoise.reset();
-            }
-        } // bypass effects
-        if (concurrentStreams > 1) {
-            if (!mRadioState[rxIter].BlockTone) {
-                mRadioState[rxIter].BlockTone = std::make_shared<audio::SineToneSource>(fxBlockToneFreq);
-            }
-            if (!mix_effect(mRadioState[rxIter].BlockTone, fxBlockToneGain * mRadioState[rxIter].Gain)) {
-                mRadioState[rxIter].BlockTone.reset();
+    if (concurrentStreams > 0 && !mRadioState[rxIter].mBypassEffects) {
+        // if FX are enabled, and we muxed any streams, eq the buffer now to apply the bandwidth simulation,
+        // but don't interfere with the effects.
+        util::ScopedLatency filterTiming(mPerformance.getHistogram(PerformanceStage::RxVhfFilter));
+        TRACE_SCOPE("audio", "RxVhfFilter");
+        mRadioState[rxIter].vhfFilter.transformFrame(mChannelBuffer, mChannelBuffer);
+    }
+    {
+        util::ScopedLatency effectsTiming(mPerformance.getHistogram(PerformanceStage::RxEffects));
+        TRACE_SCOPE("audio", "RxEffects");
+        if (concurrentStreams > 0) {
+            if (!mRadioState[rxIter].mBypassEffects) {
+                float whiteNoiseGain = 0.0f;
+                set_radio_effects(rxIter, crackleGain, whiteNoiseGain);
+                if (!mix_effect(mRadioState[rxIter].Crackle, crackleGain * mRadioState[rxIter].Gain)) {
+                    mRadioState[rxIter].Crackle.reset();
+                }
+                if (!mix_effect(mRadioState[rxIter].WhiteNoise, whiteNoiseGain * mRadioState[rxIter].Gain)) {
+                    mRadioState[rxIter].WhiteNoise.reset();
+                }
+            } // bypass effects
+            if (concurrentStreams > 1) {
+                if (!mRadioState[rxIter].BlockTone) {
+                    mRadioState[rxIter].mBlockToneSource->restart();
+                    mRadioState[rxIter].BlockTone = mRadioState[rxIter].mBlockToneSource;
+                }
+                if (!mix_effect(mRadioState[rxIter].BlockTone, fxBlockToneGain * mRadioState[rxIter].Gain)) {
+                    mRadioState[rxIter].BlockTone.reset();
+                }
+            } else {
+                if (mRadioState[rxIter].BlockTone) {
+                    mRadioState[rxIter].BlockTone.reset();
+                }
             }
         } else {
-            if (mRadioState[rxIter].BlockTone) {
-                mRadioState[rxIter].BlockTone.reset();
+            resetRadioFx(rxIter, true);
+            if (mRadioState[rxIter].mLastRxCount.load() > 0) {
+                mRadioState[rxIter].mClickSource->restart();
+                mRadioState[rxIter].Click = mRadioState[rxIter].mClickSource;
             }
         }
-    } else {
-        resetRadioFx(rxIter, true);
-        if (mRadioState[rxIter].mLastRxCount > 0) {
-            mRadioState[rxIter].Click = std::make_shared<audio::RecordedSampleSource>(mResources->mClick, false);
+        mRadioState[rxIter].mLastRxCount.store(concurrentStreams);
+        // if we have a pending click, play it.
+        if (!mix_effect(mRadioState[rxIter].Click, fxClickGain * mRadioState[rxIter].Gain)) {
+            mRadioState[rxIter].Click.reset();
         }
     }
-    mRadioState[rxIter].mLastRxCount = concurrentStreams;
-    // if we have a pending click, play it.
-    if (!mix_effect(mRadioState[rxIter].Click, fxClickGain * mRadioState[rxIter].Gain)) {
-        mRadioState[rxIter].Click.reset();
-    }
     // now, finally, mix the channel buffer into the mixing buffer.
     mix_buffers(mMixingBuffer, mChannelBuffer);
     return false;
@@ -273,22 +385,52 @@ bool RadioSimulation::_process_radio(
 
 audio::SourceStatus RadioSimulation::getAudioFrame(audio::SampleType *bufferOut)
 {
-    std::lock_guard<std::mutex> radioStateGuard(mRadioStateLock);
-    std::lock_guard<std::mutex> streamGuard(mStreamMapLock);
+    return getAudioFrames(bufferOut, 1);
+}
 
-    std::map<void *, audio::SampleType[audio::frameSizeSamples]> sampleCache;
-    std::map<void *, audio::SampleType[audio::frameSizeSamples]> eqSampleCache;
+audio::SourceStatus RadioSimulation::getAudioFrames(audio::SampleType *bufferOut, size_t nFrames)
+{
+    const bool watchdog = mPerformance.isWatchdogEnabled();
+    const auto frameStart = watchdog ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+    {
+        std::unique_lock<util::ProfiledMutex> streamGuard(mStreamMapLock, std::defer_lock);
+        {
+            util::ScopedLatency lockTiming(mPerformance.getHistogram(PerformanceStage::RxLockWait));
+            streamGuard.lock();
+        }
+        for (size_t f = 0; f < nFrames; f++) {
+            _mix_frame(bufferOut + (f * audio::frameSizeSamples));
+        }
+    }
+    if (watchdog) {
+        const auto frameTime = std::chrono::steady_clock::now() - frameStart;
+        mPerformance.checkFrame(
+                false,
+                static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(frameTime).count()),
+                static_cast<uint32_t>(nFrames * audio::frameLengthMs * 1000),
+                IncomingAudioStreams.load(),
+                _count_active_radios());
+    }
+    return audio::SourceStatus::OK;
+}
 
+void RadioSimulation::_mix_frame(audio::SampleType *bufferOut)
+{
+    util::ScopedLatency frameTiming(mPerformance.getHistogram(PerformanceStage::RxFrame));
+    TRACE_SCOPE("audio", "RxFrame");
     uint32_t allStreams = 0;
     // first, pull frames from all active audio sources.
-    for (auto &src: mIncomingStreams) {
-        if (src.second.source && src.second.source->isActive() &&
-            (sampleCache.find(src.second.source.get()) == sampleCache.end())) {
-            const auto rv = src.second.source->getAudioFrame(sampleCache[src.second.source.get()]);
-            if (rv != audio::SourceStatus::OK) {
-                sampleCache.erase(src.second.source.get());
-            } else {
-                allStreams++;
+    {
+        util::ScopedLatency decodeTiming(mPerformance.getHistogram(PerformanceStage::RxDecode));
+        TRACE_SCOPE("audio", "RxDecode");
+        for (auto &src: mIncomingStreams) {
+            src.second.sampleCacheValid = false;
+            if (src.second.source && src.second.source->isActive()) {
+                const auto rv = src.second.source->getAudioFrame(src.second.sampleCache);
+                if (rv == audio::SourceStatus::OK) {
+                    src.second.sampleCacheValid = true;
+                    allStreams++;
+                }
             }
         }
     }
@@ -297,12 +439,14 @@ audio::SourceStatus RadioSimulation::getAudioFrame(audio::SampleType *bufferOut)
     // empty the output buffer.
     ::memset(mMixingBuffer, 0, sizeof(audio::SampleType) * audio::frameSizeSamples);
 
+    const auto txConfig = mTxConfig.load();
     size_t rxIter = 0;
     for (rxIter = 0; rxIter < mRadioState.size(); rxIter++) {
-        _process_radio(sampleCache, eqSampleCache, rxIter);
+        _process_radio(rxIter, txConfig);
     } // rxIter
+    util::ScopedLatency outputTiming(mPerformance.getHistogram(PerformanceStage::RxOutput));
+    TRACE_SCOPE("audio", "RxOutput");
     ::memcpy(bufferOut, mMixingBuffer, sizeof(audio::SampleType) * audio::frameSizeSamples);
-    return audio::SourceStatus::OK;
 }
 
 void RadioSimulation::set_radio_effects(size_t rxIter, float crackleGain, float &whiteNoiseGain)
@@ -310,14 +454,13 @@ void RadioSimulation::set_radio_effects(size_t rxIter, float crackleGain, float
     whiteNoiseGain = fxWhiteNoiseGain;
     if (whiteNoiseGain > 0.0f) {
         if (!mRadioState[rxIter].WhiteNoise) {
-            mRadioState[rxIter].WhiteNoise = std::make_shared<audio::PinkNoiseGenerator>();
+            mRadioState[rxIter].WhiteNoise = mRadioState[rxIter].mWhiteNoiseSource;
         }
     }
     if (crackleGain > 0.0f) {
         if (!mRadioState[rxIter].Crackle) {
-            mRadioState[rxIter].Crackle = std::make_shared<audio::RecordedSampleSource>(
-                    mResources->mCrackle,
-                    true);
+            mRadioState[rxIter].mCrackleSource->restart();
+            mRadioState[rxIter].Crackle = mRadioState[rxIter].mCrackleSource;
         }
     }
 }
@@ -336,39 +479,47 @@ bool RadioSimulation::mix_effect(std::shared_ptr<ISampleSource> effect, float ga
 
 RadioSimulation::~RadioSimulation()
 {
-    delete[] mFetchBuffer;
-    delete[] mMixingBuffer;
-    delete[] mChannelBuffer;
+    if (mArena) {
+        // the arena may well outlive us (the pooled sources share it), so let go of our memory now.
+        for (const auto &region: mArenaRegions) {
+            mArena->unlockRegion(region.first, region.second);
+        }
+    } else {
+        delete[] mFetchBuffer;
+        delete[] mMixingBuffer;
+        delete[] mChannelBuffer;
+    }
     delete[] AudiableAudioStreams;
 }
 
 void RadioSimulation::rxVoicePacket(const afv::dto::AudioRxOnTransceivers &pkt)
 {
-    std::lock_guard<std::mutex> streamMapLock(mStreamMapLock);
+    std::lock_guard<util::ProfiledMutex> streamMapLock(mStreamMapLock);
     //FIXME:  Deal with the case of a single-callsign transmitting multiple different voicestreams simultaneously.
-    mIncomingStreams[pkt.Callsign].source->appendAudioDTO(pkt);
-    mIncomingStreams[pkt.Callsign].transceivers = pkt.Transceivers;
+    auto streamIter = mIncomingStreams.find(pkt.Callsign);
+    if (streamIter == mIncomingStreams.end()) {
+        streamIter = mIncomingStreams.emplace(pkt.Callsign, _new_stream()).first;
+    }
+    streamIter->second.source->appendAudioDTO(pkt);
+    streamIter->second.transceivers = pkt.Transceivers;
 }
 
 void RadioSimulation::setFrequency(unsigned int radio, unsigned int frequency)
 {
-    std::lock_guard<std::mutex> radioStateGuard(mRadioStateLock);
-    if (radio >= mRadioState.size()) {
+    if (radio >= mRadioConfig.size()) {
         return;
     }
-    if (mRadioState[radio].Frequency == frequency) {
-        return;
-    }
-    mRadioState[radio].Frequency = frequency;
-    // reset all of the effects, except the click which should be audiable due to the Squelch-gate kicking in on the new frequency
-    resetRadioFx(radio, true);
+    // the playback thread resets the effects when it sees the change.
+    mRadioConfig[radio].update([frequency](RadioConfig &config) {
+        config.Frequency = frequency;
+    });
 }
 
 void RadioSimulation::resetRadioFx(unsigned int radio, bool except_click)
 {
     if (!except_click) {
         mRadioState[radio].Click.reset();
-        mRadioState[radio].mLastRxCount = 0;
+        mRadioState[radio].mLastRxCount.store(0);
     }
     mRadioState[radio].BlockTone.reset();
     mRadioState[radio].Crackle.reset();
@@ -376,22 +527,29 @@ void RadioSimulation::resetRadioFx(unsigned int radio, bool except_click)
 
 void RadioSimulation::setPtt(bool pressed)
 {
-    mPtt.store(pressed);
+    mTxConfig.update([pressed](TxConfig &config) {
+        config.Ptt = pressed;
+    });
 }
 
 void RadioSimulation::setGain(unsigned int radio, float gain)
 {
-    std::lock_guard<std::mutex> radioStateGuard(mRadioStateLock);
-    mRadioState[radio].Gain = gain;
+    if (radio >= mRadioConfig.size()) {
+        return;
+    }
+    mRadioConfig[radio].update([gain](RadioConfig &config) {
+        config.Gain = gain;
+    });
 }
 
 void RadioSimulation::setTxRadio(unsigned int radio)
 {
-    std::lock_guard<std::mutex> radioStateGuard(mRadioStateLock);
-    if (radio >= mRadioState.size()) {
+    if (radio >= mRadioConfig.size()) {
         return;
     }
-    mTxRadio = radio;
+    mTxConfig.update([radio](TxConfig &config) {
+        config.TxRadio = radio;
+    });
 }
 
 void RadioSimulation::dtoHandler(const std::string &dtoName, const unsigned char *bufIn, size_t bufLen, void *user_data)
@@ -402,6 +560,7 @@ void RadioSimulation::dtoHandler(const std::string &dtoName, const unsigned char
 
 void RadioSimulation::instDtoHandler(const std::string &dtoName, const unsigned char *bufIn, size_t bufLen)
 {
+    TRACE_SCOPE("network", "RadioSimulation::dtoHandler");
     if (dtoName == "AR") {
         try {
             dto::AudioRxOnTransceivers audioIn;
@@ -410,7 +569,7 @@ void RadioSimulation::instDtoHandler(const std::string &dtoName, const unsigned
             msgpackObj.convert(audioIn);
             rxVoicePacket(audioIn);
         } catch (msgpack::type_error &e) {
-            LOG("radiosimulation", "Error unmarshalling %s packet: %s", dtoName.c_str(), e.what());
+            LOGWARN("radiosimulation", "Error unmarshalling %s packet: %s", dtoName.c_str(), e.what());
         }
     }
 }
@@ -419,9 +578,13 @@ void RadioSimulation::setUDPChannel(cryptodto::UDPChannel *newChannel)
 {
     if (mChannel != nullptr) {
         mChannel->unregisterDtoHandler("AR");
+        mChannel->setLatencyHistograms(nullptr, nullptr);
     }
     mChannel = newChannel;
     if (mChannel != nullptr) {
+        mChannel->setLatencyHistograms(
+                mPerformance.getHistogram(PerformanceStage::TxEncapsulate),
+                mPerformance.getHistogram(PerformanceStage::TxSend));
         mChannel->registerDtoHandler(
                 "AR", [this](const unsigned char *data, size_t len) {
                     try {
@@ -430,7 +593,7 @@ void RadioSimulation::setUDPChannel(cryptodto::UDPChannel *newChannel)
                         objHdl.get().convert(rxAudio);
                         this->rxVoicePacket(rxAudio);
                     } catch (const msgpack::type_error &e) {
-                        LOG("radiosimulation", "unable to unpack audio data received: %s", e.what());
+                        LOGWARN("radiosimulation", "unable to unpack audio data received: %s", e.what());
                         LOGDUMPHEX("radiosimulation", data, len);
                     }
                 });
@@ -439,7 +602,7 @@ void RadioSimulation::setUDPChannel(cryptodto::UDPChannel *newChannel)
 
 void RadioSimulation::maintainIncomingStreams()
 {
-    std::lock_guard<std::mutex> ml(mStreamMapLock);
+    std::lock_guard<util::ProfiledMutex> ml(mStreamMapLock);
     std::vector<std::string> callsignsToPurge;
     util::monotime_t now = util::monotime_get();
     for (const auto &streamPair: mIncomingStreams) {
@@ -449,7 +612,9 @@ void RadioSimulation::maintainIncomingStreams()
         }
     }
     for (const auto &callsign: callsignsToPurge) {
-        mIncomingStreams.erase(callsign);
+        auto streamIter = mIncomingStreams.find(callsign);
+        _release_stream(streamIter->second);
+        mIncomingStreams.erase(streamIter);
     }
     mMaintenanceTimer.enable(maintenanceTimerIntervalMs);
 }
@@ -462,14 +627,18 @@ void RadioSimulation::setCallsign(const std::string &newCallsign)
 void RadioSimulation::reset()
 {
     {
-        std::lock_guard<std::mutex> ml(mStreamMapLock);
+        std::lock_guard<util::ProfiledMutex> ml(mStreamMapLock);
+        for (auto &streamPair: mIncomingStreams) {
+            _release_stream(streamPair.second);
+        }
         mIncomingStreams.clear();
     }
     mTxSequence.store(0);
-    mPtt.store(false);
-    mLastFramePtt = false;
-    // reset the voice compression codec state.
-    mVoiceSink->reset();
+    setPtt(false);
+    mLastFramePtt.store(false);
+    // reset the voice compression codec state by starting over with a fresh chain.
+    std::lock_guard<util::ProfiledMutex> txChainGuard(mTxChainLock);
+    mTxChain.publish(_build_tx_chain());
 }
 
 double RadioSimulation::getVu() const
@@ -484,23 +653,189 @@ double RadioSimulation::getPeak() const
 
 bool RadioSimulation::getEnableInputFilters() const
 {
-    return static_cast<bool>(mVoiceFilter);
+    return mTxInputFilters.load();
 }
 
 void RadioSimulation::setEnableInputFilters(bool enableInputFilters)
 {
-    if (enableInputFilters) {
-        if (!mVoiceFilter) {
-            mVoiceFilter = std::make_shared<audio::SpeexPreprocessor>(mVoiceSink);
-        }
-    } else {
-        mVoiceFilter.reset();
+    std::lock_guard<util::ProfiledMutex> txChainGuard(mTxChainLock);
+    if (enableInputFilters == mTxInputFilters.load()) {
+        return;
+    }
+    mTxInputFilters.store(enableInputFilters);
+    mTxChain.publish(_build_tx_chain());
+}
+
+bool RadioSimulation::getEnableNarrowbandTx() const
+{
+    return mTxNarrowband.load();
+}
+
+void RadioSimulation::setEnableNarrowbandTx(bool enableNarrowband)
+{
+    std::lock_guard<util::ProfiledMutex> txChainGuard(mTxChainLock);
+    if (enableNarrowband == mTxNarrowband.load()) {
+        return;
     }
+    mTxNarrowband.store(enableNarrowband);
+    mTxChain.publish(_build_tx_chain());
 }
 
 void RadioSimulation::setEnableOutputEffects(bool enableEffects)
 {
-    for (auto &thisRadio: mRadioState) {
-        thisRadio.mBypassEffects = !enableEffects;
+    for (auto &thisConfig: mRadioConfig) {
+        thisConfig.update([enableEffects](RadioConfig &config) {
+            config.BypassEffects = !enableEffects;
+        });
+    }
+}
+
+PerformanceStats RadioSimulation::getPerformanceStats() const
+{
+    return mPerformance.snapshot();
+}
+
+void RadioSimulation::setEnablePerformanceStats(bool enable)
+{
+    mPerformance.setEnabled(enable);
+}
+
+void RadioSimulation::resetPerformanceStats()
+{
+    mPerformance.reset();
+}
+
+void RadioSimulation::setEnableAudioWatchdog(bool enable)
+{
+    mPerformance.setWatchdogEnabled(enable);
+}
+
+void RadioSimulation::setAudioWatchdogThreshold(float fraction)
+{
+    mPerformance.setWatchdogThreshold(fraction);
+}
+
+std::vector<AudioIncident> RadioSimulation::getAudioIncidents(uint64_t afterSequence) const
+{
+    return mPerformance.getIncidents(afterSequence);
+}
+
+std::vector<VoiceStreamStats> RadioSimulation::getStreamStatistics() const
+{
+    std::lock_guard<util::ProfiledMutex> streamMapLock(mStreamMapLock);
+    std::vector<VoiceStreamStats> allStats;
+    allStats.reserve(mIncomingStreams.size());
+    for (const auto &streamPair: mIncomingStreams) {
+        if (!streamPair.second.source) {
+            continue;
+        }
+        allStats.emplace_back(streamPair.second.source->getStatistics());
+        allStats.back().Callsign = streamPair.first;
+    }
+    return allStats;
+}
+
+CallsignMeta RadioSimulation::_new_stream()
+{
+    if (!mSpareStreams.empty()) {
+        CallsignMeta stream = std::move(mSpareStreams.back());
+        mSpareStreams.pop_back();
+        return stream;
+    }
+    if (mArena) {
+        mStreamSlotMisses++;
+    }
+    return CallsignMeta();
+}
+
+void RadioSimulation::_release_stream(CallsignMeta &stream)
+{
+    if (!stream.pooled) {
+        return;
+    }
+    stream.source->reset();
+    stream.transceivers.clear();
+    stream.sampleCacheValid = false;
+    // mSpareStreams was reserved for every slot, so this never reallocates.
+    mSpareStreams.emplace_back(std::move(stream));
+}
+
+bool RadioSimulation::enableRealtimeMemory(unsigned int streamSlots)
+{
+    if (mArena) {
+        return true;
+    }
+    const size_t bufferBytes = sizeof(audio::SampleType) * audio::frameSizeSamples;
+    const size_t decoderBytes = static_cast<size_t>(opus_decoder_get_size(1));
+    auto arena = std::make_shared<util::RealtimeArena>(
+            3 * (bufferBytes + arenaAlignment) + streamSlots * (bufferBytes + decoderBytes + 2 * arenaAlignment));
+
+    auto *channelBuffer = static_cast<audio::SampleType *>(arena->allocate(bufferBytes, arenaAlignment));
+    auto *mixingBuffer = static_cast<audio::SampleType *>(arena->allocate(bufferBytes, arenaAlignment));
+    auto *fetchBuffer = static_cast<audio::SampleType *>(arena->allocate(bufferBytes, arenaAlignment));
+    if (channelBuffer == nullptr || mixingBuffer == nullptr || fetchBuffer == nullptr) {
+        LOGERROR("radiosimulation", "couldn't allocate the real-time arena");
+        return false;
+    }
+
+    std::vector<CallsignMeta> spares;
+    spares.reserve(streamSlots);
+    for (unsigned int i = 0; i < streamSlots; i++) {
+        auto *sampleCache = static_cast<audio::SampleType *>(arena->allocate(bufferBytes, arenaAlignment));
+        if (sampleCache == nullptr) {
+            LOGERROR("radiosimulation", "couldn't allocate the real-time arena");
+            return false;
+        }
+        spares.emplace_back(std::make_shared<RemoteVoiceSource>(arena), sampleCache);
+    }
+    // the effect samples and radio state aren't ours to move into the arena, but we hold on to both until
+    // our destructor unlocks them again.
+    std::vector<std::pair<const void *, size_t>> regions;
+    for (const auto &sample: {mResources->mClick, mResources->mCrackle}) {
+        if (sample) {
+            regions.emplace_back(sample->data(), sample->lengthInSamples() * sizeof(audio::SampleType));
+        }
+    }
+    regions.emplace_back(mRadioState.data(), mRadioState.size() * sizeof(RadioState));
+    for (auto regionIter = regions.begin(); regionIter != regions.end();) {
+        if (arena->lockRegion(regionIter->first, regionIter->second)) {
+            ++regionIter;
+        } else {
+            regionIter = regions.erase(regionIter);
+        }
+    }
+
+    {
+        std::lock_guard<util::ProfiledMutex> streamMapLock(mStreamMapLock);
+        delete[] mChannelBuffer;
+        delete[] mMixingBuffer;
+        delete[] mFetchBuffer;
+        mChannelBuffer = channelBuffer;
+        mMixingBuffer = mixingBuffer;
+        mFetchBuffer = fetchBuffer;
+        mSpareStreams = std::move(spares);
+        mStreamSlots = streamSlots;
+        mArenaRegions = std::move(regions);
+        mArena = std::move(arena);
+    }
+    const auto arenaStats = mArena->getStatistics();
+    LOGINFO("radiosimulation", "real-time memory enabled: %zu byte arena (%s), %zu bytes locked in place",
+            arenaStats.CapacityBytes,
+            arenaStats.Locked ? "locked" : "not locked",
+            arenaStats.LockedRegionBytes);
+    return true;
+}
+
+RealtimeMemoryStats RadioSimulation::getRealtimeMemoryStats() const
+{
+    RealtimeMemoryStats stats;
+    std::lock_guard<util::ProfiledMutex> streamMapLock(mStreamMapLock);
+    if (mArena) {
+        stats.Enabled = true;
+        stats.Arena = mArena->getStatistics();
+        stats.StreamSlots = mStreamSlots;
+        stats.StreamSlotsFree = static_cast<uint32_t>(mSpareStreams.size());
+        stats.StreamSlotMisses = mStreamSlotMisses;
     }
+    return stats;
 }
@@ -47,13 +47,22 @@ using namespace afv_native::audio;
 using namespace afv_native;
 using namespace std;
 
-RemoteVoiceSource::RemoteVoiceSource():
-        mJitterBufferMutex(),
+RemoteVoiceSource::RemoteVoiceSource(std::shared_ptr<util::RealtimeArena> arena):
+        mDecoder(nullptr),
+        mArena(std::move(arena)),
+        mDecoderInArena(false),
+        mJitterBufferMutex("RemoteVoiceSource::mJitterBufferMutex"),
         mIsActive(false),
         mSilentFrames(0),
         mEnding(false),
         mEndingSequence(0),
-        mCurrentFrame(0)
+        mCurrentFrame(0),
+        mPacketsReceived(0),
+        mBytesReceived(0),
+        mFramesDecoded(0),
+        mFramesConcealed(0),
+        mFramesSilenced(0),
+        mDecodeErrors(0)
 {
     mJitterBuffer = jitter_buffer_init(1);
     jitter_buffer_ctl(mJitterBuffer, JITTER_BUFFER_SET_DESTROY_CALLBACK, reinterpret_cast<void *>(::free));
@@ -61,20 +70,28 @@ RemoteVoiceSource::RemoteVoiceSource():
     spx_uint32_t jitterMargin = 3;
     jitter_buffer_ctl(mJitterBuffer, JITTER_BUFFER_SET_MARGIN, &jitterMargin);
 
-    int opus_status;
-    mDecoder = opus_decoder_create(sampleRateHz, 1, &opus_status);
+    int opus_status = OPUS_OK;
+    if (mArena) {
+        mDecoder = static_cast<OpusDecoder *>(mArena->allocate(opus_decoder_get_size(1)));
+    }
+    if (mDecoder != nullptr) {
+        mDecoderInArena = true;
+        opus_status = opus_decoder_init(mDecoder, sampleRateHz, 1);
+    } else {
+        mDecoder = opus_decoder_create(sampleRateHz, 1, &opus_status);
+    }
     if (opus_status != OPUS_OK) {
-        LOG("instreambuffer", "Got error initialising Opus Codec: %s", opus_strerror(opus_status));
+        LOGERROR("instreambuffer", "Got error initialising Opus Codec: %s", opus_strerror(opus_status));
         mDecoder = nullptr;
     }
 }
 
 RemoteVoiceSource::~RemoteVoiceSource()
 {
-    if (mDecoder != nullptr) {
+    if (mDecoder != nullptr && !mDecoderInArena) {
         opus_decoder_destroy(mDecoder);
-        mDecoder = nullptr;
     }
+    mDecoder = nullptr;
     jitter_buffer_destroy(mJitterBuffer);
     mJitterBuffer = nullptr;
 }
@@ -97,12 +114,14 @@ void RemoteVoiceSource::appendAudioDTO(const dto::IAudio &audio)
     newPacket.timestamp = audio.SequenceCounter;
     newPacket.span = 1;
     {
-        std::lock_guard<std::mutex> lock(mJitterBufferMutex);
+        std::lock_guard<util::ProfiledMutex> lock(mJitterBufferMutex);
 
         jitter_buffer_put(mJitterBuffer, &newPacket);
         mSilentFrames = 0;
         mLastActive = util::monotime_get();
     }
+    mPacketsReceived.fetch_add(1, std::memory_order_relaxed);
+    mBytesReceived.fetch_add(audio.Audio.size(), std::memory_order_relaxed);
     mIsActive = true;
 }
 
@@ -116,7 +135,7 @@ SourceStatus RemoteVoiceSource::getAudioFrame(SampleType *bufferOut)
     int jitter_status;
     int opus_res = OPUS_OK;
     {
-        std::lock_guard<std::mutex> lock(mJitterBufferMutex);
+        std::lock_guard<util::ProfiledMutex> lock(mJitterBufferMutex);
         jitter_status = jitter_buffer_get(mJitterBuffer, &pktOut, 1, &tsOut);
     }
     if (mDecoder != nullptr) {
@@ -129,11 +148,13 @@ SourceStatus RemoteVoiceSource::getAudioFrame(SampleType *bufferOut)
             } else {
                 // prod opus to perform gap compensation.
                 opus_res = opus_decode_float(mDecoder, nullptr, 0, bufferOut, frameSizeSamples, false);
+                mFramesConcealed.fetch_add(1, std::memory_order_relaxed);
             }
             break;
         case JITTER_BUFFER_INSERTION:
             // insert silence.
             ::memset(bufferOut, 0, frameSizeSamples * sizeof(SampleType));
+            mFramesSilenced.fetch_add(1, std::memory_order_relaxed);
             break;
         case JITTER_BUFFER_OK:
             mCurrentFrame = tsOut;
@@ -145,14 +166,15 @@ SourceStatus RemoteVoiceSource::getAudioFrame(SampleType *bufferOut)
                     frameSizeSamples,
                     false);
             ::free(pktOut.data);
+            mFramesDecoded.fetch_add(1, std::memory_order_relaxed);
             break;
         default:
-            LOG("instreambuffer", "Got Error return from the jitter buffer: %d", jitter_status);
+            LOGDEBUG("instreambuffer", "Got Error return from the jitter buffer: %d", jitter_status);
             rv = SourceStatus::Error;
             break;
         }
         if (opus_res < 0) {
-            LOG("instreambuffer", "Opus returned an error decoding frame: %s", opus_strerror(opus_res));
+            mDecodeErrors.fetch_add(1, std::memory_order_relaxed);
         }
     } else {
         // codec is broken - insert silence.
@@ -160,7 +182,7 @@ SourceStatus RemoteVoiceSource::getAudioFrame(SampleType *bufferOut)
         rv = SourceStatus::Error;
     }
     {
-        std::lock_guard<std::mutex> lock(mJitterBufferMutex);
+        std::lock_guard<util::ProfiledMutex> lock(mJitterBufferMutex);
         jitter_buffer_tick(mJitterBuffer);
         // if we don't have a terminally flagged marker, check for timeouts.
         spx_int32_t bufCount = 0;
@@ -183,11 +205,29 @@ SourceStatus RemoteVoiceSource::getAudioFrame(SampleType *bufferOut)
 void RemoteVoiceSource::flush()
 {
     {
-        std::lock_guard<std::mutex> lock(mJitterBufferMutex);
+        std::lock_guard<util::ProfiledMutex> lock(mJitterBufferMutex);
         // this nukes the jitter buffer contents, without resetting the latency timers.
         jitter_buffer_reset(mJitterBuffer);
     }
-    opus_decoder_ctl(mDecoder, OPUS_RESET_STATE);
+    if (mDecoder != nullptr) {
+        opus_decoder_ctl(mDecoder, OPUS_RESET_STATE);
+    }
+}
+
+void RemoteVoiceSource::reset()
+{
+    flush();
+    mIsActive = false;
+    mSilentFrames = 0;
+    mCurrentFrame = 0;
+    mEnding = false;
+    mEndingSequence = 0;
+    mPacketsReceived.store(0, std::memory_order_relaxed);
+    mBytesReceived.store(0, std::memory_order_relaxed);
+    mFramesDecoded.store(0, std::memory_order_relaxed);
+    mFramesConcealed.store(0, std::memory_order_relaxed);
+    mFramesSilenced.store(0, std::memory_order_relaxed);
+    mDecodeErrors.store(0, std::memory_order_relaxed);
 }
 
 bool RemoteVoiceSource::isActive() const
@@ -200,3 +240,25 @@ util::monotime_t RemoteVoiceSource::getLastActivityTime() const
     return mLastActive;
 }
 
+VoiceStreamStats RemoteVoiceSource::getStatistics() const
+{
+    VoiceStreamStats stats;
+    stats.PacketsReceived = mPacketsReceived.load(std::memory_order_relaxed);
+    stats.BytesReceived = mBytesReceived.load(std::memory_order_relaxed);
+    stats.FramesDecoded = mFramesDecoded.load(std::memory_order_relaxed);
+    stats.FramesConcealed = mFramesConcealed.load(std::memory_order_relaxed);
+    stats.FramesSilenced = mFramesSilenced.load(std::memory_order_relaxed);
+    stats.DecodeErrors = mDecodeErrors.load(std::memory_order_relaxed);
+    return stats;
+}
+
+VoiceStreamStats::VoiceStreamStats():
+        Callsign(),
+        PacketsReceived(0),
+        BytesReceived(0),
+        FramesDecoded(0),
+        FramesConcealed(0),
+        FramesSilenced(0),
+        DecodeErrors(0)
+{
+}
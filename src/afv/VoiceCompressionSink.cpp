@@ -36,15 +36,21 @@
 #include <vector>
 
 #include "afv-native/Log.h"
+#include "afv-native/util/Trace.h"
 
 using namespace ::afv_native;
 using namespace ::afv_native::afv;
 using namespace ::std;
 
-VoiceCompressionSink::VoiceCompressionSink(ICompressedFrameSink &sink):
+VoiceCompressionSink::VoiceCompressionSink(ICompressedFrameSink &sink, int sampleRate):
 		mEncoder(nullptr),
-        mCompressedFrameSink(sink)
+        mCompressedFrameSink(sink),
+        mSampleRate(sampleRate),
+        mFrameSizeSamples(sampleRate * audio::frameLengthMs / 1000),
+        mLatency(nullptr),
+        mOutBuffer()
 {
+    mOutBuffer.reserve(audio::targetOutputFrameSizeBytes);
     open();
 }
 
@@ -59,14 +65,14 @@ int VoiceCompressionSink::open()
     if (mEncoder != nullptr) {
         return 0;
     }
-    mEncoder = opus_encoder_create(audio::sampleRateHz, 1, OPUS_APPLICATION_VOIP, &opus_status);
+    mEncoder = opus_encoder_create(mSampleRate, 1, OPUS_APPLICATION_VOIP, &opus_status);
     if (opus_status != OPUS_OK) {
-        LOG("VoiceCompressionSink", "Got error initialising Opus Codec: %s", opus_strerror(opus_status));
+        LOGERROR("VoiceCompressionSink", "Got error initialising Opus Codec: %s", opus_strerror(opus_status));
         mEncoder = nullptr;
     } else {
         opus_status = opus_encoder_ctl(mEncoder, OPUS_SET_BITRATE(audio::encoderBitrate));
         if (opus_status != OPUS_OK) {
-            LOG("VoiceCompressionSink", "error setting bitrate on codec: %s", opus_strerror(opus_status));
+            LOGERROR("VoiceCompressionSink", "error setting bitrate on codec: %s", opus_strerror(opus_status));
         }
     }
     return opus_status;
@@ -86,15 +92,30 @@ void VoiceCompressionSink::reset()
     open();
 }
 
+int VoiceCompressionSink::getSampleRate() const
+{
+    return mSampleRate;
+}
+
 void VoiceCompressionSink::putAudioFrame(const audio::SampleType *bufferIn)
 {
-    vector<unsigned char> outBuffer(audio::targetOutputFrameSizeBytes);
-    auto enc_len = opus_encode_float(mEncoder, bufferIn, audio::frameSizeSamples, outBuffer.data(), outBuffer.size());
+    // resizing within the reserved capacity doesn't reallocate.
+    mOutBuffer.resize(audio::targetOutputFrameSizeBytes);
+    opus_int32 enc_len;
+    {
+        util::ScopedLatency timing(mLatency);
+        TRACE_SCOPE("audio", "TxEncode");
+        enc_len = opus_encode_float(mEncoder, bufferIn, mFrameSizeSamples, mOutBuffer.data(), mOutBuffer.size());
+    }
     if (enc_len < 0) {
-        LOG("VoiceCompressionSink", "error encoding frame: %s", opus_strerror(enc_len));
+        LOGWARN("VoiceCompressionSink", "error encoding frame: %s", opus_strerror(enc_len));
         return;
     }
-    outBuffer.resize(enc_len);
-    mCompressedFrameSink.processCompressedFrame(outBuffer);
+    mOutBuffer.resize(enc_len);
+    mCompressedFrameSink.processCompressedFrame(mOutBuffer);
 }
 
+void VoiceCompressionSink::setLatencyHistogram(util::LatencyHistogram *histogram)
+{
+    mLatency = histogram;
+}
@@ -42,6 +42,7 @@
 #include "afv-native/afv/dto/voice_server/Heartbeat.h"
 #include "afv-native/http/Request.h"
 #include "afv-native/cryptodto/UDPChannel.h"
+#include "afv-native/util/Trace.h"
 
 using namespace afv_native::afv;
 using namespace afv_native;
@@ -102,21 +103,21 @@ void VoiceSession::voiceSessionSetupRequestCallback(http::Request *req, bool suc
                     failSession();
                 }
             } catch (json::exception &e) {
-                LOG("voicesession", "exception parsing voice session setup: %s", e.what());
+                LOGERROR("voicesession", "exception parsing voice session setup: %s", e.what());
                 mLastError = VoiceSessionError::BadResponseFromAPIServer;
                 failSession();
             }
         } else {
-            LOG("voicesession",
-                "request for voice session failed: got status %d",
-                req->getStatusCode());
+            LOGERROR("voicesession",
+                     "request for voice session failed: got status %d",
+                     req->getStatusCode());
             mLastError = VoiceSessionError::BadResponseFromAPIServer;
             failSession();
         }
     } else {
-        LOG("voicesession",
-            "request for voice session failed: got internal error %s",
-            req->getCurlError().c_str());
+        LOGERROR("voicesession",
+                 "request for voice session failed: got internal error %s",
+                 req->getCurlError().c_str());
         mLastError = VoiceSessionError::BadResponseFromAPIServer;
         failSession();
     }
@@ -128,7 +129,7 @@ bool VoiceSession::setupSession(const dto::PostCallsignResponse &cresp)
     mChannel.setAddress(cresp.VoiceServer.AddressIpV4);
     mChannel.setChannelConfig(cresp.VoiceServer.ChannelConfig);
     if (!mChannel.open()) {
-        LOG("VoiceSession:setupSession", "unable to open UDP session");
+        LOGERROR("VoiceSession:setupSession", "unable to open UDP session");
         mLastError = VoiceSessionError::UDPChannelError;
         return false;
     }
@@ -142,6 +143,7 @@ bool VoiceSession::setupSession(const dto::PostCallsignResponse &cresp)
                 this->receivedHeartbeat();
             });
     mLastError = VoiceSessionError::NoError;
+    util::traceInstant("session", "VoiceSession Connected");
     StateCallback.invokeAll(VoiceSessionState::Connected);
 
     // now that everything's been invoked, attach our callback for reconnect handling
@@ -158,8 +160,10 @@ void VoiceSession::failSession()
     // before we invoke state callbacks, remove our session handler so we don't get recursive loops.
     mSession.StateCallback.removeCallback(this);
     if (mLastError != VoiceSessionError::NoError) {
+        util::traceInstant("session", "VoiceSession Error");
         StateCallback.invokeAll(VoiceSessionState::Error);
     } else {
+        util::traceInstant("session", "VoiceSession Disconnected");
         StateCallback.invokeAll(VoiceSessionState::Disconnected);
     }
 }
@@ -183,7 +187,7 @@ void VoiceSession::receivedHeartbeat()
 void VoiceSession::heartbeatTimedOut()
 {
     util::monotime_t now = util::monotime_get();
-    LOG("voicesession", "heartbeat timeout - %d ms elapsed - disconnecting", now - mLastHeartbeatReceived);
+    LOGWARN("voicesession", "heartbeat timeout - %d ms elapsed - disconnecting", now - mLastHeartbeatReceived);
     mLastError = VoiceSessionError::Timeout;
     Disconnect(true);
 }
@@ -201,10 +205,10 @@ void VoiceSession::Disconnect(bool do_close)
                 [](http::Request *req, bool success) mutable {
                     if (success) {
                         if (req->getStatusCode() != 200) {
-                            LOG("VoiceSession:Disconnect", "Callsign Dereg Failed.  Status Code: %d", req->getStatusCode());
+                            LOGWARN("VoiceSession:Disconnect", "Callsign Dereg Failed.  Status Code: %d", req->getStatusCode());
                         }
                     } else {
-                        LOG("VoiceSession:Disconnect", "Callsign Dereg Failed.  Internal Error: %s", req->getCurlError().c_str());
+                        LOGWARN("VoiceSession:Disconnect", "Callsign Dereg Failed.  Internal Error: %s", req->getCurlError().c_str());
                     }
                 });
         // and now schedule this request to be performed.
@@ -246,6 +250,11 @@ afv_native::cryptodto::UDPChannel &VoiceSession::getUDPChannel()
     return mChannel;
 }
 
+const afv_native::cryptodto::UDPChannel &VoiceSession::getUDPChannel() const
+{
+    return mChannel;
+}
+
 void VoiceSession::updateBaseUrl()
 {
     mBaseUrl = mSession.getBaseUrl() + "/api/v1/users/" + mSession.getUsername() + "/callsigns/" + mCallsign;
@@ -38,15 +38,30 @@
 #include <algorithm>
 
 #include "afv-native/Log.h"
+#include "afv-native/audio/FileAudioDevice.h"
+#include "afv-native/audio/NullAudioDevice.h"
+#include "afv-native/audio/ResamplingSink.h"
+#include "afv-native/audio/ResamplingSource.h"
+#include "afv-native/audio/SinkFrameSizeAdjuster.h"
+#include "afv-native/audio/SourceFrameSizeAdjuster.h"
 
 using namespace afv_native::audio;
 using namespace std;
 
-AudioDevice::AudioDevice():
+const AudioDevice::Api AudioDevice::NullApi;
+const AudioDevice::Api AudioDevice::FileApi;
+
+AudioDevice::AudioDevice(unsigned int deviceFrameLengthMs):
     mSink(),
-    mSinkPtrLock(),
     mSource(),
-    mSourcePtrLock(),
+    mDeviceFrameLengthMs(deviceFrameLengthMs > 0 ? deviceFrameLengthMs : frameLengthMs),
+    mInputSampleRate(sampleRateHz),
+    mOutputSampleRate(sampleRateHz),
+    mInputFrameSizeSamples(sampleRateHz * mDeviceFrameLengthMs / 1000),
+    mOutputFrameSizeSamples(sampleRateHz * mDeviceFrameLengthMs / 1000),
+    mClientLock(),
+    mClientSource(),
+    mClientSink(),
     OutputUnderflows(0),
     InputOverflows(0)
 {
@@ -56,16 +71,104 @@ AudioDevice::~AudioDevice()
 {
 }
 
-void AudioDevice::setSource(std::shared_ptr<ISampleSource> newSrc) {
-    std::lock_guard<std::mutex> sourceGuard(mSourcePtrLock);
+std::shared_ptr<ISampleSource> AudioDevice::adaptSource(std::shared_ptr<ISampleSource> src) const
+{
+    if (!src) {
+        return src;
+    }
+    if (mOutputSampleRate != sampleRateHz) {
+        return std::make_shared<ResamplingSource>(std::move(src), mOutputSampleRate, mOutputFrameSizeSamples);
+    }
+    if (mOutputFrameSizeSamples != frameSizeSamples) {
+        return std::make_shared<SourceFrameSizeAdjuster>(std::move(src), mOutputFrameSizeSamples);
+    }
+    return src;
+}
+
+std::shared_ptr<ISampleSink> AudioDevice::adaptSink(std::shared_ptr<ISampleSink> sink) const
+{
+    if (!sink) {
+        return sink;
+    }
+    if (mInputSampleRate != sampleRateHz) {
+        return std::make_shared<ResamplingSink>(std::move(sink), mInputSampleRate, mInputFrameSizeSamples);
+    }
+    if (mInputFrameSizeSamples != frameSizeSamples) {
+        return std::make_shared<SinkFrameSizeAdjuster>(std::move(sink), mInputFrameSizeSamples);
+    }
+    return sink;
+}
 
-    mSource = std::move(newSrc);
+void AudioDevice::setSource(std::shared_ptr<ISampleSource> newSrc) {
+    std::lock_guard<std::mutex> clientGuard(mClientLock);
+    mClientSource = newSrc;
+    mSource.publish(adaptSource(std::move(newSrc)));
 }
 
 void AudioDevice::setSink(std::shared_ptr<ISampleSink> newSink) {
-    std::lock_guard<std::mutex> sinkGuard(mSinkPtrLock);
+    std::lock_guard<std::mutex> clientGuard(mClientLock);
+    mClientSink = newSink;
+    mSink.publish(adaptSink(std::move(newSink)));
+}
+
+void AudioDevice::setDeviceSampleRates(unsigned int inputSampleRate, unsigned int outputSampleRate)
+{
+    std::lock_guard<std::mutex> clientGuard(mClientLock);
+    if (inputSampleRate == mInputSampleRate && outputSampleRate == mOutputSampleRate) {
+        return;
+    }
+    LOG("AudioDevice", "hardware is running at %uHz in, %uHz out - resampling as required",
+        inputSampleRate, outputSampleRate);
+    mInputSampleRate = inputSampleRate;
+    mOutputSampleRate = outputSampleRate;
+    mInputFrameSizeSamples = mInputSampleRate * mDeviceFrameLengthMs / 1000;
+    mOutputFrameSizeSamples = mOutputSampleRate * mDeviceFrameLengthMs / 1000;
+
+    mSource.publish(adaptSource(mClientSource));
+    mSink.publish(adaptSink(mClientSink));
+}
 
-    mSink = std::move(newSink);
+unsigned int AudioDevice::getInputSampleRate() const
+{
+    return mInputSampleRate;
+}
+
+unsigned int AudioDevice::getOutputSampleRate() const
+{
+    return mOutputSampleRate;
+}
+
+unsigned int AudioDevice::getInputFrameSizeSamples() const
+{
+    return mInputFrameSizeSamples;
+}
+
+unsigned int AudioDevice::getOutputFrameSizeSamples() const
+{
+    return mOutputFrameSizeSamples;
+}
+
+bool AudioDevice::isVirtualApi(Api api)
+{
+    return api == NullApi || api == FileApi;
+}
+
+void AudioDevice::addVirtualAPIs(std::map<Api, std::string> &apiList)
+{
+    apiList[NullApi] = "Null (no audio)";
+    apiList[FileApi] = "WAVE Files";
+}
+
+std::shared_ptr<AudioDevice> AudioDevice::makeVirtualDevice(
+        const std::string &outputDeviceId,
+        const std::string &inputDeviceId,
+        Api audioApi,
+        unsigned int deviceFrameLengthMs)
+{
+    if (audioApi == FileApi) {
+        return std::make_shared<FileAudioDevice>(inputDeviceId, outputDeviceId, deviceFrameLengthMs);
+    }
+    return std::make_shared<NullAudioDevice>(deviceFrameLengthMs);
 }
 
 AudioDevice::DeviceInfo::DeviceInfo(std::string newName, std::string newId) :
@@ -0,0 +1,88 @@
+/* audio/ChannelCopy.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "afv-native/audio/ChannelCopy.h"
+
+#include <cstdint>
+#include <cstring>
+
+using namespace afv_native::audio;
+
+namespace {
+    inline bool isSampleAligned(const void *ptr, size_t step)
+    {
+        return (reinterpret_cast<uintptr_t>(ptr) % alignof(SampleType)) == 0 && (step % sizeof(SampleType)) == 0;
+    }
+}
+
+void afv_native::audio::copyToStrided(const SampleType *src, char *dst, size_t dstStep, size_t count)
+{
+    if (dstStep == sizeof(SampleType)) {
+        ::memcpy(dst, src, count * sizeof(SampleType));
+    } else if (isSampleAligned(dst, dstStep)) {
+        auto *out = reinterpret_cast<SampleType *>(dst);
+        const size_t stride = dstStep / sizeof(SampleType);
+        for (size_t i = 0; i < count; i++) {
+            out[i * stride] = src[i];
+        }
+    } else {
+        for (size_t i = 0; i < count; i++) {
+            ::memcpy(dst + i * dstStep, src + i, sizeof(SampleType));
+        }
+    }
+}
+
+void afv_native::audio::copyFromStrided(const char *src, size_t srcStep, SampleType *dst, size_t count)
+{
+    if (srcStep == sizeof(SampleType)) {
+        ::memcpy(dst, src, count * sizeof(SampleType));
+    } else if (isSampleAligned(src, srcStep)) {
+        const auto *in = reinterpret_cast<const SampleType *>(src);
+        const size_t stride = srcStep / sizeof(SampleType);
+        for (size_t i = 0; i < count; i++) {
+            dst[i] = in[i * stride];
+        }
+    } else {
+        for (size_t i = 0; i < count; i++) {
+            ::memcpy(dst + i, src + i * srcStep, sizeof(SampleType));
+        }
+    }
+}
+
+void afv_native::audio::duplicateToStereo(const SampleType *src, SampleType *dst, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        dst[2 * i] = src[i];
+        dst[2 * i + 1] = src[i];
+    }
+}
@@ -0,0 +1,114 @@
+/* audio/DecimatingSink.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "afv-native/audio/DecimatingSink.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "afv-native/utility.h"
+
+using namespace afv_native::audio;
+
+DecimatingSink::DecimatingSink(std::shared_ptr<ISampleSink> upstream, unsigned int decimationFactor):
+        mUpstreamSink(std::move(upstream)),
+        mDecimationFactor(std::max(1U, decimationFactor)),
+        mOutputFrameSize(0),
+        mCoefficients(filterTaps),
+        mWorkBuffer(nullptr),
+        mOutputBuffer(nullptr)
+{
+    mOutputFrameSize = frameSizeSamples / mDecimationFactor;
+    mWorkBuffer = new SampleType[filterTaps - 1 + frameSizeSamples];
+    mOutputBuffer = new SampleType[mOutputFrameSize];
+    reset();
+
+    // Blackman windowed-sinc lowpass, with the cutoff set a little below the output nyquist so the transition band
+    // is mostly above the voice band and mostly below the aliasing point.
+    const double cutoff = 0.875 / (2.0 * mDecimationFactor);
+    const double centre = (filterTaps - 1) / 2.0;
+    double sum = 0.0;
+    for (size_t i = 0; i < filterTaps; i++) {
+        const double x = static_cast<double>(i) - centre;
+        double sinc = 2.0 * cutoff;
+        if (x != 0.0) {
+            sinc = std::sin(2.0 * M_PI * cutoff * x) / (M_PI * x);
+        }
+        const double phase = 2.0 * M_PI * static_cast<double>(i) / (filterTaps - 1);
+        const double window = 0.42 - 0.5 * std::cos(phase) + 0.08 * std::cos(2.0 * phase);
+        mCoefficients[i] = static_cast<float>(sinc * window);
+        sum += mCoefficients[i];
+    }
+    // normalise for unity gain at DC.
+    for (auto &c: mCoefficients) {
+        c = static_cast<float>(c / sum);
+    }
+}
+
+DecimatingSink::~DecimatingSink()
+{
+    delete[] mOutputBuffer;
+    delete[] mWorkBuffer;
+}
+
+void DecimatingSink::reset()
+{
+    ::memset(mWorkBuffer, 0, (filterTaps - 1 + frameSizeSamples) * sizeof(SampleType));
+}
+
+size_t DecimatingSink::getOutputFrameSize() const
+{
+    return mOutputFrameSize;
+}
+
+void DecimatingSink::putAudioFrame(const SampleType *bufferIn)
+{
+    ::memcpy(mWorkBuffer + filterTaps - 1, bufferIn, frameSizeBytes);
+
+    const float * RESTRICT coeffs = mCoefficients.data();
+    for (size_t o = 0; o < mOutputFrameSize; o++) {
+        const SampleType * RESTRICT window = mWorkBuffer + (o * mDecimationFactor);
+        float acc = 0.0f;
+        for (size_t k = 0; k < filterTaps; k++) {
+            acc += coeffs[k] * window[k];
+        }
+        mOutputBuffer[o] = acc;
+    }
+    // keep the tail of this frame as the history for the next.
+    ::memmove(mWorkBuffer, mWorkBuffer + frameSizeSamples, (filterTaps - 1) * sizeof(SampleType));
+
+    if (mUpstreamSink) {
+        mUpstreamSink->putAudioFrame(mOutputBuffer);
+    }
+}
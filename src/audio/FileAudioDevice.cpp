@@ -0,0 +1,112 @@
+/* audio/FileAudioDevice.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "afv-native/audio/FileAudioDevice.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "afv-native/Log.h"
+
+using namespace afv_native::audio;
+
+FileAudioDevice::FileAudioDevice(
+        std::string inputFileName,
+        std::string outputFileName,
+        unsigned int deviceFrameLengthMs):
+        NullAudioDevice(deviceFrameLengthMs),
+        mInputFileName(std::move(inputFileName)),
+        mOutputFileName(std::move(outputFileName)),
+        mInputSamples(),
+        mInputPosition(0),
+        mInputFinished(true),
+        mOutputWriter()
+{
+}
+
+FileAudioDevice::~FileAudioDevice()
+{
+    // make sure the thread has stopped before our members go away.
+    FileAudioDevice::close();
+}
+
+bool FileAudioDevice::open()
+{
+    if (!mInputFileName.empty()) {
+        std::unique_ptr<AudioSampleData> inputData(LoadWav(mInputFileName.c_str()));
+        if (!inputData) {
+            LOGERROR("FileAudioDevice", "couldn't load input file %s", mInputFileName.c_str());
+            return false;
+        }
+        mInputSamples.reset(new WavSampleStorage(*inputData));
+        mInputPosition = 0;
+        mInputFinished.store(false);
+    }
+    if (!mOutputFileName.empty()) {
+        if (!mOutputWriter.open(mOutputFileName, mOutputSampleRate, SampleFormat::Int16)) {
+            return false;
+        }
+    }
+    return NullAudioDevice::open();
+}
+
+void FileAudioDevice::close()
+{
+    NullAudioDevice::close();
+    mOutputWriter.close();
+}
+
+bool FileAudioDevice::isInputFinished() const
+{
+    return mInputFinished.load();
+}
+
+void FileAudioDevice::readInput(SampleType *bufferOut, size_t count)
+{
+    size_t copied = 0;
+    if (mInputSamples) {
+        const size_t available = mInputSamples->lengthInSamples() - mInputPosition;
+        copied = std::min(count, available);
+        ::memcpy(bufferOut, mInputSamples->data() + mInputPosition, copied * sizeof(SampleType));
+        mInputPosition += copied;
+        if (mInputPosition >= mInputSamples->lengthInSamples()) {
+            mInputFinished.store(true);
+        }
+    }
+    ::memset(bufferOut + copied, 0, (count - copied) * sizeof(SampleType));
+}
+
+void FileAudioDevice::writeOutput(const SampleType *bufferIn, size_t count)
+{
+    mOutputWriter.writeSamples(bufferIn, count);
+}
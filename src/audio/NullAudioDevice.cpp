@@ -0,0 +1,163 @@
+/* audio/NullAudioDevice.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "afv-native/audio/NullAudioDevice.h"
+
+#include <chrono>
+#include <cstring>
+
+#include "afv-native/Log.h"
+#include "afv-native/util/DenormalGuard.h"
+#include "afv-native/util/RealtimeGuard.h"
+#include "afv-native/util/ThreadPolicy.h"
+#include "afv-native/util/Trace.h"
+
+using namespace afv_native::audio;
+
+NullAudioDevice::NullAudioDevice(unsigned int deviceFrameLengthMs):
+        AudioDevice(deviceFrameLengthMs),
+        mThread(),
+        mRunning(false),
+        mSpeed(1.0),
+        mFramesProcessed(0),
+        mInputFrame(new SampleType[mInputFrameSizeSamples]),
+        mOutputFrame(new SampleType[mOutputFrameSizeSamples])
+{
+}
+
+NullAudioDevice::~NullAudioDevice()
+{
+    close();
+    delete[] mOutputFrame;
+    delete[] mInputFrame;
+}
+
+bool NullAudioDevice::open()
+{
+    if (mRunning.load()) {
+        return true;
+    }
+    mFramesProcessed.store(0);
+    // our thread is real-time, so it can't set up its own log ring.
+    prepareRealtimeLogging();
+    mRunning.store(true);
+    mThread = std::thread(&NullAudioDevice::run, this);
+    return true;
+}
+
+void NullAudioDevice::close()
+{
+    if (!mRunning.exchange(false)) {
+        return;
+    }
+    if (mThread.joinable()) {
+        mThread.join();
+    }
+}
+
+void NullAudioDevice::setSpeed(double speed)
+{
+    mSpeed.store(speed > 0.0 ? speed : 0.0);
+}
+
+double NullAudioDevice::getSpeed() const
+{
+    return mSpeed.load();
+}
+
+uint64_t NullAudioDevice::getFramesProcessed() const
+{
+    return mFramesProcessed.load();
+}
+
+void NullAudioDevice::readInput(SampleType *bufferOut, size_t count)
+{
+    ::memset(bufferOut, 0, count * sizeof(SampleType));
+}
+
+void NullAudioDevice::writeOutput(const SampleType *, size_t)
+{
+}
+
+void NullAudioDevice::processFrame()
+{
+    util::RealtimeScope realtime;
+    util::FlushDenormalsScope denormals;
+    TRACE_SCOPE("audio", "NullAudioDevice frame");
+    {
+        auto sink = mSink.read();
+        if (sink) {
+            readInput(mInputFrame, mInputFrameSizeSamples);
+            sink->putAudioFrame(mInputFrame);
+        }
+    }
+    {
+        auto source = mSource.read();
+        if (source) {
+            if (source->getAudioFrame(mOutputFrame) != SourceStatus::OK) {
+                ::memset(mOutputFrame, 0, mOutputFrameSizeSamples * sizeof(SampleType));
+                mSource.unpublish(source.get());
+            }
+        } else {
+            ::memset(mOutputFrame, 0, mOutputFrameSizeSamples * sizeof(SampleType));
+        }
+    }
+    writeOutput(mOutputFrame, mOutputFrameSizeSamples);
+    mFramesProcessed.fetch_add(1);
+}
+
+void NullAudioDevice::run()
+{
+    typedef std::chrono::steady_clock clock;
+    const std::chrono::duration<double> frameDuration(static_cast<double>(mOutputFrameSizeSamples) / mOutputSampleRate);
+
+    auto nextFrame = clock::now();
+    while (mRunning.load()) {
+        util::maintainThreadPolicy(util::ThreadClass::Audio, "afv-null-audio");
+        processFrame();
+
+        const double speed = mSpeed.load();
+        if (speed > 0.0) {
+            nextFrame += std::chrono::duration_cast<clock::duration>(frameDuration / speed);
+            const auto now = clock::now();
+            if (nextFrame > now) {
+                std::this_thread::sleep_until(nextFrame);
+            } else if (now - nextFrame > std::chrono::duration_cast<clock::duration>(frameDuration * 10)) {
+                // we've fallen well behind (or the speed changed) - don't try to catch up in a burst.
+                nextFrame = now;
+            }
+        } else {
+            nextFrame = clock::now();
+        }
+    }
+}
@@ -40,49 +40,69 @@
 
 using namespace afv_native::audio;
 
-OutputMixer::OutputMixer()
+OutputMixer::OutputMixer():
+    mSources(),
+    mGain(1.0f),
+    mIntermediateBuffer(nullptr)
 {
+    mIntermediateBuffer = new SampleType[frameSizeSamples];
 }
 
 OutputMixer::~OutputMixer()
 {
+    delete[] mIntermediateBuffer;
 }
 
 SourceStatus
 OutputMixer::getAudioFrame(SampleType * RESTRICT bufferOut)
+{
+    return getAudioFrames(bufferOut, 1);
+}
+
+SourceStatus
+OutputMixer::getAudioFrames(SampleType * RESTRICT bufferOut, size_t nFrames)
+{
+    for (size_t f = 0; f < nFrames; f++) {
+        mixFrame(bufferOut + (f * frameSizeSamples));
+    }
+    mSources.remove_if([](const MixerSource &ms) -> bool { return !ms.src; });
+    return SourceStatus::OK;
+}
+
+bool
+OutputMixer::mixFrame(SampleType * RESTRICT bufferOut)
 {
     SourceStatus src_rv;
     bool didMix = false;
     int i = 0;
 
-    std::vector<SampleType> ibuf(frameSizeSamples, 0.0); // we must not touch ibuf directly. (due RESTICT in next line).
-    auto * intermediate_buffer = ibuf.data();
-
     ::memset(bufferOut, 0, sizeof(SampleType) * frameSizeSamples);
 
     for (auto &src_iter: mSources) {
-        src_rv = src_iter.src->getAudioFrame(intermediate_buffer);
+        if (!src_iter.src) {
+            continue;
+        }
+        src_rv = src_iter.src->getAudioFrame(mIntermediateBuffer);
         if (src_rv == SourceStatus::OK) {
             didMix = true;
             for (i = 0; i < frameSizeSamples; i++) {
-                bufferOut[i] += (src_iter.gain * intermediate_buffer[i]);
+                bufferOut[i] += (src_iter.gain * mIntermediateBuffer[i]);
             }
         } else {
             if (src_rv == SourceStatus::Error) {
-                LOG("outputmixer", "Error reading from stream.  Removing from mixer.");
+                LOGWARN("outputmixer", "Error reading from stream.  Removing from mixer.");
             }
             // otherwise the stream closed, and we can close it silently!
             src_iter.src.reset();
         }
     }
-    mSources.remove_if([](MixerSource ms) -> bool { return !ms.src; });
     // apply final volume adjustment.
     if (didMix) {
         for (i = 0; i < frameSizeSamples; i++) {
             bufferOut[i] *= mGain;
         }
     }
-    return SourceStatus::OK;
+    return didMix;
 }
 
 void OutputMixer::setSource(const std::shared_ptr<ISampleSource> &src, float gain)
@@ -38,6 +38,10 @@
 #include <portaudio.h>
 
 #include "afv-native/Log.h"
+#include "afv-native/util/DenormalGuard.h"
+#include "afv-native/util/RealtimeGuard.h"
+#include "afv-native/util/ThreadPolicy.h"
+#include "afv-native/util/Trace.h"
 
 using namespace afv_native::audio;
 using namespace std;
@@ -46,8 +50,9 @@ PortAudioAudioDevice::PortAudioAudioDevice(
         const std::string &userStreamName,
         const std::string &outputDeviceName,
         const std::string &inputDeviceName,
-        AudioDevice::Api audioApi):
-        AudioDevice(),
+        AudioDevice::Api audioApi,
+        unsigned int deviceFrameLengthMs):
+        AudioDevice(deviceFrameLengthMs),
         mApi(audioApi),
         mUserStreamName(userStreamName),
         mOutputDeviceName(outputDeviceName),
@@ -74,6 +79,8 @@ PortAudioAudioDevice::~PortAudioAudioDevice()
 
 bool PortAudioAudioDevice::open()
 {
+    // the callback thread is real-time, so it can't set up its own log ring.
+    prepareRealtimeLogging();
     PaStreamFlags devStreamOpts = paNoFlag;
 
     PaStreamParameters inDevParam, outDevParam;
@@ -85,23 +92,38 @@ bool PortAudioAudioDevice::open()
         return false;
     }
 
-    LOG("AudioDevice", "Opening 1 Channel, %dHz Sampling Rate, %d samples per frame", sampleRateHz, frameSizeSamples);
+    const auto *streamInParam = mSink.isPublished() ? &inDevParam : nullptr;
+    const auto *streamOutParam = mSource.isPublished() ? &outDevParam : nullptr;
+
+    // if the hardware can't run at our rate, run it at its own and resample at our end rather than relying on the
+    // host API to do it for us.
+    unsigned int streamRate = sampleRateHz;
+    if (Pa_IsFormatSupported(streamInParam, streamOutParam, sampleRateHz) != paFormatIsSupported) {
+        const auto *devInfo = Pa_GetDeviceInfo(streamOutParam != nullptr ? outDevParam.device : inDevParam.device);
+        if (devInfo != nullptr && devInfo->defaultSampleRate > 0) {
+            streamRate = static_cast<unsigned int>(devInfo->defaultSampleRate);
+        }
+    }
+    // portaudio runs both directions at the same rate.
+    setDeviceSampleRates(streamRate, streamRate);
+
+    LOG("AudioDevice", "Opening 1 Channel, %dHz Sampling Rate, %d samples per frame", streamRate, mOutputFrameSizeSamples);
     auto rv = Pa_OpenStream(
             &mAudioDevice,
-            mSink ? &inDevParam : nullptr,
-            mSource ? &outDevParam : nullptr,
-            sampleRateHz,
-            frameSizeSamples,
+            streamInParam,
+            streamOutParam,
+            streamRate,
+            mOutputFrameSizeSamples,
             devStreamOpts,
             &PortAudioAudioDevice::paAudioCallback,
             this);
     if (rv != paNoError) {
-        LOG("AudioDevice", "failed to open audio device: %s", Pa_GetErrorText(rv));
+        LOGERROR("AudioDevice", "failed to open audio device: %s", Pa_GetErrorText(rv));
         return false;
     }
     rv = Pa_StartStream(mAudioDevice);
     if (rv != paNoError) {
-        LOG("AudioDevice", "failed to start audio stream: %s", Pa_GetErrorText(rv));
+        LOGERROR("AudioDevice", "failed to start audio stream: %s", Pa_GetErrorText(rv));
         return false;
     }
     return true;
@@ -125,7 +147,7 @@ bool PortAudioAudioDevice::getDeviceForName(const string &deviceName, bool forIn
                 return true;
             }
         }
-        LOG("AudioDevice", "Couldn't find a compatible device \"%s\" - using default", deviceName.c_str());
+        LOGWARN("AudioDevice", "Couldn't find a compatible device \"%s\" - using default", deviceName.c_str());
     }
     // next, try the default device...
     auto devId = Pa_HostApiDeviceIndexToDeviceIndex(
@@ -144,7 +166,7 @@ bool PortAudioAudioDevice::getDeviceForName(const string &deviceName, bool forIn
     // if the default device doesn't work, pull the first device that will.
     auto firstDev = allDevices.begin();
     if (firstDev != allDevices.end()) {
-        LOG("AudioDevice", "Default can't handle our format.  Using \"%s\" instead.", firstDev->second.name.c_str());
+        LOGWARN("AudioDevice", "Default can't handle our format.  Using \"%s\" instead.", firstDev->second.name.c_str());
         deviceParamOut.device = firstDev->first;
         deviceParamOut.channelCount = 1;
         deviceParamOut.sampleFormat = paFloat32;
@@ -153,7 +175,7 @@ bool PortAudioAudioDevice::getDeviceForName(const string &deviceName, bool forIn
         deviceParamOut.hostApiSpecificStreamInfo = nullptr;
         return true;
     }
-    LOG("AudioDevice", "Couldn't map a working audio device");
+    LOGERROR("AudioDevice", "Couldn't map a working audio device");
     return false;
 }
 
@@ -178,35 +200,44 @@ int PortAudioAudioDevice::audioCallback(
         const PaStreamCallbackTimeInfo *streamTime,
         PaStreamCallbackFlags status)
 {
+    util::maintainThreadPolicy(util::ThreadClass::Audio, "afv-audio");
+    util::RealtimeScope realtime;
+    util::FlushDenormalsScope denormals;
+    TRACE_SCOPE("audio", "PortAudio callback");
     if ((status & paInputOverflowed) == paInputOverflowed) {
         InputOverflows.fetch_add(1);
     }
     if ((status & paOutputUnderflowed) == paOutputUnderflowed) {
         OutputUnderflows.fetch_add(1);
     }
-    {
-        std::lock_guard<std::mutex> sinkGuard(mSinkPtrLock);
-        if (mSink && inputBuffer) {
-            for (size_t i = 0; i < nFrames; i += frameSizeSamples) {
-                mSink->putAudioFrame(reinterpret_cast<const float *>(inputBuffer) + i);
+    if (inputBuffer) {
+        auto sink = mSink.read();
+        if (sink) {
+            for (size_t i = 0; i < nFrames; i += mInputFrameSizeSamples) {
+                sink->putAudioFrame(reinterpret_cast<const float *>(inputBuffer) + i);
             }
         }
     }
     if (outputBuffer) {
-        std::lock_guard<std::mutex> sourceGuard(mSourcePtrLock);
+        auto source = mSource.read();
 
-        for (size_t i = 0; i < nFrames; i += frameSizeSamples) {
-            if (mSource) {
-                SourceStatus rv;
-                rv = mSource->getAudioFrame(reinterpret_cast<float *>(outputBuffer) + i);
-                if (rv != SourceStatus::OK) {
-                    ::memset(reinterpret_cast<float *>(outputBuffer) + i, 0, frameSizeBytes);
-                    mSource.reset();
-                }
-            } else {
-                // if there's no source, but there is an output buffer, zero it to avoid making horrible buzzing sounds.
-                ::memset(reinterpret_cast<float *>(outputBuffer) + i, 0, frameSizeBytes);
+        auto *outputSamples = reinterpret_cast<float *>(outputBuffer);
+        // fetch all of the whole frames in one go so the source only has to do its setup once.
+        const size_t deviceFrames = nFrames / mOutputFrameSizeSamples;
+        const size_t framedSamples = deviceFrames * mOutputFrameSizeSamples;
+        if (source) {
+            SourceStatus rv;
+            rv = source->getAudioFrames(outputSamples, deviceFrames);
+            if (rv != SourceStatus::OK) {
+                ::memset(outputSamples, 0, framedSamples * sizeof(SampleType));
+                mSource.unpublish(source.get());
             }
+        } else {
+            // if there's no source, but there is an output buffer, zero it to avoid making horrible buzzing sounds.
+            ::memset(outputSamples, 0, framedSamples * sizeof(SampleType));
+        }
+        if (framedSamples < nFrames) {
+            ::memset(outputSamples + framedSamples, 0, (nFrames - framedSamples) * sizeof(SampleType));
         }
     }
     return 0;
@@ -294,7 +325,9 @@ bool PortAudioAudioDevice::isAbleToOpen(int deviceId, int forInput) {
                         devInfo->defaultLowInputLatency,
                         nullptr,
                 };
-                if (0 == Pa_IsFormatSupported(&inputTest, nullptr, sampleRateHz)) {
+                // we can resample if the device doesn't support our rate natively.
+                if (0 == Pa_IsFormatSupported(&inputTest, nullptr, sampleRateHz) ||
+                    0 == Pa_IsFormatSupported(&inputTest, nullptr, devInfo->defaultSampleRate)) {
                     return true;
                 }
             }
@@ -307,7 +340,8 @@ bool PortAudioAudioDevice::isAbleToOpen(int deviceId, int forInput) {
                         devInfo->defaultLowOutputLatency,
                         nullptr,
                 };
-                if (0 == Pa_IsFormatSupported(nullptr, &outputTest, sampleRateHz)) {
+                if (0 == Pa_IsFormatSupported(nullptr, &outputTest, sampleRateHz) ||
+                    0 == Pa_IsFormatSupported(nullptr, &outputTest, devInfo->defaultSampleRate)) {
                     return true;
                 }
             }
@@ -328,10 +362,15 @@ PortAudioAudioDevice::PrivateDeviceInfo::PrivateDeviceInfo(const PaDeviceInfo *s
 
 /* ========== Factory hooks ============= */
 map<AudioDevice::Api, std::string> AudioDevice::getAPIs() {
-    return PortAudioAudioDevice::getAPIs();
+    auto apiList = PortAudioAudioDevice::getAPIs();
+    addVirtualAPIs(apiList);
+    return apiList;
 }
 
 map<int, AudioDevice::DeviceInfo> AudioDevice::getCompatibleInputDevicesForApi(AudioDevice::Api api) {
+    if (isVirtualApi(api)) {
+        return map<int, AudioDevice::DeviceInfo>();
+    }
     auto allDevices = PortAudioAudioDevice::getCompatibleInputDevicesForApi(api);
     map<int, AudioDevice::DeviceInfo> returnDevices;
     for (const auto &p: allDevices) {
@@ -341,6 +380,9 @@ map<int, AudioDevice::DeviceInfo> AudioDevice::getCompatibleInputDevicesForApi(A
 }
 
 map<int, AudioDevice::DeviceInfo> AudioDevice::getCompatibleOutputDevicesForApi(AudioDevice::Api api) {
+    if (isVirtualApi(api)) {
+        return map<int, AudioDevice::DeviceInfo>();
+    }
     auto allDevices = PortAudioAudioDevice::getCompatibleOutputDevicesForApi(api);
     map<int, AudioDevice::DeviceInfo> returnDevices;
     for (const auto &p: allDevices) {
@@ -354,7 +396,12 @@ AudioDevice::makeDevice(
         const std::string &userStreamName,
         const std::string &outputDeviceId,
         const std::string &inputDeviceId,
-        AudioDevice::Api audioApi) {
-    auto devsp = std::make_shared<PortAudioAudioDevice>(userStreamName, outputDeviceId, inputDeviceId, audioApi);
+        AudioDevice::Api audioApi,
+        unsigned int deviceFrameLengthMs) {
+    if (isVirtualApi(audioApi)) {
+        return makeVirtualDevice(outputDeviceId, inputDeviceId, audioApi, deviceFrameLengthMs);
+    }
+    auto devsp = std::make_shared<PortAudioAudioDevice>(
+            userStreamName, outputDeviceId, inputDeviceId, audioApi, deviceFrameLengthMs);
     return devsp;
 }
@@ -82,7 +82,8 @@ namespace afv_native {
                     const std::string &userStreamName,
                     const std::string &outputDeviceName,
                     const std::string &inputDeviceName,
-                    Api audioApi);
+                    Api audioApi,
+                    unsigned int deviceFrameLengthMs = frameLengthMs);
             virtual ~PortAudioAudioDevice();
             bool open() override;
             void close() override;
@@ -0,0 +1,160 @@
+/* audio/ReblockingBuffer.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "afv-native/audio/ReblockingBuffer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+using namespace afv_native::audio;
+
+ReblockingBuffer::ReblockingBuffer(size_t minimumCapacity):
+        mCapacity(1),
+        mMask(0),
+        mReadIndex(0),
+        mWriteIndex(0),
+        mWriteStaged(false),
+        mRing(nullptr),
+        mWriteScratch(nullptr),
+        mReadScratch(nullptr)
+{
+    resize(minimumCapacity);
+}
+
+ReblockingBuffer::~ReblockingBuffer()
+{
+    delete[] mReadScratch;
+    delete[] mWriteScratch;
+    delete[] mRing;
+}
+
+void ReblockingBuffer::reset()
+{
+    mReadIndex = 0;
+    mWriteIndex = 0;
+    mWriteStaged = false;
+}
+
+void ReblockingBuffer::resize(size_t minimumCapacity)
+{
+    delete[] mReadScratch;
+    delete[] mWriteScratch;
+    delete[] mRing;
+
+    mCapacity = 1;
+    while (mCapacity < minimumCapacity) {
+        mCapacity <<= 1;
+    }
+    mMask = mCapacity - 1;
+    mRing = new SampleType[mCapacity];
+    mWriteScratch = new SampleType[mCapacity];
+    mReadScratch = new SampleType[mCapacity];
+    ::memset(mRing, 0, mCapacity * sizeof(SampleType));
+    reset();
+}
+
+void ReblockingBuffer::copyIn(size_t index, const SampleType *bufferIn, size_t count)
+{
+    const size_t offset = index & mMask;
+    const size_t firstPart = std::min(count, mCapacity - offset);
+    ::memcpy(mRing + offset, bufferIn, firstPart * sizeof(SampleType));
+    if (firstPart < count) {
+        ::memcpy(mRing, bufferIn + firstPart, (count - firstPart) * sizeof(SampleType));
+    }
+}
+
+void ReblockingBuffer::copyOut(size_t index, SampleType *bufferOut, size_t count) const
+{
+    const size_t offset = index & mMask;
+    const size_t firstPart = std::min(count, mCapacity - offset);
+    ::memcpy(bufferOut, mRing + offset, firstPart * sizeof(SampleType));
+    if (firstPart < count) {
+        ::memcpy(bufferOut + firstPart, mRing, (count - firstPart) * sizeof(SampleType));
+    }
+}
+
+size_t ReblockingBuffer::write(const SampleType *bufferIn, size_t count)
+{
+    count = std::min(count, getSpace());
+    copyIn(mWriteIndex, bufferIn, count);
+    mWriteIndex += count;
+    return count;
+}
+
+size_t ReblockingBuffer::read(SampleType *bufferOut, size_t count)
+{
+    count = std::min(count, getAvailable());
+    copyOut(mReadIndex, bufferOut, count);
+    mReadIndex += count;
+    return count;
+}
+
+SampleType *ReblockingBuffer::beginWrite(size_t count)
+{
+    assert(count <= getSpace());
+    const size_t offset = mWriteIndex & mMask;
+    if (offset + count <= mCapacity) {
+        mWriteStaged = false;
+        return mRing + offset;
+    }
+    mWriteStaged = true;
+    return mWriteScratch;
+}
+
+void ReblockingBuffer::endWrite(size_t count)
+{
+    assert(count <= getSpace());
+    if (mWriteStaged) {
+        copyIn(mWriteIndex, mWriteScratch, count);
+        mWriteStaged = false;
+    }
+    mWriteIndex += count;
+}
+
+const SampleType *ReblockingBuffer::beginRead(size_t count)
+{
+    assert(count <= getAvailable());
+    const size_t offset = mReadIndex & mMask;
+    if (offset + count <= mCapacity) {
+        return mRing + offset;
+    }
+    copyOut(mReadIndex, mReadScratch, count);
+    return mReadScratch;
+}
+
+void ReblockingBuffer::endRead(size_t count)
+{
+    assert(count <= getAvailable());
+    mReadIndex += count;
+}
@@ -80,3 +80,9 @@ bool RecordedSampleSource::isPlaying() const
 {
     return mPlay;
 }
+
+void RecordedSampleSource::restart()
+{
+    mCurPosition = 0;
+    mPlay = true;
+}
@@ -0,0 +1,97 @@
+/* audio/ResamplingSink.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "afv-native/audio/ResamplingSink.h"
+
+#include <speex/speex_resampler.h>
+
+#include "afv-native/Log.h"
+
+using namespace afv_native::audio;
+
+ResamplingSink::ResamplingSink(
+        std::shared_ptr<ISampleSink> destSink,
+        unsigned int inputSampleRate,
+        unsigned int inputFrameSize):
+        mDestinationSink(std::move(destSink)),
+        mInputSampleRate(inputSampleRate),
+        mInputFrameSize(inputFrameSize),
+        mResampler(nullptr),
+        mBuffer(frameSizeSamples + inputFrameSize * sampleRateHz / inputSampleRate + 16)
+{
+    int err = 0;
+    mResampler = speex_resampler_init(1, mInputSampleRate, sampleRateHz, SPEEX_RESAMPLER_QUALITY_DESKTOP, &err);
+    if (mResampler == nullptr) {
+        LOGERROR("ResamplingSink", "couldn't create resampler for %dHz: %d", mInputSampleRate, err);
+    } else {
+        speex_resampler_skip_zeros(mResampler);
+    }
+}
+
+ResamplingSink::~ResamplingSink()
+{
+    if (mResampler != nullptr) {
+        speex_resampler_destroy(mResampler);
+        mResampler = nullptr;
+    }
+}
+
+void ResamplingSink::putAudioFrame(const SampleType *bufferIn)
+{
+    if (mResampler == nullptr) {
+        return;
+    }
+    // we never hold a complete frame between calls, so there's always room for the whole input frame's output.
+    const size_t space = mBuffer.getSpace();
+    auto *fillPtr = mBuffer.beginWrite(space);
+    spx_uint32_t inLen = mInputFrameSize;
+    auto outLen = static_cast<spx_uint32_t>(space);
+    speex_resampler_process_float(mResampler, 0, bufferIn, &inLen, fillPtr, &outLen);
+    mBuffer.endWrite(outLen);
+
+    while (mBuffer.getAvailable() >= frameSizeSamples) {
+        if (mDestinationSink) {
+            mDestinationSink->putAudioFrame(mBuffer.beginRead(frameSizeSamples));
+        }
+        mBuffer.endRead(frameSizeSamples);
+    }
+}
+
+size_t ResamplingSink::getLatencySamples() const
+{
+    size_t latency = mBuffer.getLatencySamples();
+    if (mResampler != nullptr) {
+        latency += speex_resampler_get_output_latency(mResampler);
+    }
+    return latency;
+}
@@ -0,0 +1,141 @@
+/* audio/ResamplingSource.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "afv-native/audio/ResamplingSource.h"
+
+#include <cstring>
+#include <speex/speex_resampler.h>
+
+#include "afv-native/Log.h"
+
+using namespace afv_native::audio;
+
+namespace {
+    /** the most samples the resampler can emit for one of our frames, with a little slack for its rounding. */
+    size_t maxOutputPerFrame(unsigned int outputSampleRate)
+    {
+        return frameSizeSamples * outputSampleRate / sampleRateHz + 16;
+    }
+}
+
+ResamplingSource::ResamplingSource(
+        std::shared_ptr<ISampleSource> originSource,
+        unsigned int outputSampleRate,
+        unsigned int outputFrameSize):
+        mOriginSource(std::move(originSource)),
+        mOutputSampleRate(outputSampleRate),
+        mOutputFrameSize(outputFrameSize),
+        mResampler(nullptr),
+        mInputFrame(new SampleType[frameSizeSamples]),
+        mBuffer(outputFrameSize + maxOutputPerFrame(outputSampleRate))
+{
+    int err = 0;
+    mResampler = speex_resampler_init(1, sampleRateHz, mOutputSampleRate, SPEEX_RESAMPLER_QUALITY_DESKTOP, &err);
+    if (mResampler == nullptr) {
+        LOGERROR("ResamplingSource", "couldn't create resampler for %dHz: %d", mOutputSampleRate, err);
+    } else {
+        speex_resampler_skip_zeros(mResampler);
+    }
+}
+
+ResamplingSource::~ResamplingSource()
+{
+    if (mResampler != nullptr) {
+        speex_resampler_destroy(mResampler);
+        mResampler = nullptr;
+    }
+    delete[] mInputFrame;
+}
+
+bool ResamplingSource::fill(size_t count)
+{
+    while (mBuffer.getAvailable() < count) {
+        if (!mOriginSource || mResampler == nullptr) {
+            return false;
+        }
+        if (mOriginSource->getAudioFrame(mInputFrame) != SourceStatus::OK) {
+            mOriginSource.reset();
+            return false;
+        }
+        // there's always room for a whole frame's output as we never hold a complete output frame here.
+        const size_t space = mBuffer.getSpace();
+        auto *fillPtr = mBuffer.beginWrite(space);
+        spx_uint32_t inLen = frameSizeSamples;
+        auto outLen = static_cast<spx_uint32_t>(space);
+        speex_resampler_process_float(mResampler, 0, mInputFrame, &inLen, fillPtr, &outLen);
+        mBuffer.endWrite(outLen);
+    }
+    return true;
+}
+
+SourceStatus ResamplingSource::getAudioFrame(SampleType *bufferOut)
+{
+    if (!mOriginSource && mBuffer.getAvailable() == 0) {
+        return SourceStatus::Closed;
+    }
+    if (!fill(mOutputFrameSize)) {
+        // the origin broke - hand back what we have and silencefill the rest.
+        const size_t residual = mBuffer.read(bufferOut, mOutputFrameSize);
+        ::memset(bufferOut + residual, 0, sizeof(SampleType) * (mOutputFrameSize - residual));
+        return SourceStatus::OK;
+    }
+    mBuffer.read(bufferOut, mOutputFrameSize);
+    return SourceStatus::OK;
+}
+
+SourceStatus ResamplingSource::getAudioFrames(SampleType *bufferOut, size_t nFrames)
+{
+    // our frames are mOutputFrameSize long, not frameSizeSamples, so the device's frame count is in those.
+    for (size_t i = 0; i < nFrames; i++) {
+        auto rv = getAudioFrame(bufferOut + (i * mOutputFrameSize));
+        if (rv != SourceStatus::OK) {
+            ::memset(bufferOut + (i * mOutputFrameSize), 0, (nFrames - i) * mOutputFrameSize * sizeof(SampleType));
+            return rv;
+        }
+    }
+    return SourceStatus::OK;
+}
+
+size_t ResamplingSource::getFrameSizeSamples() const
+{
+    return mOutputFrameSize;
+}
+
+size_t ResamplingSource::getLatencySamples() const
+{
+    size_t latency = mBuffer.getLatencySamples();
+    if (mResampler != nullptr) {
+        latency += speex_resampler_get_output_latency(mResampler);
+    }
+    return latency;
+}
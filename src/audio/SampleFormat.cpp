@@ -0,0 +1,198 @@
+/* audio/SampleFormat.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "afv-native/audio/SampleFormat.h"
+
+#include <cstdint>
+#include <cstring>
+
+#include "afv-native/audio/ChannelCopy.h"
+
+using namespace afv_native::audio;
+
+/* The contiguous conversions are written as simple loops over aligned typed pointers so the compiler can
+ * vectorise them.  Anything strided, unaligned or packed goes a sample at a time.
+ */
+
+namespace {
+    const float int16Scale = 32768.0f;
+    const float int24Scale = 8388608.0f;
+    const float int32Scale = 2147483648.0f;
+
+    inline float clampScaled(float v, float scale)
+    {
+        v = v * scale;
+        // round to nearest, rather than truncate towards zero.
+        v += (v >= 0.0f) ? 0.5f : -0.5f;
+        // the largest float below scale that's representable - exactly scale-1 for the narrower formats.
+        const float maxValue = (scale > int24Scale) ? 2147483520.0f : scale - 1.0f;
+        v = (v > maxValue) ? maxValue : v;
+        v = (v < -scale) ? -scale : v;
+        return v;
+    }
+
+    template<typename T>
+    inline bool isAlignedFor(const void *ptr)
+    {
+        return (reinterpret_cast<uintptr_t>(ptr) % alignof(T)) == 0;
+    }
+
+    inline int32_t readInt24(const char *src)
+    {
+        const auto *b = reinterpret_cast<const uint8_t *>(src);
+        uint32_t v = static_cast<uint32_t>(b[0]) |
+                     (static_cast<uint32_t>(b[1]) << 8) |
+                     (static_cast<uint32_t>(b[2]) << 16);
+        // sign extend from bit 23.
+        if (v & 0x800000U) {
+            v |= 0xFF000000U;
+        }
+        return static_cast<int32_t>(v);
+    }
+
+    inline void writeInt24(char *dst, int32_t value)
+    {
+        auto *b = reinterpret_cast<uint8_t *>(dst);
+        const auto v = static_cast<uint32_t>(value);
+        b[0] = static_cast<uint8_t>(v & 0xFFU);
+        b[1] = static_cast<uint8_t>((v >> 8) & 0xFFU);
+        b[2] = static_cast<uint8_t>((v >> 16) & 0xFFU);
+    }
+}
+
+size_t afv_native::audio::getSampleFormatBytes(SampleFormat format)
+{
+    switch (format) {
+    case SampleFormat::Float32:
+        return sizeof(float);
+    case SampleFormat::Int16:
+        return sizeof(int16_t);
+    case SampleFormat::Int24:
+        return 3;
+    case SampleFormat::Int32:
+        return sizeof(int32_t);
+    }
+    return 0;
+}
+
+void afv_native::audio::convertToFormat(
+        const SampleType *src,
+        char *dst,
+        size_t dstStep,
+        SampleFormat format,
+        size_t count)
+{
+    switch (format) {
+    case SampleFormat::Float32:
+        copyToStrided(src, dst, dstStep, count);
+        break;
+    case SampleFormat::Int16:
+        if (dstStep == sizeof(int16_t) && isAlignedFor<int16_t>(dst)) {
+            auto *out = reinterpret_cast<int16_t *>(dst);
+            for (size_t i = 0; i < count; i++) {
+                out[i] = static_cast<int16_t>(clampScaled(src[i], int16Scale));
+            }
+        } else {
+            for (size_t i = 0; i < count; i++) {
+                const auto v = static_cast<int16_t>(clampScaled(src[i], int16Scale));
+                ::memcpy(dst + i * dstStep, &v, sizeof(v));
+            }
+        }
+        break;
+    case SampleFormat::Int24:
+        for (size_t i = 0; i < count; i++) {
+            writeInt24(dst + i * dstStep, static_cast<int32_t>(clampScaled(src[i], int24Scale)));
+        }
+        break;
+    case SampleFormat::Int32:
+        if (dstStep == sizeof(int32_t) && isAlignedFor<int32_t>(dst)) {
+            auto *out = reinterpret_cast<int32_t *>(dst);
+            for (size_t i = 0; i < count; i++) {
+                out[i] = static_cast<int32_t>(clampScaled(src[i], int32Scale));
+            }
+        } else {
+            for (size_t i = 0; i < count; i++) {
+                const auto v = static_cast<int32_t>(clampScaled(src[i], int32Scale));
+                ::memcpy(dst + i * dstStep, &v, sizeof(v));
+            }
+        }
+        break;
+    }
+}
+
+void afv_native::audio::convertFromFormat(
+        const char *src,
+        size_t srcStep,
+        SampleFormat format,
+        SampleType *dst,
+        size_t count)
+{
+    switch (format) {
+    case SampleFormat::Float32:
+        copyFromStrided(src, srcStep, dst, count);
+        break;
+    case SampleFormat::Int16:
+        if (srcStep == sizeof(int16_t) && isAlignedFor<int16_t>(src)) {
+            const auto *in = reinterpret_cast<const int16_t *>(src);
+            for (size_t i = 0; i < count; i++) {
+                dst[i] = static_cast<SampleType>(in[i]) / int16Scale;
+            }
+        } else {
+            for (size_t i = 0; i < count; i++) {
+                int16_t v;
+                ::memcpy(&v, src + i * srcStep, sizeof(v));
+                dst[i] = static_cast<SampleType>(v) / int16Scale;
+            }
+        }
+        break;
+    case SampleFormat::Int24:
+        for (size_t i = 0; i < count; i++) {
+            dst[i] = static_cast<SampleType>(readInt24(src + i * srcStep)) / int24Scale;
+        }
+        break;
+    case SampleFormat::Int32:
+        if (srcStep == sizeof(int32_t) && isAlignedFor<int32_t>(src)) {
+            const auto *in = reinterpret_cast<const int32_t *>(src);
+            for (size_t i = 0; i < count; i++) {
+                dst[i] = static_cast<SampleType>(in[i]) / int32Scale;
+            }
+        } else {
+            for (size_t i = 0; i < count; i++) {
+                int32_t v;
+                ::memcpy(&v, src + i * srcStep, sizeof(v));
+                dst[i] = static_cast<SampleType>(v) / int32Scale;
+            }
+        }
+        break;
+    }
+}
@@ -54,3 +54,8 @@ SourceStatus SineToneSource::getAudioFrame(SampleType *bufferOut)
     mFillCount++;
     return SourceStatus::OK;
 }
+
+void SineToneSource::restart()
+{
+    mFillCount = 0;
+}
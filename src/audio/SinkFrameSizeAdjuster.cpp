@@ -35,53 +35,56 @@
 #include <memory>
 #include <algorithm>
 #include <cstring>
-#include <xmmintrin.h>
 #include <cassert>
 
 using namespace afv_native::audio;
 
 SinkFrameSizeAdjuster::SinkFrameSizeAdjuster(
         std::shared_ptr<ISampleSink> destSink, unsigned int sinkFrameSize):
-        mDestinationSink(std::move(destSink)), mSourceFrameSize(sinkFrameSize),
-        mSinkBufferOffset(0)
+        mDestinationSink(std::move(destSink)),
+        mSourceFrameSize(sinkFrameSize),
+        mBuffer(frameSizeSamples)
 {
-    const size_t bufferSize = frameSizeSamples * sizeof(SampleType);
-    mSinkBuffer = new SampleType[bufferSize];
-	if (nullptr != mSinkBuffer) {
-		::memset(mSinkBuffer, 0, bufferSize);
-	}
 }
 
 SinkFrameSizeAdjuster::~SinkFrameSizeAdjuster()
 {
-    delete[] mSinkBuffer;
 }
 
 void SinkFrameSizeAdjuster::putAudioFrame(const SampleType *bufferIn)
 {
-    size_t sourceOffset = 0;
-    //precondition:  mSinkBufferOffset cannot be >= frameSizeSamples.  If it was
-    // at the end of the last push, that's a bug.
-    assert(mSinkBufferOffset < frameSizeSamples);
-
-    const size_t space_left_in_buffer = frameSizeSamples - mSinkBufferOffset;
-    // bind to the smaller of the samples we have left, and the size the source.
-    size_t sample_copy_count = std::min<size_t>(space_left_in_buffer, mSourceFrameSize);
-    // then copy those into our sample send buffer.
-    memcpy(mSinkBuffer+mSinkBufferOffset, bufferIn, sample_copy_count * sizeof(SampleType));
-    mSinkBufferOffset += sample_copy_count;
-    sourceOffset += sample_copy_count;
+    putAudioSamples(bufferIn, mSourceFrameSize);
+}
 
-    while (mSinkBufferOffset >= frameSizeSamples) {
-        mDestinationSink->putAudioFrame(mSinkBuffer);
-        mSinkBufferOffset = 0;
+void SinkFrameSizeAdjuster::putAudioSamples(const SampleType *bufferIn, size_t count)
+{
+    //precondition:  we can never be holding a complete frame between calls.
+    assert(mBuffer.getAvailable() < frameSizeSamples);
 
-        // if there's any samples left in the frame, copy them up to a whole frame maximum.
-        if ((mSourceFrameSize - sourceOffset) > 0) {
-            sample_copy_count = std::min<size_t>(frameSizeSamples, mSourceFrameSize - sourceOffset);
-            memcpy(mSinkBuffer + mSinkBufferOffset, bufferIn + sourceOffset, sample_copy_count * sizeof(SampleType));
-            mSinkBufferOffset += sample_copy_count;
+    size_t sourceOffset = 0;
+    // top up any partial frame we're holding first.
+    if (mBuffer.getAvailable() > 0) {
+        sourceOffset = mBuffer.write(bufferIn, std::min<size_t>(count, frameSizeSamples - mBuffer.getAvailable()));
+        if (mBuffer.getAvailable() < frameSizeSamples) {
+            return;
         }
+        if (mDestinationSink) {
+            mDestinationSink->putAudioFrame(mBuffer.beginRead(frameSizeSamples));
+        }
+        mBuffer.endRead(frameSizeSamples);
+    }
+    // we're now frame aligned, so pass whole frames straight through.
+    while (count - sourceOffset >= frameSizeSamples) {
+        if (mDestinationSink) {
+            mDestinationSink->putAudioFrame(bufferIn + sourceOffset);
+        }
+        sourceOffset += frameSizeSamples;
     }
+    // and hold onto the remainder.
+    mBuffer.write(bufferIn + sourceOffset, count - sourceOffset);
 }
 
+size_t SinkFrameSizeAdjuster::getLatencySamples() const
+{
+    return mBuffer.getLatencySamples();
+}
@@ -34,10 +34,17 @@
 #include "SoundIOAudioDevice.h"
 
 #include <memory>
+#include <cmath>
+#include <cstdint>
 #include <cstring>
 #include <algorithm>
 
 #include "afv-native/Log.h"
+#include "afv-native/audio/ChannelCopy.h"
+#include "afv-native/util/DenormalGuard.h"
+#include "afv-native/util/RealtimeGuard.h"
+#include "afv-native/util/ThreadPolicy.h"
+#include "afv-native/util/Trace.h"
 
 using namespace afv_native::audio;
 using namespace std;
@@ -46,8 +53,9 @@ SoundIOAudioDevice::SoundIOAudioDevice(
         const std::string &userStreamName,
         const std::string &outputDeviceName,
         const std::string &inputDeviceName,
-        AudioDevice::Api audioApi) :
-        AudioDevice(),
+        AudioDevice::Api audioApi,
+        unsigned int deviceFrameLengthMs) :
+        AudioDevice(deviceFrameLengthMs),
         mApi(audioApi),
         mUserStreamName(userStreamName),
         mOutputDeviceName(outputDeviceName),
@@ -55,29 +63,30 @@ SoundIOAudioDevice::SoundIOAudioDevice(
         mSoundIO(),
         mInputStream(),
         mOutputStream(),
-        mInputRingBuffer(),
-        mOutputRingBuffer()
+        mOutputIsStereo(false),
+        mInputFormat(SampleFormat::Float32),
+        mOutputFormat(SampleFormat::Float32),
+        mInputBuffer(mInputFrameSizeSamples * 2),
+        mOutputBuffer(mOutputFrameSizeSamples * maxFramesPerWrite)
 {
     mSoundIO = soundio_create();
     if (mSoundIO == nullptr) {
-        LOG("SoundIOAudioDevice", "libsoundio failed to create context");
+        LOGERROR("SoundIOAudioDevice", "libsoundio failed to create context");
     } else {
         mSoundIO->app_name = mUserStreamName.c_str();
         if (mApi < 0) {
             auto rv = soundio_connect(mSoundIO);
             if (rv != SoundIoErrorNone) {
-                LOG("SoundIOAudioDevice", "failed to connect to default API: %s", soundio_strerror(rv));
+                LOGERROR("SoundIOAudioDevice", "failed to connect to default API: %s", soundio_strerror(rv));
             }
         } else {
             auto backend = static_cast<enum SoundIoBackend>(mApi);
             auto rv = soundio_connect_backend(mSoundIO, backend);
             if (rv != SoundIoErrorNone) {
-                LOG("SoundIOAudioDevice", "failed to connect to API %s: %s", soundio_backend_name(backend),
+                LOGERROR("SoundIOAudioDevice", "failed to connect to API %s: %s", soundio_backend_name(backend),
                     soundio_strerror(rv));
             }
         }
-        mInputRingBuffer = soundio_ring_buffer_create(mSoundIO, frameSizeBytes);
-        mOutputRingBuffer = soundio_ring_buffer_create(mSoundIO, frameSizeBytes);
     }
 }
 
@@ -93,48 +102,61 @@ SoundIOAudioDevice::~SoundIOAudioDevice() {
             soundio_outstream_destroy(mOutputStream);
             mOutputStream = nullptr;
         }
-        if (mInputRingBuffer != nullptr) {
-            soundio_ring_buffer_destroy(mInputRingBuffer);
-            mInputRingBuffer = nullptr;
-        }
-        if (mOutputRingBuffer != nullptr) {
-            soundio_ring_buffer_destroy(mOutputRingBuffer);
-        }
         soundio_destroy(mSoundIO);
         mSoundIO = nullptr;
     }
 }
 
 bool SoundIOAudioDevice::open() {
+    // the callback threads are real-time, so they can't set up their own log rings.
+    prepareRealtimeLogging();
     auto *inputDevice = getInputDeviceForId(mInputDeviceName);
     auto *outputDevice = getOutputDeviceForId(mOutputDeviceName);
     auto *monoLayout = soundio_channel_layout_get_builtin(SoundIoChannelLayoutIdMono);
     auto *stereoLayout = soundio_channel_layout_get_builtin(SoundIoChannelLayoutIdStereo);
 
+    // run the hardware in its native format and as close to our rate as it can get - anything else, we convert.
+    SoundIoFormat inputSioFormat = SoundIoFormatFloat32NE;
+    SoundIoFormat outputSioFormat = SoundIoFormatFloat32NE;
+    unsigned int inputRate = sampleRateHz;
+    unsigned int outputRate = sampleRateHz;
+    if (inputDevice) {
+        chooseFormat(inputDevice, inputSioFormat, mInputFormat);
+        inputRate = static_cast<unsigned int>(soundio_device_nearest_sample_rate(inputDevice, sampleRateHz));
+    }
+    if (outputDevice) {
+        chooseFormat(outputDevice, outputSioFormat, mOutputFormat);
+        outputRate = static_cast<unsigned int>(soundio_device_nearest_sample_rate(outputDevice, sampleRateHz));
+    }
+    setDeviceSampleRates(inputRate, outputRate);
+
     if (inputDevice) {
         mInputStream = soundio_instream_create(inputDevice);
         if (mInputStream) {
             auto inputLayout = soundio_best_matching_channel_layout(monoLayout, 1, inputDevice->layouts,
                                                                     inputDevice->layout_count);
             mInputStream->layout = *inputLayout;
-            mInputStream->format = SoundIoFormatFloat32NE;
-            mInputStream->sample_rate = sampleRateHz;
+            mInputStream->format = inputSioFormat;
+            mInputStream->sample_rate = mInputSampleRate;
             mInputStream->userdata = this;
-            mInputStream->software_latency = static_cast<double>(frameLengthMs) / 1000.0;
+            mInputStream->software_latency = static_cast<double>(mInputFrameSizeSamples) / mInputSampleRate;
             mInputStream->name = "AFV Microphone";
             mInputStream->read_callback = staticSioReadCallback;
             mInputStream->overflow_callback = staticSioInputOverflowCallback;
             mInputStream->error_callback = staticSioInputErrorCallback;
             auto rv = soundio_instream_open(mInputStream);
             if (rv != SoundIoErrorNone) {
-                LOG("SoundIOAudioDevice::open()", "Couldn't open input stream: %s", soundio_strerror(rv));
+                LOGERROR("SoundIOAudioDevice::open()", "Couldn't open input stream: %s", soundio_strerror(rv));
                 soundio_instream_destroy(mInputStream);
                 mInputStream = nullptr;
                 return false;
             }
+            LOGDEBUG("SoundIOAudioDevice::open()", "Input software latency is %.1fms", mInputStream->software_latency * 1000.0);
+            mInputBuffer.resize(ringSizeForLatency(
+                    mInputStream->software_latency, mInputSampleRate, mInputFrameSizeSamples, 2));
             rv = soundio_instream_start(mInputStream);
             if (rv != SoundIoErrorNone) {
-                LOG("SoundIOAudioDevice::open()", "Couldn't start input stream: %s", soundio_strerror(rv));
+                LOGERROR("SoundIOAudioDevice::open()", "Couldn't start input stream: %s", soundio_strerror(rv));
                 soundio_instream_destroy(mInputStream);
                 mInputStream = nullptr;
                 return false;
@@ -155,24 +177,27 @@ bool SoundIOAudioDevice::open() {
                                                                      outputDevice->layouts,
                                                                      outputDevice->layout_count);
             mOutputStream->layout = *outputLayout;
-            mOutputStream->format = SoundIoFormatFloat32NE;
-            mOutputStream->sample_rate = sampleRateHz;
+            mOutputStream->format = outputSioFormat;
+            mOutputStream->sample_rate = mOutputSampleRate;
             mOutputStream->userdata = this;
-            mOutputStream->software_latency = static_cast<double>(frameLengthMs) / 1000.0;
+            mOutputStream->software_latency = static_cast<double>(mOutputFrameSizeSamples) / mOutputSampleRate;
             mOutputStream->name = "AFV Radio Speaker";
             mOutputStream->write_callback = staticSioWriteCallback;
             mOutputStream->underflow_callback = staticSioOutputUnderflowCallback;
             mOutputStream->error_callback = staticSioOutputErrorCallback;
             auto rv = soundio_outstream_open(mOutputStream);
             if (rv != SoundIoErrorNone) {
-                LOG("SoundIOAudioDevice::open()", "Couldn't open output stream: %s", soundio_strerror(rv));
+                LOGERROR("SoundIOAudioDevice::open()", "Couldn't open output stream: %s", soundio_strerror(rv));
                 soundio_outstream_destroy(mOutputStream);
                 mOutputStream = nullptr;
                 return false;
             }
+            LOGDEBUG("SoundIOAudioDevice::open()", "Output software latency is %.1fms", mOutputStream->software_latency * 1000.0);
+            mOutputBuffer.resize(ringSizeForLatency(
+                    mOutputStream->software_latency, mOutputSampleRate, mOutputFrameSizeSamples, maxFramesPerWrite));
             rv = soundio_outstream_start(mOutputStream);
             if (rv != SoundIoErrorNone) {
-                LOG("SoundIOAudioDevice::open()", "Couldn't start output stream: %s", soundio_strerror(rv));
+                LOGERROR("SoundIOAudioDevice::open()", "Couldn't start output stream: %s", soundio_strerror(rv));
                 soundio_outstream_destroy(mOutputStream);
                 mOutputStream = nullptr;
                 return false;
@@ -182,99 +207,177 @@ bool SoundIOAudioDevice::open() {
     return true;
 }
 
+void SoundIOAudioDevice::renderSourceFrames(
+        ISampleSource *source,
+        bool &sourceFailed,
+        SampleType *buffer,
+        size_t frameCount)
+{
+    if (source != nullptr && !sourceFailed) {
+        if (source->getAudioFrames(buffer, frameCount) == SourceStatus::OK) {
+            return;
+        }
+        mSource.unpublish(source);
+        sourceFailed = true;
+    }
+    ::memset(buffer, 0, frameCount * mOutputFrameSizeSamples * sizeof(SampleType));
+}
+
+void SoundIOAudioDevice::writeOutputAreas(
+        ISampleSource *source,
+        bool &sourceFailed,
+        SoundIoChannelArea *areas,
+        int sampleCount)
+{
+    const auto areaAligned = [](const SoundIoChannelArea &area) -> bool {
+        return (reinterpret_cast<uintptr_t>(area.ptr) % alignof(SampleType)) == 0;
+    };
+    const bool isFloat = mOutputFormat == SampleFormat::Float32;
+    const bool monoContiguous = isFloat && !mOutputIsStereo &&
+                                areas[0].step == sizeof(SampleType) &&
+                                areaAligned(areas[0]);
+    const bool stereoInterleaved = isFloat && mOutputIsStereo &&
+                                   areas[0].step == 2 * sizeof(SampleType) &&
+                                   areas[1].step == areas[0].step &&
+                                   areas[1].ptr == areas[0].ptr + sizeof(SampleType) &&
+                                   areaAligned(areas[0]);
+    const int channelCount = mOutputIsStereo ? 2 : 1;
+
+    size_t samplesWritten = 0;
+    // if there's nothing stale in the ring and the device area is a plain mono buffer, render whole frames
+    // straight into it.
+    if (monoContiguous && mOutputBuffer.getAvailable() == 0) {
+        const size_t directFrames = sampleCount / mOutputFrameSizeSamples;
+        if (directFrames > 0) {
+            renderSourceFrames(source, sourceFailed, reinterpret_cast<SampleType *>(areas[0].ptr), directFrames);
+            samplesWritten = directFrames * mOutputFrameSizeSamples;
+        }
+    }
+    while (samplesWritten < static_cast<size_t>(sampleCount)) {
+        if (mOutputBuffer.getAvailable() == 0) {
+            // fetch as many frames as we need to satisfy this write in a single request.
+            const size_t samplesNeeded = sampleCount - samplesWritten;
+            size_t framesNeeded = (samplesNeeded + mOutputFrameSizeSamples - 1) / mOutputFrameSizeSamples;
+            framesNeeded = std::min<size_t>(framesNeeded, mOutputBuffer.getSpace() / mOutputFrameSizeSamples);
+            const size_t fillSamples = framesNeeded * mOutputFrameSizeSamples;
+
+            auto *sourceFillPtr = mOutputBuffer.beginWrite(fillSamples);
+            renderSourceFrames(source, sourceFailed, sourceFillPtr, framesNeeded);
+            mOutputBuffer.endWrite(fillSamples);
+        }
+        const size_t blockSize = std::min<size_t>(mOutputBuffer.getAvailable(), sampleCount - samplesWritten);
+        const auto *ringBuf = mOutputBuffer.beginRead(blockSize);
+        if (stereoInterleaved) {
+            auto *outPtr = reinterpret_cast<SampleType *>(areas[0].ptr + samplesWritten * areas[0].step);
+            duplicateToStereo(ringBuf, outPtr, blockSize);
+        } else {
+            for (int ch = 0; ch < channelCount; ch++) {
+                convertToFormat(ringBuf, areas[ch].ptr + samplesWritten * areas[ch].step, areas[ch].step,
+                                mOutputFormat, blockSize);
+            }
+        }
+        mOutputBuffer.endRead(blockSize);
+        samplesWritten += blockSize;
+    }
+}
+
 void SoundIOAudioDevice::sioWriteCallback(struct SoundIoOutStream *stream, int frame_count_min, int frame_count_max) {
-    std::lock_guard<std::mutex> sourceLock(mSourcePtrLock);
-
-    int ringFrames = soundio_ring_buffer_fill_count(mOutputRingBuffer) / static_cast<int>(sizeof(SampleType));
-    const size_t frames = optimumFrameCount(ringFrames, frame_count_min, frame_count_max);
-
-    SoundIoChannelArea *bufAreas;
-    int sampleCount = static_cast<int>(frames);
-    auto rv = soundio_outstream_begin_write(stream, &bufAreas, &sampleCount);
-    if (rv == SoundIoErrorNone) {
-        char *chPtr[2] = {bufAreas[0].ptr, bufAreas[0].ptr};
-        int chStep[2] = {bufAreas[0].step, bufAreas[0].step};
-        if (mOutputIsStereo) {
-            chPtr[1] = bufAreas[1].ptr;
-            chStep[1] = bufAreas[1].step;
+    util::maintainThreadPolicy(util::ThreadClass::Audio, "afv-audio-out");
+    util::RealtimeScope realtime;
+    util::FlushDenormalsScope denormals;
+    TRACE_SCOPE("audio", "SoundIO write callback");
+    auto source = mSource.read();
+    bool sourceFailed = false;
+
+    auto framesLeft = static_cast<int>(optimumFrameCount(mOutputBuffer.getAvailable(), frame_count_min, frame_count_max));
+    // the backend may hand us the buffer in several pieces, so keep going until we've written it all.
+    while (framesLeft > 0) {
+        SoundIoChannelArea *bufAreas;
+        int sampleCount = framesLeft;
+        auto rv = soundio_outstream_begin_write(stream, &bufAreas, &sampleCount);
+        if (rv != SoundIoErrorNone) {
+            LOGWARN("SoundIOAudioDevice::sioWriteCallback", "Couldn't lock playback buffer: %s", soundio_strerror(rv));
+            return;
         }
-        int samplesWritten = 0;
-        while (samplesWritten < sampleCount) {
-            ringFrames = soundio_ring_buffer_fill_count(mOutputRingBuffer) / static_cast<int>(sizeof(SampleType));
-            if (ringFrames == 0) {
-                auto *sourceFillPtr = reinterpret_cast<SampleType *>(soundio_ring_buffer_write_ptr(mOutputRingBuffer));
-                if (mSource) {
-                    auto sourcerv = mSource->getAudioFrame(sourceFillPtr);
-                    if (sourcerv != SourceStatus::OK) {
-                        ::memset(sourceFillPtr, 0, frameSizeBytes);
-                        mSource.reset();
-                    }
-                } else {
-                    ::memset(sourceFillPtr, 0, frameSizeBytes);
-                }
-                soundio_ring_buffer_advance_write_ptr(mOutputRingBuffer, frameSizeBytes);
-                ringFrames = soundio_ring_buffer_fill_count(mOutputRingBuffer) / static_cast<int>(sizeof(SampleType));
+        if (sampleCount <= 0) {
+            break;
+        }
+        writeOutputAreas(source.get(), sourceFailed, bufAreas, sampleCount);
+        rv = soundio_outstream_end_write(stream);
+        if (rv != SoundIoErrorNone && rv != SoundIoErrorUnderflow) {
+            LOGWARN("SoundIOAudioDevice::sioWriteCallback", "Couldn't release playback buffer: %s", soundio_strerror(rv));
+            return;
+        }
+        framesLeft -= sampleCount;
+    }
+}
+
+void SoundIOAudioDevice::readInputAreas(ISampleSink *sink, const SoundIoChannelArea *areas, int sampleCount) {
+    size_t samplesRead = 0;
+    // if there's nothing left over in the ring and the device area is a plain mono buffer, hand whole frames to the
+    // sink in place.
+    if (areas != nullptr && mInputFormat == SampleFormat::Float32 && mInputBuffer.getAvailable() == 0 &&
+        areas[0].step == sizeof(SampleType) && (reinterpret_cast<uintptr_t>(areas[0].ptr) % alignof(SampleType)) == 0) {
+        const auto *inPtr = reinterpret_cast<const SampleType *>(areas[0].ptr);
+        const size_t directFrames = sampleCount / mInputFrameSizeSamples;
+        if (sink != nullptr) {
+            for (size_t i = 0; i < directFrames; i++) {
+                sink->putAudioFrame(inPtr + i * mInputFrameSizeSamples);
             }
-            auto *ringBuf = reinterpret_cast<SampleType *>(soundio_ring_buffer_read_ptr(mOutputRingBuffer));
-            int ringFramesLeft = ringFrames;
-            while (ringFramesLeft > 0 && samplesWritten < sampleCount) {
-                *reinterpret_cast<SampleType *>(chPtr[0]) = *(ringBuf);
-                *reinterpret_cast<SampleType *>(chPtr[1]) = *(ringBuf);
-                ringBuf++;
-                samplesWritten++;
-                chPtr[0] += chStep[0];
-                chPtr[1] += chStep[1];
-                ringFramesLeft--;
+        }
+        samplesRead = directFrames * mInputFrameSizeSamples;
+    }
+    while (samplesRead < static_cast<size_t>(sampleCount)) {
+        // fill the ring as best we can.
+        const size_t blockSize = std::min<size_t>(mInputBuffer.getSpace(), sampleCount - samplesRead);
+        auto *ringWriteBuf = mInputBuffer.beginWrite(blockSize);
+        if (areas != nullptr) {
+            convertFromFormat(areas[0].ptr + samplesRead * areas[0].step, areas[0].step, mInputFormat, ringWriteBuf,
+                              blockSize);
+        } else {
+            ::memset(ringWriteBuf, 0, blockSize * sizeof(SampleType));
+        }
+        mInputBuffer.endWrite(blockSize);
+        samplesRead += blockSize;
+
+        // if we have a complete frame, send it to the codec.
+        while (mInputBuffer.getAvailable() >= mInputFrameSizeSamples) {
+            const auto *sinkFillPtr = mInputBuffer.beginRead(mInputFrameSizeSamples);
+            if (sink != nullptr) {
+                sink->putAudioFrame(sinkFillPtr);
             }
-            soundio_ring_buffer_advance_read_ptr(mOutputRingBuffer,
-                                                 (ringFrames - ringFramesLeft) * static_cast<int>(sizeof(SampleType)));
+            mInputBuffer.endRead(mInputFrameSizeSamples);
         }
-        soundio_outstream_end_write(stream);
-    } else {
-        LOG("SoundIOAudioDevice::sioWriteCallback", "Couldn't lock playback buffer: %s", soundio_strerror(rv));
     }
 }
 
 void SoundIOAudioDevice::sioReadCallback(struct SoundIoInStream *stream, int frame_count_min, int frame_count_max) {
-    std::lock_guard<std::mutex> sinkLock(mSinkPtrLock);
-
-    // always pull the full input buffer.
-    SoundIoChannelArea *bufAreas;
-    int sampleCount = frame_count_max;
-    auto rv = soundio_instream_begin_read(stream, &bufAreas, &sampleCount);
-    if (rv == SoundIoErrorNone) {
-        auto *flexPtr = bufAreas[0].ptr;
-        int samplesRead = 0;
-        int ringFrames;
-        while (samplesRead < sampleCount) {
-            // fill the ringbuffer as best we can.
-            auto *ringWriteBuf = reinterpret_cast<SampleType *>(soundio_ring_buffer_write_ptr(mInputRingBuffer));
-            ringFrames = soundio_ring_buffer_free_count(mInputRingBuffer) / static_cast<int>(sizeof(SampleType));
-            const int initialRingFrames = ringFrames;
-            while ((samplesRead < sampleCount) && (ringFrames > 0)) {
-                *(ringWriteBuf++) = *reinterpret_cast<SampleType *>(flexPtr);
-                samplesRead++;
-                flexPtr += bufAreas[0].step;
-                ringFrames--;
-            }
-            soundio_ring_buffer_advance_write_ptr(mInputRingBuffer,
-                                                  (initialRingFrames - ringFrames) *
-                                                  static_cast<int>(sizeof(SampleType)));
-
-            // if we have a complete frame, send it to the codec.
-            ringFrames = soundio_ring_buffer_fill_count(mInputRingBuffer) / static_cast<int>(sizeof(SampleType));
-            while (ringFrames >= frameSizeSamples) {
-                auto *sinkFillPtr = reinterpret_cast<SampleType *>(soundio_ring_buffer_read_ptr(mInputRingBuffer));
-                if (mSink) {
-                    mSink->putAudioFrame(sinkFillPtr);
-                }
-                soundio_ring_buffer_advance_read_ptr(mInputRingBuffer, frameSizeBytes);
-                ringFrames = soundio_ring_buffer_fill_count(mInputRingBuffer) / static_cast<int>(sizeof(SampleType));
-            }
+    util::maintainThreadPolicy(util::ThreadClass::AudioCapture, "afv-audio-in");
+    util::RealtimeScope realtime;
+    util::FlushDenormalsScope denormals;
+    TRACE_SCOPE("audio", "SoundIO read callback");
+    auto sink = mSink.read();
+
+    // always pull the full input buffer.  Like the output, it may come in several pieces.
+    int framesLeft = frame_count_max;
+    while (framesLeft > 0) {
+        SoundIoChannelArea *bufAreas;
+        int sampleCount = framesLeft;
+        auto rv = soundio_instream_begin_read(stream, &bufAreas, &sampleCount);
+        if (rv != SoundIoErrorNone) {
+            LOGWARN("SoundIOAudioDevice::sioReadCallback", "Couldn't lock recording buffer: %s", soundio_strerror(rv));
+            return;
         }
-        soundio_instream_end_read(stream);
-    } else {
-        LOG("SoundIOAudioDevice::sioReadCallback", "Couldn't lock recording buffer: %s", soundio_strerror(rv));
+        if (sampleCount <= 0) {
+            break;
+        }
+        readInputAreas(sink.get(), bufAreas, sampleCount);
+        rv = soundio_instream_end_read(stream);
+        if (rv != SoundIoErrorNone) {
+            LOGWARN("SoundIOAudioDevice::sioReadCallback", "Couldn't release recording buffer: %s", soundio_strerror(rv));
+            return;
+        }
+        framesLeft -= sampleCount;
     }
 }
 
@@ -325,13 +428,13 @@ std::map<int, AudioDevice::DeviceInfo> SoundIOAudioDevice::getCompatibleInputDev
                         continue;
                     }
                     if (isAbleToOpen(device_info)) {
-                        LOG("SoundIOAudioDevice", "input device %s - OK", device_info->name);
+                        LOGDEBUG("SoundIOAudioDevice", "input device %s - OK", device_info->name);
                         deviceList.emplace(i, DeviceInfo(device_info->name, device_info->id));
                     }
                 }
             }
         } else {
-            LOG("SoundIOAudioDevice::getCompatibleInputDevicesForApi", "Couldn't open API: %s", soundio_strerror(rv));
+            LOGWARN("SoundIOAudioDevice::getCompatibleInputDevicesForApi", "Couldn't open API: %s", soundio_strerror(rv));
         }
         soundio_destroy(local_soundIo);
     }
@@ -357,13 +460,13 @@ std::map<int, AudioDevice::DeviceInfo> SoundIOAudioDevice::getCompatibleOutputDe
                         continue;
                     }
                     if (isAbleToOpen(device_info, true)) {
-                        LOG("SoundIOAudioDevice", "output device %s - OK", device_info->name);
+                        LOGDEBUG("SoundIOAudioDevice", "output device %s - OK", device_info->name);
                         deviceList.emplace(i, DeviceInfo(device_info->name, device_info->id));
                     }
                 }
             }
         } else {
-            LOG("SoundIOAudioDevice::getCompatibleOutputDevicesForApi", "Couldn't open API: %s", soundio_strerror(rv));
+            LOGWARN("SoundIOAudioDevice::getCompatibleOutputDevicesForApi", "Couldn't open API: %s", soundio_strerror(rv));
         }
         soundio_destroy(local_soundIo);
     }
@@ -372,14 +475,16 @@ std::map<int, AudioDevice::DeviceInfo> SoundIOAudioDevice::getCompatibleOutputDe
 
 bool SoundIOAudioDevice::isAbleToOpen(SoundIoDevice *device_info, bool for_output) {
     // first, format.
-    if (!soundio_device_supports_format(device_info, SoundIoFormatFloat32NE)) {
-        LOG("SoundIOAudioDevice", "device %s - can't handle float pcm.", device_info->name);
+    SoundIoFormat sioFormat;
+    SampleFormat format;
+    if (!chooseFormat(device_info, sioFormat, format)) {
+        LOGDEBUG("SoundIOAudioDevice", "device %s - can't handle float, s32 or s16 pcm.", device_info->name);
         return false;
     }
 
-    // next, samplerate.
-    if (!soundio_device_supports_sample_rate(device_info, sampleRateHz)) {
-        LOG("SoundIOAudioDevice", "device %s - can't handle sampling rate.", device_info->name);
+    // next, samplerate.  We can resample to anything, so long as it has one.
+    if (device_info->sample_rate_count <= 0) {
+        LOGDEBUG("SoundIOAudioDevice", "device %s - doesn't report any sampling rates.", device_info->name);
         return false;
     }
 
@@ -389,15 +494,34 @@ bool SoundIOAudioDevice::isAbleToOpen(SoundIoDevice *device_info, bool for_outpu
     if (!soundio_device_supports_layout(device_info, monoLayout) &&
         !(for_output && soundio_device_supports_layout(device_info, stereoLayout))) {
         if (for_output) {
-            LOG("SoundIOAudioDevice", "device %s - doesn't support monaural or stereo audio", device_info->name);
+            LOGDEBUG("SoundIOAudioDevice", "device %s - doesn't support monaural or stereo audio", device_info->name);
         } else {
-            LOG("SoundIOAudioDevice", "device %s - doesn't support monaural audio", device_info->name);
+            LOGDEBUG("SoundIOAudioDevice", "device %s - doesn't support monaural audio", device_info->name);
         }
         return false;
     }
     return true;
 }
 
+bool SoundIOAudioDevice::chooseFormat(SoundIoDevice *device_info, SoundIoFormat &sioFormatOut, SampleFormat &formatOut) {
+    static const struct {
+        SoundIoFormat sioFormat;
+        SampleFormat format;
+    } preferredFormats[] = {
+            {SoundIoFormatFloat32NE, SampleFormat::Float32},
+            {SoundIoFormatS32NE, SampleFormat::Int32},
+            {SoundIoFormatS16NE, SampleFormat::Int16},
+    };
+    for (const auto &thisFormat: preferredFormats) {
+        if (soundio_device_supports_format(device_info, thisFormat.sioFormat)) {
+            sioFormatOut = thisFormat.sioFormat;
+            formatOut = thisFormat.format;
+            return true;
+        }
+    }
+    return false;
+}
+
 SoundIoDevice *SoundIOAudioDevice::getInputDeviceForId(const std::string &deviceId) {
     soundio_flush_events(mSoundIO);
     auto device_count = soundio_input_device_count(mSoundIO);
@@ -422,20 +546,31 @@ SoundIoDevice *SoundIOAudioDevice::getOutputDeviceForId(const std::string &devic
     return nullptr;
 }
 
-size_t SoundIOAudioDevice::optimumFrameCount(size_t staleframes, size_t min, size_t max) {
+size_t SoundIOAudioDevice::optimumFrameCount(size_t staleframes, size_t min, size_t max) const {
     size_t frameCount;
     if (staleframes > 0 && staleframes > min) {
         frameCount = staleframes;
     } else {
-        frameCount = std::max<size_t>(staleframes + frameSizeSamples, min);
+        frameCount = std::max<size_t>(staleframes + mOutputFrameSizeSamples, min);
     }
     frameCount = std::min<size_t>(frameCount, max);
     if (frameCount == 0) {
-        frameCount = std::min<size_t>(frameSizeSamples, max);
+        frameCount = std::min<size_t>(mOutputFrameSizeSamples, max);
     }
     return frameCount;
 }
 
+size_t SoundIOAudioDevice::ringSizeForLatency(
+        double softwareLatency,
+        unsigned int sampleRate,
+        unsigned int frameSize,
+        size_t minimumFrames) {
+    const auto latencySamples = static_cast<size_t>(std::ceil(softwareLatency * sampleRate));
+    // enough whole device frames to cover the latency, plus one spare to absorb a partially consumed frame.
+    const size_t latencyFrames = (latencySamples + frameSize - 1) / frameSize + 1;
+    return std::max<size_t>(latencyFrames, minimumFrames) * frameSize;
+}
+
 void SoundIOAudioDevice::staticSioReadCallback(struct SoundIoInStream *stream, int frame_count_min, int frame_count_max) {
     auto *thisAd = reinterpret_cast<SoundIOAudioDevice *>(stream->userdata);
     thisAd->sioReadCallback(stream, frame_count_min, frame_count_max);
@@ -450,7 +585,7 @@ void
 SoundIOAudioDevice::staticSioOutputUnderflowCallback(struct SoundIoOutStream *stream)
 {
 #ifndef NDEBUG
-    LOG("SoundIOAudioDevice::Output", "Output Underflowed");
+    LOGWARN("SoundIOAudioDevice::Output", "Output Underflowed");
 #endif
     auto *thisAd = reinterpret_cast<SoundIOAudioDevice *>(stream->userdata);
     thisAd->OutputUnderflows.fetch_add(1);
@@ -459,14 +594,14 @@ SoundIOAudioDevice::staticSioOutputUnderflowCallback(struct SoundIoOutStream *st
 void
 SoundIOAudioDevice::staticSioOutputErrorCallback(struct SoundIoOutStream *stream, int err)
 {
-    LOG("SoundIOAudioDevice::Output", "Got Error: %s", soundio_strerror(err));
+    LOGERROR("SoundIOAudioDevice::Output", "Got Error: %s", soundio_strerror(err));
 }
 
 void
 SoundIOAudioDevice::staticSioInputOverflowCallback(struct SoundIoInStream *stream)
 {
 #ifndef NDEBUG
-    LOG("SoundIOAudioDevice::Input", "Input Overflowed");
+    LOGWARN("SoundIOAudioDevice::Input", "Input Overflowed");
 #endif
     auto *thisAd = reinterpret_cast<SoundIOAudioDevice *>(stream->userdata);
     thisAd->InputOverflows.fetch_add(1);
@@ -475,21 +610,29 @@ SoundIOAudioDevice::staticSioInputOverflowCallback(struct SoundIoInStream *strea
 void
 SoundIOAudioDevice::staticSioInputErrorCallback(struct SoundIoInStream *stream, int err)
 {
-    LOG("SoundIOAudioDevice::Input", "Got Error: %s", soundio_strerror(err));
+    LOGERROR("SoundIOAudioDevice::Input", "Got Error: %s", soundio_strerror(err));
 }
 
 
 
 /* ========== Factory hooks ============= */
 map<AudioDevice::Api, std::string> AudioDevice::getAPIs() {
-    return SoundIOAudioDevice::getAPIs();
+    auto apiList = SoundIOAudioDevice::getAPIs();
+    addVirtualAPIs(apiList);
+    return apiList;
 }
 
 map<int, AudioDevice::DeviceInfo> AudioDevice::getCompatibleInputDevicesForApi(AudioDevice::Api api) {
+    if (isVirtualApi(api)) {
+        return map<int, AudioDevice::DeviceInfo>();
+    }
     return SoundIOAudioDevice::getCompatibleInputDevicesForApi(api);
 }
 
 map<int, AudioDevice::DeviceInfo> AudioDevice::getCompatibleOutputDevicesForApi(AudioDevice::Api api) {
+    if (isVirtualApi(api)) {
+        return map<int, AudioDevice::DeviceInfo>();
+    }
     return SoundIOAudioDevice::getCompatibleOutputDevicesForApi(api);
 }
 
@@ -498,7 +641,12 @@ AudioDevice::makeDevice(
         const std::string &userStreamName,
         const std::string &outputDeviceId,
         const std::string &inputDeviceId,
-        AudioDevice::Api audioApi) {
-    auto devsp = std::make_shared<SoundIOAudioDevice>(userStreamName, outputDeviceId, inputDeviceId, audioApi);
+        AudioDevice::Api audioApi,
+        unsigned int deviceFrameLengthMs) {
+    if (isVirtualApi(audioApi)) {
+        return makeVirtualDevice(outputDeviceId, inputDeviceId, audioApi, deviceFrameLengthMs);
+    }
+    auto devsp = std::make_shared<SoundIOAudioDevice>(
+            userStreamName, outputDeviceId, inputDeviceId, audioApi, deviceFrameLengthMs);
     return devsp;
 }
@@ -42,6 +42,8 @@
 #include <soundio/soundio.h>
 
 #include "afv-native/audio/AudioDevice.h"
+#include "afv-native/audio/ReblockingBuffer.h"
+#include "afv-native/audio/SampleFormat.h"
 
 namespace afv_native {
     namespace audio {
@@ -67,10 +69,47 @@ namespace afv_native {
             SoundIoOutStream *mOutputStream;
             bool mOutputIsStereo;
 
-            SoundIoRingBuffer *mInputRingBuffer;
-            SoundIoRingBuffer *mOutputRingBuffer;
+            /** the sample formats we're exchanging with the hardware. */
+            SampleFormat mInputFormat;
+            SampleFormat mOutputFormat;
 
-            static size_t optimumFrameCount(size_t staleFrames, size_t min, size_t max);
+            /** mInputBuffer collects the variable sized blocks from the input stream into device frames.
+             *
+             * It's resized in open() to cover the software latency the backend actually gave us.
+             */
+            ReblockingBuffer mInputBuffer;
+            /** maxFramesPerWrite is the minimum number of device frames mOutputBuffer can hold, and so the
+             * minimum we'll request from the source at once.
+             */
+            static const size_t maxFramesPerWrite = 8;
+
+            /** mOutputBuffer holds the frames fetched from the source that haven't been written to the output stream.
+             *
+             * Like mInputBuffer, it's resized in open() to cover the negotiated software latency.
+             */
+            ReblockingBuffer mOutputBuffer;
+
+            size_t optimumFrameCount(size_t staleFrames, size_t min, size_t max) const;
+
+            /** ringSizeForLatency returns the ring capacity (in samples) needed to buffer the given software latency. */
+            static size_t ringSizeForLatency(
+                    double softwareLatency,
+                    unsigned int sampleRate,
+                    unsigned int frameSize,
+                    size_t minimumFrames);
+
+            /** renderSourceFrames fetches frameCount device frames from source into buffer, or silence if there's
+             * no source (or it has failed).  If the source fails, it's unpublished and sourceFailed is set.
+             */
+            void renderSourceFrames(ISampleSource *source, bool &sourceFailed, SampleType *buffer, size_t frameCount);
+
+            /** writeOutputAreas fills sampleCount samples of the output areas from the source. */
+            void writeOutputAreas(ISampleSource *source, bool &sourceFailed, SoundIoChannelArea *areas, int sampleCount);
+
+            /** readInputAreas passes sampleCount samples from the input areas to the sink.  areas may be nullptr
+             * if the backend reported a hole in the stream, in which case silence is used.
+             */
+            void readInputAreas(ISampleSink *sink, const SoundIoChannelArea *areas, int sampleCount);
 
             SoundIoDevice * getInputDeviceForId(const std::string &deviceId);
             SoundIoDevice * getOutputDeviceForId(const std::string &deviceId);
@@ -80,7 +119,8 @@ namespace afv_native {
                     const std::string &userStreamName,
                     const std::string &outputDeviceId,
                     const std::string &inputDeviceId,
-                    Api audioApi=-1);
+                    Api audioApi=-1,
+                    unsigned int deviceFrameLengthMs=frameLengthMs);
             virtual ~SoundIOAudioDevice();
             bool open() override;
             void close() override;
@@ -91,6 +131,12 @@ namespace afv_native {
 
         protected:
             static bool isAbleToOpen(SoundIoDevice *device_info, bool for_output = false);
+
+            /** chooseFormat picks the best sample format the device supports that we can convert to and from.
+             *
+             * @return false if the device doesn't support any of them.
+             */
+            static bool chooseFormat(SoundIoDevice *device_info, SoundIoFormat &sioFormatOut, SampleFormat &formatOut);
         };
     }
 }
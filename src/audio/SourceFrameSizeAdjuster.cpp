@@ -35,68 +35,103 @@
 #include <memory>
 #include <algorithm>
 #include <cstring>
-#include <xmmintrin.h>
 
 using namespace afv_native::audio;
 using namespace std;
 
+SourceFrameSizeAdjuster::SourceFrameSizeAdjuster(
+        std::shared_ptr<ISampleSource> originSource, unsigned int outputFrameSize, size_t maxPeekSize):
+        mOriginSource(std::move(originSource)),
+        mDestinationFrameSize(outputFrameSize),
+        mMaxPeekSize(maxPeekSize > 0 ? maxPeekSize : outputFrameSize),
+        mBuffer(mMaxPeekSize + frameSizeSamples)
+{
+}
+
+SourceFrameSizeAdjuster::~SourceFrameSizeAdjuster()
+{
+}
+
+bool SourceFrameSizeAdjuster::fill(size_t count)
+{
+    while (mBuffer.getAvailable() < count) {
+        if (!mOriginSource) {
+            return false;
+        }
+        auto *fillPtr = mBuffer.beginWrite(frameSizeSamples);
+        if (mOriginSource->getAudioFrame(fillPtr) != SourceStatus::OK) {
+            mOriginSource.reset();
+            return false;
+        }
+        mBuffer.endWrite(frameSizeSamples);
+    }
+    return true;
+}
+
 SourceStatus SourceFrameSizeAdjuster::getAudioFrame(SampleType *bufferOut)
 {
-    if (!mOriginSource) {
+    return getAudioSamples(bufferOut, mDestinationFrameSize);
+}
+
+size_t SourceFrameSizeAdjuster::getFrameSizeSamples() const
+{
+    return mDestinationFrameSize;
+}
+
+SourceStatus SourceFrameSizeAdjuster::getAudioFrames(SampleType *bufferOut, size_t nFrames)
+{
+    return getAudioSamples(bufferOut, nFrames * mDestinationFrameSize);
+}
+
+SourceStatus SourceFrameSizeAdjuster::getAudioSamples(SampleType *bufferOut, size_t count)
+{
+    if (!mOriginSource && mBuffer.getAvailable() == 0) {
         return SourceStatus::Closed;
     }
-    size_t destOffset = 0;
-    // use residual frame first.
-    if (mSourceBufferOffset > 0) {
-        size_t framesToCopy = std::min<size_t>(frameSizeSamples - mSourceBufferOffset, mDestinationFrameSize);
-        ::memcpy(bufferOut + destOffset, mSourceBuffer + mSourceBufferOffset, framesToCopy * sizeof(SampleType));
-        mSourceBufferOffset = (mSourceBufferOffset + framesToCopy) % frameSizeSamples;
-        destOffset += framesToCopy;
-    }
-    SourceStatus sourceRes;
-    while (destOffset < mDestinationFrameSize) {
-        const size_t samplesRemaining = mDestinationFrameSize - destOffset;
+    // use residual samples first.
+    size_t destOffset = mBuffer.read(bufferOut, count);
 
-        if (samplesRemaining > frameSizeSamples) {
-            // shortcut by writing straight into the buffer.
-            sourceRes = mOriginSource->getAudioFrame(bufferOut + destOffset);
-            if (sourceRes != SourceStatus::OK) {
-                // something broke.  silencefill the buffer, and return OK, but kill our source handle.
-                ::memset(bufferOut+destOffset, 0, sizeof(SampleType) * samplesRemaining);
-                mOriginSource.reset();
-                return SourceStatus::OK;
-            }
-            destOffset += frameSizeSamples;
-        } else {
-            // the remaining samples to copy must be less than a frame.
-            // fill our holding buffer.
-            sourceRes = mOriginSource->getAudioFrame(mSourceBuffer);
-            mSourceBufferOffset = 0;
-            if (sourceRes != SourceStatus::OK) {
-                // something broke.  silencefill the buffer, and return OK, but kill our source handle.
-                ::memset(bufferOut + destOffset, 0, sizeof(SampleType) * samplesRemaining);
-                mOriginSource.reset();
-                return SourceStatus::OK;
-            }
-            // now, copy out the difference.
-            ::memcpy(bufferOut + destOffset, mSourceBuffer, samplesRemaining * sizeof(SampleType));
-            mSourceBufferOffset = samplesRemaining;
-            destOffset += samplesRemaining;
+    // the ring is now empty (or we're done), so whole frames can go straight into the output.
+    const size_t wholeFrames = (count - destOffset) / frameSizeSamples;
+    if (wholeFrames > 0) {
+        if (!mOriginSource || mOriginSource->getAudioFrames(bufferOut + destOffset, wholeFrames) != SourceStatus::OK) {
+            // something broke.  silencefill the buffer, and return OK, but kill our source handle.
+            ::memset(bufferOut + destOffset, 0, sizeof(SampleType) * (count - destOffset));
+            mOriginSource.reset();
+            return SourceStatus::OK;
         }
+        destOffset += wholeFrames * frameSizeSamples;
+    }
+    // the remaining samples to copy must be less than a frame, so go via the ring.
+    if (destOffset < count) {
+        if (!fill(count - destOffset)) {
+            ::memset(bufferOut + destOffset, 0, sizeof(SampleType) * (count - destOffset));
+            return SourceStatus::OK;
+        }
+        mBuffer.read(bufferOut + destOffset, count - destOffset);
     }
     return SourceStatus::OK;
 }
 
-SourceFrameSizeAdjuster::SourceFrameSizeAdjuster(
-        std::shared_ptr<ISampleSource> originSource, unsigned int outputFrameSize):
-        mOriginSource(std::move(originSource)), mDestinationFrameSize(outputFrameSize), mSourceBufferOffset(0)
+const SampleType *SourceFrameSizeAdjuster::peekSamples(size_t count)
+{
+    count = std::min(count, mMaxPeekSize);
+    if (!fill(count)) {
+        // pad out with silence so the caller always gets a full block.
+        auto padding = count - mBuffer.getAvailable();
+        auto *fillPtr = mBuffer.beginWrite(padding);
+        ::memset(fillPtr, 0, padding * sizeof(SampleType));
+        mBuffer.endWrite(padding);
+    }
+    return mBuffer.beginRead(count);
+}
+
+void SourceFrameSizeAdjuster::consumeSamples(size_t count)
 {
-    const size_t bufferSize = frameSizeSamples * sizeof(SampleType);
-    mSourceBuffer = new SampleType[bufferSize];
-    ::memset(mSourceBuffer, 0, bufferSize);
+    mBuffer.endRead(std::min(count, mBuffer.getAvailable()));
 }
 
-SourceFrameSizeAdjuster::~SourceFrameSizeAdjuster()
+size_t SourceFrameSizeAdjuster::getLatencySamples() const
 {
-    delete[] mSourceBuffer;
+    return mBuffer.getLatencySamples();
 }
@@ -33,18 +33,21 @@
 
 #include "afv-native/audio/SpeexPreprocessor.h"
 #include "afv-native/audio/audio_params.h"
+#include "afv-native/util/Trace.h"
 
 #include <speex/speex_preprocess.h>
 
 using namespace afv_native::audio;
 
-SpeexPreprocessor::SpeexPreprocessor(std::shared_ptr<ISampleSink> upstream):
+SpeexPreprocessor::SpeexPreprocessor(std::shared_ptr<ISampleSink> upstream, int sampleRate):
     mUpstreamSink(std::move(upstream)),
     mPreprocessorState(nullptr),
+    mFrameSizeSamples(sampleRate * frameLengthMs / 1000),
+    mLatency(nullptr),
     mSpeexFrame(),
     mOutputFrame()
 {
-    mPreprocessorState = speex_preprocess_state_init(frameSizeSamples, sampleRateHz);
+    mPreprocessorState = speex_preprocess_state_init(mFrameSizeSamples, sampleRate);
 }
 
 SpeexPreprocessor::~SpeexPreprocessor()
@@ -54,14 +57,23 @@ SpeexPreprocessor::~SpeexPreprocessor()
 
 void SpeexPreprocessor::putAudioFrame(const SampleType *bufferIn)
 {
-    for (size_t i = 0; i < frameSizeSamples; i++) {
-        mSpeexFrame[i] = static_cast<spx_int16_t>(bufferIn[i] * 32767.0f);
-    }
-    speex_preprocess_run(mPreprocessorState, mSpeexFrame);
-    for (size_t i = 0; i < frameSizeSamples; i++) {
-        mOutputFrame[i] = static_cast<float>(mSpeexFrame[i]) / 32768.0f;
+    {
+        util::ScopedLatency timing(mLatency);
+        TRACE_SCOPE("audio", "TxPreprocess");
+        for (size_t i = 0; i < mFrameSizeSamples; i++) {
+            mSpeexFrame[i] = static_cast<spx_int16_t>(bufferIn[i] * 32767.0f);
+        }
+        speex_preprocess_run(mPreprocessorState, mSpeexFrame);
+        for (size_t i = 0; i < mFrameSizeSamples; i++) {
+            mOutputFrame[i] = static_cast<float>(mSpeexFrame[i]) / 32768.0f;
+        }
     }
     if (mUpstreamSink) {
         mUpstreamSink->putAudioFrame(mOutputFrame);
     }
 }
+
+void SpeexPreprocessor::setLatencyHistogram(util::LatencyHistogram *histogram)
+{
+    mLatency = histogram;
+}
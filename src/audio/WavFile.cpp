@@ -391,6 +391,7 @@ afv_native::audio::LoadWav(const char *fileName)
 		goto fail;
 	}
 
+	fclose(fh);
 	return asd;
 fail:
 	if (fh != nullptr) {
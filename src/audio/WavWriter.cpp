@@ -0,0 +1,171 @@
+/* audio/WavWriter.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "afv-native/audio/WavWriter.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "afv-native/Log.h"
+
+using namespace afv_native::audio;
+
+namespace {
+    const uint16_t wavFormatPcm = 1;
+    const uint16_t wavFormatIeeeFloat = 3;
+
+#pragma pack(push, 1)
+    /** the canonical 44 byte header - RIFF, a 16 byte fmt chunk and the data chunk header. */
+    struct WavHeader {
+        char riffId[4];
+        uint32_t riffSize;
+        char waveId[4];
+        char fmtId[4];
+        uint32_t fmtSize;
+        uint16_t wFormatTag;
+        uint16_t nChannels;
+        uint32_t nSamplesPerSec;
+        uint32_t nAvgBytesPerSec;
+        uint16_t nBlockAlign;
+        uint16_t wBitsPerSample;
+        char dataId[4];
+        uint32_t dataSize;
+    };
+#pragma pack(pop)
+
+    const size_t riffSizeOffset = offsetof(WavHeader, riffSize);
+    const size_t dataSizeOffset = offsetof(WavHeader, dataSize);
+}
+
+const size_t WavWriter::conversionBlockSize;
+
+WavWriter::WavWriter():
+        mFile(nullptr),
+        mFormat(SampleFormat::Int16),
+        mSamplesWritten(0),
+        mConversionBuffer(new char[conversionBlockSize * sizeof(int32_t)])
+{
+}
+
+WavWriter::~WavWriter()
+{
+    close();
+    delete[] mConversionBuffer;
+}
+
+bool WavWriter::open(const std::string &fileName, unsigned int sampleRate, SampleFormat format)
+{
+    close();
+    mFile = fopen(fileName.c_str(), "wb");
+    if (mFile == nullptr) {
+        LOGERROR("WavWriter", "couldn't open %s for writing", fileName.c_str());
+        return false;
+    }
+    mFormat = format;
+    mSamplesWritten = 0;
+
+    const auto sampleBytes = static_cast<uint16_t>(getSampleFormatBytes(mFormat));
+    WavHeader header;
+    ::memcpy(header.riffId, "RIFF", 4);
+    header.riffSize = sizeof(WavHeader) - 8;
+    ::memcpy(header.waveId, "WAVE", 4);
+    ::memcpy(header.fmtId, "fmt ", 4);
+    header.fmtSize = 16;
+    header.wFormatTag = (mFormat == SampleFormat::Float32) ? wavFormatIeeeFloat : wavFormatPcm;
+    header.nChannels = 1;
+    header.nSamplesPerSec = sampleRate;
+    header.nAvgBytesPerSec = sampleRate * sampleBytes;
+    header.nBlockAlign = sampleBytes;
+    header.wBitsPerSample = sampleBytes * 8;
+    ::memcpy(header.dataId, "data", 4);
+    header.dataSize = 0;
+    if (1 != fwrite(&header, sizeof(header), 1, mFile)) {
+        LOGERROR("WavWriter", "couldn't write header to %s", fileName.c_str());
+        fclose(mFile);
+        mFile = nullptr;
+        return false;
+    }
+    return true;
+}
+
+bool WavWriter::writeSamples(const SampleType *samples, size_t count)
+{
+    if (mFile == nullptr) {
+        return false;
+    }
+    const size_t sampleBytes = getSampleFormatBytes(mFormat);
+    while (count > 0) {
+        const size_t blockSize = std::min(count, conversionBlockSize);
+        convertToFormat(samples, mConversionBuffer, sampleBytes, mFormat, blockSize);
+        if (blockSize != fwrite(mConversionBuffer, sampleBytes, blockSize, mFile)) {
+            return false;
+        }
+        mSamplesWritten += blockSize;
+        samples += blockSize;
+        count -= blockSize;
+    }
+    return true;
+}
+
+void WavWriter::close()
+{
+    if (mFile == nullptr) {
+        return;
+    }
+    const auto dataSize = static_cast<uint32_t>(mSamplesWritten * getSampleFormatBytes(mFormat));
+    // RIFF chunks are padded to an even length.
+    const uint32_t padSize = dataSize % 2;
+    const uint32_t riffSize = sizeof(WavHeader) - 8 + dataSize + padSize;
+    if (padSize != 0) {
+        const char pad = 0;
+        fwrite(&pad, 1, 1, mFile);
+    }
+    fseek(mFile, riffSizeOffset, SEEK_SET);
+    fwrite(&riffSize, sizeof(riffSize), 1, mFile);
+    fseek(mFile, dataSizeOffset, SEEK_SET);
+    fwrite(&dataSize, sizeof(dataSize), 1, mFile);
+    fclose(mFile);
+    mFile = nullptr;
+}
+
+bool WavWriter::isOpen() const
+{
+    return mFile != nullptr;
+}
+
+size_t WavWriter::getSamplesWritten() const
+{
+    return mSamplesWritten;
+}
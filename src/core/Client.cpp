@@ -42,14 +42,23 @@
 
 using namespace afv_native;
 
+namespace {
+    /** audioWatchdogPollIntervalMs is how often we check for new audio deadline incidents to report. */
+    const unsigned audioWatchdogPollIntervalMs = 250;
+}
+
 Client::Client(
         struct event_base *evBase,
         const std::string &resourceBasePath,
         unsigned int numRadios,
         const std::string &clientName,
         std::string baseUrl):
+        mNetworkThread(evBase == nullptr ? new event::EventLoopThread("afv-network") : nullptr),
+        mEventQueue(),
+        mAPIConnected(false),
+        mVoiceConnected(false),
         mFxRes(std::make_shared<afv::EffectResources>(resourceBasePath)),
-        mEvBase(evBase),
+        mEvBase(evBase != nullptr ? evBase : mNetworkThread->getEventBase()),
         mTransferManager(mEvBase),
         mAPISession(mEvBase, mTransferManager, std::move(baseUrl), clientName),
         mVoiceSession(mAPISession),
@@ -65,8 +74,11 @@ Client::Client(
         mWantPtt(false),
         mPtt(false),
         mTransceiverUpdateTimer(mEvBase, std::bind(&Client::sendTransceiverUpdate, this)),
+        mAudioWatchdogTimer(mEvBase, std::bind(&Client::checkAudioIncidents, this)),
+        mLastAudioIncident(0),
         mClientName(clientName),
         mAudioApi(0),
+        mAudioFrameLengthMs(audio::frameLengthMs),
         mAudioInputDeviceName(),
         mAudioOutputDeviceName(),
         ClientEventCallback()
@@ -79,22 +91,103 @@ Client::Client(
     for (size_t i = 0; i < mRadioState.size(); i++) {
         mRadioSim->setFrequency(i, mRadioState[i].mNextFreq);
     }
+    // everything's attached to the event base now, so from here on it belongs to the network thread.
+    if (mNetworkThread) {
+        mNetworkThread->start();
+    }
 }
 
 Client::~Client()
 {
-    mVoiceSession.StateCallback.removeCallback(this);
-    mAPISession.StateCallback.removeCallback(this);
-    mAPISession.AliasUpdateCallback.removeCallback(this);
+    auto detach = [this]() {
+        mVoiceSession.StateCallback.removeCallback(this);
+        mAPISession.StateCallback.removeCallback(this);
+        mAPISession.AliasUpdateCallback.removeCallback(this);
 
-    // disconnect the radiosim from the UDP channel so if it's held open by the
-    // audio device, it doesn't crash the client.
-    mRadioSim->setPtt(false);
-    mRadioSim->setUDPChannel(nullptr);
+        // disconnect the radiosim from the UDP channel so if it's held open by the
+        // audio device, it doesn't crash the client.
+        mRadioSim->setPtt(false);
+        mRadioSim->setUDPChannel(nullptr);
+    };
+    if (mNetworkThread) {
+        mNetworkThread->call(detach);
+        // the members are destroyed on this thread, so the loop has to be stopped first.
+        mNetworkThread->stop();
+    } else {
+        detach();
+    }
+}
+
+bool Client::deferToNetworkThread(std::function<void()> command)
+{
+    if (!mNetworkThread || mNetworkThread->isLoopThread()) {
+        return false;
+    }
+    mNetworkThread->post(std::move(command));
+    return true;
+}
+
+Client::QueuedClientEvent::QueuedClientEvent(ClientEventType type):
+        Type(type),
+        APIError(),
+        VoiceError(),
+        ChannelErrno(0),
+        Incident()
+{
+}
+
+void *Client::QueuedClientEvent::getData()
+{
+    switch (Type) {
+    case ClientEventType::APIServerError:
+        return &APIError;
+    case ClientEventType::VoiceServerChannelError:
+        return &ChannelErrno;
+    case ClientEventType::VoiceServerError:
+        return &VoiceError;
+    case ClientEventType::AudioDeadline:
+        return &Incident;
+    default:
+        return nullptr;
+    }
+}
+
+void Client::raiseEvent(QueuedClientEvent event)
+{
+    if (mNetworkThread) {
+        mEventQueue.push(std::move(event));
+        return;
+    }
+    ClientEventCallback.invokeAll(event.Type, event.getData());
+}
+
+size_t Client::pollEvents()
+{
+    size_t delivered = 0;
+    QueuedClientEvent event;
+    while (mEventQueue.pop(event)) {
+        ClientEventCallback.invokeAll(event.Type, event.getData());
+        delivered++;
+    }
+    return delivered;
+}
+
+bool Client::hasNetworkThread() const
+{
+    return static_cast<bool>(mNetworkThread);
+}
+
+void Client::publishConnectionState()
+{
+    mAPIConnected.store(apiSessionUp());
+    mVoiceConnected.store(mVoiceSession.isConnected());
 }
 
 void Client::setClientPosition(double lat, double lon, double amslm, double aglm)
 {
+    if (deferToNetworkThread([this, lat, lon, amslm, aglm]() { setClientPosition(lat, lon, amslm, aglm); })) {
+        return;
+    }
     mClientLatitude = lat;
     mClientLongitude = lon;
     mClientAltitudeMSLM = amslm;
@@ -103,6 +196,9 @@ void Client::setClientPosition(double lat, double lon, double amslm, double aglm
 
 void Client::setRadioState(unsigned int radioNum, int freq)
 {
+    if (deferToNetworkThread([this, radioNum, freq]() { setRadioState(radioNum, freq); })) {
+        return;
+    }
     if (radioNum > mRadioState.size()) {
         return;
     }
@@ -120,11 +216,21 @@ void Client::setRadioState(unsigned int radioNum, int freq)
 
 void Client::setTxRadio(unsigned int radioNum)
 {
+    if (deferToNetworkThread([this, radioNum]() { setTxRadio(radioNum); })) {
+        return;
+    }
     mRadioSim->setTxRadio(radioNum);
 }
 
 bool Client::connect()
 {
+    if (mNetworkThread && !mNetworkThread->isLoopThread()) {
+        bool started = false;
+        mNetworkThread->call([this, &started]() {
+            started = connect();
+        });
+        return started;
+    }
     if (!isAPIConnected()) {
         if (mAPISession.getState() != afv::APISessionState::Disconnected) {
             return false;
@@ -138,6 +244,9 @@ bool Client::connect()
 
 void Client::disconnect()
 {
+    if (deferToNetworkThread([this]() { disconnect(); })) {
+        return;
+    }
     // voicesession must come first.
     if (isVoiceConnected()) {
         mVoiceSession.Disconnect(true);
@@ -148,6 +257,9 @@ void Client::disconnect()
 
 void Client::setCredentials(const std::string &username, const std::string &password)
 {
+    if (deferToNetworkThread([this, username, password]() { setCredentials(username, password); })) {
+        return;
+    }
     if (mAPISession.getState() != afv::APISessionState::Disconnected) {
         return;
     }
@@ -157,6 +269,9 @@ void Client::setCredentials(const std::string &username, const std::string &pass
 
 void Client::setCallsign(std::string callsign)
 {
+    if (deferToNetworkThread([this, callsign]() { setCallsign(callsign); })) {
+        return;
+    }
     if (isVoiceConnected()) {
         return;
     }
@@ -167,18 +282,18 @@ void Client::setCallsign(std::string callsign)
 
 void Client::voiceStateCallback(afv::VoiceSessionState state)
 {
-    afv::VoiceSessionError voiceError;
-    int channelErrno;
+    QueuedClientEvent errorEvent;
 
+    publishConnectionState();
     switch (state) {
     case afv::VoiceSessionState::Connected:
         LOG("afv::Client", "Voice Session Connected");
         // if we have a valid mAudioDevice, then do not attempt to restart it.  bad things will happen.
-        if (!mAudioDevice) {
+        if (!std::atomic_load(&mAudioDevice)) {
             startAudio();
         }
         queueTransceiverUpdate();
-        ClientEventCallback.invokeAll(ClientEventType::VoiceServerConnected, nullptr);
+        raiseEvent(QueuedClientEvent(ClientEventType::VoiceServerConnected));
         break;
     case afv::VoiceSessionState::Disconnected:
         LOG("afv::Client", "Voice Session Disconnected");
@@ -187,29 +302,32 @@ void Client::voiceStateCallback(afv::VoiceSessionState state)
         // bring down the API session too.
         mAPISession.Disconnect();
         mRadioSim->reset();
-        ClientEventCallback.invokeAll(ClientEventType::VoiceServerDisconnected, nullptr);
+        raiseEvent(QueuedClientEvent(ClientEventType::VoiceServerDisconnected));
         break;
     case afv::VoiceSessionState::Error:
-        LOG("afv::Client", "got error from voice session");
+        LOGERROR("afv::Client", "got error from voice session");
         stopAudio();
         stopTransceiverUpdate();
         // bring down the API session too.
         mAPISession.Disconnect();
         mRadioSim->reset();
-        voiceError = mVoiceSession.getLastError();
-        if (voiceError == afv::VoiceSessionError::UDPChannelError) {
-            channelErrno = mVoiceSession.getUDPChannel().getLastErrno();
-            ClientEventCallback.invokeAll(ClientEventType::VoiceServerChannelError, &channelErrno);
+        errorEvent.VoiceError = mVoiceSession.getLastError();
+        if (errorEvent.VoiceError == afv::VoiceSessionError::UDPChannelError) {
+            errorEvent.Type = ClientEventType::VoiceServerChannelError;
+            errorEvent.ChannelErrno = mVoiceSession.getUDPChannel().getLastErrno();
         } else {
-            ClientEventCallback.invokeAll(ClientEventType::VoiceServerError, &voiceError);
+            errorEvent.Type = ClientEventType::VoiceServerError;
         }
+        raiseEvent(errorEvent);
         break;
     }
 }
 
 void Client::sessionStateCallback(afv::APISessionState state)
 {
-    afv::APISessionError sessionError;
+    QueuedClientEvent errorEvent(ClientEventType::APIServerError);
+
+    publishConnectionState();
     switch (state) {
     case afv::APISessionState::Reconnecting:
         LOG("afv_native::Client", "Reconnecting API Session");
@@ -221,18 +339,18 @@ void Client::sessionStateCallback(afv::APISessionState state)
             mVoiceSession.Connect();
             mAPISession.updateStationAliases();
         }
-        ClientEventCallback.invokeAll(ClientEventType::APIServerConnected, nullptr);
+        raiseEvent(QueuedClientEvent(ClientEventType::APIServerConnected));
         break;
     case afv::APISessionState::Disconnected:
         LOG("afv_native::Client", "Disconnected from AFV API Server.  Terminating sessions");
         // because we only ever commence a normal API Session teardown from a voicesession hook,
         // we don't need to call into voiceSession in this case only.
-        ClientEventCallback.invokeAll(ClientEventType::APIServerDisconnected, nullptr);
+        raiseEvent(QueuedClientEvent(ClientEventType::APIServerDisconnected));
         break;
     case afv::APISessionState::Error:
-        LOG("afv_native::Client", "Got error from AFV API Server.  Disconnecting session");
-        sessionError = mAPISession.getLastError();
-        ClientEventCallback.invokeAll(ClientEventType::APIServerError, &sessionError);
+        LOGWARN("afv_native::Client", "Got error from AFV API Server.  Disconnecting session");
+        errorEvent.APIError = mAPISession.getLastError();
+        raiseEvent(errorEvent);
         break;
     default:
         // ignore the other transitions.
@@ -242,30 +360,40 @@ void Client::sessionStateCallback(afv::APISessionState state)
 
 void Client::startAudio()
 {
-    if (!mAudioDevice) {
+    if (deferToNetworkThread([this]() { startAudio(); })) {
+        return;
+    }
+    // mAudioDevice is only ever changed on the network thread, but getAudioDevice() can read it from anywhere.
+    auto audioDevice = std::atomic_load(&mAudioDevice);
+    if (!audioDevice) {
         LOG("afv::Client", "Initialising Audio...");
-        mAudioDevice = audio::AudioDevice::makeDevice(
+        audioDevice = audio::AudioDevice::makeDevice(
                 mClientName,
                 mAudioOutputDeviceName,
                 mAudioInputDeviceName,
-                mAudioApi);
+                mAudioApi,
+                mAudioFrameLengthMs);
+        std::atomic_store(&mAudioDevice, audioDevice);
     } else {
-        LOG("afv::Client", "Tried to recreate audio device...");
+        LOGWARN("afv::Client", "Tried to recreate audio device...");
     }
-    mAudioDevice->setSink(mRadioSim);
-    mAudioDevice->setSource(mRadioSim);
-    if (!mAudioDevice->open()) {
-        LOG("afv::Client", "Unable to open audio device.");
+    audioDevice->setSink(mRadioSim);
+    audioDevice->setSource(mRadioSim);
+    if (!audioDevice->open()) {
+        LOGERROR("afv::Client", "Unable to open audio device.");
         stopAudio();
-        ClientEventCallback.invokeAll(ClientEventType::AudioError, nullptr);
+        raiseEvent(QueuedClientEvent(ClientEventType::AudioError));
     };
 }
 
 void Client::stopAudio()
 {
-    if (mAudioDevice) {
-        mAudioDevice->close();
-        mAudioDevice.reset();
+    if (deferToNetworkThread([this]() { stopAudio(); })) {
+        return;
+    }
+    auto audioDevice = std::atomic_exchange(&mAudioDevice, std::shared_ptr<audio::AudioDevice>());
+    if (audioDevice) {
+        audioDevice->close();
     }
 }
 
@@ -322,28 +450,31 @@ void Client::queueTransceiverUpdate()
 void Client::unguardPtt()
 {
     if (mWantPtt && !mPtt) {
-        LOG("Client", "PTT was guarded - checking.");
+        LOGDEBUG("Client", "PTT was guarded - checking.");
         if (!areTransceiversSynced()) {
-            LOG("Client", "Freqs still unsync'd.  Restarting update.");
+            LOGDEBUG("Client", "Freqs still unsync'd.  Restarting update.");
             queueTransceiverUpdate();
             return;
         }
-        LOG("Client", "Freqs in sync - allowing PTT now.");
+        LOGDEBUG("Client", "Freqs in sync - allowing PTT now.");
         mPtt = true;
         mRadioSim->setPtt(true);
-        ClientEventCallback.invokeAll(ClientEventType::PttOpen, nullptr);
+        raiseEvent(QueuedClientEvent(ClientEventType::PttOpen));
     }
 }
 
 void Client::setPtt(bool pttState)
 {
+    if (deferToNetworkThread([this, pttState]() { setPtt(pttState); })) {
+        return;
+    }
     if (pttState) {
         mWantPtt = true;
         // if we're setting the Ptt, we have to check a few things.
         // if we're still pending an update, and the radios are out of step, guard the Ptt.
         if (!areTransceiversSynced() || mTxUpdatePending) {
             if (!mTxUpdatePending) {
-                LOG("Client", "Wanted to Open PTT mid-update - guarding");
+                LOGDEBUG("Client", "Wanted to Open PTT mid-update - guarding");
                 queueTransceiverUpdate();
             }
             return;
@@ -357,11 +488,11 @@ void Client::setPtt(bool pttState)
     mPtt = mWantPtt;
     mRadioSim->setPtt(mPtt);
     if (mPtt) {
-        LOG("Client", "Opened PTT");
-        ClientEventCallback.invokeAll(ClientEventType::PttOpen, nullptr);
+        LOGDEBUG("Client", "Opened PTT");
+        raiseEvent(QueuedClientEvent(ClientEventType::PttOpen));
     } else if (!mWantPtt) {
-        LOG("Client", "Closed PTT");
-        ClientEventCallback.invokeAll(ClientEventType::PttClosed, nullptr);
+        LOGDEBUG("Client", "Closed PTT");
+        raiseEvent(QueuedClientEvent(ClientEventType::PttClosed));
     }
 }
 
@@ -377,27 +508,47 @@ bool Client::areTransceiversSynced() const
 
 void Client::setAudioInputDevice(std::string inputDevice)
 {
+    if (deferToNetworkThread([this, inputDevice]() { setAudioInputDevice(inputDevice); })) {
+        return;
+    }
     mAudioInputDeviceName = inputDevice;
 }
 
 void Client::setAudioOutputDevice(std::string outputDevice)
 {
+    if (deferToNetworkThread([this, outputDevice]() { setAudioOutputDevice(outputDevice); })) {
+        return;
+    }
     mAudioOutputDeviceName = outputDevice;
 }
 
-bool Client::isAPIConnected() const
+bool Client::apiSessionUp() const
 {
     auto sState = mAPISession.getState();
     return sState == afv::APISessionState::Running || sState == afv::APISessionState::Reconnecting;
 }
 
+bool Client::isAPIConnected() const
+{
+    if (mNetworkThread && !mNetworkThread->isLoopThread()) {
+        return mAPIConnected.load();
+    }
+    return apiSessionUp();
+}
+
 bool Client::isVoiceConnected() const
 {
+    if (mNetworkThread && !mNetworkThread->isLoopThread()) {
+        return mVoiceConnected.load();
+    }
     return mVoiceSession.isConnected();
 }
 
 void Client::setBaseUrl(std::string newUrl)
 {
+    if (deferToNetworkThread([this, newUrl]() { setBaseUrl(newUrl); })) {
+        return;
+    }
     mAPISession.setBaseUrl(std::move(newUrl));
 }
 
@@ -408,9 +559,20 @@ void Client::stopTransceiverUpdate()
 
 void Client::setAudioApi(audio::AudioDevice::Api api)
 {
+    if (deferToNetworkThread([this, api]() { setAudioApi(api); })) {
+        return;
+    }
     mAudioApi = api;
 }
 
+void Client::setAudioFrameLengthMs(unsigned int frameLengthMs)
+{
+    if (deferToNetworkThread([this, frameLengthMs]() { setAudioFrameLengthMs(frameLengthMs); })) {
+        return;
+    }
+    mAudioFrameLengthMs = frameLengthMs;
+}
+
 void Client::setRadioGain(unsigned int radioNum, float gain)
 {
     mRadioSim->setGain(radioNum, gain);
@@ -426,6 +588,16 @@ void Client::setEnableInputFilters(bool enableInputFilters)
     mRadioSim->setEnableInputFilters(enableInputFilters);
 }
 
+void Client::setEnableNarrowbandTx(bool enableNarrowband)
+{
+    mRadioSim->setEnableNarrowbandTx(enableNarrowband);
+}
+
+bool Client::getEnableNarrowbandTx() const
+{
+    return mRadioSim->getEnableNarrowbandTx();
+}
+
 double Client::getInputPeak() const
 {
     if (mRadioSim) {
@@ -449,19 +621,185 @@ void Client::setEnableOutputEffects(bool enableEffects)
 
 void Client::aliasUpdateCallback()
 {
-    ClientEventCallback.invokeAll(ClientEventType::StationAliasesUpdated, nullptr);
+    raiseEvent(QueuedClientEvent(ClientEventType::StationAliasesUpdated));
 }
 
 std::vector<afv::dto::Station> Client::getStationAliases() const
 {
+    if (mNetworkThread && !mNetworkThread->isLoopThread()) {
+        std::vector<afv::dto::Station> aliases;
+        mNetworkThread->call([this, &aliases]() {
+            aliases = mAPISession.getStationAliases();
+        });
+        return aliases;
+    }
     return std::move(mAPISession.getStationAliases());
 }
 
 void Client::logAudioStatistics() {
-    if (mAudioDevice) {
-        LOG("Client", "Output Buffer Underflows: %d", mAudioDevice->OutputUnderflows.load());
-        LOG("Client", "Input Buffer Overflows: %d", mAudioDevice->InputOverflows.load());
+    const auto audioDevice = std::atomic_load(&mAudioDevice);
+    if (audioDevice) {
+        LOG("Client", "Output Buffer Underflows: %d", audioDevice->OutputUnderflows.load());
+        LOG("Client", "Input Buffer Overflows: %d", audioDevice->InputOverflows.load());
     }
+    const auto perfStats = getPerformanceStats();
+    if (perfStats.Enabled) {
+        for (size_t i = 0; i < afv::performanceStageCount; i++) {
+            const auto &stage = perfStats.Stages[i];
+            if (stage.Count == 0) {
+                continue;
+            }
+            LOG("Client", "%s: %llu samples, mean %.1fus, p99 %uus, max %uus",
+                afv::getPerformanceStageName(static_cast<afv::PerformanceStage>(i)),
+                static_cast<unsigned long long>(stage.Count),
+                stage.getMeanUs(),
+                stage.getPercentileUs(99.0),
+                stage.MaxUs);
+        }
+    }
+    for (const auto &lockStats: getLockStatistics()) {
+        LOG("Client", "%s: %llu acquisitions, %llu contended, wait %lluus (max %uus), held %lluus (max %uus)",
+            lockStats.Name.c_str(),
+            static_cast<unsigned long long>(lockStats.Acquisitions),
+            static_cast<unsigned long long>(lockStats.ContendedAcquisitions),
+            static_cast<unsigned long long>(lockStats.TotalWaitUs),
+            lockStats.MaxWaitUs,
+            static_cast<unsigned long long>(lockStats.TotalHoldUs),
+            lockStats.MaxHoldUs);
+    }
+    const auto memoryStats = getRealtimeMemoryStats();
+    if (memoryStats.Enabled) {
+        LOG("Client", "Real-time memory: %zu/%zu bytes used (%s), %zu bytes locked in place, %u lock failures",
+            memoryStats.Arena.UsedBytes,
+            memoryStats.Arena.CapacityBytes,
+            memoryStats.Arena.Locked ? "locked" : "not locked",
+            memoryStats.Arena.LockedRegionBytes,
+            memoryStats.Arena.LockFailures);
+        LOG("Client", "Real-time stream slots: %u of %u free, %llu misses",
+            memoryStats.StreamSlotsFree,
+            memoryStats.StreamSlots,
+            static_cast<unsigned long long>(memoryStats.StreamSlotMisses));
+    }
+    static const char *priorityNames[] = {"default", "elevated", "real-time"};
+    for (size_t i = 0; i < util::threadClassCount; i++) {
+        const auto threadClass = static_cast<util::ThreadClass>(i);
+        const auto policy = util::getThreadPolicy(threadClass);
+        const auto status = util::getThreadPolicyStatus(threadClass);
+        if (policy.Priority == util::ThreadPriority::Default && policy.CpuMask == 0) {
+            continue;
+        }
+        if (!status.Applied) {
+            LOG("Client", "%s thread: policy not applied yet", util::getThreadClassName(threadClass));
+            continue;
+        }
+        LOG("Client", "%s thread: asked for %s priority, got %s; affinity %s; last error %d",
+            util::getThreadClassName(threadClass),
+            priorityNames[static_cast<int>(policy.Priority)],
+            priorityNames[static_cast<int>(status.Priority)],
+            status.AffinityApplied ? "set" : "not set",
+            status.LastError);
+    }
+}
+
+void Client::setEnablePerformanceStats(bool enable) {
+    mRadioSim->setEnablePerformanceStats(enable);
+}
+
+afv::PerformanceStats Client::getPerformanceStats() const {
+    return mRadioSim->getPerformanceStats();
+}
+
+void Client::resetPerformanceStats() {
+    mRadioSim->resetPerformanceStats();
+}
+
+void Client::setEnableAudioWatchdog(bool enable) {
+    if (deferToNetworkThread([this, enable]() { setEnableAudioWatchdog(enable); })) {
+        return;
+    }
+    if (enable) {
+        // only report incidents from here on.
+        const auto incidents = mRadioSim->getAudioIncidents(mLastAudioIncident);
+        if (!incidents.empty()) {
+            mLastAudioIncident = incidents.back().Sequence;
+        }
+        mRadioSim->setEnableAudioWatchdog(true);
+        mAudioWatchdogTimer.enable(audioWatchdogPollIntervalMs);
+    } else {
+        mRadioSim->setEnableAudioWatchdog(false);
+        mAudioWatchdogTimer.disable();
+    }
+}
+
+void Client::setAudioWatchdogThreshold(float fraction) {
+    mRadioSim->setAudioWatchdogThreshold(fraction);
+}
+
+std::vector<afv::AudioIncident> Client::getAudioIncidents() const {
+    return mRadioSim->getAudioIncidents();
+}
+
+void Client::checkAudioIncidents() {
+    auto incidents = mRadioSim->getAudioIncidents(mLastAudioIncident);
+    for (auto &incident: incidents) {
+        mLastAudioIncident = incident.Sequence;
+        LOGWARN("Client", "%s frame %s: %uus of %uus, slowest stage %s (%uus), %u streams, %u radios",
+                incident.Transmit ? "capture" : "playback",
+                incident.Overrun ? "overran" : "near deadline",
+                incident.FrameUs,
+                incident.BudgetUs,
+                afv::getPerformanceStageName(incident.SlowestStage),
+                incident.getStageUs(incident.SlowestStage),
+                incident.ActiveStreams,
+                incident.ActiveRadios);
+        QueuedClientEvent incidentEvent(ClientEventType::AudioDeadline);
+        incidentEvent.Incident = incident;
+        raiseEvent(std::move(incidentEvent));
+    }
+    mAudioWatchdogTimer.enable(audioWatchdogPollIntervalMs);
+}
+
+cryptodto::UDPChannelStats Client::getChannelStatistics() const {
+    return mVoiceSession.getUDPChannel().getStatistics();
+}
+
+void Client::resetChannelStatistics() {
+    mVoiceSession.getUDPChannel().resetStatistics();
+}
+
+std::vector<afv::VoiceStreamStats> Client::getStreamStatistics() const {
+    return mRadioSim->getStreamStatistics();
+}
+
+bool Client::enableRealtimeMemory(unsigned int streamSlots) {
+    if (std::atomic_load(&mAudioDevice)) {
+        LOGWARN("afv::Client", "enabling real-time memory whilst the audio is running");
+    }
+    return mRadioSim->enableRealtimeMemory(streamSlots);
+}
+
+afv::RealtimeMemoryStats Client::getRealtimeMemoryStats() const {
+    return mRadioSim->getRealtimeMemoryStats();
+}
+
+void Client::setThreadPolicy(util::ThreadClass threadClass, const util::ThreadPolicy &policy) {
+    util::setThreadPolicy(threadClass, policy);
+}
+
+util::ThreadPolicy Client::getThreadPolicy(util::ThreadClass threadClass) const {
+    return util::getThreadPolicy(threadClass);
+}
+
+util::ThreadPolicyStatus Client::getThreadPolicyStatus(util::ThreadClass threadClass) const {
+    return util::getThreadPolicyStatus(threadClass);
+}
+
+std::vector<util::LockStats> Client::getLockStatistics() const {
+    return util::getLockStatistics();
+}
+
+void Client::resetLockStatistics() {
+    util::resetLockStatistics();
 }
 
 std::shared_ptr<const afv::RadioSimulation> Client::getRadioSimulation() const {
@@ -469,7 +807,7 @@ std::shared_ptr<const afv::RadioSimulation> Client::getRadioSimulation() const {
 }
 
 std::shared_ptr<const audio::AudioDevice> Client::getAudioDevice() const {
-    return mAudioDevice;
+    return std::atomic_load(&mAudioDevice);
 }
 
 bool Client::getRxActive(unsigned int radioNumber) {
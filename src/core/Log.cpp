@@ -32,95 +32,647 @@
 */
 
 #include "afv-native/Log.h"
+#include "afv-native/util/ProfiledMutex.h"
+#include "afv-native/util/RealtimeGuard.h"
+#include "afv-native/util/ThreadPolicy.h"
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdarg>
+#include <cstdio>
+#include <cstring>
 #include <ctime>
-#include <vector>
-#include <sstream>
-#include <ios>
-#include <iomanip>
+#include <memory>
 #include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 using namespace std;
-static FILE *gLoggerFh = nullptr;
 
-static void
-cleanUpDefaultLogger()
-{
-    if (nullptr != gLoggerFh) {
-        fclose(gLoggerFh);
-        gLoggerFh = nullptr;
-    }
-}
+namespace {
+    /** logRingCapacity is the number of records in each thread's ring.  It must be a power of two. */
+    const size_t logRingCapacity = 256;
 
-static void
-defaultLogger(const char *subsystem, const char *file, int line, const char *outputLine)
-{
-    char dateTimeBuf[100];
-    time_t t = time(nullptr);
-    strftime(dateTimeBuf, 100, "%c", localtime(&t));
-    if (nullptr == gLoggerFh) {
-        gLoggerFh = fopen("afv.log", "at");
-        atexit(cleanUpDefaultLogger);
-    }
-    if (nullptr != gLoggerFh) {
+    /** logSpareRings is the number of rings kept ready for real-time threads to adopt. */
+    const size_t logSpareRings = 4;
+
+    /** logDrainIntervalMs is how often the writer wakes up to drain the rings. */
+    const int logDrainIntervalMs = 20;
+
+    /** Each LOG() call site may emit logRateLimitBurst lines every logRateLimitWindowSec seconds.  Anything
+     * more is counted, and reported as a single line when the window closes.  A LOGDUMPHEX counts once, however
+     * many lines it takes.
+     */
+    const unsigned int logRateLimitBurst = 20;
+    const time_t logRateLimitWindowSec = 10;
+
+    const size_t logSubsystemSize = 32;
+
+    struct LogRecord {
+        const char *File;
+        int Line;
+        /** Continuation is set on the second and later lines of a hex dump, which share the first's fate. */
+        bool Continuation;
+        time_t Timestamp;
+        char Subsystem[logSubsystemSize];
+        char Text[afv_native::logRecordTextSize];
+    };
+
+    /** LogRing is a single-producer, single-consumer ring of log records.
+     *
+     * The producer is the thread that owns it, and the consumer is the writer thread.
+     */
+    class LogRing {
+    public:
+        LogRing():
+                Dropped(0),
+                Orphaned(false),
+                mHead(0),
+                mTail(0),
+                mRecords(new LogRecord[logRingCapacity])
+        {
+        }
+
+        ~LogRing()
+        {
+            delete[] mRecords;
+        }
+
+        LogRing(const LogRing &copySrc) = delete;
+
+        /** claim returns the record to fill in next, or nullptr if the ring is full. */
+        LogRecord *claim()
+        {
+            const size_t head = mHead.load(std::memory_order_relaxed);
+            if (head - mTail.load(std::memory_order_acquire) >= logRingCapacity) {
+                Dropped.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+            return &mRecords[head & (logRingCapacity - 1)];
+        }
+
+        /** publish makes the record returned by claim() visible to the writer. */
+        void publish()
+        {
+            mHead.store(mHead.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        /** front returns the oldest record not yet consumed, or nullptr if the ring is empty. */
+        const LogRecord *front() const
+        {
+            const size_t tail = mTail.load(std::memory_order_relaxed);
+            if (tail == mHead.load(std::memory_order_acquire)) {
+                return nullptr;
+            }
+            return &mRecords[tail & (logRingCapacity - 1)];
+        }
+
+        void pop()
+        {
+            mTail.store(mTail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        std::atomic<uint64_t> Dropped;
+        /** Orphaned is set when the owning thread exits.  The writer frees the ring once it's drained. */
+        std::atomic<bool> Orphaned;
+
+    private:
+        std::atomic<size_t> mHead;
+        std::atomic<size_t> mTail;
+        LogRecord *mRecords;
+    };
+
+    /** DefaultLogFile is where the default logger writes - afv.log in the current directory. */
+    class DefaultLogFile {
+    public:
+        DefaultLogFile():
+                mFh(nullptr),
+                mLastTimestamp(0),
+                mDateTimeBuf{}
+        {
+        }
+
+        ~DefaultLogFile()
+        {
+            if (nullptr != mFh) {
+                fclose(mFh);
+                mFh = nullptr;
+            }
+        }
+
+        void write(time_t timestamp, const char *subsystem, const char *file, int line, const char *outputLine)
+        {
+            if (nullptr == mFh) {
+                mFh = fopen("afv.log", "at");
+            }
+            if (nullptr == mFh) {
+                return;
+            }
+            if (timestamp != mLastTimestamp || mDateTimeBuf[0] == '\0') {
+                strftime(mDateTimeBuf, sizeof(mDateTimeBuf), "%c", localtime(&timestamp));
+                mLastTimestamp = timestamp;
+            }
 #ifdef NDEBUG
-        fprintf(gLoggerFh, "%s: %s: %s\n", dateTimeBuf, subsystem, outputLine);
+            fprintf(mFh, "%s: %s: %s\n", mDateTimeBuf, subsystem, outputLine);
 #else
-        fprintf(gLoggerFh, "%s: %s: %s(%d): %s\n", dateTimeBuf, subsystem, file, line, outputLine);
+            fprintf(mFh, "%s: %s: %s(%d): %s\n", mDateTimeBuf, subsystem, file, line, outputLine);
 #endif
-        fflush(gLoggerFh);
+        }
+
+        void flush()
+        {
+            if (nullptr != mFh) {
+                fflush(mFh);
+            }
+        }
+
+    private:
+        FILE *mFh;
+        time_t mLastTimestamp;
+        char mDateTimeBuf[100];
+    };
+
+    DefaultLogFile &defaultLogFile()
+    {
+        static DefaultLogFile logFile;
+        return logFile;
     }
-}
 
-static afv_native::log_fn  gLogger = defaultLogger;
-static std::mutex gLoggerLock;
+    void defaultLogger(const char *subsystem, const char *file, int line, const char *outputLine)
+    {
+        auto &logFile = defaultLogFile();
+        logFile.write(time(nullptr), subsystem, file, line, outputLine);
+        logFile.flush();
+    }
+
+    std::atomic<afv_native::log_fn> gLogger(defaultLogger);
+    std::atomic<bool> gLogAsync(true);
+    /** gLoggerLock serialises calls into the logger on the synchronous path, and against the writer thread. */
+    afv_native::util::ProfiledMutex gLoggerLock("Log::gLoggerLock");
+    /** gRealtimeRingMisses counts lines dropped because a real-time thread had no ring and there were no spares. */
+    std::atomic<uint64_t> gRealtimeRingMisses(0);
+
+    /** LogBackend owns the per-thread rings and the writer thread that drains them. */
+    class LogBackend {
+    public:
+        LogBackend():
+                mRingsLock(),
+                mRings(),
+                mSpares(),
+                mWriterThread(),
+                mWakeLock(),
+                mWake(),
+                mStopping(false),
+                mFlushRequested(0),
+                mFlushCompleted(0),
+                mRateLimits()
+        {
+            // make sure the log file outlives us, as we write to it during our final drain.
+            defaultLogFile();
+            refillSpares();
+            mWriterThread = std::thread(&LogBackend::writerMain, this);
+            Instance.store(this);
+        }
+
+        ~LogBackend()
+        {
+            {
+                std::lock_guard<std::mutex> wakeGuard(mWakeLock);
+                mStopping = true;
+            }
+            mWake.notify_all();
+            if (mWriterThread.joinable()) {
+                mWriterThread.join();
+            }
+            Stopped.store(true);
+            Instance.store(nullptr);
+        }
+
+        void registerRing(std::shared_ptr<LogRing> ring)
+        {
+            std::lock_guard<std::mutex> ringsGuard(mRingsLock);
+            mRings.emplace_back(std::move(ring));
+        }
+
+        /** adoptSpareRing hands one of the spare rings to the calling thread, or returns an empty pointer if
+         * there are none left.  It doesn't allocate or lock, so it's safe on a real-time thread.
+         */
+        std::shared_ptr<LogRing> adoptSpareRing()
+        {
+            for (auto &spare: mSpares) {
+                int expected = SpareReady;
+                if (spare.State.compare_exchange_strong(expected, SpareBusy)) {
+                    auto ring = std::move(spare.Ring);
+                    spare.State.store(SpareEmpty);
+                    return ring;
+                }
+            }
+            return std::shared_ptr<LogRing>();
+        }
+
+        void flush()
+        {
+            if (mWriterThread.get_id() == std::this_thread::get_id()) {
+                return;
+            }
+            std::unique_lock<std::mutex> wakeGuard(mWakeLock);
+            const uint64_t ticket = ++mFlushRequested;
+            mWake.notify_all();
+            mWake.wait(wakeGuard, [this, ticket] { return mFlushCompleted >= ticket || mStopping; });
+        }
+
+        /** Stopped is set once the writer has finished, after which logging falls back to the synchronous path. */
+        static std::atomic<bool> Stopped;
+        /** Instance is the backend, once it's been constructed. */
+        static std::atomic<LogBackend *> Instance;
+
+    private:
+        enum SpareState {
+            SpareEmpty,
+            SpareReady,
+            SpareBusy,
+        };
+
+        /** SpareRing is a slot for a ring that's already registered, waiting for a real-time thread to adopt it.
+         *
+         * Whoever moves State to SpareBusy owns Ring until they set it back.
+         */
+        struct SpareRing {
+            std::atomic<int> State;
+            std::shared_ptr<LogRing> Ring;
+
+            SpareRing():
+                    State(SpareEmpty),
+                    Ring()
+            {
+            }
+        };
+
+        struct RateLimitState {
+            char Subsystem[logSubsystemSize];
+            time_t WindowStart;
+            unsigned int Count;
+            uint64_t Suppressed;
+            /** LastAdmitted is whether the last line that wasn't a continuation was written. */
+            bool LastAdmitted;
+        };
+
+        struct CallSite {
+            const char *File;
+            int Line;
+
+            bool operator==(const CallSite &other) const
+            {
+                return File == other.File && Line == other.Line;
+            }
+        };
+
+        struct CallSiteHash {
+            size_t operator()(const CallSite &site) const
+            {
+                return std::hash<const void *>()(site.File) ^ (std::hash<int>()(site.Line) << 1);
+            }
+        };
+
+        std::mutex mRingsLock;
+        std::vector<std::shared_ptr<LogRing>> mRings;
+        SpareRing mSpares[logSpareRings];
+        std::thread mWriterThread;
+
+        std::mutex mWakeLock;
+        std::condition_variable mWake;
+        bool mStopping;
+        uint64_t mFlushRequested;
+        uint64_t mFlushCompleted;
+
+        /** mRateLimits is only touched by the writer thread. */
+        std::unordered_map<CallSite, RateLimitState, CallSiteHash> mRateLimits;
+
+        void writerMain()
+        {
+            std::unique_lock<std::mutex> wakeGuard(mWakeLock);
+            for (;;) {
+                mWake.wait_for(wakeGuard, std::chrono::milliseconds(logDrainIntervalMs), [this] {
+                    return mStopping || mFlushRequested != mFlushCompleted;
+                });
+                const bool stopping = mStopping;
+                const uint64_t flushTicket = mFlushRequested;
+                wakeGuard.unlock();
+
+                afv_native::util::maintainThreadPolicy(afv_native::util::ThreadClass::Logging, "afv-log");
+                drain(stopping);
+                if (!stopping) {
+                    refillSpares();
+                }
+
+                wakeGuard.lock();
+                mFlushCompleted = flushTicket;
+                mWake.notify_all();
+                if (stopping) {
+                    return;
+                }
+            }
+        }
+
+        void drain(bool final)
+        {
+            std::vector<std::shared_ptr<LogRing>> rings;
+            {
+                std::lock_guard<std::mutex> ringsGuard(mRingsLock);
+                rings = mRings;
+            }
+
+            std::lock_guard<afv_native::util::ProfiledMutex> loggerGuard(gLoggerLock);
+            const auto logger = gLogger.load();
+            const time_t now = time(nullptr);
+            bool wroteAny = false;
+            for (const auto &ring: rings) {
+                const LogRecord *record;
+                while ((record = ring->front()) != nullptr) {
+                    if (logger != nullptr && admit(*record)) {
+                        deliver(logger, record->Timestamp, record->Subsystem, record->File, record->Line, record->Text);
+                        wroteAny = true;
+                    }
+                    ring->pop();
+                }
+                const uint64_t dropped = ring->Dropped.exchange(0, std::memory_order_relaxed);
+                if (dropped > 0 && logger != nullptr) {
+                    char noteBuf[100];
+                    snprintf(noteBuf, sizeof(noteBuf), "%llu log lines dropped - the thread's log ring was full",
+                             static_cast<unsigned long long>(dropped));
+                    deliver(logger, now, "log", __FILE__, __LINE__, noteBuf);
+                    wroteAny = true;
+                }
+            }
+            const uint64_t missed = gRealtimeRingMisses.exchange(0, std::memory_order_relaxed);
+            if (missed > 0 && logger != nullptr) {
+                char noteBuf[100];
+                snprintf(noteBuf, sizeof(noteBuf), "%llu log lines dropped - no log ring was ready for a real-time thread",
+                         static_cast<unsigned long long>(missed));
+                deliver(logger, now, "log", __FILE__, __LINE__, noteBuf);
+                wroteAny = true;
+            }
+
+            // report anything we've suppressed whose window has since closed.
+            for (auto iter = mRateLimits.begin(); iter != mRateLimits.end();) {
+                auto &state = iter->second;
+                if (final || (now - state.WindowStart) >= logRateLimitWindowSec) {
+                    if (state.Suppressed > 0 && logger != nullptr) {
+                        char noteBuf[100];
+                        snprintf(noteBuf, sizeof(noteBuf), "%llu similar lines suppressed",
+                                 static_cast<unsigned long long>(state.Suppressed));
+                        deliver(logger, now, state.Subsystem, iter->first.File, iter->first.Line, noteBuf);
+                        wroteAny = true;
+                    }
+                    iter = mRateLimits.erase(iter);
+                } else {
+                    ++iter;
+                }
+            }
+
+            if (wroteAny && logger == defaultLogger) {
+                defaultLogFile().flush();
+            }
+
+            // free the rings belonging to threads that have gone away.
+            std::lock_guard<std::mutex> ringsGuard(mRingsLock);
+            for (auto iter = mRings.begin(); iter != mRings.end();) {
+                if ((*iter)->Orphaned.load() && (*iter)->front() == nullptr) {
+                    iter = mRings.erase(iter);
+                } else {
+                    ++iter;
+                }
+            }
+        }
+
+        /** refillSpares creates and registers rings for any empty spare slots. */
+        void refillSpares()
+        {
+            for (auto &spare: mSpares) {
+                int expected = SpareEmpty;
+                if (spare.State.compare_exchange_strong(expected, SpareBusy)) {
+                    spare.Ring = std::make_shared<LogRing>();
+                    registerRing(spare.Ring);
+                    spare.State.store(SpareReady);
+                }
+            }
+        }
+
+        /** admit applies the per-call-site rate limit, returning true if the record should be written. */
+        bool admit(const LogRecord &record)
+        {
+            const CallSite site{record.File, record.Line};
+            if (record.Continuation) {
+                // the window closed part way through the entry, so we no longer know how its start fared.
+                auto stateIter = mRateLimits.find(site);
+                if (stateIter == mRateLimits.end() || stateIter->second.LastAdmitted) {
+                    return true;
+                }
+                stateIter->second.Suppressed++;
+                return false;
+            }
+            auto &state = mRateLimits[site];
+            if (state.Count == 0) {
+                memcpy(state.Subsystem, record.Subsystem, logSubsystemSize);
+                state.WindowStart = record.Timestamp;
+            }
+            state.LastAdmitted = state.Count < logRateLimitBurst;
+            if (state.LastAdmitted) {
+                state.Count++;
+                return true;
+            }
+            state.Suppressed++;
+            return false;
+        }
+
+        static void deliver(
+                afv_native::log_fn logger,
+                time_t timestamp,
+                const char *subsystem,
+                const char *file,
+                int line,
+                const char *text)
+        {
+            if (logger == defaultLogger) {
+                // batch the writes - drain() flushes once at the end.
+                defaultLogFile().write(timestamp, subsystem, file, line, text);
+            } else {
+                logger(subsystem, file, line, text);
+            }
+        }
+    };
+
+    std::atomic<bool> LogBackend::Stopped(false);
+    std::atomic<LogBackend *> LogBackend::Instance(nullptr);
+
+    LogBackend &logBackend()
+    {
+        static LogBackend backend;
+        return backend;
+    }
+
+    /** ThreadLogRing is the calling thread's handle on its ring. */
+    struct ThreadLogRing {
+        std::shared_ptr<LogRing> Ring;
+
+        ~ThreadLogRing()
+        {
+            if (Ring) {
+                Ring->Orphaned.store(true);
+            }
+        }
+    };
+
+    /** threadLogRing returns the calling thread's ring, creating and registering it the first time the thread
+     * logs.  That first call allocates - every call after that doesn't.
+     *
+     * Real-time threads never create a ring.  They adopt one of the backend's spares instead, and get nullptr if
+     * there isn't one (or the backend hasn't been started with prepareRealtimeLogging()).
+     */
+    LogRing *threadLogRing()
+    {
+        static thread_local ThreadLogRing threadRing;
+        if (LogBackend::Stopped.load()) {
+            return nullptr;
+        }
+        if (!threadRing.Ring) {
+            if (afv_native::util::isRealtimeThread()) {
+                auto *backend = LogBackend::Instance.load();
+                if (backend != nullptr) {
+                    threadRing.Ring = backend->adoptSpareRing();
+                }
+            } else {
+                threadRing.Ring = std::make_shared<LogRing>();
+                logBackend().registerRing(threadRing.Ring);
+            }
+        }
+        return threadRing.Ring.get();
+    }
+
+    void logSynchronous(const char *file, int line, const char *subsystem, const char *format, va_list ap)
+    {
+        va_list ap2;
+        va_copy(ap2, ap);
+        size_t outputLen = vsnprintf(nullptr, 0, format, ap2) + 1;
+        va_end(ap2);
+
+        std::vector<char> outBuffer(outputLen);
+        vsnprintf(outBuffer.data(), outputLen, format, ap);
+        {
+            std::lock_guard<afv_native::util::ProfiledMutex> logLock(gLoggerLock);
+            const auto logger = gLogger.load();
+            if (logger != nullptr) {
+                logger(subsystem, file, line, outBuffer.data());
+            }
+        }
+    }
+
+    /** logLineV queues (or writes) one line.  continuation marks the later lines of a multi-line entry. */
+    void logLineV(const char *file, int line, const char *subsystem, bool continuation, const char *format, va_list ap)
+    {
+        LogRing *ring = nullptr;
+        if (gLogAsync.load(std::memory_order_relaxed)) {
+            ring = threadLogRing();
+            if (ring == nullptr && !LogBackend::Stopped.load() && afv_native::util::isRealtimeThread()) {
+                // drop the line rather than allocate and take locks on the synchronous path.
+                gRealtimeRingMisses.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+        if (ring == nullptr) {
+            logSynchronous(file, line, subsystem, format, ap);
+        } else {
+            LogRecord *record = ring->claim();
+            if (record != nullptr) {
+                record->File = file;
+                record->Line = line;
+                record->Continuation = continuation;
+                record->Timestamp = time(nullptr);
+                ::strncpy(record->Subsystem, subsystem, logSubsystemSize - 1);
+                record->Subsystem[logSubsystemSize - 1] = '\0';
+                vsnprintf(record->Text, afv_native::logRecordTextSize, format, ap);
+                ring->publish();
+            }
+        }
+    }
+
+    void logLine(const char *file, int line, const char *subsystem, bool continuation, const char *format, ...)
+    {
+        if (gLogger.load() == nullptr) {
+            return;
+        }
+        va_list ap;
+        va_start(ap, format);
+        logLineV(file, line, subsystem, continuation, format, ap);
+        va_end(ap);
+    }
+}
 
 void afv_native::__Log(const char *file, int line, const char *subsystem, const char *format, ...)
 {
-    if (gLogger == nullptr) {
+    if (gLogger.load() == nullptr) {
         return;
     }
     va_list ap;
-    va_list ap2;
-            va_start(ap, format);
-    va_copy(ap2, ap);
-    size_t outputLen = vsnprintf(nullptr, 0, format, ap2)+1;
+    va_start(ap, format);
+    logLineV(file, line, subsystem, false, format, ap);
+    va_end(ap);
+}
 
-    std::vector<char> outBuffer(outputLen);
-    vsnprintf(outBuffer.data(), outputLen, format, ap);
-    {
-        std::lock_guard<std::mutex> logLock(gLoggerLock);
+std::atomic<afv_native::LogLevel> afv_native::__LogThreshold(afv_native::LogLevel::Info);
 
-        gLogger(subsystem, file, line, outBuffer.data());
-    }
-    va_end(ap2);
-    va_end(ap);
+void afv_native::setLogLevel(afv_native::LogLevel level)
+{
+    __LogThreshold.store(level);
+}
+
+afv_native::LogLevel afv_native::getLogLevel()
+{
+    return __LogThreshold.load();
 }
 
 void afv_native::setLogger(afv_native::log_fn newLogger) {
-    gLogger = newLogger;
+    gLogger.store(newLogger);
 }
 
-void afv_native::__Dumphex(const char *file, int line, const char *subsystem, const void *buf, size_t len)
+void afv_native::setLogAsynchronous(bool async)
 {
-    for (size_t i = 0; i < len;) {
-        std::stringstream lineout;
+    const bool wasAsync = gLogAsync.exchange(async);
+    if (wasAsync && !async) {
+        flushLog();
+    }
+}
 
-        // splat the address.
-        lineout << std::right << std::hex << std::setw(4) << std::setfill('0') << i;
+void afv_native::prepareRealtimeLogging()
+{
+    if (!LogBackend::Stopped.load()) {
+        logBackend();
+    }
+}
 
-        lineout << ": ";
-        for (int lineCount = 0;lineCount < 16 && i < len; lineCount++) {
-            lineout << " ";
-            lineout.width(2);
-            lineout.fill('0');
-            lineout << std::right << std::hex << std::setw(2) << std::setfill('0') << static_cast<unsigned int>(reinterpret_cast<const uint8_t *>(buf)[i++]);
-        }
-        {
-            std::lock_guard<std::mutex> logLock(gLoggerLock);
+void afv_native::flushLog()
+{
+    if (LogBackend::Stopped.load()) {
+        return;
+    }
+    logBackend().flush();
+}
 
-            gLogger(subsystem, file, line, lineout.str().c_str());
+void afv_native::__Dumphex(const char *file, int line, const char *subsystem, const void *buf, size_t len)
+{
+    const auto *bytes = reinterpret_cast<const uint8_t *>(buf);
+    bool continuation = false;
+    for (size_t i = 0; i < len;) {
+        // 4 address digits, ": ", and up to 16 " xx" groups.
+        char lineout[4 + 2 + 16 * 3 + 1];
+        int pos = snprintf(lineout, sizeof(lineout), "%04zx: ", i);
+        for (int lineCount = 0; lineCount < 16 && i < len; lineCount++) {
+            pos += snprintf(lineout + pos, sizeof(lineout) - pos, " %02x", static_cast<unsigned int>(bytes[i++]));
         }
+        // only the first line counts against the call site's rate limit.
+        logLine(file, line, subsystem, continuation, "%s", lineout);
+        continuation = true;
     }
 }
@@ -44,6 +44,23 @@
 using namespace afv_native::cryptodto;
 using namespace std;
 
+EncapsulateBuffers::EncapsulateBuffers():
+        DtoBuffer(),
+        DtoTempBuffer(),
+        HeaderBuffer(),
+        Header(),
+        CipherContext(nullptr)
+{
+}
+
+EncapsulateBuffers::~EncapsulateBuffers()
+{
+    if (CipherContext != nullptr) {
+        EVP_CIPHER_CTX_free(CipherContext);
+        CipherContext = nullptr;
+    }
+}
+
 Channel::Channel():
         ChannelTag()
 {
@@ -69,22 +86,27 @@ size_t Channel::encryptChaCha20Poly1305(
         size_t plainLen,
         const dto::Header &header,
         const unsigned char *aadIn,
-        size_t aadLen)
+        size_t aadLen,
+        EncapsulateBuffers &buffers)
 {
     size_t cipherLen = 0;
     int enc_len = 0;
     unsigned char nonce[aeadModeIVSize];
+    EVP_CIPHER_CTX *cipher_context = nullptr;
 
     makeChaCha20Poly1305Nonce(header.Sequence, nonce);
 
-    auto *cipher_context = EVP_CIPHER_CTX_new();
-    //per EVP_EncryptInit, use null keys, then set the keys later with type null.
-    if (!EVP_EncryptInit_ex(cipher_context, EVP_chacha20_poly1305(), nullptr, nullptr, nullptr)) {
-        goto abort;
-    }
-    if (!EVP_CIPHER_CTX_ctrl(cipher_context, EVP_CTRL_AEAD_SET_IVLEN, aeadModeIVSize, nullptr)) {
-        goto abort;
+    if (buffers.CipherContext == nullptr) {
+        buffers.CipherContext = EVP_CIPHER_CTX_new();
+        //per EVP_EncryptInit, use null keys, then set the keys later with type null.
+        if (buffers.CipherContext == nullptr ||
+            !EVP_EncryptInit_ex(buffers.CipherContext, EVP_chacha20_poly1305(), nullptr, nullptr, nullptr) ||
+            !EVP_CIPHER_CTX_ctrl(buffers.CipherContext, EVP_CTRL_AEAD_SET_IVLEN, aeadModeIVSize, nullptr)) {
+            goto abort;
+        }
     }
+    cipher_context = buffers.CipherContext;
+    // the cipher and IV length are kept from the first use, so we only need to load the key and nonce.
     if (!EVP_EncryptInit_ex(cipher_context, nullptr, nullptr, aeadTransmitKey, nonce)) {
         goto abort;
     }
@@ -108,11 +130,11 @@ size_t Channel::encryptChaCha20Poly1305(
 
     cipherLen += aeadModeTagSize;
 
-    EVP_CIPHER_CTX_free(cipher_context);
-
     return cipherLen;
     abort:
-    EVP_CIPHER_CTX_free(cipher_context);
+    // throw the context away so the next use starts from scratch.
+    EVP_CIPHER_CTX_free(buffers.CipherContext);
+    buffers.CipherContext = nullptr;
     return 0;
 }
 
@@ -247,15 +269,32 @@ size_t Channel::Encapsulate(
         CryptoDtoMode mode,
         unsigned char *cipherTextBufOut,
         size_t cipherTextLen)
+{
+    EncapsulateBuffers buffers;
+    return Encapsulate(plainTextBuf, plainTextLen, sequence, mode, cipherTextBufOut, cipherTextLen, buffers);
+}
+
+size_t Channel::Encapsulate(
+        const unsigned char *plainTextBuf,
+        size_t plainTextLen,
+        sequence_t sequence,
+        CryptoDtoMode mode,
+        unsigned char *cipherTextBufOut,
+        size_t cipherTextLen,
+        EncapsulateBuffers &buffers)
 {
     size_t offset = 0;
     uint16_t nLen;
     int enc_len;
 
-    msgpack::sbuffer headerBuf;
+    auto &headerBuf = buffers.HeaderBuffer;
+    headerBuf.clear();
 
-    // assemble the header and pack it.
-    dto::Header myHeader(ChannelTag, sequence, mode);
+    // assemble the header and pack it.  assigning the tag reuses the header's storage once it's grown.
+    auto &myHeader = buffers.Header;
+    myHeader.ChannelTag = ChannelTag;
+    myHeader.Sequence = sequence;
+    myHeader.Mode = static_cast<int>(mode);
     msgpack::pack(headerBuf, myHeader);
 
     if (headerBuf.size() > UINT16_MAX) {
@@ -280,7 +319,7 @@ size_t Channel::Encapsulate(
             return 0;
         }
         enc_len = encryptChaCha20Poly1305(
-                cipherTextBufOut + offset, plainTextBuf, plainTextLen, myHeader, cipherTextBufOut, offset);
+                cipherTextBufOut + offset, plainTextBuf, plainTextLen, myHeader, cipherTextBufOut, offset, buffers);
         if (0 == enc_len) {
             return 0;
         }
@@ -53,6 +53,7 @@
 #endif
 
 #include "afv-native/Log.h"
+#include "afv-native/util/Trace.h"
 
 using namespace afv_native::cryptodto;
 using namespace std;
@@ -61,16 +62,25 @@ UDPChannel::UDPChannel(struct event_base *evBase, int receiveSequenceHistorySize
         Channel(),
         mAddress(),
         mDatagramRxBuffer(nullptr),
+        mDatagramTxBuffer(nullptr),
+        mTxBuffers(),
+        mTxBuffersBusy(false),
         mUDPSocket(-1),
         mEvBase(evBase),
         mSocketEvent(nullptr),
         mTxSequence(0),
         receiveSequence(0, receiveSequenceHistorySize),
         mAcceptableCiphers(1U << cryptodto::CryptoDtoMode::CryptoModeChaCha20Poly1305),
+        mCounters(),
+        mDtoHandlerLock(),
         mDtoHandlers(),
-        mLastErrno(0)
+        mLastErrno(0),
+        mEncapsulateLatency(nullptr),
+        mSendLatency(nullptr)
 {
+    resetStatistics();
     mDatagramRxBuffer = new unsigned char[maxPermittedDatagramSize];
+    mDatagramTxBuffer = new unsigned char[maxPermittedDatagramSize];
 }
 
 UDPChannel::~UDPChannel()
@@ -78,13 +88,37 @@ UDPChannel::~UDPChannel()
     close();
     delete[] mDatagramRxBuffer;
     mDatagramRxBuffer = nullptr;
+    delete[] mDatagramTxBuffer;
+    mDatagramTxBuffer = nullptr;
 }
 
 void UDPChannel::registerDtoHandler(
         const string &dtoName,
         std::function<void(const unsigned char *data, size_t len)> callback)
 {
-    mDtoHandlers[dtoName] = callback;
+    std::lock_guard<std::mutex> handlerGuard(mDtoHandlerLock);
+    mDtoHandlers[dtoName].Callback = std::move(callback);
+}
+
+void UDPChannel::sendDatagram(const unsigned char *dgBuffer, size_t dgSize)
+{
+    util::ScopedLatency sendTiming(mSendLatency);
+    TRACE_SCOPE("network", "UDPChannel::send");
+    auto sent = ::send(mUDPSocket, reinterpret_cast<const char *>(dgBuffer), dgSize, 0);
+    if (sent < 0) {
+        const auto sendErr = evutil_socket_geterror(mUDPSocket);
+        if (isWouldBlock(sendErr)) {
+            bump(mCounters.SendWouldBlock);
+        } else {
+            bump(mCounters.SendErrors);
+        }
+    } else {
+        bump(mCounters.PacketsSent);
+        bump(mCounters.BytesSent, static_cast<uint64_t>(sent));
+        if (static_cast<size_t>(sent) < dgSize) {
+            bump(mCounters.SendShortWrites);
+        }
+    }
 }
 
 void UDPChannel::evReadCallback(evutil_socket_t fd, short events, void *arg)
@@ -95,18 +129,18 @@ void UDPChannel::evReadCallback(evutil_socket_t fd, short events, void *arg)
 
 void UDPChannel::readCallback()
 {
+    TRACE_SCOPE("network", "UDPChannel::read");
     int dgSize = ::recv(
             mUDPSocket, reinterpret_cast<char *>(mDatagramRxBuffer), maxPermittedDatagramSize, 0);
     if (dgSize < 0) {
         mLastErrno = evutil_socket_geterror(mUDPSocket);
-        LOG("udpchannel:readCallback", "recv error: %s", evutil_socket_error_to_string(mLastErrno));
+        bump(mCounters.ReceiveErrors);
         return;
     }
+    bump(mCounters.PacketsReceived);
+    bump(mCounters.BytesReceived, static_cast<uint64_t>(dgSize));
     if (dgSize > maxPermittedDatagramSize) {
-        LOG("udpchannel:readCallback",
-                "recv'd datagram %d bytes, exceeding configured maximum of %d",
-                dgSize,
-                maxPermittedDatagramSize);
+        bump(mCounters.DroppedOversize);
         return;
     }
     std::string channelTag, dtoName;
@@ -115,47 +149,51 @@ void UDPChannel::readCallback()
     CryptoDtoMode cipherMode;
 
     if (!Decapsulate(mDatagramRxBuffer, dgSize, channelTag, seq, cipherMode, dtoName, dtoBuf)) {
-        LOG("udpchannel:readCallback", "recv'd invalid cryptodto frame.  Discarding");
+        bump(mCounters.DroppedInvalidFrame);
         return;
     }
     if (!RxModeEnabled(cipherMode)) {
-        LOG("udpchannel:readCallback", "got frame encrypted with undesired mode");
+        bump(mCounters.DroppedCipherMode);
         return;
     }
     if (channelTag != ChannelTag) {
-        LOG("udpchannel:readCallback", "recv'd with invalid Tag.  Discarding");
+        bump(mCounters.DroppedChannelTag);
         return;
     }
     auto rxOk = receiveSequence.Received(seq);
     switch (rxOk) {
     case ReceiveOutcome::Before:
-        LOG("udpchannel:readCallback", "recv'd duplicate sequence %d.  Discarding.", seq);
+        bump(mCounters.DroppedDuplicate);
         return;
     case ReceiveOutcome::OK:
         break;
     case ReceiveOutcome::Overflow:
+        bump(mCounters.SequenceOverflows);
         break;
     }
     // validate that the packet has a valid payload.
     if (dtoBuf.size() < 2) {
-        LOG("udpchannel:readCallback", "internal dto had bad length (too short)");
+        bump(mCounters.DroppedBadLength);
         return;
     }
     uint16_t dtoSize;
     ::memcpy(&dtoSize, dtoBuf.data(), 2);
     if (dtoSize != dtoBuf.size()-2) {
-        LOG("udpchannel:readCallback", "internal dto had bad length (length encoded mismatched datagram size)");
+        bump(mCounters.DroppedBadLength);
         return;
     }
     auto dtoIter = mDtoHandlers.find(dtoName);
     if (dtoIter == mDtoHandlers.end()) {
-        LOG("udpchannel:readCallback", "no handler for packet-type %s", dtoName.c_str());
+        bump(mCounters.DroppedUnknownDto);
         return;
     } else {
+        bump(mCounters.DtosDispatched);
+        TRACE_SCOPE("network", "UDPChannel::dispatch");
+        bump(dtoIter->second.Dispatched);
         if (dtoBuf.size() == 2) {
-            dtoIter->second(nullptr, 0);
+            dtoIter->second.Callback(nullptr, 0);
         } else {
-            dtoIter->second(reinterpret_cast<const unsigned char *>(dtoBuf.data())+2, dtoBuf.size()-2);
+            dtoIter->second.Callback(reinterpret_cast<const unsigned char *>(dtoBuf.data())+2, dtoBuf.size()-2);
         }
     }
 }
@@ -163,7 +201,7 @@ void UDPChannel::readCallback()
 bool UDPChannel::open()
 {
     if (mAddress.empty()) {
-        LOG("udpchannel", "tried to open without address set");
+        LOGERROR("udpchannel", "tried to open without address set");
         return false;
     }
     struct sockaddr_storage saddr;
@@ -173,7 +211,7 @@ bool UDPChannel::open()
         mUDPSocket = ::socket(saddr.ss_family, SOCK_DGRAM, 0);
         if (mUDPSocket < 0) {
             mLastErrno = EVUTIL_SOCKET_ERROR();
-            LOG("udpchannel", "Couldn't create UDP socket: %s", evutil_socket_error_to_string(errno));
+            LOGERROR("udpchannel", "Couldn't create UDP socket: %s", evutil_socket_error_to_string(errno));
             close();
             return false;
         }
@@ -183,7 +221,7 @@ bool UDPChannel::open()
             struct sockaddr_in6 baddr = {AF_INET6, 0, 0, IN6ADDR_ANY_INIT, 0,};
             if (::bind(mUDPSocket, reinterpret_cast<struct sockaddr *>(&baddr), sizeof(baddr))) {
                 mLastErrno = evutil_socket_geterror(mUDPSocket);
-                LOG("udpchannel", "couldn't bind IPv6 port: %s", evutil_socket_error_to_string(errno));
+                LOGERROR("udpchannel", "couldn't bind IPv6 port: %s", evutil_socket_error_to_string(errno));
                 close();
                 return false;
             }
@@ -192,14 +230,14 @@ bool UDPChannel::open()
             struct sockaddr_in baddr = {AF_INET, 0, INADDR_ANY,};
             if (::bind(mUDPSocket, reinterpret_cast<struct sockaddr *>(&baddr), sizeof(baddr))) {
                 mLastErrno = evutil_socket_geterror(mUDPSocket);
-                LOG("udpchannel", "couldn't bind IPv4 port: %s", evutil_socket_error_to_string(errno));
+                LOGERROR("udpchannel", "couldn't bind IPv4 port: %s", evutil_socket_error_to_string(errno));
                 close();
                 return false;
             }
         }
         if (::connect(mUDPSocket, reinterpret_cast<struct sockaddr *>(&saddr), saddr_len)) {
             mLastErrno = evutil_socket_geterror(mUDPSocket);
-            LOG("udpchannel", "couldn't connect to endpoint address \"%s\": %s", mAddress.c_str(), evutil_socket_error_to_string(errno));
+            LOGERROR("udpchannel", "couldn't connect to endpoint address \"%s\": %s", mAddress.c_str(), evutil_socket_error_to_string(errno));
             close();
             return false;
         }
@@ -271,6 +309,7 @@ bool UDPChannel::RxModeEnabled(CryptoDtoMode mode) const
 
 void UDPChannel::unregisterDtoHandler(const std::string &dtoName)
 {
+    std::lock_guard<std::mutex> handlerGuard(mDtoHandlerLock);
     mDtoHandlers.erase(dtoName);
 }
 
@@ -287,3 +326,88 @@ void UDPChannel::setChannelConfig(const dto::ChannelConfig &config) {
     }
     Channel::setChannelConfig(config);
 }
+
+void UDPChannel::setLatencyHistograms(util::LatencyHistogram *encapsulate, util::LatencyHistogram *send)
+{
+    mEncapsulateLatency = encapsulate;
+    mSendLatency = send;
+}
+
+bool UDPChannel::isWouldBlock(int socketError)
+{
+#ifdef WIN32
+    return socketError == WSAEWOULDBLOCK;
+#else
+    return socketError == EAGAIN || socketError == EWOULDBLOCK;
+#endif
+}
+
+UDPChannelStats UDPChannel::getStatistics() const
+{
+    UDPChannelStats stats;
+    stats.PacketsReceived = mCounters.PacketsReceived.load(std::memory_order_relaxed);
+    stats.BytesReceived = mCounters.BytesReceived.load(std::memory_order_relaxed);
+    stats.PacketsSent = mCounters.PacketsSent.load(std::memory_order_relaxed);
+    stats.BytesSent = mCounters.BytesSent.load(std::memory_order_relaxed);
+    stats.ReceiveErrors = mCounters.ReceiveErrors.load(std::memory_order_relaxed);
+    stats.SendErrors = mCounters.SendErrors.load(std::memory_order_relaxed);
+    stats.SendWouldBlock = mCounters.SendWouldBlock.load(std::memory_order_relaxed);
+    stats.SendShortWrites = mCounters.SendShortWrites.load(std::memory_order_relaxed);
+    stats.DroppedOversize = mCounters.DroppedOversize.load(std::memory_order_relaxed);
+    stats.DroppedInvalidFrame = mCounters.DroppedInvalidFrame.load(std::memory_order_relaxed);
+    stats.DroppedCipherMode = mCounters.DroppedCipherMode.load(std::memory_order_relaxed);
+    stats.DroppedChannelTag = mCounters.DroppedChannelTag.load(std::memory_order_relaxed);
+    stats.DroppedDuplicate = mCounters.DroppedDuplicate.load(std::memory_order_relaxed);
+    stats.DroppedBadLength = mCounters.DroppedBadLength.load(std::memory_order_relaxed);
+    stats.DroppedUnknownDto = mCounters.DroppedUnknownDto.load(std::memory_order_relaxed);
+    stats.SequenceOverflows = mCounters.SequenceOverflows.load(std::memory_order_relaxed);
+    stats.DtosDispatched = mCounters.DtosDispatched.load(std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> handlerGuard(mDtoHandlerLock);
+        for (const auto &handler: mDtoHandlers) {
+            const auto dispatched = handler.second.Dispatched.load(std::memory_order_relaxed);
+            if (dispatched > 0) {
+                stats.DtosReceived[handler.first] = dispatched;
+            }
+        }
+    }
+    return stats;
+}
+
+void UDPChannel::resetStatistics()
+{
+    for (auto *counter: {
+            &mCounters.PacketsReceived, &mCounters.BytesReceived, &mCounters.PacketsSent, &mCounters.BytesSent,
+            &mCounters.ReceiveErrors, &mCounters.SendErrors, &mCounters.SendWouldBlock, &mCounters.SendShortWrites,
+            &mCounters.DroppedOversize, &mCounters.DroppedInvalidFrame, &mCounters.DroppedCipherMode,
+            &mCounters.DroppedChannelTag, &mCounters.DroppedDuplicate, &mCounters.DroppedBadLength,
+            &mCounters.DroppedUnknownDto, &mCounters.SequenceOverflows, &mCounters.DtosDispatched}) {
+        counter->store(0, std::memory_order_relaxed);
+    }
+    std::lock_guard<std::mutex> handlerGuard(mDtoHandlerLock);
+    for (auto &handler: mDtoHandlers) {
+        handler.second.Dispatched.store(0, std::memory_order_relaxed);
+    }
+}
+
+UDPChannelStats::UDPChannelStats():
+        PacketsReceived(0),
+        BytesReceived(0),
+        PacketsSent(0),
+        BytesSent(0),
+        ReceiveErrors(0),
+        SendErrors(0),
+        SendWouldBlock(0),
+        SendShortWrites(0),
+        DroppedOversize(0),
+        DroppedInvalidFrame(0),
+        DroppedCipherMode(0),
+        DroppedChannelTag(0),
+        DroppedDuplicate(0),
+        DroppedBadLength(0),
+        DroppedUnknownDto(0),
+        SequenceOverflows(0),
+        DtosDispatched(0),
+        DtosReceived()
+{
+}
@@ -0,0 +1,216 @@
+/* event/EventLoopThread.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "afv-native/event/EventLoopThread.h"
+
+#include <cstring>
+#include <future>
+
+#ifndef WIN32
+#include <sys/socket.h>
+#endif
+
+#include "afv-native/Log.h"
+#include "afv-native/util/ThreadPolicy.h"
+#include "afv-native/util/Trace.h"
+
+using namespace afv_native::event;
+
+namespace {
+    thread_local const EventLoopThread *tCurrentLoop = nullptr;
+}
+
+EventLoopThread::EventLoopThread(const char *threadName):
+        mThreadName(threadName),
+        mEvBase(event_base_new()),
+        mWakeSockets{-1, -1},
+        mWakeEvent(nullptr),
+        mHousekeepingEvent(nullptr),
+        mCommands(),
+        mWakePending(false),
+        mRunning(false),
+        mThread()
+{
+#ifdef WIN32
+    const int socketFamily = AF_INET;
+#else
+    const int socketFamily = AF_UNIX;
+#endif
+    if (evutil_socketpair(socketFamily, SOCK_STREAM, 0, mWakeSockets) == 0) {
+        evutil_make_socket_nonblocking(mWakeSockets[0]);
+        evutil_make_socket_nonblocking(mWakeSockets[1]);
+        mWakeEvent = event_new(mEvBase, mWakeSockets[0], EV_READ | EV_PERSIST, EventLoopThread::evWakeCallback, this);
+        event_add(mWakeEvent, nullptr);
+    } else {
+        // without the wakeup, posted commands still run - just only when the housekeeping timer next fires.
+        LOGERROR("EventLoopThread", "couldn't create wakeup sockets: %s",
+                 evutil_socket_error_to_string(EVUTIL_SOCKET_ERROR()));
+        mWakeSockets[0] = mWakeSockets[1] = -1;
+    }
+
+    mHousekeepingEvent = event_new(mEvBase, -1, EV_PERSIST, EventLoopThread::evHousekeepingCallback, this);
+    struct timeval interval = {
+            housekeepingIntervalMs / 1000,
+            (housekeepingIntervalMs % 1000) * 1000
+    };
+    event_add(mHousekeepingEvent, &interval);
+}
+
+EventLoopThread::~EventLoopThread()
+{
+    stop();
+    if (mHousekeepingEvent != nullptr) {
+        event_del(mHousekeepingEvent);
+        event_free(mHousekeepingEvent);
+    }
+    if (mWakeEvent != nullptr) {
+        event_del(mWakeEvent);
+        event_free(mWakeEvent);
+    }
+    for (auto &wakeSocket: mWakeSockets) {
+        if (wakeSocket >= 0) {
+            evutil_closesocket(wakeSocket);
+        }
+    }
+    event_base_free(mEvBase);
+}
+
+struct event_base *EventLoopThread::getEventBase() const
+{
+    return mEvBase;
+}
+
+void EventLoopThread::start()
+{
+    if (mThread.joinable()) {
+        return;
+    }
+    mRunning.store(true);
+    mThread = std::thread(&EventLoopThread::run, this);
+}
+
+void EventLoopThread::stop()
+{
+    if (!mThread.joinable()) {
+        return;
+    }
+    post([this]() {
+        event_base_loopbreak(mEvBase);
+    });
+    mThread.join();
+    mRunning.store(false);
+}
+
+bool EventLoopThread::isRunning() const
+{
+    return mRunning.load();
+}
+
+bool EventLoopThread::isLoopThread() const
+{
+    return tCurrentLoop == this;
+}
+
+void EventLoopThread::post(std::function<void()> command)
+{
+    mCommands.push(std::move(command));
+    wake();
+}
+
+void EventLoopThread::call(const std::function<void()> &command)
+{
+    if (isLoopThread() || !isRunning()) {
+        command();
+        return;
+    }
+    std::promise<void> done;
+    auto doneFuture = done.get_future();
+    post([&command, &done]() {
+        command();
+        done.set_value();
+    });
+    doneFuture.wait();
+}
+
+void EventLoopThread::run()
+{
+    tCurrentLoop = this;
+    util::maintainThreadPolicy(util::ThreadClass::Network, mThreadName);
+    // commands only ever run from inside the loop - event_base_loop() forgets any loopbreak made before it
+    // starts, so running stop()'s here would lose it.  Anything posted before start() has already sent the
+    // wakeup, so it gets picked up straight away.
+    event_base_loop(mEvBase, 0);
+    // anything that raced in with the stop request.
+    runCommands();
+    tCurrentLoop = nullptr;
+}
+
+void EventLoopThread::wake()
+{
+    if (mWakeSockets[1] < 0) {
+        return;
+    }
+    if (!mWakePending.exchange(true)) {
+        const char wakeByte = 0;
+        ::send(mWakeSockets[1], &wakeByte, 1, 0);
+    }
+}
+
+void EventLoopThread::runCommands()
+{
+    TRACE_SCOPE("event", "EventLoopThread commands");
+    std::function<void()> command;
+    while (mCommands.pop(command)) {
+        command();
+        // let go of whatever it captured now, rather than when the next one comes along.
+        command = nullptr;
+    }
+}
+
+void EventLoopThread::evWakeCallback(evutil_socket_t fd, short events, void *arg)
+{
+    auto *loop = reinterpret_cast<EventLoopThread *>(arg);
+    char drainBuffer[64];
+    while (::recv(fd, drainBuffer, sizeof(drainBuffer), 0) > 0) {
+    }
+    // clear this before running the commands, so anything posted whilst they run wakes us again.
+    loop->mWakePending.store(false);
+    util::maintainThreadPolicy(util::ThreadClass::Network, loop->mThreadName);
+    loop->runCommands();
+}
+
+void EventLoopThread::evHousekeepingCallback(evutil_socket_t fd, short events, void *arg)
+{
+    auto *loop = reinterpret_cast<EventLoopThread *>(arg);
+    util::maintainThreadPolicy(util::ThreadClass::Network, loop->mThreadName);
+    loop->runCommands();
+}
@@ -33,16 +33,26 @@
 
 #include "afv-native/event/EventTimer.h"
 
+#include "afv-native/event/SimulatedEventDriver.h"
+#include "afv-native/util/Trace.h"
+
 using namespace afv_native::event;
 
 void EventTimer::evCallback(evutil_socket_t fd, short events, void *arg)
 {
     auto *eventObj = reinterpret_cast<EventTimer *>(arg);
+    TRACE_SCOPE("event", "EventTimer");
     eventObj->triggered();
 }
 
-EventTimer::EventTimer(struct event_base *evBase)
+EventTimer::EventTimer(struct event_base *evBase):
+        mEvent(nullptr),
+        mSimDriver(SimulatedEventDriver::forBase(evBase))
 {
+    if (mSimDriver != nullptr) {
+        mSimDriver->attach(this);
+        return;
+    }
     mEvent = event_new(evBase,
             -1, // fd
             0, // event flags
@@ -52,17 +62,35 @@ EventTimer::EventTimer(struct event_base *evBase)
 
 EventTimer::~EventTimer()
 {
-    event_del(mEvent);
-    event_free(mEvent);
+    if (mSimDriver != nullptr) {
+        mSimDriver->detach(this);
+    }
+    if (mEvent != nullptr) {
+        event_del(mEvent);
+        event_free(mEvent);
+    }
 }
 
 bool EventTimer::pending()
 {
+    if (mSimDriver != nullptr) {
+        return mSimDriver->isScheduled(this);
+    }
+    if (mEvent == nullptr) {
+        return false;
+    }
     return event_pending(mEvent, EV_TIMEOUT, nullptr);
 }
 
 void EventTimer::enable(unsigned int delayMs)
 {
+    if (mSimDriver != nullptr) {
+        mSimDriver->schedule(this, delayMs);
+        return;
+    }
+    if (mEvent == nullptr) {
+        return;
+    }
     struct timeval timeout = {
             static_cast<int>(delayMs)/1000,
             static_cast<int>(delayMs%1000)*1000
@@ -72,5 +100,12 @@ void EventTimer::enable(unsigned int delayMs)
 
 void EventTimer::disable()
 {
+    if (mSimDriver != nullptr) {
+        mSimDriver->cancel(this);
+        return;
+    }
+    if (mEvent == nullptr) {
+        return;
+    }
     event_del(mEvent);
 }
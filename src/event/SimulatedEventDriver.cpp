@@ -0,0 +1,217 @@
+/* event/SimulatedEventDriver.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "afv-native/event/SimulatedEventDriver.h"
+
+#include "afv-native/event/EventTimer.h"
+#include "afv-native/Log.h"
+
+using namespace afv_native;
+using namespace afv_native::event;
+
+static std::mutex gDriverRegistryLock;
+static std::map<struct event_base *, SimulatedEventDriver *> gDriverRegistry;
+
+SimulatedEventDriver::SimulatedEventDriver(struct event_base *evBase, util::monotime_t startTime):
+        mEvBase(evBase),
+        mNow(startTime),
+        mClockInstalled(false),
+        mScheduleLock(),
+        mNextSequence(0),
+        mSchedule(),
+        mScheduledTimers(),
+        mAttachedTimers()
+{
+    std::lock_guard<std::mutex> registryLock(gDriverRegistryLock);
+    auto &slot = gDriverRegistry[mEvBase];
+    if (slot != nullptr) {
+        LOG("SimulatedEventDriver", "replacing existing driver for event base %p", static_cast<void *>(mEvBase));
+    }
+    slot = this;
+}
+
+SimulatedEventDriver::~SimulatedEventDriver()
+{
+    {
+        std::lock_guard<std::mutex> registryLock(gDriverRegistryLock);
+        auto regIter = gDriverRegistry.find(mEvBase);
+        if (regIter != gDriverRegistry.end() && regIter->second == this) {
+            gDriverRegistry.erase(regIter);
+        }
+    }
+    if (mClockInstalled) {
+        util::monotime_set_source(nullptr);
+    }
+    std::lock_guard<std::mutex> scheduleLock(mScheduleLock);
+    for (auto *timer: mAttachedTimers) {
+        timer->mSimDriver = nullptr;
+    }
+    mAttachedTimers.clear();
+    mSchedule.clear();
+    mScheduledTimers.clear();
+}
+
+SimulatedEventDriver *SimulatedEventDriver::forBase(struct event_base *evBase)
+{
+    std::lock_guard<std::mutex> registryLock(gDriverRegistryLock);
+    auto regIter = gDriverRegistry.find(evBase);
+    if (regIter == gDriverRegistry.end()) {
+        return nullptr;
+    }
+    return regIter->second;
+}
+
+util::monotime_t SimulatedEventDriver::now() const
+{
+    return mNow.load(std::memory_order_acquire);
+}
+
+void SimulatedEventDriver::installClock()
+{
+    util::monotime_set_source(this);
+    mClockInstalled = true;
+}
+
+void SimulatedEventDriver::attach(EventTimer *timer)
+{
+    std::lock_guard<std::mutex> scheduleLock(mScheduleLock);
+    mAttachedTimers.insert(timer);
+}
+
+void SimulatedEventDriver::detach(EventTimer *timer)
+{
+    std::lock_guard<std::mutex> scheduleLock(mScheduleLock);
+    auto schedIter = mScheduledTimers.find(timer);
+    if (schedIter != mScheduledTimers.end()) {
+        mSchedule.erase(schedIter->second);
+        mScheduledTimers.erase(schedIter);
+    }
+    mAttachedTimers.erase(timer);
+}
+
+void SimulatedEventDriver::schedule(EventTimer *timer, unsigned int delayMs)
+{
+    std::lock_guard<std::mutex> scheduleLock(mScheduleLock);
+    // like event_add(), re-arming a pending timer replaces its deadline.
+    auto schedIter = mScheduledTimers.find(timer);
+    if (schedIter != mScheduledTimers.end()) {
+        mSchedule.erase(schedIter->second);
+        mScheduledTimers.erase(schedIter);
+    }
+    const ScheduleKey key(now() + delayMs, mNextSequence++);
+    mSchedule.emplace(key, timer);
+    mScheduledTimers.emplace(timer, key);
+}
+
+void SimulatedEventDriver::cancel(EventTimer *timer)
+{
+    std::lock_guard<std::mutex> scheduleLock(mScheduleLock);
+    auto schedIter = mScheduledTimers.find(timer);
+    if (schedIter != mScheduledTimers.end()) {
+        mSchedule.erase(schedIter->second);
+        mScheduledTimers.erase(schedIter);
+    }
+}
+
+bool SimulatedEventDriver::isScheduled(const EventTimer *timer) const
+{
+    std::lock_guard<std::mutex> scheduleLock(mScheduleLock);
+    return mScheduledTimers.find(timer) != mScheduledTimers.end();
+}
+
+size_t SimulatedEventDriver::pendingTimers() const
+{
+    std::lock_guard<std::mutex> scheduleLock(mScheduleLock);
+    return mSchedule.size();
+}
+
+util::monotime_t SimulatedEventDriver::nextDeadline() const
+{
+    std::lock_guard<std::mutex> scheduleLock(mScheduleLock);
+    if (mSchedule.empty()) {
+        return -1;
+    }
+    return mSchedule.begin()->first.first;
+}
+
+bool SimulatedEventDriver::fireNext(util::monotime_t limit)
+{
+    EventTimer *timer;
+    {
+        std::lock_guard<std::mutex> scheduleLock(mScheduleLock);
+        if (mSchedule.empty()) {
+            return false;
+        }
+        auto first = mSchedule.begin();
+        if (first->first.first > limit) {
+            return false;
+        }
+        timer = first->second;
+        if (first->first.first > now()) {
+            mNow.store(first->first.first, std::memory_order_release);
+        }
+        mScheduledTimers.erase(timer);
+        mSchedule.erase(first);
+    }
+    // the lock is released so the callback may re-arm, cancel or destroy
+    // timers (including itself).
+    timer->triggered();
+    return true;
+}
+
+size_t SimulatedEventDriver::advanceTo(util::monotime_t targetTime)
+{
+    size_t fired = 0;
+    while (fireNext(targetTime)) {
+        fired++;
+    }
+    if (targetTime > now()) {
+        mNow.store(targetTime, std::memory_order_release);
+    }
+    return fired;
+}
+
+size_t SimulatedEventDriver::advance(util::monotime_t deltaMs)
+{
+    return advanceTo(now() + deltaMs);
+}
+
+size_t SimulatedEventDriver::runUntilIdle(util::monotime_t limitMs)
+{
+    const util::monotime_t limit = now() + limitMs;
+    size_t fired = 0;
+    while (fireNext(limit)) {
+        fired++;
+    }
+    return fired;
+}
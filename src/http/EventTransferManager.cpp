@@ -37,6 +37,7 @@
 
 #include "afv-native/http/Request.h"
 #include "afv-native/http/TransferManager.h"
+#include "afv-native/util/Trace.h"
 
 using namespace afv_native::http;
 using namespace std;
@@ -117,6 +118,7 @@ EventTransferManager::socketCallback(CURL *easy, curl_socket_t s, int what, void
 void
 EventTransferManager::evSocketCallback(evutil_socket_t fd, short events, void *arg)
 {
+    TRACE_SCOPE("http", "EventTransferManager::socket");
     auto *etm = reinterpret_cast<EventTransferManager *>(arg);
     int running_handles = 0;
     int curl_evmask = 0;
@@ -133,6 +135,7 @@ EventTransferManager::evSocketCallback(evutil_socket_t fd, short events, void *a
 void
 EventTransferManager::evTimerCallback(evutil_socket_t fd, short events, void *arg)
 {
+    TRACE_SCOPE("http", "EventTransferManager::timer");
     auto *etm = reinterpret_cast<EventTransferManager *>(arg);
     int running_handles = 0;
 
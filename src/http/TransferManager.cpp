@@ -36,6 +36,7 @@
 #include <curl/curl.h>
 
 #include "afv-native/http/Request.h"
+#include "afv-native/util/Trace.h"
 
 using namespace afv_native::http;
 
@@ -86,6 +87,7 @@ TransferManager::processPendingMultiEvents()
             curl_multi_remove_handle(mCurlMultiHandle, msgCopy.easy_handle);
             // remove the shared_ptr hold we've got on the request itself.
             mPendingTransfers.erase(msgCopy.easy_handle);
+            util::traceAsyncEnd("http", "transfer", req);
             // and notify the request object.
             if (msgCopy.data.result == CURLE_OK) {
                 req->notifyTransferCompleted();
@@ -113,6 +115,7 @@ TransferManager::HandleRequest(Request *req)
     if (req) {
         auto curlHandle = req->getCurlHandle();
         mPendingTransfers[curlHandle] = req;
+        util::traceAsyncBegin("http", "transfer", req);
         curl_multi_add_handle(mCurlMultiHandle, curlHandle);
     }
 }
@@ -0,0 +1,143 @@
+/* util/LatencyHistogram.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "afv-native/util/LatencyHistogram.h"
+
+using namespace afv_native::util;
+
+const size_t LatencyHistogramSnapshot::bucketCount;
+
+LatencyHistogramSnapshot::LatencyHistogramSnapshot():
+        Buckets{},
+        Count(0),
+        TotalUs(0),
+        MaxUs(0)
+{
+}
+
+double LatencyHistogramSnapshot::getMeanUs() const
+{
+    if (Count == 0) {
+        return 0.0;
+    }
+    return static_cast<double>(TotalUs) / static_cast<double>(Count);
+}
+
+uint32_t LatencyHistogramSnapshot::getPercentileUs(double percentile) const
+{
+    if (Count == 0) {
+        return 0;
+    }
+    if (percentile < 0.0) {
+        percentile = 0.0;
+    } else if (percentile > 100.0) {
+        percentile = 100.0;
+    }
+    // rank is 1-based - the smallest number of samples that covers the requested percentile.
+    uint64_t rank = static_cast<uint64_t>(percentile / 100.0 * static_cast<double>(Count) + 0.5);
+    if (rank < 1) {
+        rank = 1;
+    }
+    uint64_t seen = 0;
+    for (size_t i = 0; i < bucketCount; i++) {
+        seen += Buckets[i];
+        if (seen >= rank) {
+            const uint32_t upperBound = getBucketUpperBoundUs(i);
+            return (upperBound < MaxUs) ? upperBound : MaxUs;
+        }
+    }
+    return MaxUs;
+}
+
+uint32_t LatencyHistogramSnapshot::getBucketUpperBoundUs(size_t bucket)
+{
+    if (bucket >= bucketCount - 1) {
+        return UINT32_MAX;
+    }
+    return static_cast<uint32_t>(1U) << bucket;
+}
+
+size_t LatencyHistogramSnapshot::getBucketForUs(uint32_t us)
+{
+    size_t bucket = 0;
+    while (us != 0 && bucket < bucketCount - 1) {
+        us >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+LatencyHistogram::LatencyHistogram():
+        mEnabled(false),
+        mBuckets{},
+        mCount(0),
+        mTotalUs(0),
+        mMaxUs(0),
+        mPendingUs(0)
+{
+    reset();
+}
+
+void LatencyHistogram::record(uint32_t us)
+{
+    mBuckets[LatencyHistogramSnapshot::getBucketForUs(us)].fetch_add(1, std::memory_order_relaxed);
+    mCount.fetch_add(1, std::memory_order_relaxed);
+    mTotalUs.fetch_add(us, std::memory_order_relaxed);
+    mPendingUs.fetch_add(us, std::memory_order_relaxed);
+    uint32_t oldMax = mMaxUs.load(std::memory_order_relaxed);
+    while (us > oldMax && !mMaxUs.compare_exchange_weak(oldMax, us, std::memory_order_relaxed)) {
+    }
+}
+
+LatencyHistogramSnapshot LatencyHistogram::snapshot() const
+{
+    LatencyHistogramSnapshot snap;
+    for (size_t i = 0; i < LatencyHistogramSnapshot::bucketCount; i++) {
+        snap.Buckets[i] = mBuckets[i].load(std::memory_order_relaxed);
+    }
+    snap.Count = mCount.load(std::memory_order_relaxed);
+    snap.TotalUs = mTotalUs.load(std::memory_order_relaxed);
+    snap.MaxUs = mMaxUs.load(std::memory_order_relaxed);
+    return snap;
+}
+
+void LatencyHistogram::reset()
+{
+    for (auto &bucket: mBuckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    mCount.store(0, std::memory_order_relaxed);
+    mTotalUs.store(0, std::memory_order_relaxed);
+    mMaxUs.store(0, std::memory_order_relaxed);
+    mPendingUs.store(0, std::memory_order_relaxed);
+}
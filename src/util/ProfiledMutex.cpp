@@ -0,0 +1,135 @@
+/* util/ProfiledMutex.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "afv-native/util/ProfiledMutex.h"
+
+#include <map>
+#include <memory>
+
+using namespace afv_native::util;
+
+LockStats::LockStats():
+        Name(),
+        Acquisitions(0),
+        ContendedAcquisitions(0),
+        TotalWaitUs(0),
+        MaxWaitUs(0),
+        TotalHoldUs(0),
+        MaxHoldUs(0)
+{
+}
+
+#ifdef AFV_NATIVE_PROFILE_LOCKS
+namespace {
+    struct LockRegistry {
+        std::mutex Lock;
+        std::map<std::string, std::unique_ptr<LockCounters>> Counters;
+    };
+
+    LockRegistry &lockRegistry()
+    {
+        // never destroyed, as locks with static storage (like the logger's) may still be used during exit.
+        static auto *registry = new LockRegistry();
+        return *registry;
+    }
+
+    void clearCounters(LockCounters &counters)
+    {
+        counters.Acquisitions.store(0, std::memory_order_relaxed);
+        counters.ContendedAcquisitions.store(0, std::memory_order_relaxed);
+        counters.TotalWaitUs.store(0, std::memory_order_relaxed);
+        counters.MaxWaitUs.store(0, std::memory_order_relaxed);
+        counters.TotalHoldUs.store(0, std::memory_order_relaxed);
+        counters.MaxHoldUs.store(0, std::memory_order_relaxed);
+    }
+}
+
+LockCounters *afv_native::util::getLockCounters(const char *name)
+{
+    auto &registry = lockRegistry();
+    std::lock_guard<std::mutex> registryGuard(registry.Lock);
+    auto &counters = registry.Counters[name];
+    if (!counters) {
+        counters.reset(new LockCounters);
+        clearCounters(*counters);
+    }
+    return counters.get();
+}
+
+bool afv_native::util::isLockProfilingEnabled()
+{
+    return true;
+}
+
+std::vector<LockStats> afv_native::util::getLockStatistics()
+{
+    auto &registry = lockRegistry();
+    std::lock_guard<std::mutex> registryGuard(registry.Lock);
+    std::vector<LockStats> stats;
+    for (const auto &entry: registry.Counters) {
+        LockStats lockStats;
+        lockStats.Name = entry.first;
+        lockStats.Acquisitions = entry.second->Acquisitions.load(std::memory_order_relaxed);
+        lockStats.ContendedAcquisitions = entry.second->ContendedAcquisitions.load(std::memory_order_relaxed);
+        lockStats.TotalWaitUs = entry.second->TotalWaitUs.load(std::memory_order_relaxed);
+        lockStats.MaxWaitUs = entry.second->MaxWaitUs.load(std::memory_order_relaxed);
+        lockStats.TotalHoldUs = entry.second->TotalHoldUs.load(std::memory_order_relaxed);
+        lockStats.MaxHoldUs = entry.second->MaxHoldUs.load(std::memory_order_relaxed);
+        stats.push_back(std::move(lockStats));
+    }
+    return stats;
+}
+
+void afv_native::util::resetLockStatistics()
+{
+    auto &registry = lockRegistry();
+    std::lock_guard<std::mutex> registryGuard(registry.Lock);
+    for (auto &entry: registry.Counters) {
+        clearCounters(*entry.second);
+    }
+}
+#else
+bool afv_native::util::isLockProfilingEnabled()
+{
+    return false;
+}
+
+std::vector<LockStats> afv_native::util::getLockStatistics()
+{
+    return std::vector<LockStats>();
+}
+
+void afv_native::util::resetLockStatistics()
+{
+}
+#endif
@@ -0,0 +1,141 @@
+/* util/RealtimeAllocationHook.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* Replacement global operator new/delete that report heap use on real-time threads to RealtimeGuard.
+ *
+ * This replaces the allocator for the whole program, so it's only compiled into the library when
+ * AFV_NATIVE_RT_ALLOC_GUARD is set - a host application gets to keep its own operator new otherwise.  The test
+ * suite always links it in.
+ */
+
+#include <cstdlib>
+#include <new>
+
+#include "afv-native/util/RealtimeGuard.h"
+
+using namespace afv_native;
+
+namespace {
+    struct GuardRegistration {
+        GuardRegistration()
+        {
+            util::__RealtimeAllocationGuardInstalled();
+        }
+    } gGuardRegistration;
+
+    void *guardedAllocate(std::size_t size)
+    {
+        util::__RealtimeHeapOperation(true);
+        if (size == 0) {
+            size = 1;
+        }
+        for (;;) {
+            void *ptr = std::malloc(size);
+            if (ptr != nullptr) {
+                return ptr;
+            }
+            auto handler = std::get_new_handler();
+            if (handler == nullptr) {
+                throw std::bad_alloc();
+            }
+            handler();
+        }
+    }
+
+    void *guardedAllocateNoThrow(std::size_t size) noexcept
+    {
+        try {
+            return guardedAllocate(size);
+        } catch (const std::bad_alloc &) {
+            return nullptr;
+        }
+    }
+
+    void guardedFree(void *ptr) noexcept
+    {
+        if (ptr != nullptr) {
+            util::__RealtimeHeapOperation(false);
+            std::free(ptr);
+        }
+    }
+}
+
+void *operator new(std::size_t size)
+{
+    return guardedAllocate(size);
+}
+
+void *operator new[](std::size_t size)
+{
+    return guardedAllocate(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    return guardedAllocateNoThrow(size);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+    return guardedAllocateNoThrow(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    guardedFree(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    guardedFree(ptr);
+}
+
+void operator delete(void *ptr, const std::nothrow_t &) noexcept
+{
+    guardedFree(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept
+{
+    guardedFree(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+    guardedFree(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept
+{
+    guardedFree(ptr);
+}
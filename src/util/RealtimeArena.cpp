@@ -0,0 +1,257 @@
+/* util/RealtimeArena.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "afv-native/util/RealtimeArena.h"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "afv-native/Log.h"
+
+using namespace afv_native::util;
+
+namespace {
+    size_t roundUp(size_t value, size_t multiple)
+    {
+        return (value + multiple - 1) & ~(multiple - 1);
+    }
+
+    void *mapPages(size_t len)
+    {
+#ifdef WIN32
+        return ::VirtualAlloc(nullptr, len, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+#else
+        void *ptr = ::mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        return (ptr == MAP_FAILED) ? nullptr : ptr;
+#endif
+    }
+
+    void unmapPages(void *ptr, size_t len)
+    {
+#ifdef WIN32
+        ::VirtualFree(ptr, 0, MEM_RELEASE);
+#else
+        ::munmap(ptr, len);
+#endif
+    }
+
+    bool lockPages(const void *ptr, size_t len)
+    {
+#ifdef WIN32
+        return ::VirtualLock(const_cast<void *>(ptr), len) != FALSE;
+#else
+        return ::mlock(ptr, len) == 0;
+#endif
+    }
+
+    void unlockPages(const void *ptr, size_t len)
+    {
+#ifdef WIN32
+        ::VirtualUnlock(const_cast<void *>(ptr), len);
+#else
+        ::munlock(ptr, len);
+#endif
+    }
+
+    /** pageRegion widens ptr/len out to the whole pages that cover it. */
+    std::pair<const void *, size_t> pageRegion(const void *ptr, size_t len, size_t pageSize)
+    {
+        const auto start = reinterpret_cast<uintptr_t>(ptr) & ~(static_cast<uintptr_t>(pageSize) - 1);
+        const size_t pageLen = roundUp(reinterpret_cast<uintptr_t>(ptr) + len - start, pageSize);
+        return std::make_pair(reinterpret_cast<const void *>(start), pageLen);
+    }
+
+    /** prefaultPages reads one byte from every page, so that they're all resident. */
+    void prefaultPages(const void *ptr, size_t len, size_t pageSize)
+    {
+        const volatile unsigned char *bytes = static_cast<const volatile unsigned char *>(ptr);
+        unsigned char sum = 0;
+        for (size_t offset = 0; offset < len; offset += pageSize) {
+            sum += bytes[offset];
+        }
+        if (len > 0) {
+            sum += bytes[len - 1];
+        }
+        (void)sum;
+    }
+}
+
+RealtimeArenaStats::RealtimeArenaStats():
+        CapacityBytes(0),
+        UsedBytes(0),
+        Locked(false),
+        LockedRegionBytes(0),
+        LockFailures(0),
+        FailedAllocations(0)
+{
+}
+
+RealtimeArena::RealtimeArena(size_t capacityBytes):
+        mLock(),
+        mBase(nullptr),
+        mCapacity(roundUp(capacityBytes, pageSize())),
+        mUsed(0),
+        mLocked(false),
+        mFailedAllocations(0),
+        mLockFailures(0),
+        mLockedRegions(),
+        mLockedRegionBytes(0)
+{
+    if (mCapacity == 0) {
+        return;
+    }
+    mBase = static_cast<unsigned char *>(mapPages(mCapacity));
+    if (mBase == nullptr) {
+        LOGERROR("RealtimeArena", "couldn't map %zu bytes for the real-time arena", mCapacity);
+        mCapacity = 0;
+        return;
+    }
+    // write to every page so that they're all backed before anyone needs them.  (Reading isn't enough for fresh
+    // anonymous mappings - they'd all just map the shared zero page.)
+    for (size_t offset = 0; offset < mCapacity; offset += pageSize()) {
+        static_cast<volatile unsigned char *>(mBase)[offset] = 0;
+    }
+    mLocked = lockPages(mBase, mCapacity);
+    if (!mLocked) {
+        LOGWARN("RealtimeArena", "couldn't lock the real-time arena (%zu bytes) into memory", mCapacity);
+    }
+}
+
+RealtimeArena::~RealtimeArena()
+{
+    // we don't own the memory behind any regions that are still locked, so it may already have been freed
+    // and reused - we can't safely unlock it now.
+    if (!mLockedRegions.empty()) {
+        LOGWARN("RealtimeArena", "%zu regions (%zu bytes) were never unlocked", mLockedRegions.size(),
+                mLockedRegionBytes);
+    }
+    if (mBase != nullptr) {
+        if (mLocked) {
+            unlockPages(mBase, mCapacity);
+        }
+        unmapPages(mBase, mCapacity);
+    }
+}
+
+void *RealtimeArena::allocate(size_t size, size_t alignment)
+{
+    std::lock_guard<std::mutex> arenaGuard(mLock);
+    const size_t offset = roundUp(mUsed, alignment);
+    if (mBase == nullptr || offset > mCapacity || size > mCapacity - offset) {
+        mFailedAllocations++;
+        return nullptr;
+    }
+    mUsed = offset + size;
+    void *ptr = mBase + offset;
+    ::memset(ptr, 0, size);
+    return ptr;
+}
+
+bool RealtimeArena::lockRegion(const void *ptr, size_t len)
+{
+    if (ptr == nullptr || len == 0) {
+        return false;
+    }
+    const size_t page = pageSize();
+    const auto region = pageRegion(ptr, len, page);
+
+    prefaultPages(ptr, len, page);
+    std::lock_guard<std::mutex> arenaGuard(mLock);
+    if (!lockPages(region.first, region.second)) {
+        mLockFailures++;
+        return false;
+    }
+    mLockedRegions.emplace_back(region);
+    mLockedRegionBytes += region.second;
+    return true;
+}
+
+bool RealtimeArena::unlockRegion(const void *ptr, size_t len)
+{
+    if (ptr == nullptr || len == 0) {
+        return false;
+    }
+    const size_t page = pageSize();
+    const auto region = pageRegion(ptr, len, page);
+
+    std::lock_guard<std::mutex> arenaGuard(mLock);
+    auto regionIter = std::find(mLockedRegions.begin(), mLockedRegions.end(), region);
+    if (regionIter == mLockedRegions.end()) {
+        return false;
+    }
+    mLockedRegions.erase(regionIter);
+    mLockedRegionBytes -= region.second;
+    // locks don't nest, so leave any pages that another region still covers locked.
+    const auto regionStart = reinterpret_cast<uintptr_t>(region.first);
+    for (uintptr_t pageStart = regionStart; pageStart < regionStart + region.second; pageStart += page) {
+        const bool stillLocked = std::any_of(mLockedRegions.begin(), mLockedRegions.end(),
+                [pageStart](const std::pair<const void *, size_t> &other) {
+                    const auto otherStart = reinterpret_cast<uintptr_t>(other.first);
+                    return pageStart >= otherStart && pageStart < otherStart + other.second;
+                });
+        if (!stillLocked) {
+            unlockPages(reinterpret_cast<const void *>(pageStart), page);
+        }
+    }
+    return true;
+}
+
+RealtimeArenaStats RealtimeArena::getStatistics() const
+{
+    std::lock_guard<std::mutex> arenaGuard(mLock);
+    RealtimeArenaStats stats;
+    stats.CapacityBytes = mCapacity;
+    stats.UsedBytes = mUsed;
+    stats.Locked = mLocked;
+    stats.LockedRegionBytes = mLockedRegionBytes;
+    stats.LockFailures = mLockFailures;
+    stats.FailedAllocations = mFailedAllocations;
+    return stats;
+}
+
+size_t RealtimeArena::pageSize()
+{
+#ifdef WIN32
+    SYSTEM_INFO info;
+    ::GetSystemInfo(&info);
+    return info.dwPageSize;
+#else
+    return static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+#endif
+}
@@ -0,0 +1,125 @@
+/* util/RealtimeGuard.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "afv-native/util/RealtimeGuard.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace afv_native::util;
+
+namespace {
+    // these are all constant-initialised, so they're safe to touch from operator new during static
+    // initialisation and thread start-up.
+    thread_local int tRealtimeDepth = 0;
+    thread_local int tPermitDepth = 0;
+
+    std::atomic<bool> gGuardInstalled(false);
+    std::atomic<bool> gTrap(false);
+    std::atomic<uint64_t> gAllocations(0);
+    std::atomic<uint64_t> gDeallocations(0);
+}
+
+RealtimeScope::RealtimeScope()
+{
+    tRealtimeDepth++;
+}
+
+RealtimeScope::~RealtimeScope()
+{
+    tRealtimeDepth--;
+}
+
+RealtimeAllocationPermit::RealtimeAllocationPermit()
+{
+    tPermitDepth++;
+}
+
+RealtimeAllocationPermit::~RealtimeAllocationPermit()
+{
+    tPermitDepth--;
+}
+
+RealtimeAllocationStats::RealtimeAllocationStats():
+        Allocations(0),
+        Deallocations(0)
+{
+}
+
+bool afv_native::util::isRealtimeThread()
+{
+    return tRealtimeDepth > 0;
+}
+
+bool afv_native::util::isRealtimeAllocationGuardInstalled()
+{
+    return gGuardInstalled.load(std::memory_order_relaxed);
+}
+
+RealtimeAllocationStats afv_native::util::getRealtimeAllocationStats()
+{
+    RealtimeAllocationStats stats;
+    stats.Allocations = gAllocations.load(std::memory_order_relaxed);
+    stats.Deallocations = gDeallocations.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void afv_native::util::resetRealtimeAllocationStats()
+{
+    gAllocations.store(0, std::memory_order_relaxed);
+    gDeallocations.store(0, std::memory_order_relaxed);
+}
+
+void afv_native::util::setRealtimeAllocationTrap(bool trap)
+{
+    gTrap.store(trap, std::memory_order_relaxed);
+}
+
+void afv_native::util::__RealtimeHeapOperation(bool allocation)
+{
+    if (tRealtimeDepth <= 0 || tPermitDepth > 0) {
+        return;
+    }
+    if (gTrap.load(std::memory_order_relaxed)) {
+        // no logging here - the logger may well allocate.
+        std::fputs(allocation ? "afv-native: heap allocation on a real-time thread\n"
+                              : "afv-native: heap deallocation on a real-time thread\n", stderr);
+        std::abort();
+    }
+    (allocation ? gAllocations : gDeallocations).fetch_add(1, std::memory_order_relaxed);
+}
+
+void afv_native::util::__RealtimeAllocationGuardInstalled()
+{
+    gGuardInstalled.store(true, std::memory_order_relaxed);
+}
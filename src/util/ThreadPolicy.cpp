@@ -0,0 +1,359 @@
+/* util/ThreadPolicy.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "afv-native/util/ThreadPolicy.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+
+#include "afv-native/util/Trace.h"
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#endif
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#ifdef __APPLE__
+#include <pthread/qos.h>
+#endif
+
+using namespace afv_native::util;
+
+namespace {
+    struct PolicySlot {
+        ThreadPolicy Policy;
+        ThreadPolicyStatus Status;
+    };
+
+    std::mutex gPolicyLock;
+    PolicySlot gPolicies[threadClassCount];
+    /* bumped whenever any policy changes.  Threads compare it against the generation they last applied. */
+    std::atomic<uint64_t> gPolicyGeneration(1);
+
+    /* what we need to know about a thread to put it back the way we found it. */
+    struct ThreadState {
+        uint64_t Generation = 0;
+        bool Named = false;
+        bool SchedulingSaved = false;
+        bool SchedulingChanged = false;
+        bool AffinitySaved = false;
+        bool AffinityChanged = false;
+#ifdef WIN32
+        int OriginalPriority = THREAD_PRIORITY_NORMAL;
+        DWORD_PTR OriginalAffinity = 0;
+#else
+        int OriginalPolicy = SCHED_OTHER;
+        sched_param OriginalParam = {};
+        int OriginalNice = 0;
+#endif
+#ifdef __linux__
+        cpu_set_t OriginalAffinity;
+#endif
+    };
+
+    thread_local ThreadState tThreadState;
+
+    void nameThread(const char *name)
+    {
+#if defined(WIN32)
+        typedef HRESULT (WINAPI *SetThreadDescriptionFn)(HANDLE, PCWSTR);
+        // SetThreadDescription only exists on Windows 10 1607 and later.
+        auto setThreadDescription = reinterpret_cast<SetThreadDescriptionFn>(
+                GetProcAddress(GetModuleHandleW(L"kernel32.dll"), "SetThreadDescription"));
+        if (setThreadDescription != nullptr) {
+            wchar_t wideName[64];
+            if (MultiByteToWideChar(CP_UTF8, 0, name, -1, wideName, 64) > 0) {
+                setThreadDescription(GetCurrentThread(), wideName);
+            }
+        }
+#elif defined(__APPLE__)
+        pthread_setname_np(name);
+#elif defined(__linux__)
+        char shortName[16];
+        strncpy(shortName, name, sizeof(shortName) - 1);
+        shortName[sizeof(shortName) - 1] = '\0';
+        pthread_setname_np(pthread_self(), shortName);
+#endif
+        setTraceThreadName(name);
+    }
+
+#ifdef WIN32
+    ThreadPriority applyPriority(ThreadState &state, const ThreadPolicy &policy, int &lastError)
+    {
+        HANDLE self = GetCurrentThread();
+        if (!state.SchedulingSaved) {
+            state.OriginalPriority = GetThreadPriority(self);
+            state.SchedulingSaved = true;
+        }
+        if (policy.Priority == ThreadPriority::Default) {
+            if (state.SchedulingChanged) {
+                SetThreadPriority(self, state.OriginalPriority);
+                state.SchedulingChanged = false;
+            }
+            return ThreadPriority::Default;
+        }
+        if (policy.Priority == ThreadPriority::Realtime) {
+            if (SetThreadPriority(self, THREAD_PRIORITY_TIME_CRITICAL)) {
+                state.SchedulingChanged = true;
+                return ThreadPriority::Realtime;
+            }
+            lastError = static_cast<int>(GetLastError());
+        }
+        if (SetThreadPriority(self, THREAD_PRIORITY_HIGHEST)) {
+            state.SchedulingChanged = true;
+            return ThreadPriority::Elevated;
+        }
+        lastError = static_cast<int>(GetLastError());
+        return ThreadPriority::Default;
+    }
+
+    bool applyAffinity(ThreadState &state, const ThreadPolicy &policy, int &lastError)
+    {
+        HANDLE self = GetCurrentThread();
+        if (policy.CpuMask == 0) {
+            if (state.AffinityChanged) {
+                SetThreadAffinityMask(self, state.OriginalAffinity);
+                state.AffinityChanged = false;
+            }
+            return false;
+        }
+        DWORD_PTR previous = SetThreadAffinityMask(self, static_cast<DWORD_PTR>(policy.CpuMask));
+        if (previous == 0) {
+            lastError = static_cast<int>(GetLastError());
+            return false;
+        }
+        if (!state.AffinitySaved) {
+            state.OriginalAffinity = previous;
+            state.AffinitySaved = true;
+        }
+        state.AffinityChanged = true;
+        return true;
+    }
+#else
+    /* on Linux, nice values are per-thread, and addressed by the thread's id. */
+    id_t niceTarget()
+    {
+#ifdef __linux__
+        return static_cast<id_t>(syscall(SYS_gettid));
+#else
+        return 0;
+#endif
+    }
+
+    bool elevate(int &lastError)
+    {
+#if defined(__APPLE__)
+        int rv = pthread_set_qos_class_self_np(QOS_CLASS_USER_INTERACTIVE, 0);
+        if (rv != 0) {
+            lastError = rv;
+            return false;
+        }
+        return true;
+#else
+        if (setpriority(PRIO_PROCESS, niceTarget(), -10) != 0) {
+            lastError = errno;
+            return false;
+        }
+        return true;
+#endif
+    }
+
+    ThreadPriority applyPriority(ThreadState &state, const ThreadPolicy &policy, int &lastError)
+    {
+        pthread_t self = pthread_self();
+        if (!state.SchedulingSaved) {
+            pthread_getschedparam(self, &state.OriginalPolicy, &state.OriginalParam);
+            errno = 0;
+            state.OriginalNice = getpriority(PRIO_PROCESS, niceTarget());
+            if (errno != 0) {
+                state.OriginalNice = 0;
+            }
+            state.SchedulingSaved = true;
+        }
+        if (state.SchedulingChanged) {
+            // start from where we found the thread, so a downgrade actually takes effect.
+            pthread_setschedparam(self, state.OriginalPolicy, &state.OriginalParam);
+#ifndef __APPLE__
+            setpriority(PRIO_PROCESS, niceTarget(), state.OriginalNice);
+#endif
+            state.SchedulingChanged = false;
+        }
+        if (policy.Priority == ThreadPriority::Default) {
+            return ThreadPriority::Default;
+        }
+        if (policy.Priority == ThreadPriority::Realtime) {
+            sched_param param = {};
+            int minPriority = sched_get_priority_min(SCHED_FIFO);
+            int maxPriority = sched_get_priority_max(SCHED_FIFO);
+            param.sched_priority = policy.RealtimePriority;
+            if (param.sched_priority < minPriority) {
+                param.sched_priority = minPriority;
+            } else if (param.sched_priority > maxPriority) {
+                param.sched_priority = maxPriority;
+            }
+            int rv = pthread_setschedparam(self, SCHED_FIFO, &param);
+            if (rv == 0) {
+                state.SchedulingChanged = true;
+                return ThreadPriority::Realtime;
+            }
+            lastError = rv;
+        }
+        if (elevate(lastError)) {
+            state.SchedulingChanged = true;
+            return ThreadPriority::Elevated;
+        }
+        return ThreadPriority::Default;
+    }
+
+    bool applyAffinity(ThreadState &state, const ThreadPolicy &policy, int &lastError)
+    {
+#ifdef __linux__
+        pthread_t self = pthread_self();
+        if (policy.CpuMask == 0) {
+            if (state.AffinityChanged) {
+                pthread_setaffinity_np(self, sizeof(state.OriginalAffinity), &state.OriginalAffinity);
+                state.AffinityChanged = false;
+            }
+            return false;
+        }
+        if (!state.AffinitySaved) {
+            CPU_ZERO(&state.OriginalAffinity);
+            pthread_getaffinity_np(self, sizeof(state.OriginalAffinity), &state.OriginalAffinity);
+            state.AffinitySaved = true;
+        }
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        for (int cpu = 0; cpu < 64; cpu++) {
+            if (policy.CpuMask & (uint64_t(1) << cpu)) {
+                CPU_SET(cpu, &cpus);
+            }
+        }
+        int rv = pthread_setaffinity_np(self, sizeof(cpus), &cpus);
+        if (rv != 0) {
+            lastError = rv;
+            return false;
+        }
+        state.AffinityChanged = true;
+        return true;
+#else
+        // macOS only has affinity hints, which don't do what callers of this would expect.
+        (void)state;
+        if (policy.CpuMask != 0) {
+            lastError = ENOTSUP;
+        }
+        return false;
+#endif
+    }
+#endif
+}
+
+ThreadPolicy::ThreadPolicy():
+        Priority(ThreadPriority::Default),
+        RealtimePriority(70),
+        CpuMask(0)
+{
+}
+
+ThreadPolicyStatus::ThreadPolicyStatus():
+        Applied(false),
+        Priority(ThreadPriority::Default),
+        AffinityApplied(false),
+        LastError(0)
+{
+}
+
+const char *afv_native::util::getThreadClassName(ThreadClass threadClass)
+{
+    switch (threadClass) {
+    case ThreadClass::Audio:
+        return "audio";
+    case ThreadClass::AudioCapture:
+        return "audio capture";
+    case ThreadClass::Logging:
+        return "logging";
+    case ThreadClass::Network:
+        return "network";
+    }
+    return "unknown";
+}
+
+void afv_native::util::setThreadPolicy(ThreadClass threadClass, const ThreadPolicy &policy)
+{
+    std::lock_guard<std::mutex> policyGuard(gPolicyLock);
+    auto &slot = gPolicies[static_cast<size_t>(threadClass)];
+    slot.Policy = policy;
+    slot.Status = ThreadPolicyStatus();
+    gPolicyGeneration.fetch_add(1);
+}
+
+ThreadPolicy afv_native::util::getThreadPolicy(ThreadClass threadClass)
+{
+    std::lock_guard<std::mutex> policyGuard(gPolicyLock);
+    return gPolicies[static_cast<size_t>(threadClass)].Policy;
+}
+
+ThreadPolicyStatus afv_native::util::getThreadPolicyStatus(ThreadClass threadClass)
+{
+    std::lock_guard<std::mutex> policyGuard(gPolicyLock);
+    return gPolicies[static_cast<size_t>(threadClass)].Status;
+}
+
+void afv_native::util::maintainThreadPolicy(ThreadClass threadClass, const char *name)
+{
+    auto &state = tThreadState;
+    const uint64_t generation = gPolicyGeneration.load(std::memory_order_acquire);
+    if (state.Generation == generation) {
+        return;
+    }
+    if (!state.Named) {
+        nameThread(name);
+        state.Named = true;
+    }
+
+    ThreadPolicy policy = getThreadPolicy(threadClass);
+    ThreadPolicyStatus status;
+    status.Applied = true;
+    status.Priority = applyPriority(state, policy, status.LastError);
+    status.AffinityApplied = applyAffinity(state, policy, status.LastError);
+    state.Generation = generation;
+
+    std::lock_guard<std::mutex> policyGuard(gPolicyLock);
+    gPolicies[static_cast<size_t>(threadClass)].Status = status;
+}
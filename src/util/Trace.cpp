@@ -0,0 +1,356 @@
+/* util/Trace.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "afv-native/util/Trace.h"
+#include "afv-native/util/RealtimeGuard.h"
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace afv_native::util;
+
+std::atomic<bool> afv_native::util::__TraceEnabled(false);
+
+namespace {
+    typedef std::chrono::steady_clock clock;
+
+    struct TraceEvent {
+        clock::rep Timestamp;
+        const char *Category;
+        const char *Name;
+        const void *Id;
+        char Phase;
+    };
+
+    /** TraceBuffer holds the events recorded by one thread during one trace.
+     *
+     * Only the owning thread appends to it.  Events are never overwritten, so the exporter can safely read
+     * everything below Count at any time.
+     */
+    class TraceBuffer {
+    public:
+        TraceBuffer(size_t capacity, int threadId, const char *threadName):
+                Events(capacity),
+                Count(0),
+                Dropped(0),
+                ThreadId(threadId),
+                ThreadName(threadName)
+        {
+        }
+
+        std::vector<TraceEvent> Events;
+        std::atomic<size_t> Count;
+        std::atomic<uint64_t> Dropped;
+        const int ThreadId;
+        std::atomic<const char *> ThreadName;
+    };
+
+    struct TraceSession {
+        uint64_t Generation;
+        clock::time_point Start;
+        size_t EventsPerThread;
+        std::vector<std::shared_ptr<TraceBuffer>> Buffers;
+    };
+
+    /** gTraceLock protects gTraceSession.  It's only taken when a trace is started or exported, and when a
+     * thread records its first event of a trace.
+     */
+    std::mutex gTraceLock;
+    std::shared_ptr<TraceSession> gTraceSession;
+    std::atomic<uint64_t> gTraceGeneration(0);
+
+    enum SpareState {
+        SpareEmpty,
+        SpareReady,
+        SpareBusy,
+    };
+
+    /** SpareTraceBuffer is a buffer set aside by startTrace for a real-time thread to adopt.
+     *
+     * Whoever moves State to SpareBusy owns the rest of the slot until they set it back.
+     */
+    struct SpareTraceBuffer {
+        std::atomic<int> State;
+        uint64_t Generation;
+        std::shared_ptr<TraceBuffer> Buffer;
+    };
+
+    SpareTraceBuffer gSpareBuffers[realtimeTraceBuffers];
+    /** gTraceMissed counts events from real-time threads that had no buffer, as there were no spares left. */
+    std::atomic<uint64_t> gTraceMissed(0);
+
+    struct ThreadTrace {
+        std::shared_ptr<TraceBuffer> Buffer;
+        uint64_t Generation = 0;
+        const char *Name = nullptr;
+    };
+
+    ThreadTrace &threadTrace()
+    {
+        static thread_local ThreadTrace trace;
+        return trace;
+    }
+
+    /** adoptSpareBuffer swaps the calling thread's buffer for a spare from the given trace.
+     *
+     * The thread's stale buffer is left in the slot, so it's released by the next startTrace rather than here.
+     * This doesn't allocate, free or lock, so it's safe on a real-time thread.
+     */
+    bool adoptSpareBuffer(ThreadTrace &local, uint64_t generation)
+    {
+        for (auto &spare: gSpareBuffers) {
+            int expected = SpareReady;
+            if (!spare.State.compare_exchange_strong(expected, SpareBusy, std::memory_order_acquire)) {
+                continue;
+            }
+            if (spare.Generation != generation) {
+                spare.State.store(SpareReady, std::memory_order_release);
+                continue;
+            }
+            std::swap(local.Buffer, spare.Buffer);
+            local.Generation = generation;
+            local.Buffer->ThreadName.store(local.Name);
+            spare.State.store(SpareEmpty, std::memory_order_release);
+            return true;
+        }
+        return false;
+    }
+
+    /** threadTraceBuffer returns the calling thread's buffer for the current trace, creating it if needed.
+     *
+     * Real-time threads never create one - they adopt a spare instead, or go without.
+     */
+    TraceBuffer *threadTraceBuffer()
+    {
+        auto &local = threadTrace();
+        const uint64_t generation = gTraceGeneration.load(std::memory_order_acquire);
+        if (local.Buffer && local.Generation == generation) {
+            return local.Buffer.get();
+        }
+        if (isRealtimeThread()) {
+            if (!adoptSpareBuffer(local, generation)) {
+                gTraceMissed.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+            return local.Buffer.get();
+        }
+        std::lock_guard<std::mutex> traceGuard(gTraceLock);
+        if (!gTraceSession || gTraceSession->Generation != generation) {
+            return nullptr;
+        }
+        local.Buffer = std::make_shared<TraceBuffer>(
+                gTraceSession->EventsPerThread,
+                static_cast<int>(gTraceSession->Buffers.size()) + 1,
+                local.Name);
+        local.Generation = generation;
+        gTraceSession->Buffers.push_back(local.Buffer);
+        return local.Buffer.get();
+    }
+
+    /** refillSpareBuffers sets aside a fresh buffer in every spare slot for session.  gTraceLock must be held. */
+    void refillSpareBuffers(TraceSession &session)
+    {
+        for (auto &spare: gSpareBuffers) {
+            int expected = SpareEmpty;
+            while (!spare.State.compare_exchange_weak(expected, SpareBusy, std::memory_order_acquire)) {
+                if (expected == SpareBusy) {
+                    // a thread is part way through adopting it - that's only a few instructions.
+                    std::this_thread::yield();
+                    expected = SpareEmpty;
+                }
+            }
+            spare.Buffer = std::make_shared<TraceBuffer>(
+                    session.EventsPerThread,
+                    static_cast<int>(session.Buffers.size()) + 1,
+                    nullptr);
+            spare.Generation = session.Generation;
+            session.Buffers.push_back(spare.Buffer);
+            spare.State.store(SpareReady, std::memory_order_release);
+        }
+    }
+
+    void appendJsonString(std::string &out, const char *str)
+    {
+        out += '"';
+        for (const char *p = (str != nullptr) ? str : ""; *p != '\0'; p++) {
+            switch (*p) {
+            case '"':
+                out += "\\\"";
+                break;
+            case '\\':
+                out += "\\\\";
+                break;
+            default:
+                if (static_cast<unsigned char>(*p) < 0x20) {
+                    char escBuf[8];
+                    snprintf(escBuf, sizeof(escBuf), "\\u%04x", static_cast<unsigned int>(*p));
+                    out += escBuf;
+                } else {
+                    out += *p;
+                }
+            }
+        }
+        out += '"';
+    }
+}
+
+void afv_native::util::startTrace(size_t eventsPerThread)
+{
+    std::lock_guard<std::mutex> traceGuard(gTraceLock);
+    __TraceEnabled.store(false);
+
+    auto session = std::make_shared<TraceSession>();
+    session->Generation = gTraceGeneration.load() + 1;
+    session->Start = clock::now();
+    session->EventsPerThread = (eventsPerThread > 0) ? eventsPerThread : defaultTraceEventsPerThread;
+    // real-time threads can't allocate their own buffers, so set theirs aside now.
+    refillSpareBuffers(*session);
+    gTraceMissed.store(0);
+    gTraceSession = std::move(session);
+    gTraceGeneration.store(gTraceSession->Generation, std::memory_order_release);
+
+    __TraceEnabled.store(true);
+}
+
+void afv_native::util::stopTrace()
+{
+    __TraceEnabled.store(false);
+}
+
+void afv_native::util::setTraceThreadName(const char *name)
+{
+    auto &local = threadTrace();
+    local.Name = name;
+    if (local.Buffer) {
+        local.Buffer->ThreadName.store(name);
+    }
+}
+
+void afv_native::util::__TraceRecord(char phase, const char *category, const char *name, const void *id)
+{
+    TraceBuffer *buffer = threadTraceBuffer();
+    if (buffer == nullptr) {
+        return;
+    }
+    const size_t index = buffer->Count.load(std::memory_order_relaxed);
+    if (index >= buffer->Events.size()) {
+        buffer->Dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    auto &event = buffer->Events[index];
+    event.Timestamp = clock::now().time_since_epoch().count();
+    event.Category = category;
+    event.Name = name;
+    event.Id = id;
+    event.Phase = phase;
+    buffer->Count.store(index + 1, std::memory_order_release);
+}
+
+std::string afv_native::util::exportTrace()
+{
+    stopTrace();
+
+    std::shared_ptr<TraceSession> session;
+    std::vector<std::shared_ptr<TraceBuffer>> buffers;
+    {
+        std::lock_guard<std::mutex> traceGuard(gTraceLock);
+        session = gTraceSession;
+        if (session) {
+            buffers = session->Buffers;
+        }
+    }
+
+    std::string out = "{\"traceEvents\":[";
+    bool first = true;
+    uint64_t dropped = gTraceMissed.load(std::memory_order_relaxed);
+    char numBuf[100];
+    for (const auto &buffer: buffers) {
+        const size_t count = buffer->Count.load(std::memory_order_acquire);
+        dropped += buffer->Dropped.load(std::memory_order_relaxed);
+
+        const char *threadName = buffer->ThreadName.load();
+        if (threadName != nullptr) {
+            out += first ? "\n" : ",\n";
+            first = false;
+            snprintf(numBuf, sizeof(numBuf), "{\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"name\":\"thread_name\",\"args\":{\"name\":",
+                     buffer->ThreadId);
+            out += numBuf;
+            appendJsonString(out, threadName);
+            out += "}}";
+        }
+        for (size_t i = 0; i < count; i++) {
+            const auto &event = buffer->Events[i];
+            const auto sinceStart = clock::duration(event.Timestamp) - session->Start.time_since_epoch();
+            const double tsUs = std::chrono::duration<double, std::micro>(sinceStart).count();
+
+            out += first ? "\n" : ",\n";
+            first = false;
+            out += "{\"ph\":\"";
+            out += event.Phase;
+            out += "\",\"cat\":";
+            appendJsonString(out, event.Category);
+            out += ",\"name\":";
+            appendJsonString(out, event.Name);
+            snprintf(numBuf, sizeof(numBuf), ",\"ts\":%.3f,\"pid\":1,\"tid\":%d", tsUs, buffer->ThreadId);
+            out += numBuf;
+            if (event.Phase == 'i') {
+                out += ",\"s\":\"t\"";
+            } else if (event.Phase == 'b' || event.Phase == 'e') {
+                snprintf(numBuf, sizeof(numBuf), ",\"id\":\"0x%" PRIxPTR "\"", reinterpret_cast<uintptr_t>(event.Id));
+                out += numBuf;
+            }
+            out += "}";
+        }
+    }
+    snprintf(numBuf, sizeof(numBuf), "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"droppedEvents\":%" PRIu64 "}}\n",
+             dropped);
+    out += numBuf;
+    return out;
+}
+
+bool afv_native::util::writeTrace(const std::string &fileName)
+{
+    const std::string trace = exportTrace();
+    FILE *fh = fopen(fileName.c_str(), "wb");
+    if (fh == nullptr) {
+        return false;
+    }
+    const bool ok = fwrite(trace.data(), 1, trace.size(), fh) == trace.size();
+    return (fclose(fh) == 0) && ok;
+}
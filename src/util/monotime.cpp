@@ -33,14 +33,27 @@
 
 #include "afv-native/util/monotime.h"
 
+#include <atomic>
 #include <chrono>
 
 using namespace std;
 
+static atomic<afv_native::util::MonotimeSource *> gMonotimeSource{nullptr};
+
 afv_native::util::monotime_t afv_native::util::monotime_get()
 {
+    const auto *source = gMonotimeSource.load(memory_order_acquire);
+    if (source != nullptr) {
+        return source->now();
+    }
+
     const auto monoTime = chrono::steady_clock::now();
     const auto msTime = chrono::duration_cast<chrono::milliseconds>(monoTime.time_since_epoch()).count();
 
     return msTime;
 }
+
+afv_native::util::MonotimeSource *afv_native::util::monotime_set_source(MonotimeSource *source)
+{
+    return gMonotimeSource.exchange(source, memory_order_acq_rel);
+}
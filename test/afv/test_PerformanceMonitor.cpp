@@ -0,0 +1,128 @@
+/* test/afv/test_PerformanceMonitor.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "afv-native/afv/PerformanceStats.h"
+#include <gtest/gtest.h>
+
+using namespace afv_native::afv;
+
+TEST(PerformanceMonitor, WatchdogDisabledRecordsNothing)
+{
+    PerformanceMonitor monitor;
+    monitor.checkFrame(false, 50000, 20000, 1, 1);
+    EXPECT_TRUE(monitor.getIncidents().empty());
+    EXPECT_FALSE(monitor.getHistogram(PerformanceStage::RxMix)->isEnabled());
+}
+
+TEST(PerformanceMonitor, WatchdogEnablesStageTiming)
+{
+    PerformanceMonitor monitor;
+    monitor.setWatchdogEnabled(true);
+    EXPECT_TRUE(monitor.getHistogram(PerformanceStage::RxMix)->isEnabled());
+    EXPECT_FALSE(monitor.isEnabled());
+
+    monitor.setWatchdogEnabled(false);
+    EXPECT_FALSE(monitor.getHistogram(PerformanceStage::RxMix)->isEnabled());
+}
+
+TEST(PerformanceMonitor, SlowFramesAreAttributedToTheirSlowestStage)
+{
+    PerformanceMonitor monitor;
+    monitor.setWatchdogEnabled(true);
+
+    monitor.getHistogram(PerformanceStage::RxDecode)->record(1000);
+    monitor.getHistogram(PerformanceStage::RxEffects)->record(8000);
+    monitor.getHistogram(PerformanceStage::RxEffects)->record(4000);
+    monitor.getHistogram(PerformanceStage::RxFrame)->record(13000);
+    // transmit stages mustn't be charged to a playback frame.
+    monitor.getHistogram(PerformanceStage::TxEncode)->record(19000);
+    monitor.checkFrame(false, 25000, 20000, 7, 2);
+
+    auto incidents = monitor.getIncidents();
+    ASSERT_EQ(incidents.size(), 1);
+    const auto &incident = incidents[0];
+    EXPECT_EQ(incident.Sequence, 1);
+    EXPECT_FALSE(incident.Transmit);
+    EXPECT_TRUE(incident.Overrun);
+    EXPECT_EQ(incident.FrameUs, 25000);
+    EXPECT_EQ(incident.BudgetUs, 20000);
+    EXPECT_EQ(incident.SlowestStage, PerformanceStage::RxEffects);
+    EXPECT_EQ(incident.getStageUs(PerformanceStage::RxEffects), 12000);
+    EXPECT_EQ(incident.getStageUs(PerformanceStage::RxDecode), 1000);
+    EXPECT_EQ(incident.getStageUs(PerformanceStage::TxEncode), 0);
+    EXPECT_EQ(incident.ActiveStreams, 7);
+    EXPECT_EQ(incident.ActiveRadios, 2);
+
+    // the stage times belong to the frame they were checked with.
+    monitor.checkFrame(false, 15000, 20000, 0, 0);
+    incidents = monitor.getIncidents(1);
+    ASSERT_EQ(incidents.size(), 1);
+    EXPECT_FALSE(incidents[0].Overrun);
+    EXPECT_EQ(incidents[0].getStageUs(PerformanceStage::RxEffects), 0);
+    EXPECT_EQ(incidents[0].SlowestStage, PerformanceStage::RxFrame);
+
+    // and the transmit side still has its own.
+    monitor.checkFrame(true, 19500, 20000, 0, 0);
+    incidents = monitor.getIncidents(2);
+    ASSERT_EQ(incidents.size(), 1);
+    EXPECT_TRUE(incidents[0].Transmit);
+    EXPECT_EQ(incidents[0].SlowestStage, PerformanceStage::TxEncode);
+}
+
+TEST(PerformanceMonitor, FastFramesAreNotReported)
+{
+    PerformanceMonitor monitor;
+    monitor.setWatchdogEnabled(true);
+    monitor.checkFrame(false, 9999, 20000, 0, 0);
+    EXPECT_TRUE(monitor.getIncidents().empty());
+
+    monitor.setWatchdogThreshold(0.25f);
+    monitor.checkFrame(false, 9999, 20000, 0, 0);
+    EXPECT_EQ(monitor.getIncidents().size(), 1);
+}
+
+TEST(PerformanceMonitor, IncidentRingKeepsTheMostRecent)
+{
+    PerformanceMonitor monitor;
+    monitor.setWatchdogEnabled(true);
+    const size_t total = PerformanceMonitor::incidentRingSize + 5;
+    for (size_t i = 0; i < total; i++) {
+        monitor.checkFrame(false, 30000, 20000, 0, 0);
+    }
+
+    auto incidents = monitor.getIncidents();
+    ASSERT_EQ(incidents.size(), PerformanceMonitor::incidentRingSize);
+    EXPECT_EQ(incidents.front().Sequence, 6);
+    EXPECT_EQ(incidents.back().Sequence, total);
+    EXPECT_EQ(monitor.getIncidents(total - 2).size(), 2);
+}
@@ -0,0 +1,375 @@
+/* test/afv/test_RealtimeAllocation.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+/* These drive the audio paths the way the device callbacks do and check that, once warmed up, they make no heap
+ * allocations.  Anything that only allocates on a transition (a new stream, an effect starting) is covered by
+ * the warm-up.
+ */
+
+#include "afv-native/afv/EffectResources.h"
+#include "afv-native/afv/RadioSimulation.h"
+#include "afv-native/afv/VoiceCompressionSink.h"
+#include "afv-native/audio/PinkNoiseGenerator.h"
+#include "afv-native/cryptodto/UDPChannel.h"
+#include "afv-native/util/RealtimeGuard.h"
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <event2/event.h>
+
+#ifdef WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+using namespace afv_native;
+
+namespace {
+    const size_t warmupFrames = 20;
+    const size_t testFrames = 100;
+    const unsigned int testFrequency = 118000000;
+
+    class PacketCollector: public afv::ICompressedFrameSink {
+    public:
+        std::vector<std::vector<unsigned char>> Packets;
+        bool Keep = true;
+
+        void processCompressedFrame(const std::vector<unsigned char> &compressedData) override
+        {
+            if (Keep) {
+                Packets.emplace_back(compressedData);
+            }
+        }
+    };
+
+    std::vector<audio::SampleType> pinkNoiseFrames(size_t count)
+    {
+        std::vector<audio::SampleType> samples(count * audio::frameSizeSamples);
+        audio::PinkNoiseGenerator noise(0.5f);
+        for (size_t i = 0; i < count; i++) {
+            noise.getAudioFrame(samples.data() + i * audio::frameSizeSamples);
+        }
+        return samples;
+    }
+
+    /** LoopbackReceiver is a UDP socket on the loopback interface for a channel to send to. */
+    class LoopbackReceiver {
+    public:
+        evutil_socket_t Socket;
+        std::string Address;
+
+        LoopbackReceiver():
+                Socket(::socket(AF_INET, SOCK_DGRAM, 0)),
+                Address()
+        {
+            struct sockaddr_in addr = {};
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            socklen_t addrLen = sizeof(addr);
+            if (Socket < 0
+                || ::bind(Socket, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr))
+                || ::getsockname(Socket, reinterpret_cast<struct sockaddr *>(&addr), &addrLen)) {
+                return;
+            }
+            evutil_make_socket_nonblocking(Socket);
+            Address = "127.0.0.1:" + std::to_string(ntohs(addr.sin_port));
+        }
+
+        ~LoopbackReceiver()
+        {
+            if (Socket >= 0) {
+                evutil_closesocket(Socket);
+            }
+        }
+
+        size_t drain()
+        {
+            size_t count = 0;
+            char buffer[2048];
+            while (::recv(Socket, buffer, sizeof(buffer), 0) >= 0) {
+                count++;
+            }
+            return count;
+        }
+    };
+
+    void expectNoHeapUse()
+    {
+        const auto stats = util::getRealtimeAllocationStats();
+        EXPECT_EQ(stats.Allocations, 0);
+        EXPECT_EQ(stats.Deallocations, 0);
+    }
+}
+
+TEST(RealtimeAllocation, VoiceCompressionSink)
+{
+    ASSERT_TRUE(util::isRealtimeAllocationGuardInstalled());
+    const auto frames = pinkNoiseFrames(warmupFrames + testFrames);
+    PacketCollector sink;
+    sink.Keep = false;
+    afv::VoiceCompressionSink encoder(sink);
+
+    util::RealtimeScope realtime;
+    for (size_t i = 0; i < warmupFrames; i++) {
+        encoder.putAudioFrame(frames.data() + i * audio::frameSizeSamples);
+    }
+    util::resetRealtimeAllocationStats();
+    for (size_t i = warmupFrames; i < warmupFrames + testFrames; i++) {
+        encoder.putAudioFrame(frames.data() + i * audio::frameSizeSamples);
+    }
+    expectNoHeapUse();
+}
+
+TEST(RealtimeAllocation, RadioSimulationReceive)
+{
+    ASSERT_TRUE(util::isRealtimeAllocationGuardInstalled());
+
+    // encode some voice to play back.
+    PacketCollector collector;
+    {
+        const auto frames = pinkNoiseFrames(warmupFrames + testFrames);
+        afv::VoiceCompressionSink encoder(collector);
+        for (size_t i = 0; i < warmupFrames + testFrames; i++) {
+            encoder.putAudioFrame(frames.data() + i * audio::frameSizeSamples);
+        }
+    }
+
+    auto resources = std::make_shared<afv::EffectResources>("examples/testclient");
+    struct event_base *evBase = event_base_new();
+    {
+        afv::RadioSimulation simulation(evBase, resources, nullptr, 2);
+        simulation.setFrequency(0, testFrequency);
+        simulation.setFrequency(1, testFrequency + 25000);
+
+        // two streams on the same radio, so the blocking tone gets mixed in as well.
+        std::vector<afv::dto::AudioRxOnTransceivers> streams(2);
+        for (size_t i = 0; i < streams.size(); i++) {
+            char callsign[32];
+            snprintf(callsign, sizeof(callsign), "TEST%u", static_cast<unsigned int>(i));
+            streams[i].Callsign = callsign;
+            streams[i].SequenceCounter = 0;
+            streams[i].LastPacket = false;
+            afv::dto::RxTransceiver trans;
+            trans.ID = 0;
+            trans.Frequency = testFrequency;
+            trans.DistanceRatio = 0.5f;
+            streams[i].Transceivers.emplace_back(trans);
+        }
+
+        std::vector<audio::SampleType> output(audio::frameSizeSamples);
+        for (size_t frame = 0; frame < warmupFrames + testFrames; frame++) {
+            // the packets arrive on the network thread, which is allowed to allocate.
+            for (auto &pkt: streams) {
+                pkt.Audio = collector.Packets[frame];
+                simulation.rxVoicePacket(pkt);
+                pkt.SequenceCounter++;
+            }
+            util::RealtimeScope realtime;
+            if (frame == warmupFrames) {
+                util::resetRealtimeAllocationStats();
+            }
+            simulation.getAudioFrame(output.data());
+        }
+        EXPECT_EQ(simulation.AudiableAudioStreams[0].load(), 2);
+
+        // and the streams stopping (which starts the squelch click) mustn't allocate either.
+        {
+            util::RealtimeScope realtime;
+            for (size_t frame = 0; frame < warmupFrames; frame++) {
+                simulation.getAudioFrame(output.data());
+            }
+        }
+        EXPECT_EQ(simulation.AudiableAudioStreams[0].load(), 0);
+        expectNoHeapUse();
+    }
+    event_base_free(evBase);
+}
+
+TEST(RealtimeAllocation, RadioSimulationTransmit)
+{
+    ASSERT_TRUE(util::isRealtimeAllocationGuardInstalled());
+    const auto frames = pinkNoiseFrames(warmupFrames + testFrames);
+
+    LoopbackReceiver receiver;
+    ASSERT_FALSE(receiver.Address.empty());
+
+    auto resources = std::make_shared<afv::EffectResources>("examples/testclient");
+    struct event_base *evBase = event_base_new();
+    {
+        // send for real, so that encapsulating and transmitting the voice packets is covered too.
+        cryptodto::UDPChannel channel(evBase);
+        channel.setAddress(receiver.Address);
+        ASSERT_TRUE(channel.open());
+
+        afv::RadioSimulation simulation(evBase, resources, &channel, 1);
+        simulation.setCallsign("TEST");
+        simulation.setTxRadio(0);
+        simulation.setPtt(true);
+
+        {
+            util::RealtimeScope realtime;
+            for (size_t i = 0; i < warmupFrames; i++) {
+                simulation.putAudioFrame(frames.data() + i * audio::frameSizeSamples);
+            }
+            util::resetRealtimeAllocationStats();
+            for (size_t i = warmupFrames; i < warmupFrames + testFrames; i++) {
+                simulation.putAudioFrame(frames.data() + i * audio::frameSizeSamples);
+            }
+            expectNoHeapUse();
+        }
+        EXPECT_GT(channel.getStatistics().PacketsSent, testFrames / 2);
+        EXPECT_EQ(channel.getStatistics().SendErrors, 0);
+        EXPECT_GT(receiver.drain(), 0);
+        channel.close();
+    }
+    event_base_free(evBase);
+}
+
+TEST(RealtimeAllocation, RadioSimulationTransmitChainChanges)
+{
+    ASSERT_TRUE(util::isRealtimeAllocationGuardInstalled());
+    const auto frames = pinkNoiseFrames(testFrames);
+
+    auto resources = std::make_shared<afv::EffectResources>("examples/testclient");
+    struct event_base *evBase = event_base_new();
+    {
+        afv::RadioSimulation simulation(evBase, resources, nullptr, 1);
+        simulation.setTxRadio(0);
+        simulation.setPtt(true);
+        util::resetRealtimeAllocationStats();
+
+        // the chain is rebuilt underneath the capture thread, which must neither wait for it nor free the old one.
+        std::atomic<bool> running(true);
+        std::atomic<size_t> captured(0);
+        std::thread capture([&]() {
+            util::RealtimeScope realtime;
+            for (size_t i = 0; running.load(); i = (i + 1) % testFrames) {
+                simulation.putAudioFrame(frames.data() + i * audio::frameSizeSamples);
+                captured++;
+            }
+        });
+        for (int i = 0; i < 8; i++) {
+            const size_t capturedBefore = captured.load();
+            simulation.setEnableNarrowbandTx((i & 1) != 0);
+            simulation.setEnableInputFilters((i & 2) != 0);
+            EXPECT_EQ(simulation.getEnableNarrowbandTx(), (i & 1) != 0);
+            EXPECT_EQ(simulation.getEnableInputFilters(), (i & 2) != 0);
+            while (captured.load() < capturedBefore + 10) {
+                std::this_thread::yield();
+            }
+        }
+        running.store(false);
+        capture.join();
+        expectNoHeapUse();
+    }
+    event_base_free(evBase);
+}
+
+TEST(RealtimeMemory, StreamsAreDrawnFromThePool)
+{
+    PacketCollector collector;
+    {
+        const auto frames = pinkNoiseFrames(warmupFrames);
+        afv::VoiceCompressionSink encoder(collector);
+        for (size_t i = 0; i < warmupFrames; i++) {
+            encoder.putAudioFrame(frames.data() + i * audio::frameSizeSamples);
+        }
+    }
+
+    auto resources = std::make_shared<afv::EffectResources>("examples/testclient");
+    struct event_base *evBase = event_base_new();
+    {
+        afv::RadioSimulation simulation(evBase, resources, nullptr, 1);
+        EXPECT_FALSE(simulation.getRealtimeMemoryStats().Enabled);
+        ASSERT_TRUE(simulation.enableRealtimeMemory(2));
+        simulation.setFrequency(0, testFrequency);
+
+        auto memoryStats = simulation.getRealtimeMemoryStats();
+        EXPECT_TRUE(memoryStats.Enabled);
+        EXPECT_EQ(memoryStats.StreamSlots, 2);
+        EXPECT_EQ(memoryStats.StreamSlotsFree, 2);
+        EXPECT_GT(memoryStats.Arena.UsedBytes, 0);
+        EXPECT_LE(memoryStats.Arena.UsedBytes, memoryStats.Arena.CapacityBytes);
+        EXPECT_EQ(memoryStats.Arena.FailedAllocations, 0);
+
+        // one more stream than there are slots.
+        std::vector<afv::dto::AudioRxOnTransceivers> streams(3);
+        for (size_t i = 0; i < streams.size(); i++) {
+            char callsign[32];
+            snprintf(callsign, sizeof(callsign), "TEST%u", static_cast<unsigned int>(i));
+            streams[i].Callsign = callsign;
+            streams[i].SequenceCounter = 0;
+            streams[i].LastPacket = false;
+            afv::dto::RxTransceiver trans;
+            trans.ID = 0;
+            trans.Frequency = testFrequency;
+            trans.DistanceRatio = 0.5f;
+            streams[i].Transceivers.emplace_back(trans);
+        }
+        std::vector<audio::SampleType> output(audio::frameSizeSamples);
+        for (size_t frame = 0; frame < warmupFrames; frame++) {
+            for (auto &pkt: streams) {
+                pkt.Audio = collector.Packets[frame];
+                simulation.rxVoicePacket(pkt);
+                pkt.SequenceCounter++;
+            }
+            simulation.getAudioFrame(output.data());
+        }
+        EXPECT_EQ(simulation.AudiableAudioStreams[0].load(), 3);
+        EXPECT_EQ(simulation.getStreamStatistics().size(), 3);
+
+        memoryStats = simulation.getRealtimeMemoryStats();
+        EXPECT_EQ(memoryStats.StreamSlotsFree, 0);
+        EXPECT_EQ(memoryStats.StreamSlotMisses, 1);
+
+        // the slots go back in the pool, with their counters cleared, when the streams are dropped.
+        simulation.reset();
+        memoryStats = simulation.getRealtimeMemoryStats();
+        EXPECT_EQ(memoryStats.StreamSlotsFree, 2);
+
+        streams[0].SequenceCounter = 0;
+        simulation.rxVoicePacket(streams[0]);
+        const auto streamStats = simulation.getStreamStatistics();
+        ASSERT_EQ(streamStats.size(), 1);
+        EXPECT_EQ(streamStats[0].PacketsReceived, 1);
+        EXPECT_EQ(simulation.getRealtimeMemoryStats().StreamSlotsFree, 1);
+    }
+    event_base_free(evBase);
+}
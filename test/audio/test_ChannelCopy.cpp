@@ -0,0 +1,105 @@
+/* test/audio/test_ChannelCopy.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "afv-native/audio/ChannelCopy.h"
+
+using namespace afv_native::audio;
+
+namespace {
+    std::vector<SampleType> makeRamp(size_t count)
+    {
+        std::vector<SampleType> ramp(count);
+        for (size_t i = 0; i < count; i++) {
+            ramp[i] = static_cast<SampleType>(i + 1);
+        }
+        return ramp;
+    }
+}
+
+TEST(ChannelCopy, Contiguous)
+{
+    auto src = makeRamp(37);
+    std::vector<SampleType> area(37, 0.0f);
+    copyToStrided(src.data(), reinterpret_cast<char *>(area.data()), sizeof(SampleType), src.size());
+    EXPECT_EQ(area, src);
+
+    std::vector<SampleType> dst(37, 0.0f);
+    copyFromStrided(reinterpret_cast<const char *>(area.data()), sizeof(SampleType), dst.data(), dst.size());
+    EXPECT_EQ(dst, src);
+}
+
+TEST(ChannelCopy, Strided)
+{
+    const size_t channels = 3;
+    auto src = makeRamp(37);
+    std::vector<SampleType> area(src.size() * channels, 0.0f);
+    // write into the middle channel of a 3 channel interleaved area.
+    copyToStrided(src.data(), reinterpret_cast<char *>(area.data() + 1), channels * sizeof(SampleType),
+                  src.size());
+    for (size_t i = 0; i < src.size(); i++) {
+        EXPECT_EQ(area[i * channels], 0.0f);
+        EXPECT_EQ(area[i * channels + 1], src[i]);
+        EXPECT_EQ(area[i * channels + 2], 0.0f);
+    }
+
+    std::vector<SampleType> dst(src.size(), 0.0f);
+    copyFromStrided(reinterpret_cast<const char *>(area.data() + 1), channels * sizeof(SampleType), dst.data(),
+                    dst.size());
+    EXPECT_EQ(dst, src);
+}
+
+TEST(ChannelCopy, UnalignedStep)
+{
+    const size_t step = sizeof(SampleType) + 2;
+    auto src = makeRamp(11);
+    std::vector<char> area(src.size() * step + 1, 0);
+    copyToStrided(src.data(), area.data() + 1, step, src.size());
+
+    std::vector<SampleType> dst(src.size(), 0.0f);
+    copyFromStrided(area.data() + 1, step, dst.data(), dst.size());
+    EXPECT_EQ(dst, src);
+}
+
+TEST(ChannelCopy, DuplicateToStereo)
+{
+    auto src = makeRamp(37);
+    std::vector<SampleType> dst(src.size() * 2, 0.0f);
+    duplicateToStereo(src.data(), dst.data(), src.size());
+    for (size_t i = 0; i < src.size(); i++) {
+        EXPECT_EQ(dst[2 * i], src[i]);
+        EXPECT_EQ(dst[2 * i + 1], src[i]);
+    }
+}
@@ -0,0 +1,115 @@
+/* test/audio/test_DecimatingSink.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include <afv-native/audio/audio_params.h>
+#include <afv-native/audio/DecimatingSink.h>
+#include <afv-native/audio/ISampleSink.h>
+
+using namespace afv_native::audio;
+
+class TestDecimatedSink: public ISampleSink {
+public:
+    std::vector<SampleType> mReceived;
+    size_t mFrameSize;
+    size_t mFrameCount;
+
+    explicit TestDecimatedSink(size_t frameSize):
+            mReceived(),
+            mFrameSize(frameSize),
+            mFrameCount(0)
+    {
+    }
+
+    void putAudioFrame(const SampleType *bufferIn) override
+    {
+        mFrameCount++;
+        mReceived.insert(mReceived.end(), bufferIn, bufferIn + mFrameSize);
+    }
+};
+
+static void feedTone(DecimatingSink &sink, float freqHz, size_t frames)
+{
+    std::vector<SampleType> frame(frameSizeSamples);
+    size_t t = 0;
+    for (size_t f = 0; f < frames; f++) {
+        for (auto &s: frame) {
+            s = static_cast<SampleType>(0.5 * std::sin(2.0 * M_PI * freqHz * t++ / sampleRateHz));
+        }
+        sink.putAudioFrame(frame.data());
+    }
+}
+
+static float peakAfter(const std::vector<SampleType> &buf, size_t skip)
+{
+    float peak = 0.0f;
+    for (size_t i = skip; i < buf.size(); i++) {
+        peak = std::max(peak, std::fabs(buf[i]));
+    }
+    return peak;
+}
+
+TEST(DecimatingSink, FrameSize)
+{
+    auto ts = std::make_shared<TestDecimatedSink>(narrowbandFrameSizeSamples);
+    DecimatingSink decimator(ts, narrowbandDecimationFactor);
+    ASSERT_EQ(decimator.getOutputFrameSize(), narrowbandFrameSizeSamples);
+
+    std::vector<SampleType> frame(frameSizeSamples, 0.0f);
+    decimator.putAudioFrame(frame.data());
+    decimator.putAudioFrame(frame.data());
+    EXPECT_EQ(ts->mFrameCount, 2);
+}
+
+TEST(DecimatingSink, PassesVoiceBand)
+{
+    auto ts = std::make_shared<TestDecimatedSink>(narrowbandFrameSizeSamples);
+    DecimatingSink decimator(ts, narrowbandDecimationFactor);
+
+    feedTone(decimator, 1000.0f, 5);
+    EXPECT_NEAR(peakAfter(ts->mReceived, narrowbandFrameSizeSamples), 0.5f, 0.01f);
+}
+
+TEST(DecimatingSink, RejectsAliases)
+{
+    auto ts = std::make_shared<TestDecimatedSink>(narrowbandFrameSizeSamples);
+    DecimatingSink decimator(ts, narrowbandDecimationFactor);
+
+    // 12kHz would alias straight back down to 4kHz without the filter.
+    feedTone(decimator, 12000.0f, 5);
+    EXPECT_LT(peakAfter(ts->mReceived, narrowbandFrameSizeSamples), 0.5f * 0.001f);
+}
@@ -0,0 +1,191 @@
+/* test/audio/test_FileAudioDevice.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <afv-native/audio/FileAudioDevice.h>
+#include <afv-native/audio/ISampleSink.h>
+#include <afv-native/audio/ISampleSource.h>
+#include <afv-native/audio/NullAudioDevice.h>
+#include <afv-native/audio/WavFile.h>
+#include <afv-native/audio/WavSampleStorage.h>
+#include <afv-native/audio/WavWriter.h>
+
+using namespace afv_native::audio;
+
+namespace {
+    class ConstantSource: public ISampleSource {
+    public:
+        std::atomic<size_t> mFrames{0};
+        SampleType mValue;
+
+        explicit ConstantSource(SampleType value):
+                mValue(value)
+        {
+        }
+
+        SourceStatus getAudioFrame(SampleType *bufferOut) override
+        {
+            mFrames++;
+            for (size_t i = 0; i < frameSizeSamples; i++) {
+                bufferOut[i] = mValue;
+            }
+            return SourceStatus::OK;
+        }
+    };
+
+    class CollectingSink: public ISampleSink {
+    public:
+        std::vector<SampleType> mReceived;
+        std::atomic<size_t> mFrames{0};
+
+        void putAudioFrame(const SampleType *bufferIn) override
+        {
+            mFrames++;
+            mReceived.insert(mReceived.end(), bufferIn, bufferIn + frameSizeSamples);
+        }
+    };
+
+    std::vector<SampleType> makeTone(size_t count)
+    {
+        std::vector<SampleType> tone(count);
+        for (size_t i = 0; i < count; i++) {
+            tone[i] = static_cast<SampleType>(0.5 * std::sin(2.0 * M_PI * 1000.0 * i / sampleRateHz));
+        }
+        return tone;
+    }
+
+    std::unique_ptr<WavSampleStorage> loadSamples(const std::string &fileName)
+    {
+        std::unique_ptr<AudioSampleData> data(LoadWav(fileName.c_str()));
+        if (!data) {
+            return nullptr;
+        }
+        return std::unique_ptr<WavSampleStorage>(new WavSampleStorage(*data));
+    }
+}
+
+TEST(WavWriter, RoundTrip)
+{
+    const std::string fileName = "test_wavwriter.wav";
+    auto tone = makeTone(4801);
+    {
+        WavWriter writer;
+        ASSERT_TRUE(writer.open(fileName));
+        ASSERT_TRUE(writer.writeSamples(tone.data(), tone.size()));
+        EXPECT_EQ(writer.getSamplesWritten(), tone.size());
+    }
+    auto loaded = loadSamples(fileName);
+    ASSERT_TRUE(loaded);
+    ASSERT_EQ(loaded->lengthInSamples(), tone.size());
+    for (size_t i = 0; i < tone.size(); i++) {
+        EXPECT_NEAR(loaded->data()[i], tone[i], 1.0f / 16384.0f);
+    }
+    std::remove(fileName.c_str());
+}
+
+TEST(NullAudioDevice, RunsFasterThanRealTime)
+{
+    auto source = std::make_shared<ConstantSource>(0.0f);
+    auto sink = std::make_shared<CollectingSink>();
+    NullAudioDevice device;
+    device.setSpeed(0.0);
+    device.setSource(source);
+    device.setSink(sink);
+
+    const auto start = std::chrono::steady_clock::now();
+    ASSERT_TRUE(device.open());
+    // 500 frames is 10 seconds of audio.
+    while (device.getFramesProcessed() < 500) {
+        std::this_thread::yield();
+    }
+    device.close();
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_LT(elapsed, std::chrono::seconds(5));
+    EXPECT_GE(source->mFrames.load(), 500);
+    EXPECT_GE(sink->mFrames.load(), 500);
+}
+
+TEST(FileAudioDevice, ReadsAndWritesWav)
+{
+    const std::string inputFileName = "test_fileaudio_in.wav";
+    const std::string outputFileName = "test_fileaudio_out.wav";
+    const size_t inputFrames = 20;
+    auto tone = makeTone(inputFrames * frameSizeSamples);
+    {
+        WavWriter writer;
+        ASSERT_TRUE(writer.open(inputFileName));
+        writer.writeSamples(tone.data(), tone.size());
+    }
+
+    auto source = std::make_shared<ConstantSource>(0.25f);
+    auto sink = std::make_shared<CollectingSink>();
+    size_t framesProcessed;
+    {
+        FileAudioDevice device(inputFileName, outputFileName);
+        device.setSpeed(0.0);
+        device.setSource(source);
+        device.setSink(sink);
+        ASSERT_TRUE(device.open());
+        while (!device.isInputFinished()) {
+            std::this_thread::yield();
+        }
+        device.close();
+        framesProcessed = device.getFramesProcessed();
+    }
+
+    // the sink should have received the input file, followed by silence.
+    ASSERT_GE(sink->mReceived.size(), tone.size());
+    for (size_t i = 0; i < tone.size(); i++) {
+        EXPECT_NEAR(sink->mReceived[i], tone[i], 1.0f / 16384.0f);
+    }
+    for (size_t i = tone.size(); i < sink->mReceived.size(); i++) {
+        EXPECT_EQ(sink->mReceived[i], 0.0f);
+    }
+
+    // and the output file should have every frame the source rendered.
+    auto output = loadSamples(outputFileName);
+    ASSERT_TRUE(output);
+    EXPECT_EQ(output->lengthInSamples(), framesProcessed * frameSizeSamples);
+    for (size_t i = 0; i < output->lengthInSamples(); i++) {
+        EXPECT_NEAR(output->data()[i], 0.25f, 1.0f / 16384.0f);
+    }
+    std::remove(inputFileName.c_str());
+    std::remove(outputFileName.c_str());
+}
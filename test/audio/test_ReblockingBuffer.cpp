@@ -0,0 +1,106 @@
+/* test/audio/test_ReblockingBuffer.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <gtest/gtest.h>
+#include <vector>
+
+#include <afv-native/audio/ReblockingBuffer.h>
+
+using namespace afv_native::audio;
+
+TEST(ReblockingBuffer, CapacityIsPowerOfTwo)
+{
+    ReblockingBuffer rb(1000);
+    EXPECT_EQ(rb.getCapacity(), 1024);
+    EXPECT_EQ(rb.getAvailable(), 0);
+    EXPECT_EQ(rb.getSpace(), 1024);
+}
+
+TEST(ReblockingBuffer, VariableBlocksPreserveOrder)
+{
+    ReblockingBuffer rb(64);
+    std::vector<SampleType> in(64), out(64);
+    size_t nextIn = 0, nextOut = 0;
+    // push and pull blocks of co-prime sizes so we hit every wrap position.
+    for (int iter = 0; iter < 200; iter++) {
+        const size_t writeSize = 7 + (iter % 5);
+        for (size_t i = 0; i < writeSize; i++) {
+            in[i] = static_cast<SampleType>(nextIn++);
+        }
+        ASSERT_EQ(rb.write(in.data(), writeSize), writeSize);
+        const size_t readSize = std::min<size_t>(rb.getAvailable(), 5 + (iter % 9));
+        ASSERT_EQ(rb.read(out.data(), readSize), readSize);
+        for (size_t i = 0; i < readSize; i++) {
+            ASSERT_EQ(out[i], static_cast<SampleType>(nextOut++));
+        }
+        EXPECT_EQ(rb.getLatencySamples(), nextIn - nextOut);
+    }
+}
+
+TEST(ReblockingBuffer, ContiguousBlocksArePassedThrough)
+{
+    ReblockingBuffer rb(16);
+    auto *wp = rb.beginWrite(8);
+    for (int i = 0; i < 8; i++) {
+        wp[i] = static_cast<SampleType>(i);
+    }
+    rb.endWrite(8);
+
+    auto *rp = rb.beginRead(8);
+    EXPECT_EQ(rp, wp) << "contiguous read should point straight into the ring";
+    rb.endRead(8);
+}
+
+TEST(ReblockingBuffer, WrappedBlocksAreStaged)
+{
+    ReblockingBuffer rb(16);
+    std::vector<SampleType> in(12, 0.0f);
+    rb.write(in.data(), 12);
+    std::vector<SampleType> out(12);
+    rb.read(out.data(), 12);
+
+    // this write crosses the end of the ring.
+    auto *wp = rb.beginWrite(8);
+    for (int i = 0; i < 8; i++) {
+        wp[i] = static_cast<SampleType>(100 + i);
+    }
+    rb.endWrite(8);
+    ASSERT_EQ(rb.getAvailable(), 8);
+
+    const auto *rp = rb.beginRead(8);
+    for (int i = 0; i < 8; i++) {
+        EXPECT_EQ(rp[i], static_cast<SampleType>(100 + i));
+    }
+    rb.endRead(8);
+    EXPECT_EQ(rb.getAvailable(), 0);
+}
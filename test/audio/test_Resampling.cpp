@@ -0,0 +1,169 @@
+/* test/audio/test_Resampling.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include <afv-native/audio/audio_params.h>
+#include <afv-native/audio/ISampleSink.h>
+#include <afv-native/audio/ISampleSource.h>
+#include <afv-native/audio/ResamplingSink.h>
+#include <afv-native/audio/ResamplingSource.h>
+
+using namespace afv_native::audio;
+
+namespace {
+    const unsigned int deviceRate = 44100;
+    const unsigned int deviceFrameSize = deviceRate * frameLengthMs / 1000;
+    const float toneHz = 1000.0f;
+
+    class ToneSource: public ISampleSource {
+    public:
+        size_t mT = 0;
+        size_t mFramesLeft;
+
+        explicit ToneSource(size_t frames):
+                mFramesLeft(frames)
+        {
+        }
+
+        SourceStatus getAudioFrame(SampleType *bufferOut) override
+        {
+            if (mFramesLeft == 0) {
+                return SourceStatus::Closed;
+            }
+            mFramesLeft--;
+            for (size_t i = 0; i < frameSizeSamples; i++) {
+                bufferOut[i] = static_cast<SampleType>(0.5 * std::sin(2.0 * M_PI * toneHz * mT++ / sampleRateHz));
+            }
+            return SourceStatus::OK;
+        }
+    };
+
+    class CollectingSink: public ISampleSink {
+    public:
+        std::vector<SampleType> mReceived;
+        size_t mFrameCount = 0;
+
+        void putAudioFrame(const SampleType *bufferIn) override
+        {
+            mFrameCount++;
+            mReceived.insert(mReceived.end(), bufferIn, bufferIn + frameSizeSamples);
+        }
+    };
+
+    float peakAfter(const std::vector<SampleType> &buf, size_t skip)
+    {
+        float peak = 0.0f;
+        for (size_t i = skip; i < buf.size(); i++) {
+            peak = std::max(peak, std::fabs(buf[i]));
+        }
+        return peak;
+    }
+}
+
+TEST(ResamplingSource, ProducesDeviceFrames)
+{
+    const size_t frames = 50;
+    auto tone = std::make_shared<ToneSource>(frames);
+    ResamplingSource source(tone, deviceRate, deviceFrameSize);
+
+    std::vector<SampleType> out;
+    std::vector<SampleType> frame(deviceFrameSize);
+    // we should get (about) as many device frames as there were source frames before it runs dry.
+    for (size_t i = 0; i < frames - 2; i++) {
+        ASSERT_EQ(source.getAudioFrame(frame.data()), SourceStatus::OK);
+        out.insert(out.end(), frame.begin(), frame.end());
+    }
+    EXPECT_NEAR(peakAfter(out, deviceFrameSize), 0.5f, 0.05f);
+    EXPECT_LT(source.getLatencySamples(), deviceFrameSize * 2);
+
+    // drain it - once the source has gone and the residual samples are consumed, we should see it close.
+    SourceStatus rv = SourceStatus::OK;
+    for (size_t i = 0; i < 10 && rv == SourceStatus::OK; i++) {
+        rv = source.getAudioFrame(frame.data());
+    }
+    EXPECT_EQ(rv, SourceStatus::Closed);
+}
+
+TEST(ResamplingSource, GetAudioFramesUsesDeviceFrameSize)
+{
+    auto tone = std::make_shared<ToneSource>(20);
+    ResamplingSource source(tone, deviceRate, deviceFrameSize);
+    ASSERT_EQ(source.getFrameSizeSamples(), deviceFrameSize);
+
+    // guard samples either side of two device frames - none of them should be touched.
+    const SampleType guard = 12.0f;
+    std::vector<SampleType> buf(deviceFrameSize * 2 + 2 * frameSizeSamples, guard);
+    SampleType *frames = buf.data() + frameSizeSamples;
+    ASSERT_EQ(source.getAudioFrames(frames, 2), SourceStatus::OK);
+    for (size_t i = 0; i < frameSizeSamples; i++) {
+        ASSERT_EQ(buf[i], guard);
+        ASSERT_EQ(frames[deviceFrameSize * 2 + i], guard);
+    }
+    EXPECT_NEAR(peakAfter(std::vector<SampleType>(frames + deviceFrameSize, frames + deviceFrameSize * 2), 0),
+                0.5f, 0.05f);
+
+    // once it runs dry, the remainder is silence filled - again without straying past the end.
+    SourceStatus rv = SourceStatus::OK;
+    for (size_t i = 0; i < 20 && rv == SourceStatus::OK; i++) {
+        rv = source.getAudioFrames(frames, 2);
+    }
+    EXPECT_EQ(rv, SourceStatus::Closed);
+    for (size_t i = 0; i < frameSizeSamples; i++) {
+        ASSERT_EQ(frames[deviceFrameSize * 2 + i], guard);
+    }
+    EXPECT_EQ(peakAfter(std::vector<SampleType>(frames, frames + deviceFrameSize * 2), 0), 0.0f);
+}
+
+TEST(ResamplingSink, ProducesNormalFrames)
+{
+    auto collector = std::make_shared<CollectingSink>();
+    ResamplingSink sink(collector, deviceRate, deviceFrameSize);
+
+    std::vector<SampleType> frame(deviceFrameSize);
+    size_t t = 0;
+    const size_t frames = 100;
+    for (size_t f = 0; f < frames; f++) {
+        for (auto &s: frame) {
+            s = static_cast<SampleType>(0.5 * std::sin(2.0 * M_PI * toneHz * t++ / deviceRate));
+        }
+        sink.putAudioFrame(frame.data());
+    }
+    // a second of audio in should be (very nearly) a second of audio out.
+    EXPECT_GE(collector->mFrameCount, frames - 2);
+    EXPECT_LE(collector->mFrameCount, frames);
+    EXPECT_NEAR(peakAfter(collector->mReceived, frameSizeSamples), 0.5f, 0.05f);
+}
@@ -0,0 +1,101 @@
+/* test/audio/test_SampleFormat.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <vector>
+
+#include "afv-native/audio/SampleFormat.h"
+
+using namespace afv_native::audio;
+
+namespace {
+    std::vector<SampleType> makeTestSignal()
+    {
+        return std::vector<SampleType>{0.0f, 0.5f, -0.5f, 0.25f, -1.0f, 0.999f, 0.001f, -0.001f};
+    }
+
+    void checkRoundTrip(SampleFormat format, size_t step, float tolerance)
+    {
+        auto src = makeTestSignal();
+        std::vector<char> buffer(src.size() * step + 1, 0);
+        // offset by one byte so the strided paths also have to deal with misalignment.
+        char *base = (step == getSampleFormatBytes(format)) ? buffer.data() : buffer.data() + 1;
+        convertToFormat(src.data(), base, step, format, src.size());
+
+        std::vector<SampleType> dst(src.size(), 42.0f);
+        convertFromFormat(base, step, format, dst.data(), dst.size());
+        for (size_t i = 0; i < src.size(); i++) {
+            EXPECT_NEAR(dst[i], src[i], tolerance) << "at sample " << i;
+        }
+    }
+}
+
+TEST(SampleFormat, RoundTripContiguous)
+{
+    checkRoundTrip(SampleFormat::Float32, 4, 0.0f);
+    checkRoundTrip(SampleFormat::Int16, 2, 1.0f / 32768.0f);
+    checkRoundTrip(SampleFormat::Int24, 3, 1.0f / 8388608.0f);
+    checkRoundTrip(SampleFormat::Int32, 4, 1e-6f);
+}
+
+TEST(SampleFormat, RoundTripStrided)
+{
+    checkRoundTrip(SampleFormat::Float32, 12, 0.0f);
+    checkRoundTrip(SampleFormat::Int16, 6, 1.0f / 32768.0f);
+    checkRoundTrip(SampleFormat::Int24, 7, 1.0f / 8388608.0f);
+    checkRoundTrip(SampleFormat::Int32, 9, 1e-6f);
+}
+
+TEST(SampleFormat, ClampsAtFullScale)
+{
+    std::vector<SampleType> src{2.0f, -2.0f};
+    int16_t s16[2];
+    convertToFormat(src.data(), reinterpret_cast<char *>(s16), sizeof(int16_t), SampleFormat::Int16, 2);
+    EXPECT_EQ(s16[0], INT16_MAX);
+    EXPECT_EQ(s16[1], INT16_MIN);
+
+    int32_t s32[2];
+    convertToFormat(src.data(), reinterpret_cast<char *>(s32), sizeof(int32_t), SampleFormat::Int32, 2);
+    EXPECT_GT(s32[0], INT32_MAX - 256);
+    EXPECT_EQ(s32[1], INT32_MIN);
+
+    uint8_t s24[6];
+    convertToFormat(src.data(), reinterpret_cast<char *>(s24), 3, SampleFormat::Int24, 2);
+    EXPECT_EQ(s24[0], 0xFF);
+    EXPECT_EQ(s24[1], 0xFF);
+    EXPECT_EQ(s24[2], 0x7F);
+    EXPECT_EQ(s24[3], 0x00);
+    EXPECT_EQ(s24[4], 0x00);
+    EXPECT_EQ(s24[5], 0x80);
+}
@@ -33,6 +33,7 @@
 
 #include <gtest/gtest.h>
 #include <memory>
+#include <vector>
 
 #include <afv-native/audio/audio_params.h>
 #include <afv-native/audio/ISampleSink.h>
@@ -113,4 +114,44 @@ TEST(SinkFrameSizeAdjuster, SmallerSinkTest)
     EXPECT_EQ(ts->mBufferFillCount, 1);
 
     delete[] testSourceBuffer;
-}
\ No newline at end of file
+}
+
+TEST(SinkFrameSizeAdjuster, MuchLargerSinkTest)
+{
+    const size_t input_frame_size = frameSizeSamples * 3 + 100;
+    auto ts = std::make_shared<TestSinkAdapter>(input_frame_size);
+    SinkFrameSizeAdjuster testAdjuster(ts, input_frame_size);
+
+    auto *testSourceBuffer = new SampleType[input_frame_size];
+    for (size_t i = 0; i < input_frame_size; i++) {
+        testSourceBuffer[i] = static_cast<SampleType>(i);
+    }
+
+    ASSERT_EQ(ts->mBufferFillCount, 0);
+    testAdjuster.putAudioFrame(testSourceBuffer);
+    EXPECT_EQ(ts->mBufferFillCount, 3);
+    testAdjuster.putAudioFrame(testSourceBuffer);
+    EXPECT_EQ(ts->mBufferFillCount, 6);
+
+    delete[] testSourceBuffer;
+}
+
+TEST(SinkFrameSizeAdjuster, VariableSizeTest)
+{
+    auto ts = std::make_shared<TestSinkAdapter>(frameSizeSamples * 8);
+    SinkFrameSizeAdjuster testAdjuster(ts, frameSizeSamples / 2);
+
+    std::vector<SampleType> testSourceBuffer(frameSizeSamples * 8);
+    for (size_t i = 0; i < testSourceBuffer.size(); i++) {
+        testSourceBuffer[i] = static_cast<SampleType>(i);
+    }
+    const size_t blockSizes[] = {17, frameSizeSamples, frameSizeSamples * 2 + 5, 1, frameSizeSamples - 18,
+                                 frameSizeSamples * 3 - 5};
+    size_t offset = 0;
+    for (auto blockSize: blockSizes) {
+        testAdjuster.putAudioSamples(testSourceBuffer.data() + offset, blockSize);
+        offset += blockSize;
+        EXPECT_EQ(ts->mBufferFillCount, offset / frameSizeSamples);
+        EXPECT_EQ(testAdjuster.getLatencySamples(), offset % frameSizeSamples);
+    }
+}
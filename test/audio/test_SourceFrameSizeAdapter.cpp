@@ -33,6 +33,7 @@
 
 #include <gtest/gtest.h>
 #include <memory>
+#include <vector>
 
 #include <afv-native/audio/audio_params.h>
 #include <afv-native/audio/ISampleSource.h>
@@ -110,4 +111,33 @@ TEST(SourceFrameSizeAdjuster, SmallerSourceTest)
 	EXPECT_EQ(testSinkBuffer[idx], -100.0) << "overwrote past the end of the buffer";
 	
     delete[] testSinkBuffer;
-}
\ No newline at end of file
+}
+
+TEST(SourceFrameSizeAdjuster, VariableSizeTest)
+{
+    auto ts = std::make_shared<TestSourceAdapter>();
+    SourceFrameSizeAdjuster testAdjuster(ts, frameSizeSamples / 2, frameSizeSamples * 2);
+
+    std::vector<SampleType> testSinkBuffer(frameSizeSamples * 3);
+    int expectedValue = 0;
+    const size_t requestSizes[] = {17, frameSizeSamples, frameSizeSamples * 2 + 5, 1, frameSizeSamples - 18};
+    for (auto requestSize: requestSizes) {
+        ASSERT_EQ(testAdjuster.getAudioSamples(testSinkBuffer.data(), requestSize), SourceStatus::OK);
+        for (size_t idx = 0; idx < requestSize; idx++) {
+            ASSERT_EQ(static_cast<SampleType>(expectedValue), testSinkBuffer[idx]) << "request size " << requestSize;
+            expectedValue = (expectedValue + 1) % frameSizeSamples;
+        }
+    }
+    for (auto requestSize: requestSizes) {
+        if (requestSize > frameSizeSamples * 2) {
+            continue;
+        }
+        const SampleType *block = testAdjuster.peekSamples(requestSize);
+        for (size_t idx = 0; idx < requestSize; idx++) {
+            ASSERT_EQ(static_cast<SampleType>(expectedValue), block[idx]) << "peek size " << requestSize;
+            expectedValue = (expectedValue + 1) % frameSizeSamples;
+        }
+        testAdjuster.consumeSamples(requestSize);
+        EXPECT_LT(testAdjuster.getLatencySamples(), frameSizeSamples);
+    }
+}
@@ -0,0 +1,231 @@
+/* test/core/test_Log.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "afv-native/Log.h"
+#include "afv-native/util/RealtimeGuard.h"
+#include <gtest/gtest.h>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace afv_native;
+
+namespace {
+    std::mutex gCapturedLock;
+    std::vector<std::string> gCaptured;
+    std::thread::id gCapturingThread;
+
+    void captureLogger(const char *subsystem, const char *file, int line, const char *lineOut)
+    {
+        std::lock_guard<std::mutex> capturedGuard(gCapturedLock);
+        gCaptured.emplace_back(lineOut);
+        gCapturingThread = std::this_thread::get_id();
+    }
+
+    class LogTest: public ::testing::Test {
+    protected:
+        void SetUp() override
+        {
+            flushLog();
+            setLogger(captureLogger);
+            std::lock_guard<std::mutex> capturedGuard(gCapturedLock);
+            gCaptured.clear();
+        }
+
+        void TearDown() override
+        {
+            setLogLevel(LogLevel::Info);
+            setLogAsynchronous(true);
+            flushLog();
+            setLogger(nullptr);
+        }
+
+        std::vector<std::string> captured()
+        {
+            std::lock_guard<std::mutex> capturedGuard(gCapturedLock);
+            return gCaptured;
+        }
+
+        std::thread::id capturingThread()
+        {
+            std::lock_guard<std::mutex> capturedGuard(gCapturedLock);
+            return gCapturingThread;
+        }
+    };
+}
+
+TEST_F(LogTest, FlushDeliversPendingLinesFromWriterThread)
+{
+    LOG("test", "line %d", 1);
+    LOG("test", "line %d", 2);
+    flushLog();
+
+    auto lines = captured();
+    ASSERT_EQ(lines.size(), 2);
+    EXPECT_EQ(lines[0], "line 1");
+    EXPECT_EQ(lines[1], "line 2");
+    EXPECT_NE(capturingThread(), std::this_thread::get_id());
+}
+
+TEST_F(LogTest, LongLinesAreTruncated)
+{
+    std::string longLine(logRecordTextSize * 2, 'x');
+    LOG("test", "%s", longLine.c_str());
+    flushLog();
+
+    auto lines = captured();
+    ASSERT_EQ(lines.size(), 1);
+    EXPECT_EQ(lines[0].size(), logRecordTextSize - 1);
+}
+
+TEST_F(LogTest, RepeatedLinesAreRateLimited)
+{
+    for (int i = 0; i < 100; i++) {
+        LOG("test", "repeated %d", i);
+    }
+    flushLog();
+
+    auto lines = captured();
+    EXPECT_GT(lines.size(), 0);
+    EXPECT_LT(lines.size(), 100);
+}
+
+TEST_F(LogTest, HexDumpsCountOnceAgainstTheRateLimit)
+{
+    setLogLevel(LogLevel::Debug);
+    // a full-size datagram's worth of dump is far more lines than the rate limit allows.
+    std::vector<unsigned char> datagram(1200);
+    LOGDUMPHEX("test", datagram.data(), datagram.size());
+    flushLog();
+    EXPECT_EQ(captured().size(), 75);
+
+    // but repeated dumps from the one call site are still limited.
+    for (int i = 0; i < 100; i++) {
+        LOGDUMPHEX("test", datagram.data(), 32);
+    }
+    flushLog();
+    auto lines = captured();
+    EXPECT_GT(lines.size(), 75);
+    EXPECT_LT(lines.size(), 75 + 200);
+    EXPECT_EQ((lines.size() - 75) % 2, 0);
+}
+
+TEST_F(LogTest, LinesFromManyThreadsAreDelivered)
+{
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([t]() {
+            for (int i = 0; i < 5; i++) {
+                LOG("test", "thread %d line %d", t, i);
+            }
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    flushLog();
+
+    EXPECT_EQ(captured().size(), 20);
+}
+
+TEST_F(LogTest, RealtimeThreadsUseSpareRings)
+{
+    prepareRealtimeLogging();
+    util::resetRealtimeAllocationStats();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 2; t++) {
+        threads.emplace_back([t]() {
+            util::RealtimeScope realtime;
+            for (int i = 0; i < 5; i++) {
+                LOG("test", "realtime thread %d line %d", t, i);
+            }
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    flushLog();
+
+    EXPECT_EQ(captured().size(), 10);
+    EXPECT_EQ(util::getRealtimeAllocationStats().Allocations, 0);
+}
+
+TEST_F(LogTest, SynchronousLoggingCallsLoggerDirectly)
+{
+    setLogAsynchronous(false);
+    std::string longLine(logRecordTextSize * 2, 'y');
+    LOG("test", "%s", longLine.c_str());
+
+    auto lines = captured();
+    ASSERT_EQ(lines.size(), 1);
+    EXPECT_EQ(lines[0], longLine);
+    EXPECT_EQ(capturingThread(), std::this_thread::get_id());
+}
+
+TEST_F(LogTest, LinesBelowThresholdAreNotFormatted)
+{
+    int evaluated = 0;
+    auto countEvaluation = [&evaluated]() {
+        evaluated++;
+        return evaluated;
+    };
+
+    setLogLevel(LogLevel::Warning);
+    LOGDEBUG("test", "debug %d", countEvaluation());
+    LOG("test", "info %d", countEvaluation());
+    LOGWARN("test", "warning %d", countEvaluation());
+    LOGERROR("test", "error %d", countEvaluation());
+    flushLog();
+
+    EXPECT_EQ(evaluated, 2);
+    auto lines = captured();
+    ASSERT_EQ(lines.size(), 2);
+    EXPECT_EQ(lines[0], "warning 1");
+    EXPECT_EQ(lines[1], "error 2");
+}
+
+#if AFV_NATIVE_LOG_MIN_LEVEL <= AFV_NATIVE_LOG_LEVEL_DEBUG
+TEST_F(LogTest, LoweringThresholdEnablesDebugLines)
+{
+    setLogLevel(LogLevel::Debug);
+    EXPECT_TRUE(isLogLevelEnabled(LogLevel::Debug));
+    EXPECT_FALSE(isLogLevelEnabled(LogLevel::Trace));
+    LOGDEBUG("test", "debug line");
+    flushLog();
+
+    auto lines = captured();
+    ASSERT_EQ(lines.size(), 1);
+    EXPECT_EQ(lines[0], "debug line");
+}
+#endif
@@ -0,0 +1,147 @@
+/* test/event/test_EventLoopThread.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <vector>
+
+#include "afv-native/event/EventCallbackTimer.h"
+#include "afv-native/event/EventLoopThread.h"
+
+using namespace afv_native;
+using namespace afv_native::event;
+using namespace std;
+
+TEST(EventLoopThread, RunsPostedCommandsInOrderOnTheLoopThread) {
+    EventLoopThread loop;
+    vector<int> ran;
+    atomic<int> offThread(0);
+
+    // commands posted before the loop starts wait for it.
+    loop.post([&]() {
+        ran.push_back(0);
+        if (!loop.isLoopThread()) {
+            offThread++;
+        }
+    });
+    EXPECT_TRUE(ran.empty());
+    EXPECT_FALSE(loop.isLoopThread());
+
+    loop.start();
+    for (int i = 1; i < 100; i++) {
+        loop.post([&, i]() {
+            ran.push_back(i);
+            if (!loop.isLoopThread()) {
+                offThread++;
+            }
+        });
+    }
+    loop.stop();
+
+    ASSERT_EQ(ran.size(), 100u);
+    for (int i = 0; i < 100; i++) {
+        EXPECT_EQ(ran[i], i);
+    }
+    EXPECT_EQ(offThread.load(), 0);
+}
+
+TEST(EventLoopThread, CallWaitsForTheCommand) {
+    EventLoopThread loop;
+    loop.start();
+
+    std::thread::id ranOn;
+    loop.call([&]() {
+        this_thread::sleep_for(chrono::milliseconds(20));
+        ranOn = this_thread::get_id();
+    });
+    EXPECT_NE(ranOn, std::thread::id());
+    EXPECT_NE(ranOn, this_thread::get_id());
+
+    // calls from the loop thread itself mustn't deadlock.
+    bool nested = false;
+    loop.call([&]() {
+        loop.call([&]() {
+            nested = loop.isLoopThread();
+        });
+    });
+    EXPECT_TRUE(nested);
+
+    loop.stop();
+    // once stopped, calls just run here.
+    loop.call([&]() {
+        ranOn = this_thread::get_id();
+    });
+    EXPECT_EQ(ranOn, this_thread::get_id());
+}
+
+TEST(EventLoopThread, ServicesTimersOnItsBase) {
+    EventLoopThread loop;
+    promise<std::thread::id> fired;
+    EventCallbackTimer timer(loop.getEventBase(), [&fired]() {
+        fired.set_value(this_thread::get_id());
+    });
+    timer.enable(10);
+    loop.start();
+
+    auto firedFuture = fired.get_future();
+    ASSERT_EQ(firedFuture.wait_for(chrono::seconds(5)), future_status::ready);
+    EXPECT_NE(firedFuture.get(), this_thread::get_id());
+    loop.stop();
+}
+
+TEST(EventLoopThread, ManyProducers) {
+    EventLoopThread loop;
+    loop.start();
+
+    const int producers = 4;
+    const int perProducer = 1000;
+    atomic<int> ran(0);
+    vector<thread> threads;
+    for (int p = 0; p < producers; p++) {
+        threads.emplace_back([&]() {
+            for (int i = 0; i < perProducer; i++) {
+                loop.post([&ran]() {
+                    ran++;
+                });
+            }
+        });
+    }
+    for (auto &t: threads) {
+        t.join();
+    }
+    loop.stop();
+    EXPECT_EQ(ran.load(), producers * perProducer);
+}
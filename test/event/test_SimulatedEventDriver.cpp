@@ -0,0 +1,169 @@
+/* test/event/test_SimulatedEventDriver.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+#include <event2/event.h>
+
+#include "afv-native/event/EventCallbackTimer.h"
+#include "afv-native/event/SimulatedEventDriver.h"
+#include "afv-native/util/monotime.h"
+
+using namespace afv_native;
+using namespace afv_native::event;
+using namespace std;
+
+TEST(SimulatedEventDriver, FiresInDeadlineOrder) {
+    SimulatedEventDriver driver(nullptr, 1000);
+    vector<int> fired;
+
+    EventCallbackTimer late(nullptr, [&fired]() { fired.push_back(3); });
+    EventCallbackTimer tieA(nullptr, [&fired]() { fired.push_back(1); });
+    EventCallbackTimer tieB(nullptr, [&fired]() { fired.push_back(2); });
+    EventCallbackTimer early(nullptr, [&fired]() { fired.push_back(0); });
+
+    late.enable(500);
+    tieA.enable(200);
+    tieB.enable(200);
+    early.enable(50);
+    EXPECT_EQ(driver.pendingTimers(), 4u);
+    EXPECT_EQ(driver.nextDeadline(), 1050);
+
+    EXPECT_EQ(driver.advance(199), 1u);
+    EXPECT_TRUE(tieA.pending());
+    EXPECT_EQ(driver.advance(1000), 3u);
+    EXPECT_EQ(fired, (vector<int>{0, 1, 2, 3}));
+    EXPECT_EQ(driver.now(), 2199);
+    EXPECT_EQ(driver.nextDeadline(), -1);
+}
+
+TEST(SimulatedEventDriver, RearmAndDisable) {
+    SimulatedEventDriver driver(nullptr);
+    int count = 0;
+    EventCallbackTimer timer(nullptr, [&count]() { count++; });
+
+    timer.enable(100);
+    timer.enable(300);
+    EXPECT_EQ(driver.advance(200), 0u);
+    EXPECT_TRUE(timer.pending());
+    timer.disable();
+    EXPECT_FALSE(timer.pending());
+    EXPECT_EQ(driver.advance(1000), 0u);
+    EXPECT_EQ(count, 0);
+}
+
+TEST(SimulatedEventDriver, PeriodicTimerOverHours) {
+    SimulatedEventDriver driver(nullptr, 0);
+    driver.installClock();
+
+    const unsigned int intervalMs = 30 * 1000;
+    vector<util::monotime_t> stamps;
+    unique_ptr<EventCallbackTimer> timer;
+    timer.reset(new EventCallbackTimer(nullptr, [&]() {
+        stamps.push_back(util::monotime_get());
+        timer->enable(intervalMs);
+    }));
+    timer->enable(intervalMs);
+
+    const util::monotime_t sixHours = 6 * 60 * 60 * 1000;
+    EXPECT_EQ(driver.advance(sixHours), 720u);
+    ASSERT_EQ(stamps.size(), 720u);
+    for (size_t i = 0; i < stamps.size(); i++) {
+        EXPECT_EQ(stamps[i], static_cast<util::monotime_t>((i + 1) * intervalMs));
+    }
+    EXPECT_EQ(util::monotime_get(), sixHours);
+    EXPECT_EQ(driver.runUntilIdle(intervalMs), 1u);
+}
+
+TEST(SimulatedEventDriver, CallbackMayDestroyTimers) {
+    SimulatedEventDriver driver(nullptr);
+    int count = 0;
+    unique_ptr<EventCallbackTimer> victim(new EventCallbackTimer(nullptr, [&count]() { count += 100; }));
+    EventCallbackTimer killer(nullptr, [&]() {
+        count++;
+        victim.reset();
+    });
+
+    killer.enable(10);
+    victim->enable(10);
+    EXPECT_EQ(driver.advance(10), 1u);
+    EXPECT_EQ(count, 1);
+    EXPECT_EQ(driver.pendingTimers(), 0u);
+}
+
+TEST(SimulatedEventDriver, ClockRestoredOnDestruction) {
+    {
+        SimulatedEventDriver driver(nullptr, 5);
+        driver.installClock();
+        EXPECT_EQ(util::monotime_get(), 5);
+    }
+    // the steady clock is nowhere near the start of the simulation.
+    EXPECT_GT(util::monotime_get(), 5);
+}
+
+TEST(SimulatedEventDriver, TimerOutlivesDriver) {
+    unique_ptr<SimulatedEventDriver> driver(new SimulatedEventDriver(nullptr));
+    int count = 0;
+    EventCallbackTimer timer(nullptr, [&count]() { count++; });
+    timer.enable(10);
+    driver.reset();
+    EXPECT_FALSE(timer.pending());
+    timer.enable(10);
+    EXPECT_EQ(count, 0);
+}
+
+TEST(SimulatedEventDriver, OtherBasesUseLibevent) {
+    struct event_base *simBase = event_base_new();
+    struct event_base *realBase = event_base_new();
+    SimulatedEventDriver driver(simBase);
+
+    int simCount = 0, realCount = 0;
+    EventCallbackTimer simTimer(simBase, [&simCount]() { simCount++; });
+    EventCallbackTimer realTimer(realBase, [&realCount]() { realCount++; });
+    simTimer.enable(0);
+    realTimer.enable(0);
+
+    event_base_dispatch(realBase);
+    event_base_dispatch(simBase);
+    EXPECT_EQ(realCount, 1);
+    EXPECT_EQ(simCount, 0);
+
+    driver.advance(0);
+    EXPECT_EQ(simCount, 1);
+
+    event_base_free(realBase);
+    event_base_free(simBase);
+}
@@ -0,0 +1,98 @@
+/* test/util/test_DenormalGuard.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "afv-native/util/DenormalGuard.h"
+#include "afv-native/audio/BiQuadFilter.h"
+#include <gtest/gtest.h>
+#include <cfloat>
+#include <cmath>
+
+using namespace afv_native;
+using namespace afv_native::util;
+
+namespace {
+    // volatile, so the multiplications happen at runtime, under whatever FPU mode is in force.
+    volatile float gTiny = 1e-30f;
+    volatile float gScale = 1e-10f;
+
+    float subnormalProduct()
+    {
+        return gTiny * gScale;
+    }
+}
+
+TEST(DenormalGuard, FlushDenormal)
+{
+    EXPECT_EQ(0.0f, flushDenormal(1e-20f));
+    EXPECT_EQ(0.0f, flushDenormal(-1e-20f));
+    EXPECT_EQ(0.0f, flushDenormal(FLT_MIN / 4.0f));
+    EXPECT_EQ(1e-6f, flushDenormal(1e-6f));
+    EXPECT_EQ(-0.5f, flushDenormal(-0.5f));
+}
+
+TEST(DenormalGuard, ScopeFlushesAndRestores)
+{
+    if (!denormalFlushSupported) {
+        return;
+    }
+    EXPECT_EQ(FP_SUBNORMAL, std::fpclassify(subnormalProduct()));
+    {
+        FlushDenormalsScope denormals;
+        EXPECT_EQ(0.0f, subnormalProduct());
+        {
+            FlushDenormalsScope nested;
+            EXPECT_EQ(0.0f, subnormalProduct());
+        }
+        // the inner scope restores the mode the outer one set.
+        EXPECT_EQ(0.0f, subnormalProduct());
+    }
+    EXPECT_EQ(FP_SUBNORMAL, std::fpclassify(subnormalProduct()));
+}
+
+TEST(DenormalGuard, DisabledScopeDoesNothing)
+{
+    FlushDenormalsScope denormals(false);
+    EXPECT_EQ(FP_SUBNORMAL, std::fpclassify(subnormalProduct()));
+}
+
+TEST(DenormalGuard, BiQuadFilterSettlesToZero)
+{
+    auto filter = audio::BiQuadFilter::peakingEqFilter(2200.0f, 0.25f, 13.0f);
+    // a signal fading out: it has to come out of the filter as silence, not as subnormals.
+    float level = 0.5f;
+    for (int i = 0; i < 2000; i++) {
+        const float out = filter.TransformOne((i % 2) ? level : -level);
+        EXPECT_NE(FP_SUBNORMAL, std::fpclassify(out)) << "at sample " << i;
+        level *= 0.9f;
+    }
+    EXPECT_EQ(0.0f, filter.TransformOne(0.0f));
+}
@@ -0,0 +1,141 @@
+/* test/util/test_LatencyHistogram.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "afv-native/util/LatencyHistogram.h"
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+using namespace afv_native::util;
+
+TEST(LatencyHistogram, Buckets)
+{
+    EXPECT_EQ(LatencyHistogramSnapshot::getBucketForUs(0), 0);
+    EXPECT_EQ(LatencyHistogramSnapshot::getBucketForUs(1), 1);
+    EXPECT_EQ(LatencyHistogramSnapshot::getBucketForUs(2), 2);
+    EXPECT_EQ(LatencyHistogramSnapshot::getBucketForUs(3), 2);
+    EXPECT_EQ(LatencyHistogramSnapshot::getBucketForUs(4), 3);
+    EXPECT_EQ(LatencyHistogramSnapshot::getBucketForUs(20000), 15);
+    EXPECT_EQ(LatencyHistogramSnapshot::getBucketForUs(UINT32_MAX), LatencyHistogramSnapshot::bucketCount - 1);
+
+    for (size_t b = 0; b < LatencyHistogramSnapshot::bucketCount - 1; b++) {
+        const uint32_t upper = LatencyHistogramSnapshot::getBucketUpperBoundUs(b);
+        EXPECT_EQ(LatencyHistogramSnapshot::getBucketForUs(upper - 1), b) << "bucket " << b;
+        EXPECT_EQ(LatencyHistogramSnapshot::getBucketForUs(upper), b + 1) << "bucket " << b;
+    }
+}
+
+TEST(LatencyHistogram, RecordAndSummarise)
+{
+    LatencyHistogram h;
+    for (int i = 0; i < 98; i++) {
+        h.record(100);
+    }
+    h.record(5000);
+    h.record(9000);
+
+    auto snap = h.snapshot();
+    EXPECT_EQ(snap.Count, 100);
+    EXPECT_EQ(snap.TotalUs, 98 * 100 + 5000 + 9000);
+    EXPECT_EQ(snap.MaxUs, 9000);
+    EXPECT_DOUBLE_EQ(snap.getMeanUs(), (98.0 * 100 + 5000 + 9000) / 100.0);
+    EXPECT_EQ(snap.Buckets[LatencyHistogramSnapshot::getBucketForUs(100)], 98);
+
+    // 100us is in [64,128) so the median is reported as the top of that bucket.
+    EXPECT_EQ(snap.getPercentileUs(50.0), 128);
+    EXPECT_EQ(snap.getPercentileUs(99.0), 8192);
+    // the top bucket edge would exceed the largest sample, so it's clamped.
+    EXPECT_EQ(snap.getPercentileUs(100.0), 9000);
+}
+
+TEST(LatencyHistogram, EmptyAndReset)
+{
+    LatencyHistogram h;
+    EXPECT_EQ(h.snapshot().getPercentileUs(99.0), 0);
+    EXPECT_EQ(h.snapshot().getMeanUs(), 0.0);
+
+    h.setEnabled(true);
+    h.record(42);
+    h.reset();
+    auto snap = h.snapshot();
+    EXPECT_EQ(snap.Count, 0);
+    EXPECT_EQ(snap.MaxUs, 0);
+    EXPECT_TRUE(h.isEnabled()) << "reset changed the enabled state";
+}
+
+TEST(LatencyHistogram, ScopedLatencyHonoursEnable)
+{
+    LatencyHistogram h;
+    {
+        ScopedLatency t(&h);
+    }
+    EXPECT_EQ(h.snapshot().Count, 0) << "recorded while disabled";
+
+    h.setEnabled(true);
+    {
+        ScopedLatency t(&h);
+    }
+    EXPECT_EQ(h.snapshot().Count, 1);
+
+    // a null histogram is allowed, and does nothing.
+    {
+        ScopedLatency t(nullptr);
+    }
+}
+
+TEST(LatencyHistogram, ConcurrentRecord)
+{
+    LatencyHistogram h;
+    const int threadCount = 4;
+    const int perThread = 10000;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; t++) {
+        threads.emplace_back([&h, t]() {
+            for (int i = 0; i < perThread; i++) {
+                h.record(static_cast<uint32_t>(t * 1000 + (i % 1000)));
+            }
+        });
+    }
+    for (auto &t: threads) {
+        t.join();
+    }
+    auto snap = h.snapshot();
+    EXPECT_EQ(snap.Count, threadCount * perThread);
+    EXPECT_EQ(snap.MaxUs, (threadCount - 1) * 1000 + 999);
+    uint64_t bucketTotal = 0;
+    for (auto b: snap.Buckets) {
+        bucketTotal += b;
+    }
+    EXPECT_EQ(bucketTotal, snap.Count);
+}
@@ -0,0 +1,100 @@
+/* test/util/test_MpscQueue.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "afv-native/util/MpscQueue.h"
+#include <gtest/gtest.h>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace afv_native::util;
+
+TEST(MpscQueue, FifoOrder)
+{
+    MpscQueue<int> queue;
+    int value = -1;
+    EXPECT_FALSE(queue.pop(value));
+
+    for (int i = 0; i < 10; i++) {
+        queue.push(i);
+    }
+    for (int i = 0; i < 10; i++) {
+        ASSERT_TRUE(queue.pop(value));
+        EXPECT_EQ(value, i);
+    }
+    EXPECT_FALSE(queue.pop(value));
+}
+
+TEST(MpscQueue, ReleasesWhatsLeftOnDestruction)
+{
+    auto tracked = std::make_shared<int>(1);
+    {
+        MpscQueue<std::shared_ptr<int>> queue;
+        queue.push(tracked);
+        queue.push(tracked);
+        EXPECT_EQ(tracked.use_count(), 3);
+    }
+    EXPECT_EQ(tracked.use_count(), 1);
+}
+
+TEST(MpscQueue, ConcurrentProducersKeepTheirOwnOrder)
+{
+    const int producers = 4;
+    const int perProducer = 20000;
+    MpscQueue<std::pair<int, int>> queue;
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++) {
+        threads.emplace_back([&queue, p]() {
+            for (int i = 0; i < perProducer; i++) {
+                queue.push(std::make_pair(p, i));
+            }
+        });
+    }
+
+    std::vector<int> nextExpected(producers, 0);
+    int received = 0;
+    std::pair<int, int> item;
+    while (received < producers * perProducer) {
+        if (!queue.pop(item)) {
+            std::this_thread::yield();
+            continue;
+        }
+        ASSERT_EQ(item.second, nextExpected[item.first]);
+        nextExpected[item.first]++;
+        received++;
+    }
+    for (auto &t: threads) {
+        t.join();
+    }
+    EXPECT_FALSE(queue.pop(item));
+}
@@ -0,0 +1,134 @@
+/* test/util/test_ProfiledMutex.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "afv-native/util/ProfiledMutex.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace afv_native::util;
+
+TEST(ProfiledMutex, BehavesAsAMutex)
+{
+    ProfiledMutex mutex("test::BehavesAsAMutex");
+    int counter = 0;
+    std::thread other([&mutex, &counter]() {
+        for (int i = 0; i < 10000; i++) {
+            std::lock_guard<ProfiledMutex> guard(mutex);
+            counter++;
+        }
+    });
+    for (int i = 0; i < 10000; i++) {
+        std::lock_guard<ProfiledMutex> guard(mutex);
+        counter++;
+    }
+    other.join();
+    EXPECT_EQ(counter, 20000);
+
+    ASSERT_TRUE(mutex.try_lock());
+    mutex.unlock();
+}
+
+#ifdef AFV_NATIVE_PROFILE_LOCKS
+namespace {
+    LockStats findLock(const char *name)
+    {
+        for (const auto &lockStats: getLockStatistics()) {
+            if (lockStats.Name == name) {
+                return lockStats;
+            }
+        }
+        return LockStats();
+    }
+}
+
+TEST(ProfiledMutex, CountsAcquisitionsAndContention)
+{
+    EXPECT_TRUE(isLockProfilingEnabled());
+    ProfiledMutex mutex("test::CountsAcquisitionsAndContention");
+    {
+        std::lock_guard<ProfiledMutex> guard(mutex);
+    }
+    auto stats = findLock("test::CountsAcquisitionsAndContention");
+    EXPECT_EQ(stats.Acquisitions, 1);
+    EXPECT_EQ(stats.ContendedAcquisitions, 0);
+
+    std::atomic<bool> holding(false);
+    std::thread holder([&mutex, &holding]() {
+        std::lock_guard<ProfiledMutex> guard(mutex);
+        holding.store(true);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    });
+    while (!holding.load()) {
+        std::this_thread::yield();
+    }
+    {
+        std::lock_guard<ProfiledMutex> guard(mutex);
+    }
+    holder.join();
+
+    stats = findLock("test::CountsAcquisitionsAndContention");
+    EXPECT_EQ(stats.Acquisitions, 3);
+    EXPECT_EQ(stats.ContendedAcquisitions, 1);
+    EXPECT_GT(stats.MaxWaitUs, 1000);
+    EXPECT_GE(stats.MaxHoldUs, 15000);
+    EXPECT_GE(stats.TotalHoldUs, stats.MaxHoldUs);
+}
+
+TEST(ProfiledMutex, InstancesShareCountersByName)
+{
+    {
+        ProfiledMutex first("test::InstancesShareCountersByName");
+        std::lock_guard<ProfiledMutex> guard(first);
+    }
+    {
+        ProfiledMutex second("test::InstancesShareCountersByName");
+        std::lock_guard<ProfiledMutex> guard(second);
+    }
+    EXPECT_EQ(findLock("test::InstancesShareCountersByName").Acquisitions, 2);
+
+    resetLockStatistics();
+    EXPECT_EQ(findLock("test::InstancesShareCountersByName").Acquisitions, 0);
+}
+#else
+TEST(ProfiledMutex, NoStatisticsWithoutProfiling)
+{
+    EXPECT_FALSE(isLockProfilingEnabled());
+    ProfiledMutex mutex("test::NoStatisticsWithoutProfiling");
+    {
+        std::lock_guard<ProfiledMutex> guard(mutex);
+    }
+    EXPECT_TRUE(getLockStatistics().empty());
+}
+#endif
@@ -0,0 +1,129 @@
+/* test/util/test_RcuPointer.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "afv-native/util/RcuPointer.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace afv_native::util;
+
+namespace {
+    const uint32_t aliveMagic = 0xA11FEu;
+
+    struct RcuTestObject {
+        std::atomic<uint32_t> magic;
+        std::thread::id *destroyedOn;
+
+        explicit RcuTestObject(std::thread::id *destroyedOnPtr = nullptr):
+            magic(aliveMagic),
+            destroyedOn(destroyedOnPtr)
+        {
+        }
+
+        ~RcuTestObject()
+        {
+            magic.store(0);
+            if (destroyedOn != nullptr) {
+                *destroyedOn = std::this_thread::get_id();
+            }
+        }
+    };
+}
+
+TEST(RcuPointer, PublishAndUnpublish)
+{
+    RcuPointer<RcuTestObject> rp;
+    EXPECT_FALSE(rp.isPublished());
+    EXPECT_FALSE(rp.read());
+
+    auto obj = std::make_shared<RcuTestObject>();
+    rp.publish(obj);
+    EXPECT_TRUE(rp.isPublished());
+    {
+        auto guard = rp.read();
+        ASSERT_TRUE(guard);
+        EXPECT_EQ(guard.get(), obj.get());
+        EXPECT_TRUE(rp.unpublish(guard.get()));
+    }
+    EXPECT_FALSE(rp.isPublished());
+    EXPECT_FALSE(rp.unpublish(obj.get()));
+    // unpublished objects are still owned until the next publish.
+    EXPECT_EQ(obj.use_count(), 2);
+    rp.publish(nullptr);
+    EXPECT_EQ(obj.use_count(), 1);
+}
+
+TEST(RcuPointer, ReleasesOnWriterThread)
+{
+    std::thread::id destroyedOn;
+    RcuPointer<RcuTestObject> rp;
+    rp.publish(std::make_shared<RcuTestObject>(&destroyedOn));
+
+    std::thread reader([&rp]() {
+        auto guard = rp.read();
+        ASSERT_TRUE(guard);
+    });
+    reader.join();
+    rp.publish(nullptr);
+    EXPECT_EQ(destroyedOn, std::this_thread::get_id());
+}
+
+TEST(RcuPointer, ReadersNeverSeeReleasedObjects)
+{
+    RcuPointer<RcuTestObject> rp;
+    rp.publish(std::make_shared<RcuTestObject>());
+    std::atomic<bool> done(false);
+    std::atomic<size_t> dead(0);
+
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 2; i++) {
+        readers.emplace_back([&rp, &done, &dead]() {
+            while (!done.load()) {
+                auto guard = rp.read();
+                if (guard && guard->magic.load() != aliveMagic) {
+                    dead.fetch_add(1);
+                }
+            }
+        });
+    }
+    for (int i = 0; i < 2000; i++) {
+        rp.publish(std::make_shared<RcuTestObject>());
+    }
+    done.store(true);
+    for (auto &thisReader: readers) {
+        thisReader.join();
+    }
+    EXPECT_EQ(dead.load(), 0);
+}
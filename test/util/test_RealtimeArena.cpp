@@ -0,0 +1,120 @@
+/* test/util/test_RealtimeArena.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "afv-native/util/RealtimeArena.h"
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <vector>
+
+using namespace afv_native::util;
+
+TEST(RealtimeArena, CapacityIsWholePages)
+{
+    RealtimeArena arena(100);
+    const auto stats = arena.getStatistics();
+    EXPECT_EQ(stats.CapacityBytes, RealtimeArena::pageSize());
+    EXPECT_EQ(stats.UsedBytes, 0);
+}
+
+TEST(RealtimeArena, AllocationsAreAlignedAndZeroed)
+{
+    RealtimeArena arena(4096);
+    auto *first = static_cast<unsigned char *>(arena.allocate(3, 1));
+    ASSERT_NE(first, nullptr);
+    first[0] = 0xff;
+
+    auto *second = arena.allocateArray<double>(8);
+    ASSERT_NE(second, nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(second) % alignof(double), 0);
+    for (int i = 0; i < 8; i++) {
+        EXPECT_EQ(second[i], 0.0);
+    }
+
+    auto *third = arena.allocate(10, 64);
+    ASSERT_NE(third, nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(third) % 64, 0);
+    EXPECT_GE(arena.getStatistics().UsedBytes, 3 + 8 * sizeof(double) + 10);
+}
+
+TEST(RealtimeArena, ExhaustionIsCounted)
+{
+    RealtimeArena arena(1);
+    const size_t capacity = arena.getStatistics().CapacityBytes;
+    EXPECT_NE(arena.allocate(capacity, 1), nullptr);
+    EXPECT_EQ(arena.allocate(1, 1), nullptr);
+    EXPECT_EQ(arena.getStatistics().FailedAllocations, 1);
+    EXPECT_EQ(arena.getStatistics().UsedBytes, capacity);
+}
+
+TEST(RealtimeArena, LockRegionCountsWholePages)
+{
+    std::vector<unsigned char> block(RealtimeArena::pageSize() * 3);
+    RealtimeArena arena(4096);
+    // locking is subject to the OS's limits, so either outcome is valid - but it must be accounted for.
+    const bool locked = arena.lockRegion(block.data() + 10, RealtimeArena::pageSize());
+    const auto stats = arena.getStatistics();
+    if (locked) {
+        EXPECT_GE(stats.LockedRegionBytes, RealtimeArena::pageSize());
+        EXPECT_EQ(stats.LockedRegionBytes % RealtimeArena::pageSize(), 0);
+        EXPECT_EQ(stats.LockFailures, 0);
+    } else {
+        EXPECT_EQ(stats.LockedRegionBytes, 0);
+        EXPECT_EQ(stats.LockFailures, 1);
+    }
+    EXPECT_FALSE(arena.lockRegion(nullptr, 10));
+    // the arena doesn't own block, so it has to be unlocked before it goes away.
+    EXPECT_EQ(arena.unlockRegion(block.data() + 10, RealtimeArena::pageSize()), locked);
+}
+
+TEST(RealtimeArena, UnlockRegionForgetsTheRegion)
+{
+    std::vector<unsigned char> block(RealtimeArena::pageSize() * 4);
+    RealtimeArena arena(4096);
+    const size_t halfPage = RealtimeArena::pageSize() / 2;
+    // two regions that share a page.
+    const bool firstLocked = arena.lockRegion(block.data(), RealtimeArena::pageSize() + halfPage);
+    const bool secondLocked = arena.lockRegion(block.data() + RealtimeArena::pageSize() + halfPage, halfPage * 3);
+    if (!firstLocked || !secondLocked) {
+        // locking is subject to the OS's limits - there's nothing to test without it.
+        arena.unlockRegion(block.data(), RealtimeArena::pageSize() + halfPage);
+        arena.unlockRegion(block.data() + RealtimeArena::pageSize() + halfPage, halfPage * 3);
+        return;
+    }
+    const size_t lockedBytes = arena.getStatistics().LockedRegionBytes;
+
+    EXPECT_TRUE(arena.unlockRegion(block.data(), RealtimeArena::pageSize() + halfPage));
+    EXPECT_EQ(arena.getStatistics().LockedRegionBytes, lockedBytes - 2 * RealtimeArena::pageSize());
+    EXPECT_FALSE(arena.unlockRegion(block.data(), RealtimeArena::pageSize() + halfPage));
+
+    EXPECT_TRUE(arena.unlockRegion(block.data() + RealtimeArena::pageSize() + halfPage, halfPage * 3));
+    EXPECT_EQ(arena.getStatistics().LockedRegionBytes, 0);
+}
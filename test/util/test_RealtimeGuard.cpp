@@ -0,0 +1,123 @@
+/* test/util/test_RealtimeGuard.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "afv-native/util/RealtimeGuard.h"
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+using namespace afv_native::util;
+
+namespace {
+    // stored through a volatile so the compiler can't elide the allocations.
+    std::vector<int> *volatile gEscape = nullptr;
+
+    /** allocateSomething makes exactly two allocations (the vector and its storage) and frees them again. */
+    void allocateSomething()
+    {
+        gEscape = new std::vector<int>(16);
+        delete gEscape;
+    }
+}
+
+TEST(RealtimeGuard, HookIsInstalled)
+{
+    EXPECT_TRUE(isRealtimeAllocationGuardInstalled());
+}
+
+TEST(RealtimeGuard, OnlyCountsInsideAScope)
+{
+    resetRealtimeAllocationStats();
+    EXPECT_FALSE(isRealtimeThread());
+    allocateSomething();
+    EXPECT_EQ(getRealtimeAllocationStats().Allocations, 0);
+    {
+        RealtimeScope realtime;
+        EXPECT_TRUE(isRealtimeThread());
+        {
+            RealtimeScope nested;
+            allocateSomething();
+        }
+        EXPECT_TRUE(isRealtimeThread());
+        allocateSomething();
+    }
+    EXPECT_FALSE(isRealtimeThread());
+    allocateSomething();
+
+    const auto stats = getRealtimeAllocationStats();
+    EXPECT_EQ(stats.Allocations, 4);
+    EXPECT_EQ(stats.Deallocations, 4);
+
+    resetRealtimeAllocationStats();
+    EXPECT_EQ(getRealtimeAllocationStats().Allocations, 0);
+}
+
+TEST(RealtimeGuard, PermitSuspendsTheGuard)
+{
+    resetRealtimeAllocationStats();
+    RealtimeScope realtime;
+    {
+        RealtimeAllocationPermit permit;
+        allocateSomething();
+    }
+    EXPECT_EQ(getRealtimeAllocationStats().Allocations, 0);
+    allocateSomething();
+    EXPECT_EQ(getRealtimeAllocationStats().Allocations, 2);
+}
+
+TEST(RealtimeGuard, ScopeIsPerThread)
+{
+    resetRealtimeAllocationStats();
+    std::thread other;
+    {
+        RealtimeScope realtime;
+        {
+            // starting the thread allocates on this one.
+            RealtimeAllocationPermit permit;
+            other = std::thread([]() {
+                EXPECT_FALSE(isRealtimeThread());
+                allocateSomething();
+            });
+        }
+        other.join();
+    }
+    EXPECT_EQ(getRealtimeAllocationStats().Allocations, 0);
+}
+
+TEST(RealtimeGuardDeathTest, TrapAborts)
+{
+    EXPECT_DEATH({
+        setRealtimeAllocationTrap(true);
+        RealtimeScope realtime;
+        allocateSomething();
+    }, "heap allocation on a real-time thread");
+}
@@ -0,0 +1,81 @@
+/* test/util/test_SeqLock.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "afv-native/util/SeqLock.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+
+using namespace afv_native::util;
+
+struct SeqLockTestValue {
+    uint64_t a;
+    uint32_t b;
+    float c;
+};
+
+TEST(SeqLock, LoadStore)
+{
+    SeqLock<SeqLockTestValue> sl(SeqLockTestValue{1, 2, 3.0f});
+    auto v = sl.load();
+    EXPECT_EQ(v.a, 1);
+    EXPECT_EQ(v.b, 2);
+    EXPECT_EQ(v.c, 3.0f);
+
+    sl.update([](SeqLockTestValue &nv) { nv.b = 20; });
+    v = sl.load();
+    EXPECT_EQ(v.a, 1);
+    EXPECT_EQ(v.b, 20);
+}
+
+TEST(SeqLock, ReadersNeverSeeTornWrites)
+{
+    SeqLock<SeqLockTestValue> sl(SeqLockTestValue{0, 0, 0.0f});
+    std::atomic<bool> done(false);
+
+    std::thread writer([&sl, &done]() {
+        for (uint32_t i = 1; i < 200000; i++) {
+            sl.store(SeqLockTestValue{i, i, static_cast<float>(i)});
+        }
+        done.store(true);
+    });
+    size_t torn = 0;
+    while (!done.load()) {
+        auto v = sl.load();
+        if (v.a != v.b || static_cast<float>(v.b) != v.c) {
+            torn++;
+        }
+    }
+    writer.join();
+    EXPECT_EQ(torn, 0);
+}
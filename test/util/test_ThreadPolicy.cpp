@@ -0,0 +1,162 @@
+/* test/util/test_ThreadPolicy.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "afv-native/util/ThreadPolicy.h"
+#include <gtest/gtest.h>
+#include <thread>
+
+#ifndef WIN32
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+using namespace afv_native::util;
+
+namespace {
+    // nothing in the tests runs a capture callback, so we can have this class to ourselves.
+    const ThreadClass testClass = ThreadClass::AudioCapture;
+
+    class ThreadPolicyTest: public ::testing::Test {
+    protected:
+        void TearDown() override
+        {
+            setThreadPolicy(testClass, ThreadPolicy());
+        }
+    };
+}
+
+TEST_F(ThreadPolicyTest, DefaultPolicyOnlyNamesTheThread)
+{
+    std::thread([] {
+#ifndef WIN32
+        int policyBefore;
+        sched_param paramBefore;
+        pthread_getschedparam(pthread_self(), &policyBefore, &paramBefore);
+#endif
+        maintainThreadPolicy(testClass, "afv-test-capture");
+#ifdef __linux__
+        char name[32] = {};
+        pthread_getname_np(pthread_self(), name, sizeof(name));
+        // Linux only keeps 15 characters.
+        EXPECT_STREQ("afv-test-captur", name);
+#endif
+#ifndef WIN32
+        int policyAfter;
+        sched_param paramAfter;
+        pthread_getschedparam(pthread_self(), &policyAfter, &paramAfter);
+        EXPECT_EQ(policyBefore, policyAfter);
+        EXPECT_EQ(paramBefore.sched_priority, paramAfter.sched_priority);
+#endif
+    }).join();
+
+    auto status = getThreadPolicyStatus(testClass);
+    EXPECT_TRUE(status.Applied);
+    EXPECT_EQ(ThreadPriority::Default, status.Priority);
+    EXPECT_FALSE(status.AffinityApplied);
+}
+
+TEST_F(ThreadPolicyTest, RealtimeFallsBackWhenRefused)
+{
+    ThreadPolicy policy;
+    policy.Priority = ThreadPriority::Realtime;
+    policy.RealtimePriority = 10;
+    setThreadPolicy(testClass, policy);
+    EXPECT_FALSE(getThreadPolicyStatus(testClass).Applied);
+
+    std::thread([] {
+        maintainThreadPolicy(testClass, "afv-test");
+        auto status = getThreadPolicyStatus(testClass);
+        ASSERT_TRUE(status.Applied);
+#ifndef WIN32
+        // whatever we were allowed, the status has to describe what the thread actually got.
+        int schedPolicy;
+        sched_param param;
+        pthread_getschedparam(pthread_self(), &schedPolicy, &param);
+        if (status.Priority == ThreadPriority::Realtime) {
+            EXPECT_EQ(SCHED_FIFO, schedPolicy);
+            EXPECT_EQ(10, param.sched_priority);
+        } else {
+            EXPECT_NE(SCHED_FIFO, schedPolicy);
+            EXPECT_NE(0, status.LastError);
+        }
+#endif
+
+        // going back to the default puts the scheduling back the way it was.
+        setThreadPolicy(testClass, ThreadPolicy());
+        maintainThreadPolicy(testClass, "afv-test");
+        EXPECT_EQ(ThreadPriority::Default, getThreadPolicyStatus(testClass).Priority);
+#ifndef WIN32
+        pthread_getschedparam(pthread_self(), &schedPolicy, &param);
+        EXPECT_EQ(SCHED_OTHER, schedPolicy);
+#endif
+    }).join();
+}
+
+#ifdef __linux__
+TEST_F(ThreadPolicyTest, AffinityIsAppliedAndRestored)
+{
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    ASSERT_EQ(0, sched_getaffinity(0, sizeof(allowed), &allowed));
+    int firstCpu = 0;
+    while (firstCpu < 64 && !CPU_ISSET(firstCpu, &allowed)) {
+        firstCpu++;
+    }
+    ASSERT_LT(firstCpu, 64);
+
+    ThreadPolicy policy;
+    policy.CpuMask = uint64_t(1) << firstCpu;
+    setThreadPolicy(testClass, policy);
+
+    std::thread([firstCpu, &allowed] {
+        maintainThreadPolicy(testClass, "afv-test");
+        EXPECT_TRUE(getThreadPolicyStatus(testClass).AffinityApplied);
+
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        pthread_getaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+        EXPECT_EQ(1, CPU_COUNT(&cpus));
+        EXPECT_TRUE(CPU_ISSET(firstCpu, &cpus));
+
+        // nothing changes until the policy does.
+        maintainThreadPolicy(testClass, "afv-test");
+        EXPECT_TRUE(getThreadPolicyStatus(testClass).AffinityApplied);
+
+        setThreadPolicy(testClass, ThreadPolicy());
+        maintainThreadPolicy(testClass, "afv-test");
+        EXPECT_FALSE(getThreadPolicyStatus(testClass).AffinityApplied);
+        CPU_ZERO(&cpus);
+        pthread_getaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+        EXPECT_TRUE(CPU_EQUAL(&allowed, &cpus));
+    }).join();
+}
+#endif
@@ -0,0 +1,160 @@
+/* test/util/test_Trace.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "afv-native/util/RealtimeGuard.h"
+#include "afv-native/util/Trace.h"
+#include <gtest/gtest.h>
+#include <nlohmann/json.hpp>
+#include <thread>
+
+using namespace afv_native::util;
+using json = nlohmann::json;
+
+TEST(Trace, DisabledByDefault)
+{
+    EXPECT_FALSE(isTraceEnabled());
+    TRACE_SCOPE("test", "ignored");
+    traceInstant("test", "ignored");
+
+    auto trace = json::parse(exportTrace());
+    for (const auto &event: trace["traceEvents"]) {
+        EXPECT_NE(event["name"], "ignored");
+    }
+}
+
+TEST(Trace, RecordsSpansAndInstants)
+{
+    startTrace();
+    EXPECT_TRUE(isTraceEnabled());
+    {
+        TRACE_SCOPE("test", "outer");
+        traceInstant("test", "marker");
+    }
+    int transfer = 0;
+    traceAsyncBegin("test", "transfer", &transfer);
+    traceAsyncEnd("test", "transfer", &transfer);
+
+    auto trace = json::parse(exportTrace());
+    EXPECT_FALSE(isTraceEnabled());
+    const auto &events = trace["traceEvents"];
+    ASSERT_EQ(events.size(), 5);
+    EXPECT_EQ(events[0]["ph"], "B");
+    EXPECT_EQ(events[0]["name"], "outer");
+    EXPECT_EQ(events[0]["cat"], "test");
+    EXPECT_EQ(events[1]["ph"], "i");
+    EXPECT_EQ(events[1]["name"], "marker");
+    EXPECT_EQ(events[2]["ph"], "E");
+    EXPECT_EQ(events[3]["ph"], "b");
+    EXPECT_EQ(events[3]["id"], events[4]["id"]);
+    EXPECT_EQ(events[4]["ph"], "e");
+    EXPECT_LE(events[0]["ts"].get<double>(), events[2]["ts"].get<double>());
+    EXPECT_EQ(trace["otherData"]["droppedEvents"], 0);
+}
+
+TEST(Trace, SeparatesAndNamesThreads)
+{
+    startTrace();
+    traceInstant("test", "main");
+    std::thread worker([]() {
+        setTraceThreadName("worker");
+        traceInstant("test", "worker");
+    });
+    worker.join();
+
+    auto trace = json::parse(exportTrace());
+    int mainTid = -1, workerTid = -1;
+    bool workerNamed = false;
+    for (const auto &event: trace["traceEvents"]) {
+        if (event["ph"] == "M") {
+            workerNamed = (event["args"]["name"] == "worker");
+        } else if (event["name"] == "main") {
+            mainTid = event["tid"];
+        } else if (event["name"] == "worker") {
+            workerTid = event["tid"];
+        }
+    }
+    EXPECT_NE(mainTid, -1);
+    EXPECT_NE(workerTid, -1);
+    EXPECT_NE(mainTid, workerTid);
+    EXPECT_TRUE(workerNamed);
+}
+
+TEST(Trace, DropsEventsWhenThreadBufferFull)
+{
+    startTrace(4);
+    for (int i = 0; i < 10; i++) {
+        traceInstant("test", "spam");
+    }
+
+    auto trace = json::parse(exportTrace());
+    EXPECT_EQ(trace["traceEvents"].size(), 4);
+    EXPECT_EQ(trace["otherData"]["droppedEvents"], 6);
+}
+
+TEST(Trace, StartDiscardsPreviousTrace)
+{
+    startTrace();
+    traceInstant("test", "first");
+    stopTrace();
+    startTrace();
+    traceInstant("test", "second");
+
+    auto trace = json::parse(exportTrace());
+    ASSERT_EQ(trace["traceEvents"].size(), 1);
+    EXPECT_EQ(trace["traceEvents"][0]["name"], "second");
+}
+
+TEST(Trace, RealtimeThreadsUseSpareBuffers)
+{
+    startTrace();
+    resetRealtimeAllocationStats();
+    // one more real-time thread than there are spares - its events are dropped.
+    for (size_t t = 0; t < realtimeTraceBuffers + 1; t++) {
+        std::thread audio([]() {
+            RealtimeScope realtime;
+            traceInstant("test", "realtime");
+        });
+        audio.join();
+    }
+    EXPECT_EQ(getRealtimeAllocationStats().Allocations, 0);
+
+    auto trace = json::parse(exportTrace());
+    size_t recorded = 0;
+    for (const auto &event: trace["traceEvents"]) {
+        if (event["name"] == "realtime") {
+            recorded++;
+        }
+    }
+    EXPECT_EQ(recorded, realtimeTraceBuffers);
+    EXPECT_EQ(trace["otherData"]["droppedEvents"], 1);
+}
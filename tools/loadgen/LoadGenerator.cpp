@@ -0,0 +1,360 @@
+/* loadgen/LoadGenerator.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "LoadGenerator.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <event2/event.h>
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <ctime>
+#endif
+
+#include "afv-native/Log.h"
+#include "afv-native/afv/RadioSimulation.h"
+#include "afv-native/afv/VoiceCompressionSink.h"
+#include "afv-native/afv/dto/voice_server/AudioRxOnTransceivers.h"
+#include "afv-native/audio/NullAudioDevice.h"
+#include "afv-native/audio/PinkNoiseGenerator.h"
+#include "afv-native/audio/RecordedSampleSource.h"
+#include "afv-native/audio/WavFile.h"
+#include "afv-native/audio/WavSampleStorage.h"
+
+using namespace afv_native;
+
+namespace {
+    /** packetCycleFrames is how many distinct packets each talker cycles through. */
+    const unsigned int packetCycleFrames = 250;
+
+    class PacketCollector: public afv::ICompressedFrameSink {
+    public:
+        explicit PacketCollector(std::vector<std::vector<unsigned char>> &packets):
+                mPackets(packets)
+        {
+        }
+
+        void processCompressedFrame(const std::vector<unsigned char> &compressedData) override
+        {
+            mPackets.emplace_back(compressedData);
+        }
+
+    protected:
+        std::vector<std::vector<unsigned char>> &mPackets;
+    };
+
+    int64_t threadCpuTimeNs()
+    {
+#ifdef WIN32
+        FILETIME creationTime, exitTime, kernelTime, userTime;
+        GetThreadTimes(GetCurrentThread(), &creationTime, &exitTime, &kernelTime, &userTime);
+        const uint64_t kernel100ns = (static_cast<uint64_t>(kernelTime.dwHighDateTime) << 32) | kernelTime.dwLowDateTime;
+        const uint64_t user100ns = (static_cast<uint64_t>(userTime.dwHighDateTime) << 32) | userTime.dwLowDateTime;
+        return static_cast<int64_t>((kernel100ns + user100ns) * 100);
+#else
+        struct timespec ts;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+#endif
+    }
+
+    struct SyntheticStream {
+        std::string Callsign;
+        unsigned int Frequency;
+        uint32_t Sequence;
+        size_t PacketOffset;
+        bool InLossBurst;
+        bool HaveHeldPacket;
+        afv::dto::AudioRxOnTransceivers HeldPacket;
+        std::vector<afv::dto::AudioRxOnTransceivers> ArrivalQueue;
+    };
+
+    /** TimedSource sits between the null device and the RadioSimulation.
+     * Before each frame it injects that frame's packets, then it times the
+     * render.
+     */
+    class TimedSource: public audio::ISampleSource {
+    public:
+        TimedSource(
+                const LoadProfile &profile,
+                const std::vector<std::vector<unsigned char>> &packets,
+                std::shared_ptr<afv::RadioSimulation> simulation,
+                unsigned int streamCount,
+                RunResult &result):
+                mProfile(profile),
+                mPackets(packets),
+                mSimulation(std::move(simulation)),
+                mStreams(streamCount),
+                mResult(result),
+                mRng(profile.Seed),
+                mUniform(0.0, 1.0),
+                mLossExitProbability(1.0),
+                mLossEntryProbability(0.0),
+                mFrame(0),
+                mTotalFrames(profile.WarmupFrames + profile.MeasureFrames),
+                mFinished(false)
+        {
+            if (mProfile.MeanLossBurst > 1.0) {
+                mLossExitProbability = 1.0 / mProfile.MeanLossBurst;
+            }
+            if (mProfile.LossRate >= 1.0) {
+                mLossEntryProbability = 1.0;
+                mLossExitProbability = 0.0;
+            } else if (mProfile.LossRate > 0.0) {
+                // two-state (Gilbert) model - the time spent in the loss state works out to LossRate.
+                mLossEntryProbability = mProfile.LossRate * mLossExitProbability / (1.0 - mProfile.LossRate);
+            }
+
+            std::uniform_int_distribution<size_t> offsetDist(0, mPackets.size() - 1);
+            for (unsigned int i = 0; i < streamCount; i++) {
+                auto &stream = mStreams[i];
+                char callsign[32];
+                snprintf(callsign, sizeof(callsign), "LOAD%04u", i);
+                stream.Callsign = callsign;
+                stream.Frequency = mProfile.Frequencies[i % mProfile.Frequencies.size()];
+                stream.Sequence = 0;
+                stream.PacketOffset = offsetDist(mRng);
+                stream.InLossBurst = false;
+                stream.HaveHeldPacket = false;
+            }
+            mResult.CpuUs.reserve(mProfile.MeasureFrames);
+            mResult.WallUs.reserve(mProfile.MeasureFrames);
+        }
+
+        audio::SourceStatus getAudioFrame(audio::SampleType *bufferOut) override
+        {
+            if (mFrame >= mTotalFrames) {
+                ::memset(bufferOut, 0, audio::frameSizeBytes);
+                return audio::SourceStatus::OK;
+            }
+            injectPackets();
+
+            const auto wallStart = std::chrono::steady_clock::now();
+            const auto cpuStart = threadCpuTimeNs();
+            mSimulation->getAudioFrame(bufferOut);
+            const auto cpuEnd = threadCpuTimeNs();
+            const auto wallEnd = std::chrono::steady_clock::now();
+
+            if (mFrame >= mProfile.WarmupFrames) {
+                mResult.CpuUs.push_back(static_cast<double>(cpuEnd - cpuStart) / 1000.0);
+                mResult.WallUs.push_back(std::chrono::duration<double, std::micro>(wallEnd - wallStart).count());
+            }
+            mFrame++;
+            if (mFrame >= mTotalFrames) {
+                mFinished.store(true);
+            }
+            return audio::SourceStatus::OK;
+        }
+
+        bool isFinished() const
+        {
+            return mFinished.load();
+        }
+
+    protected:
+        const LoadProfile &mProfile;
+        const std::vector<std::vector<unsigned char>> &mPackets;
+        std::shared_ptr<afv::RadioSimulation> mSimulation;
+        std::vector<SyntheticStream> mStreams;
+        RunResult &mResult;
+
+        std::mt19937 mRng;
+        std::uniform_real_distribution<double> mUniform;
+        double mLossExitProbability;
+        double mLossEntryProbability;
+
+        unsigned int mFrame;
+        const unsigned int mTotalFrames;
+        std::atomic<bool> mFinished;
+
+        void injectPackets()
+        {
+            for (size_t i = 0; i < mStreams.size(); i++) {
+                auto &stream = mStreams[i];
+
+                afv::dto::AudioRxOnTransceivers pkt;
+                pkt.Callsign = stream.Callsign;
+                pkt.SequenceCounter = stream.Sequence++;
+                pkt.Audio = mPackets[(stream.PacketOffset + pkt.SequenceCounter) % mPackets.size()];
+                pkt.LastPacket = false;
+                afv::dto::RxTransceiver trans;
+                trans.ID = 0;
+                trans.Frequency = stream.Frequency;
+                trans.DistanceRatio = mProfile.DistanceRatio;
+                pkt.Transceivers.emplace_back(trans);
+
+                if (stream.InLossBurst) {
+                    stream.InLossBurst = mUniform(mRng) >= mLossExitProbability;
+                } else {
+                    stream.InLossBurst = mUniform(mRng) < mLossEntryProbability;
+                }
+                if (stream.InLossBurst) {
+                    mResult.PacketsLost++;
+                } else if (!stream.HaveHeldPacket && mUniform(mRng) < mProfile.ReorderRate) {
+                    stream.HeldPacket = std::move(pkt);
+                    stream.HaveHeldPacket = true;
+                    mResult.PacketsReordered++;
+                } else {
+                    stream.ArrivalQueue.emplace_back(std::move(pkt));
+                    if (stream.HaveHeldPacket) {
+                        stream.ArrivalQueue.emplace_back(std::move(stream.HeldPacket));
+                        stream.HaveHeldPacket = false;
+                    }
+                }
+
+                // stagger the streams so the clumps don't all land on the same frame.
+                if (mProfile.ArrivalBurst <= 1 || ((mFrame + i) % mProfile.ArrivalBurst) == 0) {
+                    for (const auto &queued: stream.ArrivalQueue) {
+                        mSimulation->rxVoicePacket(queued);
+                        mResult.PacketsDelivered++;
+                    }
+                    stream.ArrivalQueue.clear();
+                }
+            }
+        }
+    };
+}
+
+LoadProfile::LoadProfile():
+        Frequencies{124000000},
+        DistanceRatio(1.0f),
+        LossRate(0.0),
+        MeanLossBurst(1.0),
+        ReorderRate(0.0),
+        ArrivalBurst(1),
+        OutputEffects(true),
+        Seed(1),
+        DeviceSpeed(0.0),
+        WarmupFrames(50),
+        MeasureFrames(1500),
+        EffectsPath("."),
+        WavFile()
+{
+}
+
+RunResult::RunResult():
+        Streams(0),
+        CpuUs(),
+        WallUs(),
+        PacketsDelivered(0),
+        PacketsLost(0),
+        PacketsReordered(0)
+{
+}
+
+LoadGenerator::LoadGenerator(LoadProfile profile):
+        mProfile(std::move(profile)),
+        mResources(),
+        mPackets()
+{
+}
+
+LoadGenerator::~LoadGenerator() = default;
+
+bool LoadGenerator::prepare()
+{
+    mResources = std::make_shared<afv::EffectResources>(mProfile.EffectsPath);
+    if (mProfile.OutputEffects && (!mResources->mClick || !mResources->mCrackle)) {
+        LOG("LoadGenerator", "effect samples not found in \"%s\" - radio effects won't be rendered",
+                mProfile.EffectsPath.c_str());
+    }
+
+    std::shared_ptr<audio::ISampleSource> talkerAudio;
+    if (!mProfile.WavFile.empty()) {
+        std::unique_ptr<audio::AudioSampleData> wavData(audio::LoadWav(mProfile.WavFile.c_str()));
+        if (!wavData) {
+            LOG("LoadGenerator", "couldn't load %s", mProfile.WavFile.c_str());
+            return false;
+        }
+        auto storage = std::make_shared<audio::WavSampleStorage>(*wavData);
+        talkerAudio = std::make_shared<audio::RecordedSampleSource>(storage, true);
+    } else {
+        talkerAudio = std::make_shared<audio::PinkNoiseGenerator>(0.3f);
+    }
+
+    mPackets.clear();
+    PacketCollector collector(mPackets);
+    afv::VoiceCompressionSink encoder(collector);
+    std::vector<audio::SampleType> frame(audio::frameSizeSamples);
+    for (unsigned int i = 0; i < packetCycleFrames; i++) {
+        talkerAudio->getAudioFrame(frame.data());
+        encoder.putAudioFrame(frame.data());
+    }
+    if (mPackets.empty()) {
+        LOG("LoadGenerator", "couldn't encode any talker audio");
+        return false;
+    }
+    return true;
+}
+
+RunResult LoadGenerator::run(unsigned int streamCount)
+{
+    RunResult result;
+    result.Streams = streamCount;
+
+    struct event_base *evBase = event_base_new();
+    {
+        const auto radioCount = static_cast<unsigned int>(mProfile.Frequencies.size());
+        auto simulation = std::make_shared<afv::RadioSimulation>(evBase, mResources, nullptr, radioCount);
+        for (unsigned int i = 0; i < radioCount; i++) {
+            simulation->setFrequency(i, mProfile.Frequencies[i]);
+        }
+        simulation->setEnableOutputEffects(mProfile.OutputEffects);
+
+        auto source = std::make_shared<TimedSource>(mProfile, mPackets, simulation, streamCount, result);
+        audio::NullAudioDevice device;
+        device.setSpeed(mProfile.DeviceSpeed);
+        device.setSource(source);
+        if (!device.open()) {
+            LOG("LoadGenerator", "couldn't open the null audio device");
+        } else {
+            while (!source->isFinished()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            device.close();
+        }
+    }
+    event_base_free(evBase);
+    return result;
+}
+
+const LoadProfile &LoadGenerator::getProfile() const
+{
+    return mProfile;
+}
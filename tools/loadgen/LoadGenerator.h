@@ -0,0 +1,120 @@
+/* loadgen/LoadGenerator.h
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef LOADGEN_LOADGENERATOR_H
+#define LOADGEN_LOADGENERATOR_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "afv-native/afv/EffectResources.h"
+
+/** LoadProfile describes the synthetic traffic a LoadGenerator feeds to the
+ * RadioSimulation.
+ */
+struct LoadProfile {
+    /** one radio is created and tuned for each frequency.  Streams are dealt
+     * out across them round-robin.
+     */
+    std::vector<unsigned int> Frequencies;
+    float DistanceRatio;
+
+    /** LossRate is the long-run fraction of packets lost.  MeanLossBurst is the
+     * average run length of consecutive losses (1 = independent losses).
+     */
+    double LossRate;
+    double MeanLossBurst;
+    /** ReorderRate is the probability a packet is held back and delivered after its successor. */
+    double ReorderRate;
+    /** ArrivalBurst delivers packets in clumps of this many frames, as a
+     * congested network does.  1 delivers every packet on time.
+     */
+    unsigned int ArrivalBurst;
+
+    bool OutputEffects;
+    uint32_t Seed;
+    double DeviceSpeed;
+    unsigned int WarmupFrames;
+    unsigned int MeasureFrames;
+    std::string EffectsPath;
+    std::string WavFile;
+
+    LoadProfile();
+};
+
+/** RunResult holds the per-frame render cost measured for one stream count. */
+struct RunResult {
+    unsigned int Streams;
+    /** per-frame thread CPU time, in microseconds. */
+    std::vector<double> CpuUs;
+    /** per-frame wall-clock time, in microseconds. */
+    std::vector<double> WallUs;
+    uint64_t PacketsDelivered;
+    uint64_t PacketsLost;
+    uint64_t PacketsReordered;
+
+    RunResult();
+};
+
+/** LoadGenerator drives a RadioSimulation with N synthetic talkers.
+ *
+ * Each talker replays a cycle of pre-encoded opus packets through
+ * rxVoicePacket() with the impairments given in the profile.  Packets for a
+ * frame are injected before the frame is rendered, and only the
+ * getAudioFrame() call itself is timed.  Rendering is clocked by a
+ * NullAudioDevice, so the whole device path is exercised.
+ */
+class LoadGenerator {
+public:
+    explicit LoadGenerator(LoadProfile profile);
+    virtual ~LoadGenerator();
+
+    /** prepare loads the effect resources and encodes the packet cycle.
+     *
+     * @return false if the talker audio couldn't be loaded or encoded.
+     */
+    bool prepare();
+
+    RunResult run(unsigned int streamCount);
+
+    const LoadProfile &getProfile() const;
+
+protected:
+    LoadProfile mProfile;
+    std::shared_ptr<afv_native::afv::EffectResources> mResources;
+    std::vector<std::vector<unsigned char>> mPackets;
+};
+
+#endif //LOADGEN_LOADGENERATOR_H
@@ -0,0 +1,245 @@
+/* loadgen/main.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+
+#include "afv-native/Log.h"
+#include "afv-native/audio/audio_params.h"
+
+#include "LoadGenerator.h"
+
+using json = nlohmann::json;
+
+static void usage(const char *progName)
+{
+    std::cerr << "Usage: " << progName << " [options]" << std::endl
+              << "  --streams N           measure only N talkers (default: sweep)" << std::endl
+              << "  --step N              sweep step (default 8)" << std::endl
+              << "  --max-streams N       sweep limit (default 512)" << std::endl
+              << "  --freq HZ             add a radio tuned to HZ (may be repeated, default 124000000)" << std::endl
+              << "  --distance RATIO      DistanceRatio of every talker (default 1.0)" << std::endl
+              << "  --loss FRACTION       long-run packet loss (default 0)" << std::endl
+              << "  --loss-burst FRAMES   mean length of a loss burst (default 1)" << std::endl
+              << "  --reorder FRACTION    probability a packet arrives after its successor (default 0)" << std::endl
+              << "  --arrival-burst N     deliver packets in clumps of N frames (default 1)" << std::endl
+              << "  --no-effects          disable the radio output effects" << std::endl
+              << "  --warmup N            frames rendered before measuring (default 50)" << std::endl
+              << "  --frames N            frames measured per run (default 1500)" << std::endl
+              << "  --speed X             null device speed, 0 = flat out (default 0)" << std::endl
+              << "  --budget-us US        per-frame CPU budget (default one frame, 20000)" << std::endl
+              << "  --percentile P        percentile held to the budget (default 99)" << std::endl
+              << "  --seed N              random seed (default 1)" << std::endl
+              << "  --effects DIR         directory holding Click_f32.wav and Crackle_f32.wav" << std::endl
+              << "  --wav FILE            talker audio (default pink noise)" << std::endl
+              << "  --output FILE         write the JSON report to FILE instead of stdout" << std::endl;
+}
+
+static void stderrLogger(const char *subsystem, const char *file, int line, const char *lineOut)
+{
+    std::cerr << subsystem << ": " << lineOut << std::endl;
+}
+
+/** percentile returns the nearest-rank percentile of sorted. */
+static double percentile(const std::vector<double> &sorted, double pct)
+{
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    auto rank = static_cast<size_t>(std::ceil(pct / 100.0 * sorted.size()));
+    rank = std::max<size_t>(rank, 1);
+    return sorted[std::min(rank, sorted.size()) - 1];
+}
+
+static json summarise(std::vector<double> samples)
+{
+    std::sort(samples.begin(), samples.end());
+    double total = 0.0;
+    for (auto s: samples) {
+        total += s;
+    }
+    return json{
+            {"mean",  samples.empty() ? 0.0 : total / samples.size()},
+            {"min",   samples.empty() ? 0.0 : samples.front()},
+            {"p50",   percentile(samples, 50.0)},
+            {"p90",   percentile(samples, 90.0)},
+            {"p99",   percentile(samples, 99.0)},
+            {"p99.9", percentile(samples, 99.9)},
+            {"max",   samples.empty() ? 0.0 : samples.back()},
+    };
+}
+
+int
+main(int argc, char **argv)
+{
+    afv_native::setLogger(stderrLogger);
+
+    LoadProfile profile;
+    std::vector<unsigned int> frequencies;
+    unsigned int fixedStreams = 0;
+    unsigned int step = 8;
+    unsigned int maxStreams = 512;
+    double budgetUs = afv_native::audio::frameLengthMs * 1000.0;
+    double budgetPercentile = 99.0;
+    std::string outputFile;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool haveValue = (i + 1) < argc;
+        if (arg == "--streams" && haveValue) {
+            fixedStreams = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--step" && haveValue) {
+            step = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--max-streams" && haveValue) {
+            maxStreams = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--freq" && haveValue) {
+            frequencies.push_back(static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10)));
+        } else if (arg == "--distance" && haveValue) {
+            profile.DistanceRatio = std::strtof(argv[++i], nullptr);
+        } else if (arg == "--loss" && haveValue) {
+            profile.LossRate = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--loss-burst" && haveValue) {
+            profile.MeanLossBurst = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--reorder" && haveValue) {
+            profile.ReorderRate = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--arrival-burst" && haveValue) {
+            profile.ArrivalBurst = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--no-effects") {
+            profile.OutputEffects = false;
+        } else if (arg == "--warmup" && haveValue) {
+            profile.WarmupFrames = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--frames" && haveValue) {
+            profile.MeasureFrames = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--speed" && haveValue) {
+            profile.DeviceSpeed = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--budget-us" && haveValue) {
+            budgetUs = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--percentile" && haveValue) {
+            budgetPercentile = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--seed" && haveValue) {
+            profile.Seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--effects" && haveValue) {
+            profile.EffectsPath = argv[++i];
+        } else if (arg == "--wav" && haveValue) {
+            profile.WavFile = argv[++i];
+        } else if (arg == "--output" && haveValue) {
+            outputFile = argv[++i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (!frequencies.empty()) {
+        profile.Frequencies = frequencies;
+    }
+    if (step == 0 || profile.MeasureFrames == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    LoadGenerator generator(profile);
+    if (!generator.prepare()) {
+        return 1;
+    }
+
+    json runs = json::array();
+    unsigned int maxSustainable = 0;
+    for (unsigned int streams = (fixedStreams > 0) ? fixedStreams : step;
+         streams <= ((fixedStreams > 0) ? fixedStreams : maxStreams);
+         streams += step) {
+        auto result = generator.run(streams);
+        const double cpuAtPercentile = [&result, budgetPercentile]() {
+            auto sorted = result.CpuUs;
+            std::sort(sorted.begin(), sorted.end());
+            return percentile(sorted, budgetPercentile);
+        }();
+        const bool sustainable = !result.CpuUs.empty() && cpuAtPercentile <= budgetUs;
+        LOG("loadgen", "%u streams: p%g frame CPU %.1fus %s",
+                streams, budgetPercentile, cpuAtPercentile, sustainable ? "ok" : "over budget");
+
+        runs.push_back(json{
+                {"streams",          result.Streams},
+                {"frames",           result.CpuUs.size()},
+                {"packetsDelivered", result.PacketsDelivered},
+                {"packetsLost",      result.PacketsLost},
+                {"packetsReordered", result.PacketsReordered},
+                {"cpuUs",            summarise(result.CpuUs)},
+                {"wallUs",           summarise(result.WallUs)},
+                {"sustainable",      sustainable},
+        });
+        if (!sustainable) {
+            break;
+        }
+        maxSustainable = streams;
+    }
+
+    json report{
+            {"frameLengthMs", afv_native::audio::frameLengthMs},
+            {"budgetUs", budgetUs},
+            {"budgetPercentile", budgetPercentile},
+            {"profile", {
+                    {"frequencies", profile.Frequencies},
+                    {"distanceRatio", profile.DistanceRatio},
+                    {"lossRate", profile.LossRate},
+                    {"meanLossBurst", profile.MeanLossBurst},
+                    {"reorderRate", profile.ReorderRate},
+                    {"arrivalBurst", profile.ArrivalBurst},
+                    {"outputEffects", profile.OutputEffects},
+                    {"seed", profile.Seed},
+                    {"deviceSpeed", profile.DeviceSpeed},
+                    {"warmupFrames", profile.WarmupFrames},
+                    {"measureFrames", profile.MeasureFrames},
+            }},
+            {"runs", runs},
+            {"maxSustainableStreams", maxSustainable},
+    };
+
+    if (outputFile.empty()) {
+        std::cout << report.dump(2) << std::endl;
+    } else {
+        std::ofstream out(outputFile);
+        if (!out) {
+            LOG("loadgen", "couldn't write %s", outputFile.c_str());
+            return 1;
+        }
+        out << report.dump(2) << std::endl;
+    }
+    return 0;
+}
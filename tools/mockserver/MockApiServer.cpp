@@ -0,0 +1,325 @@
+/* mockserver/MockApiServer.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "MockApiServer.h"
+
+#include <ctime>
+#include <fstream>
+#include <sstream>
+#include <event2/buffer.h>
+#include <event2/keyvalq_struct.h>
+
+#include "afv-native/Log.h"
+#include "afv-native/afv/dto/AuthRequest.h"
+#include "afv-native/afv/dto/Transceiver.h"
+#include "afv-native/afv/dto/VoiceServerConnectionData.h"
+#include "afv-native/util/base64.h"
+
+#include "MockVoiceServer.h"
+
+using namespace afv_native;
+using json = nlohmann::json;
+
+namespace {
+    std::string base64UrlEncode(const std::string &in)
+    {
+        auto encoded = util::Base64Encode(reinterpret_cast<const unsigned char *>(in.data()), in.size());
+        while (!encoded.empty() && encoded.back() == '=') {
+            encoded.pop_back();
+        }
+        for (auto &c: encoded) {
+            if (c == '+') {
+                c = '-';
+            } else if (c == '/') {
+                c = '_';
+            }
+        }
+        return encoded;
+    }
+
+    std::vector<std::string> splitPath(const char *path)
+    {
+        std::vector<std::string> segments;
+        std::istringstream pathStream(path != nullptr ? path : "");
+        std::string segment;
+        while (std::getline(pathStream, segment, '/')) {
+            if (!segment.empty()) {
+                segments.emplace_back(segment);
+            }
+        }
+        return segments;
+    }
+}
+
+MockApiServer::MockApiServer(struct event_base *evBase, MockVoiceServer &voiceServer):
+        mEvBase(evBase),
+        mVoiceServer(voiceServer),
+        mHttp(nullptr),
+        mPassword(),
+        mTokenLifetimeSec(3600),
+        mStationAliases(json::array()),
+        mTokens(),
+        mRequestCount(0)
+{
+}
+
+MockApiServer::~MockApiServer()
+{
+    close();
+}
+
+bool MockApiServer::open(const std::string &address, uint16_t port)
+{
+    close();
+    mHttp = evhttp_new(mEvBase);
+    if (mHttp == nullptr) {
+        LOG("MockApiServer", "couldn't create http server");
+        return false;
+    }
+    evhttp_set_allowed_methods(mHttp, EVHTTP_REQ_GET | EVHTTP_REQ_POST | EVHTTP_REQ_DELETE);
+    evhttp_set_gencb(mHttp, MockApiServer::evRequestCallback, this);
+    if (evhttp_bind_socket(mHttp, address.c_str(), port) != 0) {
+        LOG("MockApiServer", "couldn't bind to %s:%d", address.c_str(), port);
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MockApiServer::close()
+{
+    if (mHttp != nullptr) {
+        evhttp_free(mHttp);
+        mHttp = nullptr;
+    }
+}
+
+void MockApiServer::setPassword(const std::string &password)
+{
+    mPassword = password;
+}
+
+void MockApiServer::setTokenLifetime(unsigned int seconds)
+{
+    mTokenLifetimeSec = seconds;
+}
+
+bool MockApiServer::loadStationAliases(const std::string &fileName)
+{
+    std::ifstream aliasFile(fileName);
+    if (!aliasFile) {
+        LOG("MockApiServer", "couldn't open %s", fileName.c_str());
+        return false;
+    }
+    try {
+        auto aliases = json::parse(aliasFile);
+        if (!aliases.is_array()) {
+            LOG("MockApiServer", "%s doesn't contain an array of stations", fileName.c_str());
+            return false;
+        }
+        mStationAliases = std::move(aliases);
+    } catch (const json::exception &e) {
+        LOG("MockApiServer", "couldn't parse %s: %s", fileName.c_str(), e.what());
+        return false;
+    }
+    return true;
+}
+
+uint64_t MockApiServer::getRequestCount() const
+{
+    return mRequestCount;
+}
+
+void MockApiServer::evRequestCallback(struct evhttp_request *req, void *arg)
+{
+    auto *server = reinterpret_cast<MockApiServer *>(arg);
+    server->handleRequest(req);
+}
+
+void MockApiServer::handleRequest(struct evhttp_request *req)
+{
+    mRequestCount++;
+    const auto method = evhttp_request_get_command(req);
+    const auto path = splitPath(evhttp_uri_get_path(evhttp_request_get_evhttp_uri(req)));
+
+    if (path.size() < 3 || path[0] != "api" || path[1] != "v1") {
+        sendError(req, HTTP_NOTFOUND);
+        return;
+    }
+    if (path.size() == 3 && path[2] == "auth" && method == EVHTTP_REQ_POST) {
+        handleAuth(req);
+        return;
+    }
+    if (!isAuthorised(req)) {
+        sendError(req, 401);
+        return;
+    }
+    if (path.size() == 4 && path[2] == "stations" && path[3] == "aliased" && method == EVHTTP_REQ_GET) {
+        handleStationAliases(req);
+        return;
+    }
+    if (path.size() >= 6 && path[2] == "users" && path[4] == "callsigns") {
+        if (path.size() == 6) {
+            handleCallsign(req, path[5]);
+            return;
+        }
+        if (path.size() == 7 && path[6] == "transceivers" && method == EVHTTP_REQ_POST) {
+            handleTransceivers(req, path[5]);
+            return;
+        }
+    }
+    sendError(req, HTTP_NOTFOUND);
+}
+
+void MockApiServer::handleAuth(struct evhttp_request *req)
+{
+    afv::dto::AuthRequest authRequest;
+    try {
+        json::parse(getRequestBody(req)).get_to(authRequest);
+    } catch (const json::exception &e) {
+        LOG("MockApiServer", "bad auth request: %s", e.what());
+        sendError(req, HTTP_BADREQUEST);
+        return;
+    }
+    if (!mPassword.empty() && authRequest.Password != mPassword) {
+        sendError(req, 401);
+        return;
+    }
+    sendReply(req, HTTP_OK, makeToken(authRequest.Username), "text/plain");
+}
+
+void MockApiServer::handleCallsign(struct evhttp_request *req, const std::string &callsign)
+{
+    switch (evhttp_request_get_command(req)) {
+    case EVHTTP_REQ_POST:
+        sendJson(req, json{{"voiceServer", mVoiceServer.createSession(callsign)}});
+        break;
+    case EVHTTP_REQ_DELETE:
+        mVoiceServer.removeSession(callsign);
+        sendReply(req, HTTP_OK, "", "text/plain");
+        break;
+    default:
+        sendError(req, HTTP_BADMETHOD);
+        break;
+    }
+}
+
+void MockApiServer::handleTransceivers(struct evhttp_request *req, const std::string &callsign)
+{
+    std::vector<afv::dto::Transceiver> transceivers;
+    try {
+        auto transJson = json::parse(getRequestBody(req));
+        if (!transJson.is_array()) {
+            sendError(req, HTTP_BADREQUEST);
+            return;
+        }
+        for (const auto &tJson: transJson) {
+            afv::dto::Transceiver trans(0, 0, 0.0, 0.0, 0.0, 0.0);
+            tJson.get_to(trans);
+            transceivers.emplace_back(trans);
+        }
+    } catch (const json::exception &e) {
+        LOG("MockApiServer", "bad transceiver update: %s", e.what());
+        sendError(req, HTTP_BADREQUEST);
+        return;
+    }
+    if (!mVoiceServer.updateTransceivers(callsign, transceivers)) {
+        sendError(req, HTTP_NOTFOUND);
+        return;
+    }
+    sendReply(req, HTTP_OK, "", "text/plain");
+}
+
+void MockApiServer::handleStationAliases(struct evhttp_request *req)
+{
+    sendJson(req, mStationAliases);
+}
+
+bool MockApiServer::isAuthorised(struct evhttp_request *req) const
+{
+    const char *authHeader = evhttp_find_header(evhttp_request_get_input_headers(req), "Authorization");
+    if (authHeader == nullptr) {
+        return false;
+    }
+    const std::string bearerPrefix = "Bearer ";
+    const std::string authValue(authHeader);
+    if (authValue.compare(0, bearerPrefix.size(), bearerPrefix) != 0) {
+        return false;
+    }
+    return mTokens.find(authValue.substr(bearerPrefix.size())) != mTokens.end();
+}
+
+std::string MockApiServer::makeToken(const std::string &username)
+{
+    const auto now = ::time(nullptr);
+    const json header{
+            {"alg", "none"},
+            {"typ", "JWT"},
+    };
+    const json payload{
+            {"sub", username},
+            {"iat", static_cast<uint64_t>(now)},
+            {"exp", static_cast<uint64_t>(now + mTokenLifetimeSec)},
+    };
+    auto token = base64UrlEncode(header.dump()) + "." + base64UrlEncode(payload.dump()) + ".";
+    mTokens.insert(token);
+    return token;
+}
+
+std::string MockApiServer::getRequestBody(struct evhttp_request *req)
+{
+    auto *inBuf = evhttp_request_get_input_buffer(req);
+    const size_t bodyLen = evbuffer_get_length(inBuf);
+    if (bodyLen == 0) {
+        return std::string();
+    }
+    return std::string(reinterpret_cast<const char *>(evbuffer_pullup(inBuf, -1)), bodyLen);
+}
+
+void MockApiServer::sendReply(struct evhttp_request *req, int code, const std::string &body, const char *contentType)
+{
+    evhttp_add_header(evhttp_request_get_output_headers(req), "Content-Type", contentType);
+    auto *outBuf = evhttp_request_get_output_buffer(req);
+    evbuffer_add(outBuf, body.data(), body.size());
+    evhttp_send_reply(req, code, nullptr, nullptr);
+}
+
+void MockApiServer::sendJson(struct evhttp_request *req, const json &body)
+{
+    sendReply(req, HTTP_OK, body.dump(), "application/json; charset=UTF-8");
+}
+
+void MockApiServer::sendError(struct evhttp_request *req, int code)
+{
+    evhttp_send_error(req, code, nullptr);
+}
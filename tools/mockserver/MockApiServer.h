@@ -0,0 +1,100 @@
+/* mockserver/MockApiServer.h
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef MOCKSERVER_MOCKAPISERVER_H
+#define MOCKSERVER_MOCKAPISERVER_H
+
+#include <cstdint>
+#include <set>
+#include <string>
+#include <vector>
+#include <event2/event.h>
+#include <event2/http.h>
+#include <nlohmann/json.hpp>
+
+class MockVoiceServer;
+
+/** MockApiServer implements the subset of the AFV REST API used by
+ * APISession and VoiceSession:
+ *
+ *  - POST   /api/v1/auth
+ *  - POST   /api/v1/users/{user}/callsigns/{callsign}
+ *  - DELETE /api/v1/users/{user}/callsigns/{callsign}
+ *  - POST   /api/v1/users/{user}/callsigns/{callsign}/transceivers
+ *  - GET    /api/v1/stations/aliased
+ *
+ * Issued tokens are unsigned ("alg": "none") JWTs, which is all the client
+ * inspects.  Any username is accepted; if a password is set, it must match.
+ */
+class MockApiServer {
+public:
+    MockApiServer(struct event_base *evBase, MockVoiceServer &voiceServer);
+    virtual ~MockApiServer();
+
+    bool open(const std::string &address, uint16_t port);
+    void close();
+
+    void setPassword(const std::string &password);
+    void setTokenLifetime(unsigned int seconds);
+    bool loadStationAliases(const std::string &fileName);
+
+    uint64_t getRequestCount() const;
+
+protected:
+    struct event_base *mEvBase;
+    MockVoiceServer &mVoiceServer;
+    struct evhttp *mHttp;
+
+    std::string mPassword;
+    unsigned int mTokenLifetimeSec;
+    nlohmann::json mStationAliases;
+    std::set<std::string> mTokens;
+    uint64_t mRequestCount;
+
+    static void evRequestCallback(struct evhttp_request *req, void *arg);
+    void handleRequest(struct evhttp_request *req);
+    void handleAuth(struct evhttp_request *req);
+    void handleCallsign(struct evhttp_request *req, const std::string &callsign);
+    void handleTransceivers(struct evhttp_request *req, const std::string &callsign);
+    void handleStationAliases(struct evhttp_request *req);
+
+    bool isAuthorised(struct evhttp_request *req) const;
+    std::string makeToken(const std::string &username);
+
+    static std::string getRequestBody(struct evhttp_request *req);
+    static void sendReply(struct evhttp_request *req, int code, const std::string &body, const char *contentType);
+    static void sendJson(struct evhttp_request *req, const nlohmann::json &body);
+    static void sendError(struct evhttp_request *req, int code);
+};
+
+#endif //MOCKSERVER_MOCKAPISERVER_H
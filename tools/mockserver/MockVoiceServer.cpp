@@ -0,0 +1,477 @@
+/* mockserver/MockVoiceServer.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "MockVoiceServer.h"
+
+#include <cerrno>
+#include <cstring>
+#include <functional>
+#include <msgpack.hpp>
+#include <openssl/rand.h>
+
+#ifdef WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <winsock.h>
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#endif
+
+#include "afv-native/Log.h"
+#include "afv-native/afv/dto/domain/RxTransceiver.h"
+#include "afv-native/afv/dto/voice_server/AudioRxOnTransceivers.h"
+#include "afv-native/afv/dto/voice_server/AudioTxOnTransceivers.h"
+#include "afv-native/cryptodto/dto/ChannelConfig.h"
+#include "afv-native/cryptodto/dto/Header.h"
+
+#include "ScriptedTalker.h"
+
+using namespace afv_native;
+
+namespace {
+    /** HeartbeatAck is the voice server's reply to a client Heartbeat.  The
+     * client doesn't look inside it.
+     */
+    class HeartbeatAck {
+    public:
+        std::string Callsign;
+
+        MSGPACK_DEFINE_ARRAY(Callsign);
+
+        static std::string getName()
+        {
+            return "HA";
+        }
+    };
+
+    std::string makeChannelTag()
+    {
+        static const char hexDigits[] = "0123456789abcdef";
+        unsigned char tagBytes[16];
+        RAND_bytes(tagBytes, sizeof(tagBytes));
+        std::string tag;
+        for (auto b: tagBytes) {
+            tag.push_back(hexDigits[b >> 4]);
+            tag.push_back(hexDigits[b & 0x0f]);
+        }
+        return tag;
+    }
+}
+
+MockVoiceServer::Session::Session():
+        Callsign(),
+        Channel(),
+        TxSequence(0),
+        Address(),
+        AddressLength(0),
+        Transceivers(),
+        LastHeard(util::monotime_get())
+{
+}
+
+MockVoiceServer::MockVoiceServer(struct event_base *evBase, std::string listenAddress):
+        mEvBase(evBase),
+        mAddress(std::move(listenAddress)),
+        mSocket(-1),
+        mSocketEvent(nullptr),
+        mDatagramBuffer(nullptr),
+        mEcho(false),
+        mSessions(),
+        mSessionsByTag(),
+        mTalkers(),
+        mMaintenanceTimer(evBase, std::bind(&MockVoiceServer::maintainSessions, this)),
+        mDatagramsReceived(0),
+        mDatagramsSent(0),
+        mDatagramsDropped(0)
+{
+    mDatagramBuffer = new unsigned char[cryptodto::maxPermittedDatagramSize];
+}
+
+MockVoiceServer::~MockVoiceServer()
+{
+    close();
+    // talkers hold a reference to us, so must go before anything else does.
+    mTalkers.clear();
+    delete[] mDatagramBuffer;
+    mDatagramBuffer = nullptr;
+}
+
+bool MockVoiceServer::open()
+{
+    struct sockaddr_storage saddr;
+    int saddrLen = sizeof(saddr);
+
+    if (evutil_parse_sockaddr_port(mAddress.c_str(), reinterpret_cast<struct sockaddr *>(&saddr), &saddrLen)) {
+        LOG("MockVoiceServer", "couldn't parse listen address \"%s\"", mAddress.c_str());
+        return false;
+    }
+    mSocket = ::socket(saddr.ss_family, SOCK_DGRAM, 0);
+    if (mSocket < 0) {
+        LOG("MockVoiceServer", "couldn't create UDP socket: %s", evutil_socket_error_to_string(EVUTIL_SOCKET_ERROR()));
+        return false;
+    }
+    evutil_make_socket_nonblocking(mSocket);
+    evutil_make_listen_socket_reuseable(mSocket);
+    if (::bind(mSocket, reinterpret_cast<struct sockaddr *>(&saddr), saddrLen)) {
+        LOG("MockVoiceServer", "couldn't bind to \"%s\": %s", mAddress.c_str(), evutil_socket_error_to_string(EVUTIL_SOCKET_ERROR()));
+        close();
+        return false;
+    }
+    mSocketEvent = event_new(mEvBase, mSocket, EV_READ | EV_PERSIST, MockVoiceServer::evReadCallback, this);
+    event_add(mSocketEvent, nullptr);
+    mMaintenanceTimer.enable(maintenanceIntervalMs);
+    for (auto &talker: mTalkers) {
+        talker->start();
+    }
+    return true;
+}
+
+void MockVoiceServer::close()
+{
+    for (auto &talker: mTalkers) {
+        talker->stop();
+    }
+    mMaintenanceTimer.disable();
+    if (mSocketEvent != nullptr) {
+        event_del(mSocketEvent);
+        event_free(mSocketEvent);
+        mSocketEvent = nullptr;
+    }
+    if (mSocket >= 0) {
+        evutil_closesocket(mSocket);
+        mSocket = -1;
+    }
+}
+
+const std::string &MockVoiceServer::getAddress() const
+{
+    return mAddress;
+}
+
+void MockVoiceServer::setEcho(bool echo)
+{
+    mEcho = echo;
+}
+
+afv::dto::VoiceServerConnectionData MockVoiceServer::createSession(const std::string &callsign)
+{
+    removeSession(callsign);
+
+    std::unique_ptr<Session> session(new Session());
+    session->Callsign = callsign;
+
+    afv::dto::VoiceServerConnectionData connectionData;
+    connectionData.AddressIpV4 = mAddress;
+    connectionData.AddressIpV6 = mAddress;
+    auto &clientConfig = connectionData.ChannelConfig;
+    clientConfig.ChannelTag = makeChannelTag();
+    RAND_bytes(clientConfig.AeadReceiveKey, cryptodto::aeadModeKeySize);
+    RAND_bytes(clientConfig.AeadTransmitKey, cryptodto::aeadModeKeySize);
+
+    // our config is the mirror of the client's - what it transmits with, we receive with.
+    cryptodto::dto::ChannelConfig serverConfig(clientConfig);
+    ::memcpy(serverConfig.AeadReceiveKey, clientConfig.AeadTransmitKey, cryptodto::aeadModeKeySize);
+    ::memcpy(serverConfig.AeadTransmitKey, clientConfig.AeadReceiveKey, cryptodto::aeadModeKeySize);
+    session->Channel.setChannelConfig(serverConfig);
+
+    mSessionsByTag[clientConfig.ChannelTag] = session.get();
+    mSessions[callsign] = std::move(session);
+    LOG("MockVoiceServer", "created session for %s", callsign.c_str());
+    return connectionData;
+}
+
+bool MockVoiceServer::removeSession(const std::string &callsign)
+{
+    auto sessIter = mSessions.find(callsign);
+    if (sessIter == mSessions.end()) {
+        return false;
+    }
+    mSessionsByTag.erase(sessIter->second->Channel.ChannelTag);
+    mSessions.erase(sessIter);
+    return true;
+}
+
+bool MockVoiceServer::updateTransceivers(
+        const std::string &callsign, const std::vector<afv::dto::Transceiver> &transceivers)
+{
+    auto sessIter = mSessions.find(callsign);
+    if (sessIter == mSessions.end()) {
+        return false;
+    }
+    auto &session = *sessIter->second;
+    session.Transceivers.clear();
+    for (const auto &trans: transceivers) {
+        session.Transceivers[trans.ID] = trans.Frequency;
+    }
+    return true;
+}
+
+void MockVoiceServer::addTalker(std::unique_ptr<ScriptedTalker> talker)
+{
+    if (mSocketEvent != nullptr) {
+        talker->start();
+    }
+    mTalkers.emplace_back(std::move(talker));
+}
+
+size_t MockVoiceServer::getSessionCount() const
+{
+    return mSessions.size();
+}
+
+uint64_t MockVoiceServer::getDatagramsReceived() const
+{
+    return mDatagramsReceived;
+}
+
+uint64_t MockVoiceServer::getDatagramsSent() const
+{
+    return mDatagramsSent;
+}
+
+uint64_t MockVoiceServer::getDatagramsDropped() const
+{
+    return mDatagramsDropped;
+}
+
+void MockVoiceServer::evReadCallback(evutil_socket_t fd, short events, void *arg)
+{
+    auto *server = reinterpret_cast<MockVoiceServer *>(arg);
+    server->readCallback();
+}
+
+void MockVoiceServer::readCallback()
+{
+    // drain as much as we can per wakeup - under load, one datagram per loop
+    // iteration can't keep up.
+    for (int i = 0; i < maxDatagramsPerWakeup; i++) {
+        struct sockaddr_storage from;
+        ev_socklen_t fromLen = sizeof(from);
+        auto dgSize = ::recvfrom(
+                mSocket,
+                reinterpret_cast<char *>(mDatagramBuffer),
+                cryptodto::maxPermittedDatagramSize,
+                0,
+                reinterpret_cast<struct sockaddr *>(&from),
+                &fromLen);
+        if (dgSize < 0) {
+            const auto err = EVUTIL_SOCKET_ERROR();
+            if (err != EWOULDBLOCK && err != EAGAIN) {
+                LOG("MockVoiceServer", "recv error: %s", evutil_socket_error_to_string(err));
+            }
+            return;
+        }
+        mDatagramsReceived++;
+        processDatagram(mDatagramBuffer, static_cast<size_t>(dgSize), from, fromLen);
+    }
+}
+
+void MockVoiceServer::processDatagram(
+        const unsigned char *data, size_t len, const struct sockaddr_storage &from, ev_socklen_t fromLen)
+{
+    std::string channelTag, dtoName;
+    cryptodto::sequence_t seq;
+    cryptodto::CryptoDtoMode cipherMode;
+    msgpack::sbuffer dtoBuf;
+    Session *session = nullptr;
+
+    try {
+        // the header is in the clear, so we can find the session before decrypting.
+        uint16_t headerSize;
+        if (len < sizeof(headerSize)) {
+            mDatagramsDropped++;
+            return;
+        }
+        ::memcpy(&headerSize, data, sizeof(headerSize));
+        if (len < sizeof(headerSize) + headerSize) {
+            mDatagramsDropped++;
+            return;
+        }
+        cryptodto::dto::Header header;
+        auto headerHdl = msgpack::unpack(reinterpret_cast<const char *>(data) + sizeof(headerSize), headerSize);
+        headerHdl.get().convert(header);
+
+        auto tagIter = mSessionsByTag.find(header.ChannelTag);
+        if (tagIter == mSessionsByTag.end()) {
+            mDatagramsDropped++;
+            return;
+        }
+        session = tagIter->second;
+        if (!session->Channel.Decapsulate(data, len, channelTag, seq, cipherMode, dtoName, dtoBuf)) {
+            LOG("MockVoiceServer", "couldn't decapsulate datagram from %s", session->Callsign.c_str());
+            mDatagramsDropped++;
+            return;
+        }
+    } catch (const std::exception &e) {
+        LOG("MockVoiceServer", "malformed datagram: %s", e.what());
+        mDatagramsDropped++;
+        return;
+    }
+
+    uint16_t dtoSize;
+    if (dtoBuf.size() < sizeof(dtoSize)) {
+        mDatagramsDropped++;
+        return;
+    }
+    ::memcpy(&dtoSize, dtoBuf.data(), sizeof(dtoSize));
+    if (dtoSize != dtoBuf.size() - sizeof(dtoSize)) {
+        mDatagramsDropped++;
+        return;
+    }
+
+    // clients may rebind (or NAT may move them), so always reply to where they last spoke from.
+    ::memcpy(&session->Address, &from, fromLen);
+    session->AddressLength = fromLen;
+    session->LastHeard = util::monotime_get();
+
+    if (dtoName == "H") {
+        processHeartbeat(*session);
+    } else if (dtoName == "AT") {
+        processAudio(*session, reinterpret_cast<const unsigned char *>(dtoBuf.data()) + sizeof(dtoSize), dtoSize);
+    } else {
+        LOG("MockVoiceServer", "ignoring %s packet from %s", dtoName.c_str(), session->Callsign.c_str());
+    }
+}
+
+void MockVoiceServer::processHeartbeat(Session &session)
+{
+    HeartbeatAck ack;
+    ack.Callsign = session.Callsign;
+    sendTo(session, ack);
+}
+
+void MockVoiceServer::processAudio(Session &session, const unsigned char *data, size_t len)
+{
+    afv::dto::AudioTxOnTransceivers txAudio;
+    try {
+        auto objHdl = msgpack::unpack(reinterpret_cast<const char *>(data), len);
+        objHdl.get().convert(txAudio);
+    } catch (const std::exception &e) {
+        LOG("MockVoiceServer", "unable to unpack audio from %s: %s", session.Callsign.c_str(), e.what());
+        mDatagramsDropped++;
+        return;
+    }
+    std::vector<uint32_t> frequencies;
+    for (const auto &tx: txAudio.Transceivers) {
+        auto transIter = session.Transceivers.find(tx.ID);
+        if (transIter != session.Transceivers.end()) {
+            frequencies.push_back(transIter->second);
+        }
+    }
+    if (frequencies.empty()) {
+        return;
+    }
+    deliver(txAudio, frequencies, session.Callsign);
+}
+
+void MockVoiceServer::deliver(
+        const afv::dto::IAudio &audio,
+        const std::vector<uint32_t> &frequencies,
+        const std::string &sender)
+{
+    afv::dto::AudioRxOnTransceivers rxAudio;
+    rxAudio.Callsign = audio.Callsign;
+    rxAudio.SequenceCounter = audio.SequenceCounter;
+    rxAudio.Audio = audio.Audio;
+    rxAudio.LastPacket = audio.LastPacket;
+
+    for (auto &sessPair: mSessions) {
+        auto &session = *sessPair.second;
+        if (session.AddressLength == 0 || (!mEcho && session.Callsign == sender)) {
+            continue;
+        }
+        rxAudio.Transceivers.clear();
+        for (const auto &trans: session.Transceivers) {
+            for (auto freq: frequencies) {
+                if (trans.second == freq) {
+                    afv::dto::RxTransceiver rxTrans;
+                    rxTrans.ID = trans.first;
+                    rxTrans.Frequency = freq;
+                    rxTrans.DistanceRatio = 1.0f;
+                    rxAudio.Transceivers.emplace_back(rxTrans);
+                    break;
+                }
+            }
+        }
+        if (!rxAudio.Transceivers.empty()) {
+            sendTo(session, rxAudio);
+        }
+    }
+}
+
+void MockVoiceServer::maintainSessions()
+{
+    const auto now = util::monotime_get();
+    for (auto sessIter = mSessions.begin(); sessIter != mSessions.end();) {
+        if (now - sessIter->second->LastHeard > sessionIdleTimeoutMs) {
+            LOG("MockVoiceServer", "session for %s timed out", sessIter->first.c_str());
+            mSessionsByTag.erase(sessIter->second->Channel.ChannelTag);
+            sessIter = mSessions.erase(sessIter);
+        } else {
+            sessIter++;
+        }
+    }
+    mMaintenanceTimer.enable(maintenanceIntervalMs);
+}
+
+template<class T>
+void MockVoiceServer::sendTo(Session &session, const T &dto)
+{
+    if (mSocket < 0 || session.AddressLength == 0) {
+        return;
+    }
+    std::vector<unsigned char> dgBuffer(cryptodto::maxPermittedDatagramSize);
+    const size_t dgSize = session.Channel.Encapsulate<T>(
+            dgBuffer.data(),
+            dgBuffer.size(),
+            session.TxSequence++,
+            cryptodto::CryptoDtoMode::CryptoModeChaCha20Poly1305,
+            dto);
+    if (dgSize == 0) {
+        LOG("MockVoiceServer", "couldn't encapsulate %s for %s", T::getName().c_str(), session.Callsign.c_str());
+        return;
+    }
+    auto sent = ::sendto(
+            mSocket,
+            reinterpret_cast<const char *>(dgBuffer.data()),
+            dgSize,
+            0,
+            reinterpret_cast<const struct sockaddr *>(&session.Address),
+            session.AddressLength);
+    if (sent < 0) {
+        mDatagramsDropped++;
+        return;
+    }
+    mDatagramsSent++;
+}
@@ -0,0 +1,154 @@
+/* mockserver/MockVoiceServer.h
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef MOCKSERVER_MOCKVOICESERVER_H
+#define MOCKSERVER_MOCKVOICESERVER_H
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <event2/event.h>
+#include <event2/util.h>
+
+#ifdef WIN32
+#include <winsock2.h>
+#else
+#include <sys/socket.h>
+#endif
+
+#include "afv-native/afv/dto/Transceiver.h"
+#include "afv-native/afv/dto/VoiceServerConnectionData.h"
+#include "afv-native/afv/dto/interfaces/IAudio.h"
+#include "afv-native/cryptodto/Channel.h"
+#include "afv-native/event/EventCallbackTimer.h"
+#include "afv-native/util/monotime.h"
+
+class ScriptedTalker;
+
+/** MockVoiceServer is a stand-in for the AFV voice server.
+ *
+ * Sessions are created by the mock API server when a callsign is posted and
+ * hand back a cryptodto channel config the same way the real service does.
+ * Heartbeats are answered, and audio transmitted on a transceiver is fanned out
+ * as AR packets to every other session that has a transceiver on the same
+ * frequency.  With echo enabled the sender hears itself too.
+ *
+ * There is no range modelling - every receiver hears every transmitter on its
+ * frequency at full strength.
+ */
+class MockVoiceServer {
+public:
+    MockVoiceServer(struct event_base *evBase, std::string listenAddress);
+    virtual ~MockVoiceServer();
+
+    bool open();
+    void close();
+
+    /** @return the address clients are told to send voice traffic to. */
+    const std::string &getAddress() const;
+
+    void setEcho(bool echo);
+
+    /** createSession registers (or re-registers) callsign and returns the
+     * connection data the API server should hand to the client.
+     */
+    afv_native::afv::dto::VoiceServerConnectionData createSession(const std::string &callsign);
+    bool removeSession(const std::string &callsign);
+    bool updateTransceivers(const std::string &callsign, const std::vector<afv_native::afv::dto::Transceiver> &transceivers);
+
+    void addTalker(std::unique_ptr<ScriptedTalker> talker);
+
+    /** deliver sends audio to every session with a transceiver tuned to one of
+     * frequencies.  sender is skipped unless echo is enabled.
+     */
+    void deliver(
+            const afv_native::afv::dto::IAudio &audio,
+            const std::vector<uint32_t> &frequencies,
+            const std::string &sender);
+
+    size_t getSessionCount() const;
+    uint64_t getDatagramsReceived() const;
+    uint64_t getDatagramsSent() const;
+    uint64_t getDatagramsDropped() const;
+
+protected:
+    struct Session {
+        std::string Callsign;
+        afv_native::cryptodto::Channel Channel;
+        afv_native::cryptodto::sequence_t TxSequence;
+        struct sockaddr_storage Address;
+        ev_socklen_t AddressLength;
+        std::map<uint16_t, uint32_t> Transceivers;
+        afv_native::util::monotime_t LastHeard;
+
+        Session();
+    };
+
+    /** sessionIdleTimeoutMs is how long a session may go without any traffic
+     * before it is discarded.  It's a few heartbeat timeouts so a stalled
+     * client under load isn't dropped out from under the test.
+     */
+    static const int sessionIdleTimeoutMs = 30 * 1000;
+    static const int maintenanceIntervalMs = 5 * 1000;
+    static const int maxDatagramsPerWakeup = 64;
+
+    struct event_base *mEvBase;
+    std::string mAddress;
+    evutil_socket_t mSocket;
+    struct event *mSocketEvent;
+    unsigned char *mDatagramBuffer;
+    bool mEcho;
+
+    std::map<std::string, std::unique_ptr<Session>> mSessions;
+    std::map<std::string, Session *> mSessionsByTag;
+    std::vector<std::unique_ptr<ScriptedTalker>> mTalkers;
+    afv_native::event::EventCallbackTimer mMaintenanceTimer;
+
+    uint64_t mDatagramsReceived;
+    uint64_t mDatagramsSent;
+    uint64_t mDatagramsDropped;
+
+    static void evReadCallback(evutil_socket_t fd, short events, void *arg);
+    void readCallback();
+    void processDatagram(const unsigned char *data, size_t len, const struct sockaddr_storage &from, ev_socklen_t fromLen);
+    void processHeartbeat(Session &session);
+    void processAudio(Session &session, const unsigned char *data, size_t len);
+    void maintainSessions();
+
+    template<class T>
+    void sendTo(Session &session, const T &dto);
+};
+
+#endif //MOCKSERVER_MOCKVOICESERVER_H
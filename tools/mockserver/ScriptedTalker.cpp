@@ -0,0 +1,171 @@
+/* mockserver/ScriptedTalker.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "ScriptedTalker.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <sstream>
+
+#include "afv-native/Log.h"
+#include "afv-native/audio/RecordedSampleSource.h"
+#include "afv-native/audio/SineToneSource.h"
+#include "afv-native/audio/WavFile.h"
+#include "afv-native/audio/WavSampleStorage.h"
+#include "afv-native/audio/audio_params.h"
+
+#include "MockVoiceServer.h"
+
+using namespace afv_native;
+
+ScriptedTalker::ScriptedTalker(
+        struct event_base *evBase,
+        MockVoiceServer &server,
+        std::string callsign,
+        uint32_t frequency,
+        unsigned int onMs,
+        unsigned int offMs):
+        mServer(server),
+        mCallsign(std::move(callsign)),
+        mFrequencies{frequency},
+        mOnMs(onMs),
+        mOffMs(offMs),
+        mSource(std::make_shared<audio::SineToneSource>(1000.0, 0.5f)),
+        mEncoder(*this),
+        mFrameTimer(evBase, std::bind(&ScriptedTalker::frameTick, this)),
+        mNextFrameTime(0),
+        mCycleStart(0),
+        mSequence(0),
+        mTalking(false),
+        mLastPacket(false)
+{
+}
+
+ScriptedTalker::~ScriptedTalker()
+{
+    stop();
+}
+
+std::unique_ptr<ScriptedTalker>
+ScriptedTalker::parse(struct event_base *evBase, MockVoiceServer &server, const std::string &spec)
+{
+    std::vector<std::string> fields;
+    std::istringstream specStream(spec);
+    std::string field;
+    while (std::getline(specStream, field, ':')) {
+        fields.emplace_back(field);
+    }
+    if (fields.size() < 2 || fields.size() == 4 || fields.size() > 5 || fields[0].empty()) {
+        LOG("ScriptedTalker", "bad talker description \"%s\"", spec.c_str());
+        return nullptr;
+    }
+    const auto frequency = static_cast<uint32_t>(std::strtoul(fields[1].c_str(), nullptr, 10));
+    if (frequency == 0) {
+        LOG("ScriptedTalker", "bad talker frequency \"%s\"", fields[1].c_str());
+        return nullptr;
+    }
+    unsigned int onMs = 5000, offMs = 5000;
+    if (fields.size() == 5) {
+        onMs = static_cast<unsigned int>(std::strtoul(fields[3].c_str(), nullptr, 10));
+        offMs = static_cast<unsigned int>(std::strtoul(fields[4].c_str(), nullptr, 10));
+    }
+    std::unique_ptr<ScriptedTalker> talker(new ScriptedTalker(evBase, server, fields[0], frequency, onMs, offMs));
+    if (fields.size() >= 3 && !fields[2].empty()) {
+        if (!talker->setWavFile(fields[2])) {
+            return nullptr;
+        }
+    }
+    return talker;
+}
+
+bool ScriptedTalker::setWavFile(const std::string &fileName)
+{
+    std::unique_ptr<audio::AudioSampleData> wavData(audio::LoadWav(fileName.c_str()));
+    if (!wavData) {
+        LOG("ScriptedTalker", "couldn't load %s", fileName.c_str());
+        return false;
+    }
+    auto storage = std::make_shared<audio::WavSampleStorage>(*wavData);
+    mSource = std::make_shared<audio::RecordedSampleSource>(storage, true);
+    return true;
+}
+
+void ScriptedTalker::start()
+{
+    mCycleStart = util::monotime_get();
+    mNextFrameTime = mCycleStart;
+    mTalking = false;
+    mFrameTimer.enable(0);
+}
+
+void ScriptedTalker::stop()
+{
+    mFrameTimer.disable();
+}
+
+void ScriptedTalker::frameTick()
+{
+    const util::monotime_t now = util::monotime_get();
+    // if we've stalled badly, don't try to burst the backlog out all at once.
+    if (now - mNextFrameTime > 1000) {
+        mNextFrameTime = now;
+    }
+    while (mNextFrameTime <= now) {
+        const bool shouldTalk = (mOffMs == 0) || ((mNextFrameTime - mCycleStart) % (mOnMs + mOffMs)) < mOnMs;
+        if (shouldTalk || mTalking) {
+            audio::SampleType frame[audio::frameSizeSamples];
+            if (shouldTalk) {
+                mSource->getAudioFrame(frame);
+            } else {
+                ::memset(frame, 0, sizeof(frame));
+            }
+            // the first silent frame closes out the over.
+            mLastPacket = !shouldTalk;
+            mEncoder.putAudioFrame(frame);
+            mTalking = shouldTalk;
+        }
+        mNextFrameTime += audio::frameLengthMs;
+    }
+    mFrameTimer.enable(static_cast<unsigned int>(mNextFrameTime - now));
+}
+
+void ScriptedTalker::processCompressedFrame(const std::vector<unsigned char> &compressedData)
+{
+    afv::dto::IAudio audioDto;
+    audioDto.Callsign = mCallsign;
+    audioDto.SequenceCounter = mSequence++;
+    audioDto.Audio = compressedData;
+    audioDto.LastPacket = mLastPacket;
+    mServer.deliver(audioDto, mFrequencies, mCallsign);
+}
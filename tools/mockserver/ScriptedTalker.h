@@ -0,0 +1,100 @@
+/* mockserver/ScriptedTalker.h
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef MOCKSERVER_SCRIPTEDTALKER_H
+#define MOCKSERVER_SCRIPTEDTALKER_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <event2/event.h>
+
+#include "afv-native/afv/VoiceCompressionSink.h"
+#include "afv-native/audio/ISampleSource.h"
+#include "afv-native/event/EventCallbackTimer.h"
+#include "afv-native/util/monotime.h"
+
+class MockVoiceServer;
+
+/** ScriptedTalker is a synthetic station that keys up on a frequency.
+ *
+ * It transmits for onMs, then stays silent for offMs, repeating forever.  An
+ * offMs of 0 makes it talk continuously.  Audio comes from a looped WAV file,
+ * or a test tone if no file is given.
+ */
+class ScriptedTalker: public afv_native::afv::ICompressedFrameSink {
+public:
+    ScriptedTalker(
+            struct event_base *evBase,
+            MockVoiceServer &server,
+            std::string callsign,
+            uint32_t frequency,
+            unsigned int onMs,
+            unsigned int offMs);
+    virtual ~ScriptedTalker();
+
+    /** parse builds a talker from a CALLSIGN:FREQHZ[:WAVFILE[:ONMS:OFFMS]]
+     * description.
+     *
+     * @return the talker, or nullptr if the description or WAV file was bad.
+     */
+    static std::unique_ptr<ScriptedTalker> parse(struct event_base *evBase, MockVoiceServer &server, const std::string &spec);
+
+    bool setWavFile(const std::string &fileName);
+    void start();
+    void stop();
+
+    void processCompressedFrame(const std::vector<unsigned char> &compressedData) override;
+
+protected:
+    MockVoiceServer &mServer;
+    std::string mCallsign;
+    std::vector<uint32_t> mFrequencies;
+    unsigned int mOnMs;
+    unsigned int mOffMs;
+
+    std::shared_ptr<afv_native::audio::ISampleSource> mSource;
+    afv_native::afv::VoiceCompressionSink mEncoder;
+    afv_native::event::EventCallbackTimer mFrameTimer;
+
+    afv_native::util::monotime_t mNextFrameTime;
+    afv_native::util::monotime_t mCycleStart;
+    uint32_t mSequence;
+    bool mTalking;
+    bool mLastPacket;
+
+    void frameTick();
+};
+
+#endif //MOCKSERVER_SCRIPTEDTALKER_H
@@ -0,0 +1,172 @@
+/* mockserver/main.cpp
+ *
+ * This file is part of AFV-Native.
+ *
+ * Copyright (c) 2019 Christopher Collins
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <event2/event.h>
+
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+#include "afv-native/Log.h"
+
+#include "MockApiServer.h"
+#include "MockVoiceServer.h"
+#include "ScriptedTalker.h"
+
+static void usage(const char *progName)
+{
+    std::cerr << "Usage: " << progName << " [options]" << std::endl
+              << "  --api-addr ADDR       address for the REST API (default 127.0.0.1)" << std::endl
+              << "  --api-port PORT       port for the REST API (default 61000)" << std::endl
+              << "  --voice-addr ADDR:PORT  UDP address for voice traffic (default 127.0.0.1:50000)" << std::endl
+              << "  --password PASSWORD   require this password to authenticate" << std::endl
+              << "  --token-ttl SECONDS   lifetime of issued tokens (default 3600)" << std::endl
+              << "  --stations FILE       JSON file to serve as the station alias list" << std::endl
+              << "  --echo                return transmitted audio to the sender too" << std::endl
+              << "  --talker CALLSIGN:FREQHZ[:WAVFILE[:ONMS:OFFMS]]" << std::endl
+              << "                        add a scripted talker (may be repeated)" << std::endl;
+}
+
+static void stderrLogger(const char *subsystem, const char *file, int line, const char *lineOut)
+{
+    std::cerr << subsystem << ": " << lineOut << std::endl;
+}
+
+static void signalCallback(evutil_socket_t sig, short events, void *arg)
+{
+    auto *evBase = reinterpret_cast<struct event_base *>(arg);
+    event_base_loopexit(evBase, nullptr);
+}
+
+int
+main(int argc, char **argv)
+{
+#ifdef WIN32
+    WSADATA wsaData;
+    int wsErr = WSAStartup(MAKEWORD(2, 2), &wsaData);
+    if (wsErr != 0) {
+        std::cerr << "WSAStartup failed with error: " << wsErr << std::endl;
+        return 1;
+    }
+#endif
+
+    afv_native::setLogger(stderrLogger);
+
+    std::string apiAddress = "127.0.0.1";
+    uint16_t apiPort = 61000;
+    std::string voiceAddress = "127.0.0.1:50000";
+    std::string password;
+    unsigned int tokenTtl = 3600;
+    std::string stationsFile;
+    bool echo = false;
+    std::vector<std::string> talkerSpecs;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool haveValue = (i + 1) < argc;
+        if (arg == "--api-addr" && haveValue) {
+            apiAddress = argv[++i];
+        } else if (arg == "--api-port" && haveValue) {
+            apiPort = static_cast<uint16_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--voice-addr" && haveValue) {
+            voiceAddress = argv[++i];
+        } else if (arg == "--password" && haveValue) {
+            password = argv[++i];
+        } else if (arg == "--token-ttl" && haveValue) {
+            tokenTtl = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--stations" && haveValue) {
+            stationsFile = argv[++i];
+        } else if (arg == "--echo") {
+            echo = true;
+        } else if (arg == "--talker" && haveValue) {
+            talkerSpecs.emplace_back(argv[++i]);
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    struct event_base *evBase = event_base_new();
+    int rv = 0;
+    {
+        MockVoiceServer voiceServer(evBase, voiceAddress);
+        MockApiServer apiServer(evBase, voiceServer);
+
+        voiceServer.setEcho(echo);
+        apiServer.setPassword(password);
+        apiServer.setTokenLifetime(tokenTtl);
+        if (!stationsFile.empty() && !apiServer.loadStationAliases(stationsFile)) {
+            rv = 1;
+        }
+        for (const auto &spec: talkerSpecs) {
+            auto talker = ScriptedTalker::parse(evBase, voiceServer, spec);
+            if (!talker) {
+                rv = 1;
+                break;
+            }
+            voiceServer.addTalker(std::move(talker));
+        }
+        if (rv == 0 && (!voiceServer.open() || !apiServer.open(apiAddress, apiPort))) {
+            rv = 1;
+        }
+
+        if (rv == 0) {
+            struct event *sigIntEvent = evsignal_new(evBase, SIGINT, signalCallback, evBase);
+            struct event *sigTermEvent = evsignal_new(evBase, SIGTERM, signalCallback, evBase);
+            event_add(sigIntEvent, nullptr);
+            event_add(sigTermEvent, nullptr);
+
+            LOG("mockserver", "API on http://%s:%d, voice on %s", apiAddress.c_str(), apiPort, voiceAddress.c_str());
+            event_base_dispatch(evBase);
+
+            event_free(sigTermEvent);
+            event_free(sigIntEvent);
+            LOG("mockserver", "%llu API requests, %llu datagrams received, %llu sent, %llu dropped",
+                    static_cast<unsigned long long>(apiServer.getRequestCount()),
+                    static_cast<unsigned long long>(voiceServer.getDatagramsReceived()),
+                    static_cast<unsigned long long>(voiceServer.getDatagramsSent()),
+                    static_cast<unsigned long long>(voiceServer.getDatagramsDropped()));
+        }
+        apiServer.close();
+        voiceServer.close();
+    }
+    event_base_free(evBase);
+    return rv;
+}